@@ -0,0 +1,829 @@
+// =============================================================================
+// unravel_bench — DSP micro- and end-to-end benchmarks
+// =============================================================================
+// Times the SHIPPING DSP units in isolation and the whole engine end to end,
+// so performance work can be measured and regressions caught:
+//
+//   stft.forward / stft.inverse    STFTProcessor analysis / synthesis per frame
+//   fft.forward / fft.inverse      Each compiled-in FFTBackend at 256 / 1024 / 2048
+//   magphase.*                     MagPhaseFrame magnitude + polar conversions
+//   kernels.*                      SpectralKernels magnitudes / Wiener masks / flatness,
+//                                  under each instruction set this build and CPU offer
+//   mask.*                         MaskEstimator updateGuides (Float32 / Key16 history) / updateStats / computeMasks,
+//                                  and a whole frame estimated every 1 / 2 / 4 frames
+//   lowfreq.process                LowFreqPartialTracker::process
+//   harmonic.process               HarmonicMaskDetector::process (8192-point grid, Float32 / Key16)
+//   reconciler.map                 MaskReconciler::map (8192 → 2048 grid)
+//   brightness.process             BrightnessShelf::process, 6 channels × 512 (settled / ramping)
+//   hpss.processBlock              HPSSProcessor::processBlock at block sizes
+//                                  32..2048 and 1 / 2 / 2-linked / 6 / 6-pooled channels,
+//                                  plus pipelined 1 / 2-linked and 2 channels at the
+//                                  No LF Tracker / Short Median / Half-Rate Masks tiers
+//   hpss.stemSplit                 Three stereo engines soloing one stream each,
+//                                  standalone vs one SharedAnalysis between them,
+//                                  vs one engine with stem outputs
+//
+// Each result reports ns per item (a frame, or for processBlock a frame of
+// one channel), the real-time factor where it applies, for processBlock the
+// slowest single callback (what a small host buffer has to fit), and the
+// number of ::operator new calls made while timing — every one of which is
+// an RT-safety regression in the engine paths.
+//
+//   unravel_bench [--quick] [--json <file>] [--filter <substring>]
+//     --quick              Fewer frames and one repeat (CI smoke run)
+//     --json <file>        Write the JSON report there instead of stdout
+//     --filter <text>      Only run benchmarks whose name contains text
+//
+// The JSON report goes to stdout (or --json); a readable table goes to stderr.
+// Per-unit figures are the best of several repeats, to keep scheduler noise
+// out of comparisons between builds.
+// =============================================================================
+
+#include <JuceHeader.h>
+#include "HPSSProcessor.h"
+#include "STFTProcessor.h"
+#include "FFTBackend.h"
+#include "MagPhaseFrame.h"
+#include "MaskEstimator.h"
+#include "LowFreqPartialTracker.h"
+#include "HarmonicMaskDetector.h"
+#include "MaskReconciler.h"
+#include "SpectralKernels.h"
+#include "ChannelWorkerPool.h"
+#include "BrightnessShelf.h"
+#include "SharedAnalysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Allocation counting: every ::operator new while a benchmark is timing.
+// -----------------------------------------------------------------------------
+namespace
+{
+std::atomic<long long> gAllocations { 0 };
+
+// Every replacement below allocates and frees through these, kept out of
+// line: an inlined std::free on a pointer from ::operator new reads to GCC
+// as a mismatched pair (-Wmismatched-new-delete), though the pair matches.
+#if defined(_MSC_VER)
+ #define UNRAVEL_BENCH_NOINLINE __declspec(noinline)
+#else
+ #define UNRAVEL_BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+UNRAVEL_BENCH_NOINLINE void* countedAllocate (std::size_t size, std::size_t alignment)
+{
+    gAllocations.fetch_add (1, std::memory_order_relaxed);
+    size = size != 0 ? size : 1;
+   #if defined(_MSC_VER)
+    if (void* p = alignment != 0 ? _aligned_malloc (size, alignment) : std::malloc (size))
+        return p;
+   #else
+    if (void* p = alignment != 0 ? std::aligned_alloc (alignment, (size + alignment - 1) / alignment * alignment)
+                                 : std::malloc (size))
+        return p;
+   #endif
+    throw std::bad_alloc();
+}
+
+UNRAVEL_BENCH_NOINLINE void countedRelease (void* p, bool aligned) noexcept
+{
+   #if defined(_MSC_VER)
+    if (aligned)
+    {
+        _aligned_free (p);
+        return;
+    }
+   #endif
+    juce::ignoreUnused (aligned);
+    std::free (p);
+}
+}
+
+void* operator new (std::size_t size)                                       { return countedAllocate (size, 0); }
+void* operator new[] (std::size_t size)                                     { return countedAllocate (size, 0); }
+void* operator new (std::size_t size, std::align_val_t align)               { return countedAllocate (size, (std::size_t) align); }
+void* operator new[] (std::size_t size, std::align_val_t align)             { return countedAllocate (size, (std::size_t) align); }
+void operator delete (void* p) noexcept                                     { countedRelease (p, false); }
+void operator delete[] (void* p) noexcept                                   { countedRelease (p, false); }
+void operator delete (void* p, std::size_t) noexcept                        { countedRelease (p, false); }
+void operator delete[] (void* p, std::size_t) noexcept                      { countedRelease (p, false); }
+void operator delete (void* p, std::align_val_t) noexcept                   { countedRelease (p, true); }
+void operator delete[] (void* p, std::align_val_t) noexcept                 { countedRelease (p, true); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept      { countedRelease (p, true); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept    { countedRelease (p, true); }
+
+namespace
+{
+constexpr double kSR = 48000.0;
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    bool quick = false;
+    std::string jsonPath;
+    std::string filter;
+};
+
+struct Result
+{
+    std::string name;
+    std::string config;         ///< e.g. "2048/512", "block=64 ch=2 linked"
+    double nsPerItem = 0.0;
+    long long items = 0;        ///< Items per repeat
+    long long allocations = 0;  ///< Worst repeat
+    double xrt = 0.0;           ///< Real-time factor (0 = not applicable)
+    int blockSize = 0;
+    int channels = 0;
+    double peakBlockNs = 0.0;   ///< Slowest single processBlock call (0 = not measured)
+};
+
+std::vector<Result> gResults;
+Options gOptions;
+
+bool selected (const std::string& name)
+{
+    return gOptions.filter.empty() || name.find (gOptions.filter) != std::string::npos;
+}
+
+double nanoseconds (Clock::duration d)
+{
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds> (d).count();
+}
+
+int numRepeats() { return gOptions.quick ? 1 : 3; }
+int numFrames()  { return gOptions.quick ? 200 : 2000; }
+
+/** Keep the best repeat of each (name, config) and its worst allocation count. */
+void record (Result result, double ns, long long allocations)
+{
+    result.nsPerItem = ns / (double) std::max (1LL, result.items);
+    result.allocations = allocations;
+
+    auto existing = std::find_if (gResults.begin(), gResults.end(), [&] (const Result& r)
+    {
+        return r.name == result.name && r.config == result.config;
+    });
+    if (existing == gResults.end())
+    {
+        gResults.push_back (result);
+        return;
+    }
+
+    existing->allocations = std::max (existing->allocations, allocations);
+    if (result.nsPerItem < existing->nsPerItem)
+    {
+        existing->nsPerItem = result.nsPerItem;
+        existing->xrt = result.xrt;
+    }
+    if (result.peakBlockNs > 0.0)
+        existing->peakBlockNs = existing->peakBlockNs > 0.0 ? std::min (existing->peakBlockNs, result.peakBlockNs)
+                                                            : result.peakBlockNs;
+}
+
+// -----------------------------------------------------------------------------
+// Test material: two hum partials, a harmonic series and a noise bed, so the
+// medians, trackers and masks all see realistic, non-degenerate input.
+// -----------------------------------------------------------------------------
+std::vector<float> makeSignal (int numSamples, uint32_t seed)
+{
+    std::vector<float> x ((size_t) numSamples);
+    juce::Random rng ((juce::int64) seed);
+    float lp = 0.0f;
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const double t = n / kSR;
+        double tone = 0.30 * std::sin (2.0 * M_PI * 100.0 * t) + 0.15 * std::sin (2.0 * M_PI * 160.0 * t);
+        for (int h = 1; h <= 6; ++h)
+            tone += 0.05 / h * std::sin (2.0 * M_PI * 440.0 * h * t);
+        lp += 0.25f * ((rng.nextFloat() * 2.0f - 1.0f) - lp);
+        x[(size_t) n] = (float) tone + 0.2f * lp;
+    }
+    return x;
+}
+
+/** Magnitude frames of the test signal on an fftSize/hop grid. */
+std::vector<std::vector<float>> analyse (int fftSize, int hopSize, int count)
+{
+    const auto signal = makeSignal (fftSize + hopSize * count, 7);
+    STFTProcessor stft ({ fftSize, hopSize });
+    stft.prepare (kSR, hopSize);
+    MagPhaseFrame frame (fftSize / 2 + 1);
+
+    std::vector<std::vector<float>> frames;
+    size_t pos = 0;
+    while ((int) frames.size() < count && pos + (size_t) hopSize <= signal.size())
+    {
+        stft.pushAndProcess (signal.data() + pos, hopSize);
+        pos += (size_t) hopSize;
+        while (stft.isFrameReady())
+        {
+            auto bins = stft.getCurrentFrame();
+            frame.computeMagnitudes (bins);
+            auto mags = frame.getMagnitudes();
+            frames.emplace_back (mags.begin(), mags.end());
+            stft.setCurrentFrame (bins);
+            stft.pushAndProcess (nullptr, 0);
+        }
+    }
+    return frames;
+}
+
+// -----------------------------------------------------------------------------
+// Unit benchmarks
+// -----------------------------------------------------------------------------
+void benchStft (int fftSize, int hopSize)
+{
+    if (! selected ("stft"))
+        return;
+
+    const std::string config = std::to_string (fftSize) + "/" + std::to_string (hopSize);
+    const int frames = numFrames();
+    const auto signal = makeSignal (fftSize + hopSize * (frames + 1), 1);
+    std::vector<float> out ((size_t) hopSize);
+
+    for (int repeat = 0; repeat < numRepeats(); ++repeat)
+    {
+        STFTProcessor stft ({ fftSize, hopSize });
+        stft.prepare (kSR, hopSize);
+        std::vector<std::complex<float>> bins ((size_t) stft.getNumBins());
+
+        // Fill the first window so every timed push completes one frame.
+        stft.pushAndProcess (signal.data(), fftSize - hopSize);
+        size_t pos = (size_t) (fftSize - hopSize);
+
+        // Forward = push one hop (completes a frame); inverse = synthesis,
+        // overlap-add and reading the hop back out.
+        Clock::duration forward {}, inverse {};
+        long long forwardAllocs = 0, inverseAllocs = 0;
+        for (int f = 0; f < frames; ++f, pos += (size_t) hopSize)
+        {
+            const long long a0 = gAllocations.load();
+            const auto t0 = Clock::now();
+            stft.pushAndProcess (signal.data() + pos, hopSize);
+            const auto t1 = Clock::now();
+            const long long a1 = gAllocations.load();
+            auto frame = stft.getCurrentFrame();
+            stft.setCurrentFrame (frame);
+            stft.processOutput (out.data(), hopSize);
+            const auto t2 = Clock::now();
+            forwardAllocs += a1 - a0;
+            inverseAllocs += gAllocations.load() - a1;
+            forward += t1 - t0;
+            inverse += t2 - t1;
+        }
+
+        Result r;
+        r.config = config;
+        r.items = frames;
+        r.name = "stft.forward";
+        record (r, nanoseconds (forward), forwardAllocs);
+        r.name = "stft.inverse";
+        record (r, nanoseconds (inverse), inverseAllocs);
+    }
+}
+
+/** Time fn(frameIndex) over the frames, best of the repeats. */
+template <typename Fn>
+void benchFrames (const std::string& name, const std::string& config, int numItems, Fn&& fn)
+{
+    if (! selected (name))
+        return;
+
+    for (int repeat = 0; repeat < numRepeats(); ++repeat)
+    {
+        const long long allocBefore = gAllocations.load();
+        const auto start = Clock::now();
+        for (int i = 0; i < numItems; ++i)
+            fn (i);
+        const double ns = nanoseconds (Clock::now() - start);
+        const long long allocs = gAllocations.load() - allocBefore;
+
+        Result r;
+        r.name = name;
+        r.config = config;
+        r.items = numItems;
+        record (r, ns, allocs);
+    }
+}
+
+void benchUnits()
+{
+    const int frames = numFrames();
+    constexpr int fft = 2048, hop = 512, bins = fft / 2 + 1;
+    const auto mags = analyse (fft, hop, 64);
+    const std::string grid = "2048/512";
+
+    // FFT backends on their own (STFTProcessor's default is marked "*").
+    for (auto kind : { FFTBackend::Kind::Juce, FFTBackend::Kind::Builtin, FFTBackend::Kind::Pffft })
+    {
+        if (! FFTBackend::isAvailable (kind))
+            continue;
+        for (int order : { 8, 10, 11 })
+        {
+            auto backend = FFTBackend::create (order, kind);
+            const auto input = makeSignal (backend->getSize(), 5);
+            std::vector<std::complex<float>> spectrum ((size_t) backend->getNumBins());
+            std::vector<float> output ((size_t) backend->getSize());
+            const std::string config = std::to_string (backend->getSize()) + " " + backend->getName()
+                                     + (kind == FFTBackend::getDefaultKind() ? "*" : "");
+            benchFrames ("fft.forward", config, frames, [&] (int) { backend->forward (input.data(), spectrum.data()); });
+            benchFrames ("fft.inverse", config, frames, [&] (int) { backend->inverse (spectrum.data(), output.data()); });
+        }
+    }
+
+    // MagPhaseFrame: both directions of the polar reference path, and the
+    // magnitude-only path the engine uses.
+    {
+        std::vector<std::complex<float>> spectrum ((size_t) bins);
+        for (int b = 0; b < bins; ++b)
+            spectrum[(size_t) b] = std::polar (mags[0][(size_t) b], 0.37f * (float) b);
+        MagPhaseFrame frame (bins);
+        benchFrames ("magphase.computeMagnitudes", grid, frames, [&] (int) { frame.computeMagnitudes (spectrum); });
+        benchFrames ("magphase.fromComplex", grid, frames, [&] (int) { frame.fromComplex (spectrum); });
+        benchFrames ("magphase.toComplex", grid, frames, [&] (int) { frame.toComplex (spectrum); });
+    }
+
+    // SpectralKernels under every variant available here (the selected one
+    // is marked "*"), then back to the selection the engine would make.
+    {
+        using SpectralKernels::InstructionSet;
+        std::vector<std::complex<float>> spectrum ((size_t) bins);
+        for (int b = 0; b < bins; ++b)
+            spectrum[(size_t) b] = std::polar (mags[0][(size_t) b], 0.37f * (float) b);
+        std::vector<float> out ((size_t) bins), flux ((size_t) bins, 0.1f), flatness ((size_t) bins, 0.4f);
+        SpectralKernels::FlatnessWorkspace workspace;
+        workspace.prepare (bins);
+        const SpectralKernels::WienerParams params { 1e-6f, 1.2f, 1.0f, 1.5f, 1e-8f };
+
+        SpectralKernels::selectInstructionSet();
+        const auto selected = SpectralKernels::getInstructionSet();
+        for (auto set : { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::NEON, InstructionSet::AVX2 })
+        {
+            if (! SpectralKernels::setInstructionSet (set))
+                continue;
+            const std::string config = grid + " " + SpectralKernels::getInstructionSetName (set)
+                                     + (set == selected ? "*" : "");
+            benchFrames ("kernels.magnitudes", config, frames, [&] (int)
+            {
+                SpectralKernels::computeMagnitudes (spectrum.data(), out.data(), bins, 1e-9f);
+            });
+            benchFrames ("kernels.wienerMasks", config, frames, [&] (int i)
+            {
+                const auto& m = mags[(size_t) i % mags.size()];
+                SpectralKernels::computeWienerMasks (m.data(), mags[0].data(), flux.data(), flatness.data(),
+                                                     out.data(), bins, params);
+            });
+            benchFrames ("kernels.flatness", config, frames, [&] (int i)
+            {
+                SpectralKernels::computeSpectralFlatness (mags[(size_t) i % mags.size()].data(), out.data(),
+                                                          bins, 9, 1e-9f, workspace);
+            });
+        }
+        SpectralKernels::setInstructionSet (selected);
+    }
+
+    // MaskEstimator stages, fed the analysed frames in order.
+    {
+        MaskEstimator estimator;
+        estimator.prepare (bins, kSR);
+        estimator.setSeparation (0.85f);
+        std::vector<float> tonal ((size_t) bins), transient ((size_t) bins), noise ((size_t) bins);
+        auto frameAt = [&] (int i) { return juce::Span<const float> (mags[(size_t) i % mags.size()]); };
+
+        benchFrames ("mask.updateGuides", grid, frames, [&] (int i) { estimator.updateGuides (frameAt (i)); });
+
+        MaskEstimator keyed;
+        keyed.setHistoryFormat (SlidingMedian::HistoryFormat::Key16);
+        keyed.prepare (bins, kSR);
+        benchFrames ("mask.updateGuides", grid + " key16", frames, [&] (int i) { keyed.updateGuides (frameAt (i)); });
+        benchFrames ("mask.updateStats", grid, frames, [&] (int i) { estimator.updateStats (frameAt (i)); });
+        benchFrames ("mask.computeMasks", grid, frames, [&] (int)
+        {
+            estimator.computeMasks (juce::Span<float> (tonal), juce::Span<float> (transient), juce::Span<float> (noise));
+        });
+
+        // A whole frame (guides, statistics, masks), estimated every frame
+        // and decimated.
+        for (int interval : { 1, 2, 4 })
+        {
+            MaskEstimator decimated;
+            decimated.prepare (bins, kSR);
+            decimated.setSeparation (0.85f);
+            decimated.setMaskDecimation (interval);
+            benchFrames ("mask.frame", grid + " decimate=" + std::to_string (interval), frames, [&] (int i)
+            {
+                decimated.updateGuides (frameAt (i));
+                decimated.updateStats (frameAt (i));
+                decimated.computeMasks (juce::Span<float> (tonal), juce::Span<float> (transient), juce::Span<float> (noise));
+            });
+        }
+
+        // The same frame analysing only a low band (the rest fixed masks).
+        for (int topHz : { 4000, 1000 })
+        {
+            MaskEstimator banded;
+            banded.prepare (bins, kSR);
+            banded.setSeparation (0.85f);
+            banded.setActiveBand (0, std::min (bins, (int) std::ceil (topHz * fft / kSR) + 1));
+            benchFrames ("mask.frame", grid + " band=0-" + std::to_string (topHz / 1000) + "k", frames, [&] (int i)
+            {
+                banded.updateGuides (frameAt (i));
+                banded.updateStats (frameAt (i));
+                banded.computeMasks (juce::Span<float> (tonal), juce::Span<float> (transient), juce::Span<float> (noise));
+            });
+        }
+    }
+
+    // LowFreqPartialTracker on its own (it also runs inside updateGuides).
+    {
+        LowFreqPartialTracker tracker;
+        tracker.prepare (bins, kSR);
+        benchFrames ("lowfreq.process", grid, frames, [&] (int i)
+        {
+            tracker.process (juce::Span<const float> (mags[(size_t) i % mags.size()]));
+        });
+    }
+
+    // Long-grid harmonic path: detector on 8192-point frames, reconciled to 2048.
+    {
+        constexpr int longFft = 8192, longBins = longFft / 2 + 1;
+        const auto longMags = analyse (longFft, longFft / 4, 32);
+        HarmonicMaskDetector detector;
+        detector.prepare (longBins);
+        std::vector<float> longMask ((size_t) longBins), shortMask ((size_t) bins);
+        const int longFrames = std::max (1, frames / 4);
+        benchFrames ("harmonic.process", "8192/2048", longFrames, [&] (int i)
+        {
+            detector.process (juce::Span<const float> (longMags[(size_t) i % longMags.size()]),
+                              juce::Span<float> (longMask));
+        });
+
+        HarmonicMaskDetector keyedDetector;
+        keyedDetector.setHistoryFormat (SlidingMedian::HistoryFormat::Key16);
+        keyedDetector.prepare (longBins);
+        benchFrames ("harmonic.process", "8192/2048 key16", longFrames, [&] (int i)
+        {
+            keyedDetector.process (juce::Span<const float> (longMags[(size_t) i % longMags.size()]),
+                                   juce::Span<float> (longMask));
+        });
+
+        MaskReconciler reconciler;
+        reconciler.prepare (longBins, bins);
+        benchFrames ("reconciler.map", "8192->2048", frames, [&] (int)
+        {
+            reconciler.map (juce::Span<const float> (longMask), juce::Span<float> (shortMask));
+        });
+    }
+
+    {
+        // One item is a 512-sample block of every channel, refilled from
+        // the source each time so repeated boosts never run away.
+        constexpr int channels = 6, block = 512;
+        const std::vector<float> source = makeSignal (channels * block, 11);
+        std::vector<float> audio (source.size());
+        float* ptrs[channels];
+        for (int ch = 0; ch < channels; ++ch)
+            ptrs[ch] = audio.data() + ch * block;
+
+        BrightnessShelf shelf;
+        shelf.prepare (kSR, channels);
+        shelf.snapGainDb (6.0f);
+        benchFrames ("brightness.process", "6ch x 512", frames, [&] (int)
+        {
+            std::copy (source.begin(), source.end(), audio.begin());
+            shelf.process (ptrs, channels, block);
+        });
+        benchFrames ("brightness.process", "6ch x 512 ramping", frames, [&] (int i)
+        {
+            std::copy (source.begin(), source.end(), audio.begin());
+            shelf.setGainDb ((i & 1) ? 9.0f : -9.0f);
+            shelf.process (ptrs, channels, block);
+        });
+    }
+}
+
+// -----------------------------------------------------------------------------
+// End-to-end: HPSSProcessor::processBlock
+// -----------------------------------------------------------------------------
+struct Layout
+{
+    int channels;
+    bool linked;
+    int workers;
+    bool unity = false;     ///< All gains at unity: the transparent (analysis-only) path
+    bool sparse = false;    ///< Half-second bursts in digital silence, silence gate on
+    bool pipelined = false; ///< HPSSProcessor::setPipelining(): frame work spread over the hop
+    QualityGovernor::Tier tier = QualityGovernor::Tier::Full;   ///< HPSSProcessor::setQualityTier()
+};
+
+void benchProcessBlock (int blockSize, const Layout& layout, ChannelWorkerPool& pool)
+{
+    if (! selected ("hpss"))
+        return;
+
+    const double seconds = gOptions.quick ? 2.0 : 10.0;
+    const int warmupSamples = (int) kSR / 2;
+    const int numBlocks = (int) (seconds * kSR) / blockSize;
+    const int totalSamples = warmupSamples + numBlocks * blockSize;
+
+    std::vector<std::vector<float>> in, out;
+    for (int ch = 0; ch < layout.channels; ++ch)
+    {
+        in.push_back (makeSignal (totalSamples, 100u + (uint32_t) ch));
+        out.emplace_back ((size_t) blockSize);
+
+        // Effects-library material: one burst every two seconds.
+        if (layout.sparse)
+            for (int i = 0; i < totalSamples; ++i)
+                if (i % (int) (2.0 * kSR) >= (int) (0.5 * kSR))
+                    in.back()[(size_t) i] = 0.0f;
+    }
+    std::vector<const float*> inPtrs ((size_t) layout.channels);
+    std::vector<float*> outPtrs ((size_t) layout.channels);
+    for (int ch = 0; ch < layout.channels; ++ch)
+        outPtrs[(size_t) ch] = out[(size_t) ch].data();
+
+    std::string config = "block=" + std::to_string (blockSize) + " ch=" + std::to_string (layout.channels);
+    if (layout.linked)
+        config += " linked";
+    if (layout.workers > 0)
+        config += " workers=" + std::to_string (layout.workers);
+    if (layout.unity)
+        config += " unity";
+    if (layout.sparse)
+        config += " sparse";
+    if (layout.pipelined)
+        config += " pipelined";
+    if (layout.tier != QualityGovernor::Tier::Full)
+        config += std::string (" tier=") + QualityGovernor::getTierName (layout.tier);
+
+    for (int repeat = 0; repeat < numRepeats(); ++repeat)
+    {
+        HPSSProcessor proc (false);   // The plugin's 2048/512 configuration
+        proc.setPipelining (layout.pipelined);
+        proc.prepare (kSR, blockSize, layout.channels);
+        proc.setSeparation (0.85f);
+        proc.setChannelLink (layout.linked ? HPSSProcessor::ChannelLink::Linked
+                                           : HPSSProcessor::ChannelLink::Independent);
+        proc.setWorkerPool (layout.workers > 0 ? &pool : nullptr);
+        proc.setQualityTier (layout.tier);
+        if (layout.sparse)
+            proc.setSilenceGate (SilenceGate::kDefaultThresholdDb);
+
+        // Non-unity gains unless the layout measures the transparent path.
+        const float tonal = layout.unity ? 1.0f : 1.5f;
+        const float noise = layout.unity ? 1.0f : 0.25f;
+        const float transient = layout.unity ? 1.0f : 0.5f;
+        proc.snapGainSmoothers (tonal, noise, transient);
+        auto runBlock = [&] (int pos)
+        {
+            for (int ch = 0; ch < layout.channels; ++ch)
+                inPtrs[(size_t) ch] = in[(size_t) ch].data() + pos;
+            proc.processBlock (inPtrs.data(), outPtrs.data(), layout.channels, blockSize, tonal, noise, transient);
+        };
+
+        int pos = 0;
+        for (; pos + blockSize <= warmupSamples; pos += blockSize)
+            runBlock (pos);
+
+        const long long allocBefore = gAllocations.load();
+        double peakNs = 0.0;
+        const auto start = Clock::now();
+        for (int b = 0; b < numBlocks; ++b, pos += blockSize)
+        {
+            const auto blockStart = Clock::now();
+            runBlock (pos);
+            peakNs = std::max (peakNs, nanoseconds (Clock::now() - blockStart));
+        }
+        const double ns = nanoseconds (Clock::now() - start);
+        const long long allocs = gAllocations.load() - allocBefore;
+
+        Result r;
+        r.name = "hpss.processBlock";
+        r.config = config;
+        r.blockSize = blockSize;
+        r.channels = layout.channels;
+        const int hopSize = proc.getHopSize();
+        r.items = (long long) numBlocks * blockSize / hopSize * layout.channels;
+        r.xrt = (numBlocks * (double) blockSize / kSR) / (ns * 1.0e-9);
+        r.peakBlockNs = peakNs;
+        record (r, ns, allocs);
+    }
+}
+
+// A stem split: three stereo engines on the same input, one per stream, each
+// with its own analysis or one SharedAnalysis between them. ns per frame of
+// one channel of one engine, as hpss.processBlock.
+enum class StemSplit { Standalone, Shared, Buses };
+
+void benchStemSplit (StemSplit split)
+{
+    if (! selected ("hpss.stemSplit"))
+        return;
+
+    constexpr int kMembers = 3, kChannels = 2, blockSize = 512;
+    const double seconds = gOptions.quick ? 2.0 : 10.0;
+    const int warmupSamples = (int) kSR / 2;
+    const int numBlocks = (int) (seconds * kSR) / blockSize;
+    const int totalSamples = warmupSamples + numBlocks * blockSize;
+
+    std::vector<std::vector<float>> in, out;
+    for (int ch = 0; ch < kChannels; ++ch)
+        in.push_back (makeSignal (totalSamples, 300u + (uint32_t) ch));
+    for (int ch = 0; ch < kMembers * kChannels; ++ch)
+        out.emplace_back ((size_t) blockSize);
+    std::vector<float*> outPtrs ((size_t) (kMembers * kChannels));   // Buses: stream-major
+    for (size_t ch = 0; ch < outPtrs.size(); ++ch)
+        outPtrs[ch] = out[ch].data();
+    const bool buses = split == StemSplit::Buses;
+    const int numEngines = buses ? 1 : kMembers;
+    const HPSSProcessor::FrameGains stems[kMembers] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+                                                        { 0.0f, 0.0f, 1.0f } };
+
+    for (int repeat = 0; repeat < numRepeats(); ++repeat)
+    {
+        std::unique_ptr<HPSSProcessor> members[kMembers];
+        std::shared_ptr<SharedAnalysis> group;
+        for (int m = 0; m < numEngines; ++m)
+        {
+            members[m] = std::make_unique<HPSSProcessor> (false);
+            members[m]->setStemOutputs (buses);
+            members[m]->prepare (kSR, blockSize, kChannels);
+            members[m]->setSeparation (0.85f);
+            if (split == StemSplit::Shared)
+            {
+                if (group == nullptr)
+                    group = std::make_shared<SharedAnalysis> (members[m]->getSharedAnalysisLayout());
+                members[m]->setSharedAnalysis (group.get());
+            }
+            if (! buses)
+                members[m]->snapGainSmoothers (stems[m].tonal, stems[m].noise, stems[m].transient);
+        }
+
+        std::vector<const float*> inPtrs ((size_t) kChannels);
+        auto runBlock = [&] (int pos)
+        {
+            for (int ch = 0; ch < kChannels; ++ch)
+                inPtrs[(size_t) ch] = in[(size_t) ch].data() + pos;
+            if (buses)
+            {
+                members[0]->processStemBlock (inPtrs.data(), outPtrs.data(), outPtrs.data() + kChannels,
+                                              outPtrs.data() + 2 * kChannels, kChannels, blockSize,
+                                              1.0f, 1.0f, 1.0f);
+                return;
+            }
+            for (int m = 0; m < kMembers; ++m)
+                members[m]->processBlock (inPtrs.data(), outPtrs.data(), kChannels, blockSize,
+                                          stems[m].tonal, stems[m].noise, stems[m].transient);
+        };
+
+        int pos = 0;
+        for (; pos + blockSize <= warmupSamples; pos += blockSize)
+            runBlock (pos);
+
+        const long long allocBefore = gAllocations.load();
+        const auto start = Clock::now();
+        for (int b = 0; b < numBlocks; ++b, pos += blockSize)
+            runBlock (pos);
+        const double ns = nanoseconds (Clock::now() - start);
+        const long long allocs = gAllocations.load() - allocBefore;
+
+        Result r;
+        r.name = "hpss.stemSplit";
+        r.config = buses ? std::string ("buses=3 ch=2 one engine")
+                         : std::string ("members=3 ch=2 ") + (split == StemSplit::Shared ? "shared" : "standalone");
+        r.blockSize = blockSize;
+        r.channels = kChannels;
+        r.items = (long long) numBlocks * blockSize / members[0]->getHopSize() * kChannels * kMembers;
+        r.xrt = (numBlocks * (double) blockSize / kSR) / (ns * 1.0e-9);
+        record (r, ns, allocs);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Reporting
+// -----------------------------------------------------------------------------
+void writeJson (std::FILE* file)
+{
+    std::fprintf (file, "{\n  \"suite\": \"unravel_bench\",\n  \"isa\": \"%s\",\n  \"profiling\": %d,\n"
+                        "  \"quick\": %s,\n  \"sample_rate\": %.0f,\n  \"results\": [\n",
+                  SpectralKernels::getInstructionSetName(), UNRAVEL_DSP_PROFILING,
+                  gOptions.quick ? "true" : "false", kSR);
+    for (size_t i = 0; i < gResults.size(); ++i)
+    {
+        const auto& r = gResults[i];
+        std::fprintf (file, "    { \"name\": \"%s\", \"config\": \"%s\", \"ns_per_frame\": %.1f, \"frames\": %lld, "
+                            "\"allocations\": %lld",
+                      r.name.c_str(), r.config.c_str(), r.nsPerItem, r.items, r.allocations);
+        if (r.blockSize > 0)
+            std::fprintf (file, ", \"block_size\": %d, \"channels\": %d, \"xrt\": %.1f",
+                          r.blockSize, r.channels, r.xrt);
+        if (r.peakBlockNs > 0.0)
+            std::fprintf (file, ", \"peak_block_ns\": %.0f", r.peakBlockNs);
+        std::fprintf (file, " }%s\n", i + 1 < gResults.size() ? "," : "");
+    }
+    std::fprintf (file, "  ]\n}\n");
+}
+
+void printTable()
+{
+    std::fprintf (stderr, "%-28s %-36s %12s %10s %12s %7s\n",
+                  "benchmark", "config", "ns/frame", "xRT", "peak ns", "allocs");
+    for (const auto& r : gResults)
+    {
+        char xrt[32] = "-";
+        if (r.xrt > 0.0)
+            std::snprintf (xrt, sizeof (xrt), "%.1f", r.xrt);
+        char peak[32] = "-";
+        if (r.peakBlockNs > 0.0)
+            std::snprintf (peak, sizeof (peak), "%.0f", r.peakBlockNs);
+        std::fprintf (stderr, "%-28s %-36s %12.1f %10s %12s %7lld\n",
+                      r.name.c_str(), r.config.c_str(), r.nsPerItem, xrt, peak, r.allocations);
+    }
+}
+
+bool parseOptions (int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--quick")
+            gOptions.quick = true;
+        else if (arg == "--json" && i + 1 < argc)
+            gOptions.jsonPath = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc)
+            gOptions.filter = argv[++i];
+        else
+        {
+            std::fprintf (stderr, "usage: unravel_bench [--quick] [--json file] [--filter text]\n");
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    if (! parseOptions (argc, argv))
+        return 2;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    benchStft (2048, 512);
+    benchStft (1024, 256);
+    benchUnits();
+
+    ChannelWorkerPool pool;
+    pool.prepare (3);
+    const Layout layouts[] = {
+        { 1, false, 0 },
+        { 2, false, 0 },
+        { 2, true,  0 },
+        { 6, false, 0 },
+        { 6, false, 3 },
+        { 2, false, 0, true },
+        { 2, false, 0, false, true },
+        { 1, false, 0, false, false, true },
+        { 2, true,  0, false, false, true },
+        { 2, false, 0, false, false, false, QualityGovernor::Tier::NoLowFreqTracker },
+        { 2, false, 0, false, false, false, QualityGovernor::Tier::ShortVerticalMedian },
+        { 2, false, 0, false, false, false, QualityGovernor::Tier::DecimatedMasks },
+    };
+    for (int blockSize : { 32, 64, 128, 512, 2048 })
+        for (const auto& layout : layouts)
+            benchProcessBlock (blockSize, layout, pool);
+    pool.release();
+
+    benchStemSplit (StemSplit::Standalone);
+    benchStemSplit (StemSplit::Shared);
+    benchStemSplit (StemSplit::Buses);
+
+    printTable();
+
+    if (gOptions.jsonPath.empty())
+    {
+        writeJson (stdout);
+        return 0;
+    }
+
+    std::FILE* file = std::fopen (gOptions.jsonPath.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::fprintf (stderr, "unravel_bench: cannot write %s\n", gOptions.jsonPath.c_str());
+        return 1;
+    }
+    writeJson (file);
+    std::fclose (file);
+    return 0;
+}
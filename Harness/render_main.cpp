@@ -0,0 +1,248 @@
+// =============================================================================
+// unravel_render — offline / batch HPSS renderer
+// =============================================================================
+// Renders audio files through OfflineHPSSRenderer: whole-file analysis,
+// centred (lag-free) horizontal medians, frames split across every core, and
+// output aligned with the input (no plugin latency to compensate). Intended
+// for library batch jobs (e.g. Soundminer "process with" chains) where
+// throughput matters and latency does not.
+//
+// Parameters take the plugin's units and go through the same corner
+// compensation as PluginProcessor::updateParameters(), so a render matches
+// the plugin at the same settings (apart from the centred medians).
+//
+//   unravel_render [options] <input>...
+//     --tonal <dB>         Tonal gain, -60..12 (default 0; -60 = off)
+//     --noise <dB>         Noise gain (default 0)
+//     --transient <dB>     Transient gain (default 0)
+//     --separation <%>     0..100 (default 85)
+//     --focus <value>      -100 (tonal) .. +100 (noise) (default 0)
+//     --floor <%>          Spectral floor, 0..100 (default 0)
+//     --link               Stereo Link: one mask set for all channels
+//     --low-latency        1024/256 STFT instead of the plugin's 2048/512
+//     --overlap <%>        Frame overlap: 50, 75 (default) or 87.5
+//     --no-limit           Disable the -1 dB safety limiter
+//     --silence-gate <dB>  Hold masks below this peak-bin level, skip digital
+//                          silence (default -100, as the plugin)
+//     --no-gate            Estimate and resynthesise every frame
+//     --threads <n>        Threads including this one (default: all cores)
+//     --out-dir <dir>      Write <name>.wav there (default: <name>_unravel.wav
+//                          next to each input)
+//
+// Output is WAV at the input's sample rate and bit depth (16/24/32-bit float),
+// with the input's metadata carried over.
+// =============================================================================
+
+#include <JuceHeader.h>
+#include "OfflineHPSSRenderer.h"
+#include "ChannelWorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+
+namespace
+{
+float dbToLinear (float db) noexcept { return db <= -60.0f ? 0.0f : std::pow (10.0f, db / 20.0f); }
+
+struct Options
+{
+    float tonalDb = 0.0f, noiseDb = 0.0f, transientDb = 0.0f;
+    float separationPct = 85.0f, focus = 0.0f, floorPct = 0.0f, overlapPct = 75.0f;
+    float gateDb = SilenceGate::kDefaultThresholdDb;
+    bool link = false, lowLatency = false, noLimit = false, noGate = false;
+    int threads = 0;
+    juce::File outDir;
+    juce::Array<juce::File> inputs;
+};
+
+void printUsage()
+{
+    std::printf ("usage: unravel_render [--tonal dB] [--noise dB] [--transient dB] [--separation %%]\n"
+                 "                      [--focus -100..100] [--floor %%] [--link] [--low-latency]\n"
+                 "                      [--overlap 50|75|87.5] [--no-limit] [--silence-gate dB] [--no-gate]\n"
+                 "                      [--threads n] [--out-dir dir] <input>...\n");
+}
+
+bool parseOptions (const juce::StringArray& args, Options& options)
+{
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        auto value = [&] (float& target)
+        {
+            if (i + 1 >= args.size())
+                return false;
+            target = args[++i].getFloatValue();
+            return true;
+        };
+
+        bool ok = true;
+        if      (arg == "--tonal")       ok = value (options.tonalDb);
+        else if (arg == "--noise")       ok = value (options.noiseDb);
+        else if (arg == "--transient")   ok = value (options.transientDb);
+        else if (arg == "--separation")  ok = value (options.separationPct);
+        else if (arg == "--focus")       ok = value (options.focus);
+        else if (arg == "--floor")       ok = value (options.floorPct);
+        else if (arg == "--overlap")     ok = value (options.overlapPct)
+                                           && (options.overlapPct == 50.0f || options.overlapPct == 75.0f
+                                               || options.overlapPct == 87.5f);
+        else if (arg == "--silence-gate") ok = value (options.gateDb);
+        else if (arg == "--no-gate")     options.noGate = true;
+        else if (arg == "--link")        options.link = true;
+        else if (arg == "--low-latency") options.lowLatency = true;
+        else if (arg == "--no-limit")    options.noLimit = true;
+        else if (arg == "--threads" && i + 1 < args.size())
+            options.threads = args[++i].getIntValue();
+        else if (arg == "--out-dir" && i + 1 < args.size())
+            options.outDir = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+        else if (arg.startsWith ("--"))
+            ok = false;
+        else
+            options.inputs.add (juce::File::getCurrentWorkingDirectory().getChildFile (arg));
+
+        if (! ok)
+        {
+            std::fprintf (stderr, "unravel_render: bad option '%s'\n", arg.toRawUTF8());
+            return false;
+        }
+    }
+    return ! options.inputs.isEmpty();
+}
+
+// PluginProcessor::updateParameters() without solo/mute: transient tracks
+// min(tonal, noise), and pad asymmetry lifts the spectral floor.
+OfflineHPSSRenderer::Settings resolveSettings (const Options& options)
+{
+    OfflineHPSSRenderer::Settings settings;
+    settings.tonalGain     = dbToLinear (juce::jlimit (-60.0f, 12.0f, options.tonalDb));
+    settings.noiseGain     = dbToLinear (juce::jlimit (-60.0f, 12.0f, options.noiseDb));
+    settings.transientGain = dbToLinear (juce::jlimit (-60.0f, 12.0f, options.transientDb))
+                           * std::min ({ settings.tonalGain, settings.noiseGain, 1.0f });
+
+    const float maxPadGain = std::max (settings.tonalGain, settings.noiseGain);
+    float cornerFactor = 0.0f;
+    if (maxPadGain > 1e-9f)
+    {
+        const float asymmetry = 1.0f - std::min (settings.tonalGain, settings.noiseGain) / maxPadGain;
+        cornerFactor = asymmetry * asymmetry * asymmetry * asymmetry;
+    }
+
+    settings.separation    = juce::jlimit (0.0f, 1.0f, options.separationPct / 100.0f);
+    settings.focus         = juce::jlimit (-1.0f, 1.0f, options.focus / 100.0f);
+    settings.spectralFloor = std::max (juce::jlimit (0.0f, 1.0f, options.floorPct / 100.0f), cornerFactor);
+    settings.channelLink   = options.link ? HPSSProcessor::ChannelLink::Linked
+                                          : HPSSProcessor::ChannelLink::Independent;
+    settings.highQuality   = ! options.lowLatency;
+    settings.overlap       = options.overlapPct == 50.0f ? STFTProcessor::Overlap::Half
+                           : options.overlapPct == 87.5f ? STFTProcessor::Overlap::SevenEighths
+                                                         : STFTProcessor::Overlap::ThreeQuarters;
+    settings.safetyLimiting = ! options.noLimit;
+    settings.silenceGateDb = options.noGate ? SilenceGate::kDisabledDb : options.gateDb;
+    return settings;
+}
+
+juce::File outputFileFor (const juce::File& input, const Options& options)
+{
+    if (options.outDir != juce::File())
+        return options.outDir.getChildFile (input.getFileNameWithoutExtension() + ".wav");
+    return input.getSiblingFile (input.getFileNameWithoutExtension() + "_unravel.wav");
+}
+
+bool renderFile (const juce::File& input, const juce::File& output, juce::AudioFormatManager& formats,
+                 OfflineHPSSRenderer& renderer)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+    if (reader == nullptr)
+    {
+        std::fprintf (stderr, "unravel_render: cannot read %s\n", input.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    const int numChannels = static_cast<int> (reader->numChannels);
+    const auto length = reader->lengthInSamples;
+    if (numChannels <= 0 || length <= 0 || length > std::numeric_limits<int>::max())
+    {
+        std::fprintf (stderr, "unravel_render: unsupported length or layout: %s\n", input.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    const int numSamples = static_cast<int> (length);
+    juce::AudioBuffer<float> buffer (numChannels, numSamples);
+    reader->read (&buffer, 0, numSamples, 0, true, true);
+
+    const auto start = std::chrono::steady_clock::now();
+    renderer.render (buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(),
+                     numChannels, numSamples, reader->sampleRate);
+    const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+    const int bitsPerSample = reader->bitsPerSample <= 16 ? 16 : reader->bitsPerSample <= 24 ? 24 : 32;
+    output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (output.createOutputStream());
+    if (stream == nullptr)
+    {
+        std::fprintf (stderr, "unravel_render: cannot write %s\n", output.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), reader->sampleRate,
+                                                                          (unsigned int) numChannels, bitsPerSample,
+                                                                          reader->metadataValues, 0));
+    if (writer == nullptr)
+    {
+        std::fprintf (stderr, "unravel_render: cannot encode %s\n", output.getFullPathName().toRawUTF8());
+        return false;
+    }
+    stream.release(); // Owned by the writer from here on
+
+    writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+
+    const double duration = numSamples / reader->sampleRate;
+    std::printf ("%s -> %s  (%.1f s audio, %.2f s, %.0fx real time)\n",
+                 input.getFileName().toRawUTF8(), output.getFullPathName().toRawUTF8(),
+                 duration, seconds, seconds > 0.0 ? duration / seconds : 0.0);
+    return true;
+}
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    Options options;
+    if (! parseOptions (juce::StringArray (argv + 1, argc - 1), options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    if (options.outDir != juce::File() && ! options.outDir.createDirectory())
+    {
+        std::fprintf (stderr, "unravel_render: cannot create %s\n", options.outDir.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    // The calling thread takes part in every stage, so n threads = n - 1 workers.
+    const int threads = options.threads > 0 ? options.threads : juce::SystemStats::getNumCpus();
+    ChannelWorkerPool pool;
+    pool.prepare (std::max (0, threads - 1));
+
+    OfflineHPSSRenderer renderer;
+    renderer.setSettings (resolveSettings (options));
+    renderer.setWorkerPool (&pool);
+
+    int failures = 0;
+    for (const auto& input : options.inputs)
+        if (! renderFile (input, outputFileFor (input, options), formats, renderer))
+            ++failures;
+
+    pool.release();
+    return failures == 0 ? 0 : 1;
+}
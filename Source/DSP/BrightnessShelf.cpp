@@ -0,0 +1,178 @@
+#include "BrightnessShelf.h"
+#include <algorithm>
+#include <cmath>
+
+BrightnessShelf::Coefficients BrightnessShelf::design(double sampleRate, float gainDb) noexcept
+{
+    jassert(sampleRate > 0.0);
+
+    // RBJ cookbook high shelf, as makeHighShelf(), in double.
+    const double A = std::sqrt(std::pow(10.0, static_cast<double>(gainDb) / 20.0));
+    const double aMinus1 = A - 1.0;
+    const double aPlus1 = A + 1.0;
+    const double omega = 2.0 * juce::MathConstants<double>::pi * kFrequency / sampleRate;
+    const double cosOmega = std::cos(omega);
+    const double beta = std::sin(omega) * std::sqrt(A) / kQ;
+    const double aMinus1CosOmega = aMinus1 * cosOmega;
+
+    const double a0 = aPlus1 - aMinus1CosOmega + beta;
+    Coefficients k;
+    k.b0 = static_cast<float>(A * (aPlus1 + aMinus1CosOmega + beta) / a0);
+    k.b1 = static_cast<float>(A * -2.0 * (aMinus1 + aPlus1 * cosOmega) / a0);
+    k.b2 = static_cast<float>(A * (aPlus1 + aMinus1CosOmega - beta) / a0);
+    k.a1 = static_cast<float>(2.0 * (aMinus1 - aPlus1 * cosOmega) / a0);
+    k.a2 = static_cast<float>((aPlus1 - aMinus1CosOmega - beta) / a0);
+    return k;
+}
+
+void BrightnessShelf::prepare(double sampleRate, int maxChannels)
+{
+    jassert(maxChannels > 0);
+
+    table_.resize((size_t) kTableSize);
+    for (int i = 0; i < kTableSize; ++i)
+        table_[(size_t) i] = design(sampleRate, kMinDb + static_cast<float>(i) * kStepDb);
+
+    // The table's middle entry is the 0 dB shelf: make it the exact identity.
+    table_[(size_t) juce::roundToInt(-kMinDb / kStepDb)] = {};
+
+    state_.assign((size_t) maxChannels, {});
+    stateClear_ = true;
+    gain_.reset(sampleRate, kRampSeconds);
+}
+
+void BrightnessShelf::reset() noexcept
+{
+    std::fill(state_.begin(), state_.end(), State {});
+    stateClear_ = true;
+}
+
+void BrightnessShelf::setGainDb(float gainDb) noexcept
+{
+    gain_.setTargetValue(juce::jlimit(kMinDb, kMaxDb, gainDb));
+}
+
+void BrightnessShelf::snapGainDb(float gainDb) noexcept
+{
+    gain_.setCurrentAndTargetValue(juce::jlimit(kMinDb, kMaxDb, gainDb));
+}
+
+BrightnessShelf::Coefficients BrightnessShelf::getCoefficients(float gainDb) const noexcept
+{
+    jassert(! table_.empty());
+
+    const float position = (juce::jlimit(kMinDb, kMaxDb, gainDb) - kMinDb) / kStepDb;
+    const int index = std::min(static_cast<int>(position), kTableSize - 2);
+    const float frac = std::min(position - static_cast<float>(index), 1.0f);
+    const auto& lo = table_[(size_t) index];
+    const auto& hi = table_[(size_t) index + 1];
+    if (frac <= 0.0f)
+        return lo;
+
+    // Neighbouring shelves 0.1 dB apart: their coefficients are close
+    // enough for a straight blend to stay stable and monotonic in gain.
+    auto blend = [frac](float a, float b) noexcept { return a + (b - a) * frac; };
+    return { blend(lo.b0, hi.b0), blend(lo.b1, hi.b1), blend(lo.b2, hi.b2),
+             blend(lo.a1, hi.a1), blend(lo.a2, hi.a2) };
+}
+
+template <int NumChannels>
+void BrightnessShelf::filterGroup(float* const* channels, State* state, const Coefficients& k,
+                                  int start, int numSamples) noexcept
+{
+    float s1[NumChannels], s2[NumChannels];
+    float* data[NumChannels];
+    for (int c = 0; c < NumChannels; ++c)
+    {
+        s1[c] = state[c].s1;
+        s2[c] = state[c].s2;
+        data[c] = channels[c] + start;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int c = 0; c < NumChannels; ++c)
+        {
+            const float x = data[c][i];
+            const float y = k.b0 * x + s1[c];
+            s1[c] = k.b1 * x - k.a1 * y + s2[c];
+            s2[c] = k.b2 * x - k.a2 * y;
+            data[c][i] = y;
+        }
+    }
+
+    for (int c = 0; c < NumChannels; ++c)
+        state[c] = { s1[c], s2[c] };
+}
+
+void BrightnessShelf::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert(numChannels <= static_cast<int>(state_.size()));
+    numChannels = std::min(numChannels, static_cast<int>(state_.size()));
+
+    // Identity: one sample through it leaves both states at zero, which is
+    // where they are already, so skipping it changes nothing.
+    if (isIdentity())
+    {
+        if (! stateClear_)
+            reset();
+        return;
+    }
+    stateClear_ = false;
+
+    for (int start = 0; start < numSamples;)
+    {
+        // Settled: one coefficient set for the rest of the block.
+        const int length = gain_.isSmoothing() ? std::min(kSubBlock, numSamples - start) : numSamples - start;
+        const Coefficients k = getCoefficients(gain_.skip(length));
+
+        int channel = 0;
+        for (; channel + 4 <= numChannels; channel += 4)
+            filterGroup<4>(channels + channel, state_.data() + channel, k, start, length);
+        if (channel + 2 <= numChannels)
+        {
+            filterGroup<2>(channels + channel, state_.data() + channel, k, start, length);
+            channel += 2;
+        }
+        if (channel < numChannels)
+            filterGroup<1>(channels + channel, state_.data() + channel, k, start, length);
+
+        start += length;
+    }
+}
+
+void BrightnessShelf::prepareGrid(Grid& grid, double sampleRate, int fftSize, int numBins)
+{
+    jassert(sampleRate > 0.0 && fftSize > 0 && numBins > 0);
+    juce::ignoreUnused(sampleRate);
+
+    grid.cosW.resize((size_t) numBins);
+    grid.cos2W.resize((size_t) numBins);
+    for (int b = 0; b < numBins; ++b)
+    {
+        const double omega = 2.0 * juce::MathConstants<double>::pi * b / fftSize;
+        grid.cosW[(size_t) b] = static_cast<float>(std::cos(omega));
+        grid.cos2W[(size_t) b] = static_cast<float>(std::cos(2.0 * omega));
+    }
+}
+
+void BrightnessShelf::getMagnitudes(const Coefficients& k, const Grid& grid, float* out) noexcept
+{
+    // |B(e^jω)|² / |A(e^jω)|² with a0 = 1, expanded in cos ω and cos 2ω.
+    const float numC0 = k.b0 * k.b0 + k.b1 * k.b1 + k.b2 * k.b2;
+    const float numC1 = 2.0f * (k.b0 * k.b1 + k.b1 * k.b2);
+    const float numC2 = 2.0f * k.b0 * k.b2;
+    const float denC0 = 1.0f + k.a1 * k.a1 + k.a2 * k.a2;
+    const float denC1 = 2.0f * (k.a1 + k.a1 * k.a2);
+    const float denC2 = 2.0f * k.a2;
+
+    const int numBins = static_cast<int>(grid.cosW.size());
+    for (int b = 0; b < numBins; ++b)
+    {
+        const float c1 = grid.cosW[(size_t) b];
+        const float c2 = grid.cos2W[(size_t) b];
+        const float num = numC0 + numC1 * c1 + numC2 * c2;
+        const float den = denC0 + denC1 * c1 + denC2 * c2;
+        out[b] = std::sqrt(std::max(num, 0.0f) / std::max(den, 1e-12f));
+    }
+}
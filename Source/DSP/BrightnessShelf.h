@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/**
+ * BrightnessShelf - the post-separation treble shelf, all channels at once
+ *
+ * A second-order high shelf at 4 kHz (Q 0.707, the RBJ design that
+ * juce::dsp::IIR::Coefficients::makeHighShelf() builds), -12 to +12 dB.
+ * One instance filters every channel of the bus, in transposed direct
+ * form II with the coefficients held in registers: channels are run in
+ * groups of four sample-interleaved, so four independent recursions share
+ * the pipeline instead of one channel's feedback chain setting the pace.
+ *
+ * The gain ramps linearly over 20 ms. While it moves, the coefficients are
+ * interpolated between neighbouring entries of a 0.1 dB table every
+ * kSubBlock samples, so automation glides instead of stepping once per
+ * host block. Settled at 0 dB the shelf is the identity and process()
+ * returns without touching the audio.
+ *
+ * getMagnitudes() evaluates the same shelf's magnitude response on an FFT
+ * grid, for folding the shelf into a spectral gain instead
+ * (HPSSProcessor::setSpectralBrightness()).
+ *
+ * RT-safety: prepare() allocates; everything else is allocation-free.
+ */
+class BrightnessShelf
+{
+public:
+    static constexpr float kFrequency = 4000.0f;
+    static constexpr float kQ = 0.707f;
+    static constexpr float kMinDb = -12.0f;
+    static constexpr float kMaxDb = 12.0f;
+    static constexpr float kStepDb = 0.1f;          ///< Coefficient table spacing
+    static constexpr int kTableSize = 241;          ///< (24 dB / 0.1 dB) + 1, -12 … +12 inclusive
+    static constexpr int kSubBlock = 32;            ///< Samples per coefficient update while ramping
+    static constexpr double kRampSeconds = 0.02;
+
+    /** Biquad coefficients, normalised by a0. */
+    struct Coefficients
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    /** The shelf at a gain, designed directly (no table). */
+    static Coefficients design(double sampleRate, float gainDb) noexcept;
+
+    BrightnessShelf() = default;
+
+    /**
+     * Build the coefficient table and the per-channel state (allocates).
+     * @param sampleRate  Sample rate
+     * @param maxChannels Most channels process() will be given
+     */
+    void prepare(double sampleRate, int maxChannels);
+
+    /** Clear the filter state (the gain is kept). */
+    void reset() noexcept;
+
+    /** Gain to ramp to, in dB (clamped to kMinDb … kMaxDb). */
+    void setGainDb(float gainDb) noexcept;
+
+    /** Jump to a gain with no ramp. */
+    void snapGainDb(float gainDb) noexcept;
+
+    float getGainDb() const noexcept { return gain_.getCurrentValue(); }
+
+    /** Settled at 0 dB: process() leaves the audio alone. */
+    bool isIdentity() const noexcept { return ! gain_.isSmoothing() && gain_.getTargetValue() == 0.0f; }
+
+    /** Table coefficients at a gain (interpolated between 0.1 dB steps). */
+    Coefficients getCoefficients(float gainDb) const noexcept;
+
+    /**
+     * Filter a block in place, advancing the ramp.
+     * @param channels    Per-channel sample pointers
+     * @param numChannels <= the prepared maxChannels
+     * @param numSamples  Samples per channel
+     */
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /**
+     * Magnitude response on an FFT grid: out[b] = |H| at b × sampleRate /
+     * fftSize. Uses the cosine tables prepareGrid() built for the grid.
+     */
+    struct Grid
+    {
+        std::vector<float> cosW;        ///< cos(ω) per bin
+        std::vector<float> cos2W;       ///< cos(2ω) per bin
+    };
+
+    /** Cosine tables for a grid of numBins bins of an fftSize FFT (allocates). */
+    static void prepareGrid(Grid& grid, double sampleRate, int fftSize, int numBins);
+
+    /** |H| of a coefficient set over a prepared grid. */
+    static void getMagnitudes(const Coefficients& coefficients, const Grid& grid, float* out) noexcept;
+
+private:
+    struct State
+    {
+        float s1 = 0.0f, s2 = 0.0f;
+    };
+
+    template <int NumChannels>
+    static void filterGroup(float* const* channels, State* state, const Coefficients& k,
+                            int start, int numSamples) noexcept;
+
+    std::vector<Coefficients> table_;               ///< kTableSize entries, kMinDb upwards
+    std::vector<State> state_;                      ///< One per channel
+    juce::SmoothedValue<float> gain_;
+    bool stateClear_ = true;                        ///< Every state is zero (the identity's steady state)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BrightnessShelf)
+};
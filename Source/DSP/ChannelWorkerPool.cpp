@@ -0,0 +1,304 @@
+#include "ChannelWorkerPool.h"
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+ #include <immintrin.h>
+#endif
+
+#if defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+ #include <time.h>
+#endif
+
+namespace
+{
+    /** Spin-wait hint: lets the sibling hyperthread run and saves power. */
+    inline void cpuRelax() noexcept
+    {
+       #if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+       #elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+       #endif
+    }
+
+    /**
+     * Counting semaphore a worker parks on. Signalling takes no lock: it is
+     * an atomic increment, plus a kernel wake only when the worker is
+     * actually asleep (glibc sem_post and dispatch_semaphore_signal both
+     * skip the syscall otherwise; Windows' ReleaseSemaphore is always one
+     * call, but never a user-mode lock). So the audio thread never waits on
+     * a mutex a worker could hold, as juce::Thread::notify()'s
+     * WaitableEvent would make it.
+     */
+    class WakeSemaphore
+    {
+    public:
+       #if defined(__APPLE__)
+        WakeSemaphore() : semaphore(dispatch_semaphore_create(0)) {}
+        ~WakeSemaphore() { dispatch_release(semaphore); }
+        void signal() noexcept { dispatch_semaphore_signal(semaphore); }
+        void wait(int milliseconds) noexcept
+        {
+            dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t) milliseconds * 1000000));
+        }
+       #elif defined(_WIN32)
+        WakeSemaphore() : semaphore(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+        ~WakeSemaphore() { CloseHandle(semaphore); }
+        void signal() noexcept { ReleaseSemaphore(semaphore, 1, nullptr); }
+        void wait(int milliseconds) noexcept { WaitForSingleObject(semaphore, (DWORD) milliseconds); }
+       #else
+        WakeSemaphore() { sem_init(&semaphore, 0, 0); }
+        ~WakeSemaphore() { sem_destroy(&semaphore); }
+        void signal() noexcept { sem_post(&semaphore); }
+        void wait(int milliseconds) noexcept
+        {
+            timespec deadline {};
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += milliseconds / 1000;
+            deadline.tv_nsec += (long) (milliseconds % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            sem_timedwait(&semaphore, &deadline);     // A timeout or EINTR just re-checks
+        }
+       #endif
+
+    private:
+       #if defined(__APPLE__)
+        dispatch_semaphore_t semaphore;
+       #elif defined(_WIN32)
+        HANDLE semaphore;
+       #else
+        sem_t semaphore;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+    };
+}
+
+//==============================================================================
+class ChannelWorkerPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker(ChannelWorkerPool& owner)
+        : juce::Thread("Unravel channel worker"), pool(owner)
+    {
+    }
+
+    ~Worker() override { stopThread(1000); }
+
+    /** Wake the worker if it has parked (lock-free; see WakeSemaphore). */
+    void wake() noexcept
+    {
+        if (parked.load(std::memory_order_seq_cst))
+            parking.signal();
+    }
+
+    /** Ask the thread to exit, waking it from its park at once. */
+    void requestExit() noexcept
+    {
+        signalThreadShouldExit();
+        parking.signal();
+    }
+
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+        uint32_t seen = pool.generation_.load(std::memory_order_acquire);
+
+        while (! threadShouldExit())
+        {
+            updateWorkgroupMembership();
+
+            const uint32_t gen = pool.generation_.load(std::memory_order_acquire);
+            if (gen != seen)
+            {
+                seen = gen;
+                pool.drain(gen);
+                continue;
+            }
+
+            if (spinForNextBatch(seen))
+                continue;
+
+            // Park. Publish parked before the final re-check so that run()
+            // either sees parked (and signals) or we see its new generation.
+            // A signal left over from an earlier wake only costs one more
+            // turn round the loop.
+            parked.store(true, std::memory_order_seq_cst);
+            if (pool.generation_.load(std::memory_order_seq_cst) == seen && ! threadShouldExit())
+                parking.wait(100);
+            parked.store(false, std::memory_order_relaxed);
+        }
+
+       #if UNRAVEL_HAS_AUDIO_WORKGROUP
+        token.reset();
+       #endif
+    }
+
+    std::atomic<bool> parked { false };
+
+private:
+    /** Spin for up to kSpinMicroseconds; true if a new batch arrived. */
+    bool spinForNextBatch(uint32_t seen) const noexcept
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::microseconds(kSpinMicroseconds);
+        do
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                if (pool.generation_.load(std::memory_order_acquire) != seen)
+                    return true;
+                cpuRelax();
+            }
+        }
+        while (Clock::now() < deadline && ! threadShouldExit());
+        return false;
+    }
+
+    void updateWorkgroupMembership()
+    {
+       #if UNRAVEL_HAS_AUDIO_WORKGROUP
+        const uint32_t version = pool.workgroupVersion_.load(std::memory_order_acquire);
+        if (version == joinedVersion)
+            return;
+
+        joinedVersion = version;
+        token.reset();
+        juce::AudioWorkgroup workgroup;
+        {
+            const juce::SpinLock::ScopedLockType lock(pool.workgroupLock_);
+            workgroup = pool.workgroup_;
+        }
+        if (workgroup)
+            workgroup.join(token);
+       #endif
+    }
+
+    ChannelWorkerPool& pool;
+    WakeSemaphore parking;
+
+   #if UNRAVEL_HAS_AUDIO_WORKGROUP
+    juce::WorkgroupToken token;
+    uint32_t joinedVersion = 0;
+   #endif
+};
+
+//==============================================================================
+ChannelWorkerPool::ChannelWorkerPool() = default;
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    release();
+}
+
+void ChannelWorkerPool::prepare(int numWorkers)
+{
+    release();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>(*this));
+       #if UNRAVEL_HAS_AUDIO_WORKGROUP
+        workers_.back()->startRealtimeThread(juce::Thread::RealtimeOptions{});
+       #else
+        workers_.back()->startThread(juce::Thread::Priority::highest);
+       #endif
+    }
+}
+
+void ChannelWorkerPool::release()
+{
+    for (auto& worker : workers_)
+        worker->requestExit();
+    for (auto& worker : workers_)
+        worker->stopThread(1000);
+    workers_.clear();
+}
+
+void ChannelWorkerPool::run(int numTasks, Task task, void* context) noexcept
+{
+    jassert(task != nullptr);
+    jassert(numTasks <= kMaxTasks);
+    if (numTasks <= 0)
+        return;
+
+    if (workers_.empty() || numTasks == 1)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task(context, i);
+        return;
+    }
+
+    // Publish the batch: fields first, then the claim word that makes the
+    // tasks claimable, then the generation that wakes the workers.
+    const uint32_t gen = generation_.load(std::memory_order_relaxed) + 1;
+    task_.store(task, std::memory_order_relaxed);
+    context_.store(context, std::memory_order_relaxed);
+    remaining_.store(numTasks, std::memory_order_relaxed);
+    claim_.store(packClaim(gen, static_cast<uint32_t>(numTasks), 0), std::memory_order_release);
+    generation_.store(gen, std::memory_order_seq_cst);
+
+    // Wake only as many workers as there are tasks beyond our own share.
+    const int helpers = std::min(getNumWorkers(), numTasks - 1);
+    for (int i = 0; i < helpers; ++i)
+        workers_[(size_t) i]->wake();
+
+    // Work on the batch ourselves; anything no worker claimed runs here.
+    drain(gen);
+
+    // Only tasks a worker has already started can be outstanding.
+    while (remaining_.load(std::memory_order_acquire) > 0)
+        cpuRelax();
+}
+
+void ChannelWorkerPool::drain(uint32_t gen) noexcept
+{
+    for (;;)
+    {
+        uint64_t claim = claim_.load(std::memory_order_acquire);
+        uint32_t index = 0;
+        for (;;)
+        {
+            if (static_cast<uint32_t>(claim >> 32) != gen)
+                return;                                 // A newer batch (or none) is live
+            index = static_cast<uint32_t>(claim) & 0xffffu;
+            if (index >= ((static_cast<uint32_t>(claim) >> 16) & 0xffffu))
+                return;                                 // Every task is claimed
+            if (claim_.compare_exchange_weak(claim, claim + 1,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+                break;
+        }
+
+        // A claimed task keeps its batch live (remaining_ > 0), so the batch
+        // fields cannot change until it is finished.
+        task_.load(std::memory_order_relaxed)(context_.load(std::memory_order_relaxed),
+                                              static_cast<int>(index));
+        remaining_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+#if UNRAVEL_HAS_AUDIO_WORKGROUP
+void ChannelWorkerPool::setAudioWorkgroup(const juce::AudioWorkgroup& workgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock_);
+        workgroup_ = workgroup;
+    }
+    workgroupVersion_.fetch_add(1, std::memory_order_release);
+    for (auto& worker : workers_)
+        worker->wake();
+}
+#endif
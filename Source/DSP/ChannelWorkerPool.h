@@ -0,0 +1,120 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// juce::AudioWorkgroup and Thread::startRealtimeThread arrived in JUCE 7.0.6.
+#if defined(JUCE_MAJOR_VERSION) \
+    && (JUCE_MAJOR_VERSION > 7 || (JUCE_MAJOR_VERSION == 7 && (JUCE_MINOR_VERSION > 0 || JUCE_BUILDNUMBER >= 6)))
+ #define UNRAVEL_HAS_AUDIO_WORKGROUP 1
+#else
+ #define UNRAVEL_HAS_AUDIO_WORKGROUP 0
+#endif
+
+/**
+ * ChannelWorkerPool - fans per-channel work out to pre-spawned worker threads
+ *
+ * Used by HPSSProcessor to process the channels of a wide bus (5.1 / 7.1 /
+ * 12-channel beds) concurrently instead of one after another on the host's
+ * audio thread. The audio thread publishes a batch of numTasks indexed
+ * tasks, works on the batch itself, and returns once every task has run;
+ * workers help by claiming tasks from the same batch.
+ *
+ * Real-time behaviour:
+ * - Threads are spawned in prepare() and joined in release(); run() never
+ *   allocates, creates threads, or takes a lock while workers are awake.
+ * - Hand-off is a single atomic claim word (generation | count | next index), so a
+ *   task is only ever run once, by whichever thread claims it first. The
+ *   calling thread claims tasks too: if no worker wakes in time, the whole
+ *   batch simply runs inline on the audio thread (the serial behaviour),
+ *   and the caller only ever waits for tasks a worker has already started.
+ * - After a batch, workers spin for a bounded window (kSpinMicroseconds)
+ *   watching for the next one, then park on a semaphore whose signal takes
+ *   no lock (POSIX sem_post, dispatch_semaphore_signal, ReleaseSemaphore).
+ *   Waking a parked worker costs an atomic and one kernel wake; a worker
+ *   still spinning is woken with no syscall. The audio thread never waits
+ *   on a mutex, so a descheduled worker cannot hold it up.
+ * - Where the host provides an audio workgroup (macOS, JUCE >= 7.0.6) the
+ *   workers join it, so the OS schedules them as part of the audio deadline.
+ *
+ * Tasks must be noexcept and must not block. Each worker installs its own
+ * juce::ScopedNoDenormals, matching the audio thread's FTZ/DAZ state.
+ */
+class ChannelWorkerPool
+{
+public:
+    /** A batch task: called once per index in [0, numTasks). */
+    using Task = void (*)(void* context, int taskIndex) noexcept;
+
+    ChannelWorkerPool();
+    ~ChannelWorkerPool();
+
+    /**
+     * Spawn the worker threads (non-real-time). Replaces any previous set.
+     * @param numWorkers Threads besides the calling thread (0 = run inline)
+     */
+    void prepare(int numWorkers);
+
+    /** Stop and join all workers (non-real-time). */
+    void release();
+
+    /** Number of worker threads (the calling thread is not counted). */
+    int getNumWorkers() const noexcept { return static_cast<int>(workers_.size()); }
+
+    /**
+     * Run task(context, i) for every i in [0, numTasks) and return when all
+     * have finished. RT-safe. Must only be called from one thread at a time.
+     * @param numTasks Task count, at most kMaxTasks
+     */
+    void run(int numTasks, Task task, void* context) noexcept;
+
+   #if UNRAVEL_HAS_AUDIO_WORKGROUP
+    /**
+     * Make the workers join the host's audio workgroup (or leave it, for a
+     * default-constructed one). Workers pick the change up before their next
+     * batch; safe to call from any thread.
+     */
+    void setAudioWorkgroup(const juce::AudioWorkgroup& workgroup);
+   #endif
+
+    /** Largest batch run() accepts (the count shares the claim word). */
+    static constexpr int kMaxTasks = 0xffff;
+
+    /** Worker spin window after a batch before parking, in microseconds. */
+    static constexpr int kSpinMicroseconds = 200;
+
+private:
+    class Worker;
+
+    /** Claim and run tasks of generation gen until none are left. */
+    void drain(uint32_t gen) noexcept;
+
+    // Claim word: generation (32 bits) | task count (16) | next index (16).
+    // Carrying the count means a stale worker can never validate an index
+    // against another batch's count.
+    static uint64_t packClaim(uint32_t gen, uint32_t count, uint32_t index) noexcept
+    {
+        return (static_cast<uint64_t>(gen) << 32) | (static_cast<uint64_t>(count) << 16) | index;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // Current batch. Written by run() before the release-store of claim_
+    // and only read after a successful claim, which keeps the batch live.
+    std::atomic<Task> task_ { nullptr };
+    std::atomic<void*> context_ { nullptr };
+
+    std::atomic<uint64_t> claim_ { 0 };          ///< See packClaim()
+    std::atomic<uint32_t> generation_ { 0 };     ///< Last published batch
+    std::atomic<int> remaining_ { 0 };           ///< Tasks of the current batch not yet finished
+
+   #if UNRAVEL_HAS_AUDIO_WORKGROUP
+    juce::SpinLock workgroupLock_;
+    juce::AudioWorkgroup workgroup_;
+    std::atomic<uint32_t> workgroupVersion_ { 0 };
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelWorkerPool)
+};
@@ -0,0 +1,55 @@
+#include "DspArena.h"
+#include <cstring>
+#include <new>
+
+DspArena::~DspArena()
+{
+    // Only the block: the buffers may already be gone (they are usually
+    // members declared after the arena).
+    if (block_ != nullptr)
+        ::operator delete(block_, std::align_val_t(kAlignment));
+}
+
+void DspArena::clear() noexcept
+{
+    for (auto& entry : entries_)
+    {
+        entry.buffer->data_ = nullptr;
+        entry.buffer->size_ = 0;
+    }
+    entries_.clear();
+
+    if (block_ != nullptr)
+        ::operator delete(block_, std::align_val_t(kAlignment));
+    block_ = nullptr;
+    numBytes_ = 0;
+}
+
+void DspArena::addEntry(BufferBase& buffer, size_t bytes, size_t count)
+{
+    jassert(block_ == nullptr);     // clear() before laying out again
+
+    const size_t offset = (numBytes_ + kAlignment - 1) / kAlignment * kAlignment;
+    entries_.push_back({ &buffer, offset, count });
+    numBytes_ = offset + bytes;
+}
+
+void DspArena::allocate()
+{
+    jassert(block_ == nullptr);
+
+    // Round the end up too, so the last buffer's tail shares no cache line
+    // with whatever the allocator puts next.
+    numBytes_ = (numBytes_ + kAlignment - 1) / kAlignment * kAlignment;
+    if (numBytes_ == 0)
+        return;
+
+    block_ = static_cast<std::byte*>(::operator new(numBytes_, std::align_val_t(kAlignment)));
+    std::memset(block_, 0, numBytes_);
+
+    for (auto& entry : entries_)
+    {
+        entry.buffer->data_ = entry.count > 0 ? block_ + entry.offset : nullptr;
+        entry.buffer->size_ = entry.count;
+    }
+}
@@ -0,0 +1,125 @@
+#include "DspProfiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DspProfiler
+{
+const char* getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::ForwardFFT:         return "Forward FFT";
+        case Stage::Magnitudes:         return "Magnitudes";
+        case Stage::Medians:            return "Medians";
+        case Stage::FluxFlatness:       return "Flux / flatness";
+        case Stage::LowFreqTracker:     return "Low-freq tracker";
+        case Stage::MaskPostProcessing: return "Masks";
+        case Stage::GainApplication:    return "Gain application";
+        case Stage::InverseFFT:         return "Inverse FFT";
+        case Stage::NumStages:          break;
+    }
+    return "";
+}
+
+//==============================================================================
+Ring::Ring() noexcept
+    : originTicks_(readTicks()),
+      originHighResTicks_(juce::Time::getHighResolutionTicks())
+{
+}
+
+void Ring::push(const BlockRecord& record) noexcept
+{
+    // Single writer: written_ is only ever stored by this thread.
+    const uint64_t index = written_.load(std::memory_order_relaxed);
+    auto& slot = slots_[static_cast<size_t>(index % kCapacity)];
+
+    slot.sequence.fetch_add(1, std::memory_order_relaxed);  // -> odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = record;
+    slot.record.index = index;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sequence.fetch_add(1, std::memory_order_release);  // -> even: stable
+
+    written_.store(index + 1, std::memory_order_release);
+}
+
+int Ring::read(uint64_t& cursor, BlockRecord* out, int maxRecords) const noexcept
+{
+    const uint64_t written = written_.load(std::memory_order_acquire);
+
+    // Anything older than one ring's worth has been overwritten.
+    if (written - cursor > static_cast<uint64_t>(kCapacity))
+        cursor = written - static_cast<uint64_t>(kCapacity);
+
+    int count = 0;
+    for (; cursor < written && count < maxRecords; ++cursor)
+    {
+        const auto& slot = slots_[static_cast<size_t>(cursor % kCapacity)];
+        const uint32_t s1 = slot.sequence.load(std::memory_order_acquire);
+        if (s1 & 1u)
+            continue;                                       // Being rewritten: the writer lapped us
+
+        out[count] = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != s1 || out[count].index != cursor)
+            continue;                                       // Torn, or already a newer record
+
+        ++count;
+    }
+    return count;
+}
+
+//==============================================================================
+bool LoadMeter::update(const Ring& ring) noexcept
+{
+    bool any = false;
+    for (;;)
+    {
+        const int count = ring.read(cursor_, batch_.data(), kBatch);
+        if (count == 0)
+            break;
+        any = true;
+
+        // Tick rate from the newest record's stamps against the ring's origin.
+        // Wait for 50 ms of history so the high-res clock's granularity
+        // doesn't show in the ratio; it only gets more accurate from there.
+        const auto& newest = batch_[(size_t) count - 1];
+        const double highResPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const double elapsed = static_cast<double>(newest.endHighResTicks - ring.getOriginHighResTicks())
+                             / highResPerSecond;
+        if (elapsed >= 0.05)
+            ticksPerSecond_ = static_cast<double>(newest.endTicks - ring.getOriginTicks()) / elapsed;
+
+        if (ticksPerSecond_ <= 0.0)
+            continue;
+
+        const double microsecondsPerTick = 1.0e6 / ticksPerSecond_;
+        for (int i = 0; i < count; ++i)
+        {
+            const auto& record = batch_[(size_t) i];
+            if (record.numSamples <= 0 || record.sampleRate <= 0.0)
+                continue;
+
+            const double audioSeconds = record.numSamples / record.sampleRate;
+            const double blockMicroseconds = static_cast<double>(record.blockTicks) * microsecondsPerTick;
+            const float load = static_cast<float>(blockMicroseconds * 1.0e-4 / audioSeconds);
+            peakLoadPercent_ = std::max(peakLoadPercent_, load);
+
+            // One-pole average with a ~0.5 s (of audio) time constant,
+            // independent of the host block size.
+            const float alpha = hasAverage_ ? static_cast<float>(1.0 - std::exp(-audioSeconds / 0.5)) : 1.0f;
+            hasAverage_ = true;
+
+            loadPercent_ += alpha * (load - loadPercent_);
+            blockMicroseconds_ += alpha * (static_cast<float>(blockMicroseconds) - blockMicroseconds_);
+            for (size_t s = 0; s < stageMicroseconds_.size(); ++s)
+            {
+                const float stage = static_cast<float>(static_cast<double>(record.stageTicks[s]) * microsecondsPerTick);
+                stageMicroseconds_[s] += alpha * (stage - stageMicroseconds_[s]);
+            }
+        }
+    }
+    return any;
+}
+}
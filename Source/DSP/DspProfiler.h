@@ -0,0 +1,237 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+ #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+#endif
+
+// Per-stage DSP timing (off by default; the CMake option UNRAVEL_DSP_PROFILING
+// turns it on). When off, UNRAVEL_PROFILE_STAGE expands to nothing and the
+// engine carries no timing code at all.
+#ifndef UNRAVEL_DSP_PROFILING
+ #define UNRAVEL_DSP_PROFILING 0
+#endif
+
+/**
+ * DspProfiler - per-stage cycle counts and real-time load for the DSP engine
+ *
+ * Three pieces, all lock-free and allocation-free on the audio side:
+ *
+ * - Accumulator: per-stage tick totals and call counts. One per channel lane,
+ *   written only by the thread running that lane (UNRAVEL_PROFILE_STAGE), so
+ *   worker threads never share one. HPSSProcessor folds its lanes into a
+ *   BlockRecord after every block (collectStageTicks()).
+ * - Ring: single-producer / single-consumer history of BlockRecords. The
+ *   audio thread pushes one record per block; the UI thread reads the new
+ *   ones. Each slot is a seqlock (even sequence = stable, odd = write in
+ *   progress), like the plugin's spectrum snapshot, so the writer is
+ *   wait-free and the reader just drops a record overwritten mid-copy.
+ * - LoadMeter: UI-side reduction of the ring to a load percentage (time spent
+ *   in processBlock over the real time the block represents) and average
+ *   per-stage microseconds per block.
+ *
+ * Ticks are the CPU's cheapest monotonic counter: the TSC on x86 (constant
+ * rate "reference cycles" on any CPU of the last decade), CNTVCT_EL0 on arm64,
+ * juce::Time high-resolution ticks elsewhere. Their rate is calibrated on the
+ * reader side against juce::Time from the records' end stamps, so nothing on
+ * the audio thread needs to know it.
+ */
+namespace DspProfiler
+{
+    /** Timed stages of one STFT frame, in pipeline order. */
+    enum class Stage
+    {
+        ForwardFFT,           ///< Window + forward FFT (STFTProcessor)
+        Magnitudes,           ///< Complex → magnitude (MagPhaseFrame)
+        Medians,              ///< Horizontal + vertical median guides
+        FluxFlatness,         ///< Spectral flux and flatness
+        LowFreqTracker,       ///< LowFreqPartialTracker::process
+        MaskPostProcessing,   ///< Wiener masks, smoothing, floor, blur, 3-way split
+        GainApplication,      ///< Stream gains → per-bin gain → complex bins
+        InverseFFT,           ///< Inverse FFT + synthesis window + overlap-add
+        NumStages
+    };
+
+    static constexpr int kNumStages = static_cast<int>(Stage::NumStages);
+
+    /** Short display name of a stage ("Forward FFT", ...). */
+    const char* getStageName(Stage stage) noexcept;
+
+    /** Current value of the profiling tick counter. */
+    inline uint64_t readTicks() noexcept
+    {
+       #if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return static_cast<uint64_t>(__rdtsc());
+       #elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+        uint64_t value;
+        __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+       #else
+        return static_cast<uint64_t>(juce::Time::getHighResolutionTicks());
+       #endif
+    }
+
+    /** Per-stage tick totals and call counts since the last clear(). */
+    struct Accumulator
+    {
+        std::array<uint64_t, kNumStages> ticks {};
+        std::array<uint32_t, kNumStages> calls {};
+
+        void add(Stage stage, uint64_t elapsed) noexcept
+        {
+            ticks[static_cast<size_t>(stage)] += elapsed;
+            ++calls[static_cast<size_t>(stage)];
+        }
+
+        void clear() noexcept
+        {
+            ticks.fill(0);
+            calls.fill(0);
+        }
+    };
+
+    /** Times its scope into an Accumulator (nullptr = no-op). */
+    class ScopedStage
+    {
+    public:
+        ScopedStage(Accumulator* accumulator, Stage stage) noexcept
+            : accumulator_(accumulator), stage_(stage), start_(accumulator != nullptr ? readTicks() : 0)
+        {
+        }
+
+        ~ScopedStage()
+        {
+            if (accumulator_ != nullptr)
+                accumulator_->add(stage_, readTicks() - start_);
+        }
+
+    private:
+        Accumulator* accumulator_;
+        Stage stage_;
+        uint64_t start_;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    /** One processBlock call. */
+    struct BlockRecord
+    {
+        uint64_t index = 0;                             ///< Position in the ring's history (set by push())
+        uint64_t blockTicks = 0;                        ///< Whole callback, in ticks
+        std::array<uint64_t, kNumStages> stageTicks {}; ///< Summed over channels and frames
+        uint64_t endTicks = 0;                          ///< readTicks() at the end of the block
+        int64_t endHighResTicks = 0;                    ///< juce::Time high-res ticks, same instant
+        int numSamples = 0;
+        int numChannels = 0;
+        int numFrames = 0;                              ///< STFT frames across all channels
+        double sampleRate = 0.0;
+    };
+
+    /**
+     * SPSC ring of the most recent BlockRecords (see namespace comment).
+     * push() is wait-free and RT-safe; read() may be called from one other
+     * thread at a time.
+     */
+    class Ring
+    {
+    public:
+        static constexpr int kCapacity = 128;
+
+        Ring() noexcept;
+
+        /** Audio thread: publish a record (its index is assigned here). */
+        void push(const BlockRecord& record) noexcept;
+
+        /**
+         * Reader thread: copy out records published since `cursor`, oldest
+         * first, and advance the cursor. Records the writer has already
+         * overwritten (reader more than kCapacity behind, or a slot rewritten
+         * mid-copy) are skipped.
+         * @return Number of records written to out
+         */
+        int read(uint64_t& cursor, BlockRecord* out, int maxRecords) const noexcept;
+
+        /** Records pushed so far. */
+        uint64_t getNumWritten() const noexcept { return written_.load(std::memory_order_acquire); }
+
+        /** Tick / high-res tick pair taken at construction (rate calibration origin). */
+        uint64_t getOriginTicks() const noexcept { return originTicks_; }
+        int64_t getOriginHighResTicks() const noexcept { return originHighResTicks_; }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint32_t> sequence { 0 };
+            BlockRecord record;
+        };
+
+        std::array<Slot, kCapacity> slots_;
+        std::atomic<uint64_t> written_ { 0 };
+        const uint64_t originTicks_;
+        const int64_t originHighResTicks_;
+
+        JUCE_DECLARE_NON_COPYABLE(Ring)
+    };
+
+    /**
+     * UI-side summary of a Ring. update() folds in every new record; the
+     * figures are exponential averages (time constant ~0.5 s of audio) so a
+     * 30 Hz readout is steady, plus the worst single block since the last
+     * resetPeak().
+     */
+    class LoadMeter
+    {
+    public:
+        /** Read new records from the ring; returns false if there were none. */
+        bool update(const Ring& ring) noexcept;
+
+        /** Time in processBlock as a percentage of the audio it produced. */
+        float getLoadPercent() const noexcept { return loadPercent_; }
+
+        /** Largest single-block load since resetPeak(). */
+        float getPeakLoadPercent() const noexcept { return peakLoadPercent_; }
+
+        void resetPeak() noexcept { peakLoadPercent_ = 0.0f; }
+
+        /** Average microseconds per block spent in a stage (all channels). */
+        float getStageMicroseconds(Stage stage) const noexcept
+        {
+            return stageMicroseconds_[static_cast<size_t>(stage)];
+        }
+
+        /** Average microseconds per block in the whole callback. */
+        float getBlockMicroseconds() const noexcept { return blockMicroseconds_; }
+
+        /** Calibrated tick rate (0 until enough time has passed to measure it). */
+        double getTicksPerSecond() const noexcept { return ticksPerSecond_; }
+
+    private:
+        static constexpr int kBatch = 32;
+
+        uint64_t cursor_ = 0;
+        double ticksPerSecond_ = 0.0;
+        float loadPercent_ = 0.0f;
+        float peakLoadPercent_ = 0.0f;
+        float blockMicroseconds_ = 0.0f;
+        std::array<float, kNumStages> stageMicroseconds_ {};
+        bool hasAverage_ = false;
+        std::array<BlockRecord, kBatch> batch_ {};
+    };
+}
+
+#define UNRAVEL_PROFILE_JOIN_(a, b) a##b
+#define UNRAVEL_PROFILE_JOIN(a, b) UNRAVEL_PROFILE_JOIN_(a, b)
+
+#if UNRAVEL_DSP_PROFILING
+ /** Time the rest of the enclosing scope as `stage` into `accumulator` (may be nullptr). */
+ #define UNRAVEL_PROFILE_STAGE(accumulator, stage) \
+    const DspProfiler::ScopedStage UNRAVEL_PROFILE_JOIN(unravelProfileScope_, __LINE__)((accumulator), DspProfiler::Stage::stage)
+#else
+ #define UNRAVEL_PROFILE_STAGE(accumulator, stage)
+#endif
@@ -0,0 +1,382 @@
+#include "FFTBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if UNRAVEL_FFT_PFFFT
+ #include <pffft.h>
+#endif
+
+// JUCE engines faster than its generic fallback: vDSP on Apple, IPP/MKL or
+// FFTW when the JUCE build enables them.
+#if JUCE_MAC || JUCE_IOS || JUCE_DSP_USE_INTEL_MKL || JUCE_DSP_USE_SHARED_FFTW || JUCE_DSP_USE_STATIC_FFTW
+ #define UNRAVEL_FFT_JUCE_HAS_VENDOR_ENGINE 1
+#else
+ #define UNRAVEL_FFT_JUCE_HAS_VENDOR_ENGINE 0
+#endif
+
+namespace
+{
+//==============================================================================
+/** juce::dsp::FFT: copies into and out of the 2·N workspace its API requires. */
+class JuceBackend final : public FFTBackend
+{
+public:
+    explicit JuceBackend(int order)
+        : FFTBackend(order), fft_(order), workspace_((size_t) getSize() * 2, 0.0f)
+    {
+    }
+
+    void forward(const float* input, std::complex<float>* bins) noexcept override
+    {
+        const int n = getSize();
+        float* work = workspace_.data();
+        std::memcpy(work, input, sizeof(float) * (size_t) n);
+        std::fill(work + n, work + 2 * n, 0.0f);
+        fft_.performRealOnlyForwardTransform(work);         // Interleaved re/im, bins 0..N/2 used
+        std::copy(work, work + 2 * getNumBins(), reinterpret_cast<float*>(bins));
+    }
+
+    void inverse(const std::complex<float>* bins, float* output) noexcept override
+    {
+        float* work = workspace_.data();
+        std::memcpy(work, bins, sizeof(std::complex<float>) * (size_t) getNumBins());
+        fft_.performRealOnlyInverseTransform(work);         // Applies 1/N
+        std::memcpy(output, work, sizeof(float) * (size_t) getSize());
+    }
+
+    float getRoundTripGain() const noexcept override { return 1.0f; }
+    Kind getKind() const noexcept override { return Kind::Juce; }
+    const char* getName() const noexcept override { return "JUCE"; }
+
+private:
+    juce::dsp::FFT fft_;
+    std::vector<float> workspace_;
+};
+
+//==============================================================================
+/**
+ * Radix-2 real FFT. The N real samples are read as M = N/2 complex samples
+ * z[n] = x[2n] + i·x[2n+1]; an M-point complex FFT of z runs in the output
+ * buffer itself, then one pass over the bin pairs (k, M - k) splits it into
+ * the spectra of the even and odd samples and recombines them:
+ *
+ *     X[k] = E[k] + W^k·O[k],   X[M - k] = conj(E[k] - W^k·O[k]),   W = e^{-2πi/N}
+ *
+ * The inverse runs the same steps backwards, writing the merged sequence
+ * straight into bit-reversed order in the output buffer, so neither
+ * direction touches any memory but its two arguments and the tables.
+ * Complex products are written out by hand: std::complex's operator* has an
+ * inf/NaN recovery path compilers won't drop without -ffast-math.
+ */
+class BuiltinBackend final : public FFTBackend
+{
+public:
+    explicit BuiltinBackend(int order)
+        : FFTBackend(order), half_(getSize() / 2)
+    {
+        const int m = half_;
+        int bits = 0;
+        while ((1 << bits) < m)
+            ++bits;
+
+        bitReverse_.resize((size_t) m);
+        for (int i = 0; i < m; ++i)
+        {
+            int reversed = 0;
+            for (int b = 0; b < bits; ++b)
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            bitReverse_[(size_t) i] = reversed;
+        }
+
+        // Butterfly twiddles, one contiguous run per stage of length L >= 8
+        // (e^{-2πij/L}, j < L/2, stage runs back to back), and split
+        // twiddles e^{-2πik/N}, k <= M/2; computed in double so only the
+        // final rounding to float is lost.
+        for (int len = 8; len <= m; len <<= 1)
+            for (int j = 0; j < len / 2; ++j)
+            {
+                const double phase = -2.0 * juce::MathConstants<double>::pi * (double) j / (double) len;
+                twiddles_.push_back({ (float) std::cos(phase), (float) std::sin(phase) });
+            }
+
+        split_.resize((size_t) (m / 2 + 1));
+        for (size_t k = 0; k < split_.size(); ++k)
+        {
+            const double phase = -2.0 * juce::MathConstants<double>::pi * (double) k / (double) getSize();
+            split_[k] = { (float) std::cos(phase), (float) std::sin(phase) };
+        }
+    }
+
+    void forward(const float* input, std::complex<float>* bins) noexcept override
+    {
+        const int m = half_;
+        auto* z = reinterpret_cast<float*>(bins);
+
+        for (int n = 0; n < m; ++n)
+        {
+            const int r = bitReverse_[(size_t) n];
+            z[2 * r]     = input[2 * n];
+            z[2 * r + 1] = input[2 * n + 1];
+        }
+        butterflies<false>(z);
+
+        // DC and Nyquist from Z[0]: E[0] = Re, O[0] = Im.
+        const float re0 = z[0];
+        const float im0 = z[1];
+        z[0] = re0 + im0;
+        z[1] = 0.0f;
+        z[2 * m]     = re0 - im0;
+        z[2 * m + 1] = 0.0f;
+
+        for (int k = 1; k <= m / 2; ++k)
+        {
+            const int j = m - k;
+            const float ar = z[2 * k], ai = z[2 * k + 1];
+            const float br = z[2 * j], bi = -z[2 * j + 1];          // conj(Z[M - k])
+
+            // E = (a + b) / 2, O = (a - b) / 2i
+            const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+            const float orr = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+
+            const float wr = split_[(size_t) k].real(), wi = split_[(size_t) k].imag();
+            const float tr = wr * orr - wi * oi;                     // W^k·O
+            const float ti = wr * oi + wi * orr;
+
+            z[2 * k]     = er + tr;
+            z[2 * k + 1] = ei + ti;
+            if (j != k)
+            {
+                z[2 * j]     = er - tr;
+                z[2 * j + 1] = -(ei - ti);
+            }
+        }
+    }
+
+    void inverse(const std::complex<float>* bins, float* output) noexcept override
+    {
+        const int m = half_;
+        const float* x = reinterpret_cast<const float*>(bins);
+
+        // Merge: Z[k] = (a + b) + i·(a - b)·conj(W^k) with a = X[k],
+        // b = conj(X[M - k]); twice the forward's E + i·O, which with the
+        // unnormalised M-point inverse makes the round trip gain 2M = N.
+        {
+            const float dc = x[0], nyquist = x[2 * m];
+            const int r = bitReverse_[0];
+            output[2 * r]     = dc + nyquist;
+            output[2 * r + 1] = dc - nyquist;
+        }
+
+        for (int k = 1; k <= m / 2; ++k)
+        {
+            const int j = m - k;
+            const float ar = x[2 * k], ai = x[2 * k + 1];
+            const float br = x[2 * j], bi = -x[2 * j + 1];
+
+            const float er = ar + br, ei = ai + bi;
+            const float dr = ar - br, di = ai - bi;
+
+            const float wr = split_[(size_t) k].real(), wi = -split_[(size_t) k].imag();   // conj(W^k)
+            const float pr = dr * wr - di * wi;                      // (a - b)·conj(W^k)
+            const float pj = dr * wi + di * wr;
+            const float orr = -pj, oi = pr;                          // · i
+
+            const int rk = bitReverse_[(size_t) k];
+            output[2 * rk]     = er + orr;
+            output[2 * rk + 1] = ei + oi;
+            if (j != k)
+            {
+                const int rj = bitReverse_[(size_t) j];
+                output[2 * rj]     = er - orr;
+                output[2 * rj + 1] = -(ei - oi);
+            }
+        }
+
+        butterflies<true>(output);                                   // x[2n], x[2n+1] = Re, Im z[n]
+    }
+
+    float getRoundTripGain() const noexcept override { return (float) getSize(); }
+    Kind getKind() const noexcept override { return Kind::Builtin; }
+    const char* getName() const noexcept override { return "Builtin"; }
+
+private:
+    /** In-place M-point complex FFT of bit-reversed interleaved data (inverse: conjugate twiddles, unscaled). */
+    template <bool Inverse>
+    void butterflies(float* d) const noexcept
+    {
+        const int m = half_;
+
+        // Lengths 2 and 4 in one pass: twiddles 1 and ∓i, no multiplies.
+        if (m >= 4)
+        {
+            for (int i = 0; i < m; i += 4)
+            {
+                float* p = d + 2 * i;
+                const float ar = p[0] + p[2], ai = p[1] + p[3];
+                const float br = p[0] - p[2], bi = p[1] - p[3];
+                const float cr = p[4] + p[6], ci = p[5] + p[7];
+                const float dr = p[4] - p[6], di = p[5] - p[7];
+                // d·(-i) forward, d·(+i) inverse
+                const float er = Inverse ? -di : di, ei = Inverse ? dr : -dr;
+                p[0] = ar + cr;  p[1] = ai + ci;
+                p[2] = br + er;  p[3] = bi + ei;
+                p[4] = ar - cr;  p[5] = ai - ci;
+                p[6] = br - er;  p[7] = bi - ei;
+            }
+        }
+        else if (m == 2)
+        {
+            const float ur = d[0], ui = d[1];
+            d[0] = ur + d[2];  d[1] = ui + d[3];
+            d[2] = ur - d[2];  d[3] = ui - d[3];
+        }
+
+        const auto* tw = twiddles_.data();
+        for (int len = 8; len <= m; len <<= 1)
+        {
+            const int halfLen = len / 2;
+            for (int start = 0; start < m; start += len)
+            {
+                float* lo = d + 2 * start;
+                float* hi = lo + 2 * halfLen;
+                for (int j = 0; j < halfLen; ++j)
+                {
+                    const float wr = tw[j].real();
+                    const float wi = Inverse ? -tw[j].imag() : tw[j].imag();
+                    const float vr = hi[2 * j] * wr - hi[2 * j + 1] * wi;
+                    const float vi = hi[2 * j] * wi + hi[2 * j + 1] * wr;
+                    const float ur = lo[2 * j], ui = lo[2 * j + 1];
+                    lo[2 * j]     = ur + vr;
+                    lo[2 * j + 1] = ui + vi;
+                    hi[2 * j]     = ur - vr;
+                    hi[2 * j + 1] = ui - vi;
+                }
+            }
+            tw += halfLen;
+        }
+    }
+
+    const int half_;
+    std::vector<int> bitReverse_;
+    std::vector<std::complex<float>> twiddles_;
+    std::vector<std::complex<float>> split_;
+};
+
+#if UNRAVEL_FFT_PFFFT
+//==============================================================================
+/**
+ * PFFFT's ordered real transform. Its packed layout ([DC, Nyquist, re1, im1,
+ * ...]) is the bin layout with the two real-only bins folded together, so
+ * forward() runs straight into the bins and unfolds Nyquist, and inverse()
+ * folds into the output buffer and transforms there in place. PFFFT needs
+ * 16-byte alignment; other buffers go through an aligned scratch copy.
+ */
+class PffftBackend final : public FFTBackend
+{
+public:
+    explicit PffftBackend(int order)
+        : FFTBackend(order),
+          setup_(pffft_new_setup(getSize(), PFFFT_REAL)),
+          work_(static_cast<float*>(pffft_aligned_malloc(sizeof(float) * (size_t) getSize()))),
+          scratch_(static_cast<float*>(pffft_aligned_malloc(sizeof(float) * (size_t) getSize())))
+    {
+        jassert(setup_ != nullptr);
+    }
+
+    ~PffftBackend() override
+    {
+        pffft_aligned_free(scratch_);
+        pffft_aligned_free(work_);
+        pffft_destroy_setup(setup_);
+    }
+
+    void forward(const float* input, std::complex<float>* bins) noexcept override
+    {
+        const int n = getSize();
+        auto* out = reinterpret_cast<float*>(bins);
+        if (! isAligned(input))
+            input = static_cast<const float*>(std::memcpy(scratch_, input, sizeof(float) * (size_t) n));
+
+        float* packed = isAligned(out) ? out : scratch_;
+        pffft_transform_ordered(setup_, input, packed, work_, PFFFT_FORWARD);
+        if (packed != out)
+            std::memcpy(out, packed, sizeof(float) * (size_t) n);
+
+        const float nyquist = out[1];
+        out[1] = 0.0f;
+        bins[n / 2] = { nyquist, 0.0f };
+    }
+
+    void inverse(const std::complex<float>* bins, float* output) noexcept override
+    {
+        const int n = getSize();
+        float* packed = isAligned(output) ? output : scratch_;
+        std::memcpy(packed + 2, bins + 1, sizeof(std::complex<float>) * (size_t) (n / 2 - 1));
+        packed[0] = bins[0].real();
+        packed[1] = bins[n / 2].real();
+        pffft_transform_ordered(setup_, packed, packed, work_, PFFFT_BACKWARD);
+        if (packed != output)
+            std::memcpy(output, packed, sizeof(float) * (size_t) n);
+    }
+
+    float getRoundTripGain() const noexcept override { return (float) getSize(); }
+    Kind getKind() const noexcept override { return Kind::Pffft; }
+    const char* getName() const noexcept override { return "PFFFT"; }
+
+    /** PFFFT's real transform needs N to be a multiple of 32 (SIMD width × 8). */
+    static bool supportsOrder(int order) noexcept { return order >= 5; }
+
+private:
+    static bool isAligned(const void* p) noexcept { return (reinterpret_cast<uintptr_t>(p) & 15u) == 0; }
+
+    PFFFT_Setup* setup_;
+    float* work_;
+    float* scratch_;
+};
+#endif
+}
+
+//==============================================================================
+FFTBackend::Kind FFTBackend::getDefaultKind() noexcept
+{
+   #if UNRAVEL_FFT_PFFFT
+    return Kind::Pffft;
+   #elif UNRAVEL_FFT_JUCE_HAS_VENDOR_ENGINE
+    return Kind::Juce;
+   #else
+    return Kind::Builtin;
+   #endif
+}
+
+bool FFTBackend::isAvailable(Kind kind) noexcept
+{
+    return kind != Kind::Pffft || UNRAVEL_FFT_PFFFT;
+}
+
+std::unique_ptr<FFTBackend> FFTBackend::create(int order, Kind kind)
+{
+    jassert(order >= 1);
+
+    if (kind == Kind::Default || ! isAvailable(kind))
+        kind = getDefaultKind();
+
+    switch (kind)
+    {
+        case Kind::Juce:
+            return std::make_unique<JuceBackend>(order);
+
+        case Kind::Pffft:
+           #if UNRAVEL_FFT_PFFFT
+            if (PffftBackend::supportsOrder(order))
+                return std::make_unique<PffftBackend>(order);
+           #endif
+            break;
+
+        case Kind::Builtin:
+        case Kind::Default:
+            break;
+    }
+    return std::make_unique<BuiltinBackend>(order);
+}
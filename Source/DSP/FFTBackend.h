@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <memory>
+#include <vector>
+
+// PFFFT is opt-in: the CMake option UNRAVEL_FFT_PFFFT points the build at an
+// external PFFFT checkout and defines this. Without it the backend is absent.
+#ifndef UNRAVEL_FFT_PFFFT
+ #define UNRAVEL_FFT_PFFFT 0
+#endif
+
+/**
+ * FFTBackend - real-only forward/inverse FFT behind one interface
+ *
+ * The STFT (and the offline renderer) hand a backend their own buffers
+ * directly: forward() reads fftSize windowed samples and writes the
+ * fftSize/2 + 1 complex bins, inverse() reads the bins and writes fftSize
+ * samples. No interleaved 2·fftSize staging buffer and no repacking loop on
+ * either side; a backend that needs its own layout converts in place or in
+ * a workspace it owns.
+ *
+ * Backends scale differently, so each reports its round-trip gain:
+ * inverse(forward(x)) == getRoundTripGain() · x. The caller folds 1/gain into
+ * its synthesis (COLA) scale instead of carrying a per-platform constant.
+ *
+ * Kinds:
+ * - Juce: juce::dsp::FFT. Whatever engine JUCE was configured with: vDSP on
+ *   Apple platforms, Intel IPP/MKL or FFTW when JUCE_DSP_USE_* is set, and
+ *   otherwise JUCE's generic complex fallback. Round-trip gain 1.
+ * - Builtin: a float radix-2 transform of the real signal as a half-length
+ *   complex sequence plus one split pass, working in the caller's buffers.
+ *   Half the butterfly work of JUCE's fallback, which runs the real signal
+ *   as a full-length complex one. Gain N.
+ * - Pffft: PFFFT (SIMD, any platform), when built with UNRAVEL_FFT_PFFFT.
+ *   Gain N. 16-byte aligned buffers (arena buffers are) avoid a copy.
+ *
+ * Kind::Default picks, in order: Pffft if compiled in, Juce where JUCE has a
+ * vendor engine (Apple, or IPP/MKL/FFTW configured), else Builtin.
+ *
+ * RT-safety: create() allocates (tables, workspaces) and belongs in the
+ * owner's constructor or prepare(); forward() and inverse() never allocate.
+ * One backend instance serves one thread at a time.
+ */
+class FFTBackend
+{
+public:
+    enum class Kind
+    {
+        Default,
+        Juce,
+        Builtin,
+        Pffft
+    };
+
+    /** Backend for fftSize = 2^order (order >= 1). Kind::Pffft falls back to Default when not compiled in. */
+    static std::unique_ptr<FFTBackend> create(int order, Kind kind = Kind::Default);
+
+    /** What Kind::Default resolves to in this build. */
+    static Kind getDefaultKind() noexcept;
+
+    /** Whether a kind is compiled into this build. */
+    static bool isAvailable(Kind kind) noexcept;
+
+    virtual ~FFTBackend() = default;
+
+    int getSize() const noexcept { return size_; }
+    int getNumBins() const noexcept { return size_ / 2 + 1; }
+
+    /**
+     * Real forward transform.
+     * @param input  fftSize samples (not modified)
+     * @param bins   fftSize/2 + 1 bins out; DC and Nyquist have zero imaginary parts
+     */
+    virtual void forward(const float* input, std::complex<float>* bins) noexcept = 0;
+
+    /**
+     * Real inverse transform (imaginary parts of DC and Nyquist are ignored).
+     * @param bins   fftSize/2 + 1 bins (not modified)
+     * @param output fftSize samples out, scaled by getRoundTripGain()
+     */
+    virtual void inverse(const std::complex<float>* bins, float* output) noexcept = 0;
+
+    /** inverse(forward(x)) == getRoundTripGain() · x. */
+    virtual float getRoundTripGain() const noexcept = 0;
+
+    virtual Kind getKind() const noexcept = 0;
+
+    /** Short display name ("JUCE", "Builtin", "PFFFT"). */
+    virtual const char* getName() const noexcept = 0;
+
+protected:
+    explicit FFTBackend(int order) noexcept : size_(1 << order) {}
+
+private:
+    const int size_;
+
+    JUCE_DECLARE_NON_COPYABLE(FFTBackend)
+};
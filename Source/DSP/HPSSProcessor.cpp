@@ -1,4 +1,6 @@
 #include "HPSSProcessor.h"
+#include "ChannelWorkerPool.h"
+#include "SpectralKernels.h"
 #include <algorithm>
 #include <cmath>
 
@@ -6,8 +8,10 @@
 // Constructor & Destructor
 // =============================================================================
 
-HPSSProcessor::HPSSProcessor(bool lowLatency)
-    : useHighQuality_(!lowLatency)
+HPSSProcessor::HPSSProcessor(bool lowLatency, Synthesis synthesis, STFTProcessor::Overlap overlap)
+    : useHighQuality_(!lowLatency),
+      synthesis_(synthesis),
+      overlap_(overlap)
 {
     // Initialize parameter smoothers with fast ramp times for responsive controls
     tonalGainSmoother_.reset(48000.0, 0.02);      // 20ms ramp time
@@ -21,8 +25,9 @@ HPSSProcessor::~HPSSProcessor() = default;
 // Core Interface
 // =============================================================================
 
-void HPSSProcessor::prepare(double sampleRate, int maxBlockSize) noexcept
+void HPSSProcessor::prepare(double sampleRate, int maxBlockSize, int numChannels) noexcept
 {
+    jassert(numChannels >= 1);
     currentSampleRate_ = sampleRate;
     currentBlockSize_ = maxBlockSize;
 
@@ -30,23 +35,19 @@ void HPSSProcessor::prepare(double sampleRate, int maxBlockSize) noexcept
     tonalGainSmoother_.reset(sampleRate, 0.02);
     noiseGainSmoother_.reset(sampleRate, 0.02);
     transientGainSmoother_.reset(sampleRate, 0.02);
+    brightnessSmoother_.reset(sampleRate, BrightnessShelf::kRampSeconds);
+
+    // Pick the kernel variant (CPU query) here, not on the first frame.
+    SpectralKernels::selectInstructionSet();
     
-    // Initialize all components
+    // Initialize all components (one lane per channel)
+    lanes_.resize(static_cast<size_t>(std::max(1, numChannels)));
     initializeComponents();
-    
-    // Prepare processing buffers
-    tonalMaskBuffer_.resize(numBins_, 0.0f);
-    noiseMaskBuffer_.resize(numBins_, 0.0f);
-    transientMaskBuffer_.resize(numBins_, 0.0f);
+    framesWereLinked_ = false;
+    unityHoldoffSamples_ = 0;
+    pipelineStage_ = PipelineStage::Idle;
+    sharedEpoch_ = 0;
 
-    // Prepare bypass buffer with latency compensation
-    // Write position starts ahead of read position by latency amount
-    // This creates the proper delay for bypass mode
-    const int latencyInSamples = getLatencyInSamples();
-    bypassBuffer_.resize(latencyInSamples + maxBlockSize, 0.0f);
-    bypassWritePos_ = latencyInSamples;  // Write ahead by latency
-    bypassReadPos_ = 0;                   // Read from beginning (zeros = initial silence)
-    
     isInitialized_ = true;
 }
 
@@ -55,30 +56,72 @@ void HPSSProcessor::reset() noexcept
     if (!isInitialized_) return;
     
     // Reset all components
-    if (stftProcessor_)
-        stftProcessor_->reset();
-    
-    if (magPhaseFrame_)
-        magPhaseFrame_->reset();
-    
-    if (maskEstimator_)
-        maskEstimator_->reset();
+    for (auto& lane : lanes_)
+    {
+        if (lane.stftProcessor)
+            lane.stftProcessor->reset();
+
+        if (lane.analysisStft)
+        {
+            lane.analysisStft->reset();
+            primeAnalysis(lane);
+        }
+
+        if (lane.magPhaseFrame)
+            lane.magPhaseFrame->reset();
+
+        if (lane.maskEstimator)
+            lane.maskEstimator->reset();
+
+        if (lane.lowBand)
+            lane.lowBand->reset();
+
+        lane.silenceGate.reset();
+        lane.frameSilent = false;
+        lane.masksShared = false;
+        lane.analysisFrame = 0;
+        lane.tierFadeFrames = 0;
+        lane.analysisRestartPending = false;
+
+        // Maintain proper bypass delay offset
+        std::fill(lane.bypassBuffer.begin(), lane.bypassBuffer.end(), 0.0f);
+        lane.bypassWritePos = getLatencyInSamples();
+        lane.bypassReadPos = 0;
+    }
     
+    pipelineStage_ = PipelineStage::Idle;   // The STFTs dropped the held frame
+
     // Reset parameter smoothers (20ms for responsive controls)
     tonalGainSmoother_.reset(currentSampleRate_, 0.02);
     noiseGainSmoother_.reset(currentSampleRate_, 0.02);
     transientGainSmoother_.reset(currentSampleRate_, 0.02);
     
     // Clear buffers
-    std::fill(tonalMaskBuffer_.begin(), tonalMaskBuffer_.end(), 0.0f);
-    std::fill(noiseMaskBuffer_.begin(), noiseMaskBuffer_.end(), 0.0f);
-    std::fill(transientMaskBuffer_.begin(), transientMaskBuffer_.end(), 0.0f);
-    std::fill(bypassBuffer_.begin(), bypassBuffer_.end(), 0.0f);
+    std::fill(tonalMasks_.begin(), tonalMasks_.end(), 0.0f);
+    std::fill(noiseMasks_.begin(), noiseMasks_.end(), 0.0f);
+    std::fill(transientMasks_.begin(), transientMasks_.end(), 0.0f);
+    std::fill(binGains_.begin(), binGains_.end(), 0.0f);
+    std::fill(linkedMagnitudes_.begin(), linkedMagnitudes_.end(), 0.0f);
+    std::fill(linkedLowBand_.begin(), linkedLowBand_.end(), 0.0f);
+    std::fill(synthesisTonalMasks_.begin(), synthesisTonalMasks_.end(), 0.0f);
+    std::fill(synthesisNoiseMasks_.begin(), synthesisNoiseMasks_.end(), 0.0f);
+    std::fill(synthesisTransientMasks_.begin(), synthesisTransientMasks_.end(), 0.0f);
+    analysisCountdown_ = lanes_[0].stftProcessor->getFftSize();
+    framesWereLinked_ = false;
+    unityHoldoffSamples_ = 0;
 
-    // Maintain proper bypass delay offset
-    const int latencyInSamples = getLatencyInSamples();
-    bypassWritePos_ = latencyInSamples;
-    bypassReadPos_ = 0;
+    if (spectrumHistory_ != nullptr)
+        spectrumHistory_->resetAccumulation();
+}
+
+void HPSSProcessor::restartAnalysis() noexcept
+{
+    if (!isInitialized_) return;
+
+    // Applied as each lane starts its next frame: a pipelined frame held
+    // between blocks has begun its masks, and finishes them on its history.
+    for (auto& lane : lanes_)
+        lane.analysisRestartPending = true;
 }
 
 void HPSSProcessor::processBlock(const float* inputBuffer,
@@ -87,32 +130,353 @@ void HPSSProcessor::processBlock(const float* inputBuffer,
                                 float tonalGain,
                                 float noiseGain,
                                 float transientGain) noexcept
+{
+    processBlock(&inputBuffer, &outputBuffer, 1, numSamples, tonalGain, noiseGain, transientGain);
+}
+
+void HPSSProcessor::processStemBlock(const float* const* inputs,
+                                     float* const* tonalOutputs,
+                                     float* const* noiseOutputs,
+                                     float* const* transientOutputs,
+                                     int numChannels,
+                                     int numSamples,
+                                     float tonalGain,
+                                     float noiseGain,
+                                     float transientGain) noexcept
+{
+    jassert(stemOutputs_);
+    jassert(noiseOutputs != nullptr && transientOutputs != nullptr);
+
+    // The two extra streams ride along with the block; tonal takes the
+    // place of the mix.
+    blockNoiseOutputs_ = noiseOutputs;
+    blockTransientOutputs_ = transientOutputs;
+    processBlock(inputs, tonalOutputs, numChannels, numSamples, tonalGain, noiseGain, transientGain);
+    blockNoiseOutputs_ = nullptr;
+    blockTransientOutputs_ = nullptr;
+}
+
+void HPSSProcessor::processBlock(const float* const* inputs,
+                                float* const* outputs,
+                                int numChannels,
+                                int numSamples,
+                                float tonalGain,
+                                float noiseGain,
+                                float transientGain) noexcept
 {
     jassert(isInitialized_);
-    jassert(inputBuffer != nullptr);
-    jassert(outputBuffer != nullptr);
+    jassert(inputs != nullptr);
+    jassert(outputs != nullptr);
+    jassert(numChannels > 0 && numChannels <= getNumChannels());
     jassert(numSamples > 0 && numSamples <= currentBlockSize_);
 
+    numChannels = std::min(numChannels, getNumChannels());
+
     // Handle bypass mode
     if (bypassEnabled_)
     {
-        processBypass(inputBuffer, outputBuffer, numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            processBypass(lanes_[(size_t) ch], inputs[ch], outputs[ch], numSamples);
+            if (blockNoiseOutputs_ != nullptr)
+                std::fill(blockNoiseOutputs_[ch], blockNoiseOutputs_[ch] + numSamples, 0.0f);
+            if (blockTransientOutputs_ != nullptr)
+                std::fill(blockTransientOutputs_[ch], blockTransientOutputs_[ch] + numSamples, 0.0f);
+        }
         return;
     }
 
-    // Check for unity gain optimization (all three streams at unity = transparent passthrough)
-    if (tryUnityGainPath(inputBuffer, outputBuffer, numSamples, tonalGain, noiseGain, transientGain))
+    // The bypass delay is fed every block, ahead of any lane writing an
+    // in-place output, so the transparent path (and bypass) can take over on
+    // any block with the delay line already full.
+    for (int ch = 0; ch < numChannels; ++ch)
+        writeBypassDelay(lanes_[(size_t) ch], inputs[ch], numSamples);
+
+    updateSpectralBrightness(numSamples);
+
+    // All three streams at unity = transparent: analysis runs as usual, the
+    // output comes from the delay line. Frames resynthesised before the gains
+    // landed on unity are still in the overlap-add buffer for up to one FFT
+    // length, so only switch over once they have played out. Stem outputs
+    // never do: no single stream is the input.
+    const bool unityGain = ! stemOutputs_ && isUnityGain(tonalGain, noiseGain, transientGain);
+    if (! unityGain)
+        unityHoldoffSamples_ = getFftSize() + (pipelining_ ? getHopSize() : 0);
+    transparent_ = unityGain && unityHoldoffSamples_ <= 0;
+    if (unityGain)
+        unityHoldoffSamples_ = std::max(0, unityHoldoffSamples_ - numSamples);
+
+    blockInputs_ = inputs;
+    blockOutputs_ = outputs;
+    blockNumSamples_ = numSamples;
+    blockFrame_ = 0;
+
+    // Most small host blocks complete no frame: move the samples through and
+    // skip everything that only matters at a frame (gains, link changes,
+    // the fan-out to workers).
+    const int framesDue = getFramesDue(numSamples);
+    if (framesDue == 0 && pipelineStage_ == PipelineStage::Idle)
     {
+        processFramelessBlock(numChannels);
         return;
     }
 
-    // Update parameter smoothing
-    updateParameterSmoothing(tonalGain, noiseGain, transientGain);
+    // Pipelining: a block that only advances the held frame leaves the
+    // gains and link state to the next block that completes a frame. A new
+    // quality tier lands with them (before the link: one tier links).
+    if (framesDue > 0 && requestedTier_ != qualityTier_)
+        applyQualityTier(numChannels);
+    const bool linked = isLinkedAnalysis() && numChannels > 1;
+    if (framesDue > 0)
+    {
+        // Update parameter smoothing
+        if (gainSource_ == nullptr)
+            updateParameterSmoothing(tonalGain, noiseGain, transientGain);
+
+        // Gains of every frame this block produces, scheduled up front so lanes
+        // running on workers don't share smoother state.
+        scheduleFrameGains(framesDue);
+
+        // Coming back from Linked, lanes 1..N-1 hold stale guide history from
+        // before the link; restart them rather than mix old and new frames.
+        // (A linked frame still held only uses lane 0's estimator.)
+        if (! linked && framesWereLinked_)
+            for (int ch = 1; ch < numChannels; ++ch)
+            {
+                lanes_[(size_t) ch].maskEstimator->reset();
+                lanes_[(size_t) ch].silenceGate.reset();
+            }
+        framesWereLinked_ = linked;
+    }
+
+    if (pipelining_)
+    {
+        processPipelinedBlock(numChannels, framesDue, linked);
+        return;
+    }
 
     // Main processing pipeline
+    // All lanes see the same sample counts, so their frames become ready
+    // together and every lane processes the same number of frames.
+    if (synthesis_ == Synthesis::Partitioned)
+    {
+        processPartitionedBlock(numChannels, linked);
+    }
+    else if (! linked)
+    {
+        // Lanes are fully independent: one task per channel runs the whole
+        // block (push → frames → output), in parallel when a pool is set.
+        runLaneTasks(numChannels, &HPSSProcessor::runIndependentLane);
+        blockFrame_ = lanes_[0].framesThisBlock;
+    }
+    else
+    {
+        // Linked lanes meet once per frame for the shared mask estimate;
+        // everything either side of it runs per lane.
+        runLaneTasks(numChannels, &HPSSProcessor::runLinkedLaneInput);
+        while (lanes_[0].stftProcessor->isFrameReady())
+        {
+            estimateLinkedMasks(numChannels);
+            runLaneTasks(numChannels, &HPSSProcessor::runLinkedLaneSynthesis);
+            ++blockFrame_;
+        }
+    }
+
+    // Every lane is on the same frame grid, so the frames scheduled up
+    // front are exactly the frames processed.
+    jassert(blockFrame_ == framesDue);
+
+    // Denormal flushing is handled at the hardware level by the host processor's
+    // juce::ScopedNoDenormals (FTZ/DAZ); no manual per-sample flush needed.
+}
+
+void HPSSProcessor::setWorkerPool(ChannelWorkerPool* pool) noexcept
+{
+    workerPool_ = pool;
+}
+
+void HPSSProcessor::setSpectrumHistory(SpectrumHistoryRing* history) noexcept
+{
+    spectrumHistory_ = history;
+}
+
+void HPSSProcessor::setGainSource(GainSource* source) noexcept
+{
+    gainSource_ = source;
+}
+
+void HPSSProcessor::setSharedAnalysis(SharedAnalysis* shared) noexcept
+{
+    // A group for another layout would hand over masks of other frames.
+    jassert(shared == nullptr || shared->getLayout() == getSharedAnalysisLayout());
+    sharedAnalysis_ = (shared != nullptr && shared->getLayout() == getSharedAnalysisLayout()) ? shared : nullptr;
+}
+
+SharedAnalysis::Layout HPSSProcessor::getSharedAnalysisLayout() const noexcept
+{
+    SharedAnalysis::Layout layout;
+    if (lanes_.empty() || ! lanes_[0].stftProcessor)
+        return layout;
+
+    const auto& analysis = lanes_[0].analysisStft ? *lanes_[0].analysisStft : *lanes_[0].stftProcessor;
+    layout.sampleRate = currentSampleRate_;
+    layout.fftSize = analysis.getFftSize();
+    layout.hopSize = analysis.getHopSize();
+    layout.numChannels = getNumChannels();
+    layout.partitioned = (synthesis_ == Synthesis::Partitioned);
+    layout.historyFormat = historyFormat_;
+    layout.warmStart = warmStart_;
+    return layout;
+}
+
+void HPSSProcessor::resyncSharedAnalysis(int64_t epoch) noexcept
+{
+    if (!isInitialized_) return;
+
+    // The synthesis keeps running, so the frames go on where they were:
+    // members agree on the next one by the timeline position it completes
+    // at. Its key is the first of the epoch (restartLaneAnalysis() numbers
+    // it 1), and a held frame has already shared its masks.
+    restartAnalysis();
+    const int untilNext = (synthesis_ == Synthesis::Partitioned) ? analysisCountdown_
+                                                                 : std::max(1, getSamplesUntilNextFrame());
+    sharedEpoch_ = epoch + untilNext;
+}
+
+void HPSSProcessor::setWarmStart(bool enabled) noexcept
+{
+    warmStart_ = enabled;
+    for (auto& lane : lanes_)
+    {
+        if (lane.maskEstimator)
+            lane.maskEstimator->setWarmStart(warmStart_);
+    }
+}
+
+void HPSSProcessor::preroll(const float* const* inputs, int numChannels, int numSamples,
+                            float tonalGain, float noiseGain, float transientGain) noexcept
+{
+    jassert(isInitialized_);
+    jassert(inputs != nullptr && numChannels > 0 && numSamples >= 0);
+    numChannels = std::min(numChannels, getNumChannels());
+
+    // The full pass would have arrived at these gains long ago: no ramp.
+    snapGainSmoothers(tonalGain, noiseGain, transientGain);
+
+    // Exactly what playing the look-back would do, into scratch outputs: the
+    // overlap-add, bypass delay and gate states come out as a full pass
+    // leaves them, not just the estimators.
+    float* const* tonal = prerollOutputs_.data();
+    float* const* noise = tonal + lanes_.size();
+    float* const* transient = noise + lanes_.size();
+    for (int done = 0; done < numSamples; )
+    {
+        const int n = std::min(currentBlockSize_, numSamples - done);
+        for (int ch = 0; ch < numChannels; ++ch)
+            prerollInputs_[(size_t) ch] = inputs[ch] + done;
+
+        if (stemOutputs_)
+            processStemBlock(prerollInputs_.data(), tonal, noise, transient, numChannels, n,
+                             tonalGain, noiseGain, transientGain);
+        else
+            processBlock(prerollInputs_.data(), tonal, numChannels, n, tonalGain, noiseGain, transientGain);
+        done += n;
+    }
+}
+
+int HPSSProcessor::getPrerollSamples() const noexcept
+{
+    if (lanes_.empty() || ! lanes_[0].stftProcessor)
+        return 0;
+
+    // An output sample leaves latency samples after its input, from frames
+    // reaching one analysis window back (the tracker's reaches further), each
+    // of which an estimator settles on over getSettlingFrames() hops.
+    const auto& analysis = lanes_[0].analysisStft ? *lanes_[0].analysisStft : *lanes_[0].stftProcessor;
+    const int lowBandWindow = LowBandAnalyzer::getFftSize(currentSampleRate_)
+                            * LowBandAnalyzer::getDecimation(currentSampleRate_);
+    // Whole analysis hops, so a section starting on the full pass's frame
+    // grid has its look-back start on it too.
+    const int hop = analysis.getHopSize();
+    const int samples = getLatencyInSamples() + std::max(analysis.getFftSize(), lowBandWindow)
+                      + MaskEstimator::getSettlingFrames() * hop;
+    return (samples + hop - 1) / hop * hop;
+}
+
+int HPSSProcessor::getSamplesUntilNextFrame() const noexcept
+{
+    // Lanes advance in lock step, and in Partitioned mode analysis frames
+    // complete on synthesis frame boundaries: lane 0's synthesis STFT
+    // speaks for all of them. A pipelined frame held between blocks is
+    // already complete; the next one is the frame after it.
+    if (lanes_.empty() || ! lanes_[0].stftProcessor)
+        return 0;
+    const auto& stft = *lanes_[0].stftProcessor;
+    return pipelineStage_ != PipelineStage::Idle ? stft.getSamplesUntilFollowingFrame()
+                                                 : stft.getSamplesUntilNextFrame();
+}
+
+int HPSSProcessor::getFramesDue(int numSamples) const noexcept
+{
+    const int untilNext = std::max(1, getSamplesUntilNextFrame());
+    if (untilNext > numSamples)
+        return 0;
+    return (numSamples - untilNext) / lanes_[0].stftProcessor->getHopSize() + 1;
+}
+
+void HPSSProcessor::processFramelessBlock(int numChannels) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& lane = lanes_[(size_t) ch];
+        lane.stftProcessor->pushAndProcess(blockInputs_[ch], blockNumSamples_);
+        if (synthesis_ == Synthesis::Partitioned)
+            lane.analysisStft->pushAndProcess(blockInputs_[ch], blockNumSamples_);
+        jassert(! lane.stftProcessor->isFrameReady());
+        lane.framesThisBlock = 0;
+        finishLaneBlock(ch);
+    }
+
+    // No analysis frame either (they complete on synthesis frames).
+    if (synthesis_ == Synthesis::Partitioned)
+        analysisCountdown_ -= blockNumSamples_;
+}
+
+// =============================================================================
+// Per-lane block stages
+// =============================================================================
+
+void HPSSProcessor::runLaneTasks(int numChannels, void (HPSSProcessor::*stage)(int) noexcept) noexcept
+{
+    if (workerPool_ == nullptr || numChannels < 2)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            (this->*stage)(ch);
+        return;
+    }
+
+    currentStage_ = stage;
+    workerPool_->run(numChannels,
+                     [](void* context, int channel) noexcept
+                     {
+                         auto& self = *static_cast<HPSSProcessor*>(context);
+                         (self.*(self.currentStage_))(channel);
+                     },
+                     this);
+}
+
+void HPSSProcessor::runIndependentLane(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    const size_t offset = static_cast<size_t>(channel) * static_cast<size_t>(numBins_);
+    const float* tonal = tonalMasks_.data() + offset;
+    const float* transient = transientMasks_.data() + offset;
+    const float* noise = noiseMasks_.data() + offset;
+    float* gains = binGains_.data() + offset;
 
     // 1. Push input samples to STFT processor and produce frame if ready
-    stftProcessor_->pushAndProcess(inputBuffer, numSamples);
+    lane.stftProcessor->pushAndProcess(blockInputs_[channel], blockNumSamples_);
+    lane.framesThisBlock = 0;
 
     // 2. Process all ready frames
     // When blockSize > hopSize, multiple frames may be available per block.
@@ -120,66 +484,570 @@ void HPSSProcessor::processBlock(const float* inputBuffer,
     // processing of additional frames from buffered input. The STFT processor
     // has a safety check (getReadableDistance >= fftSize) to prevent reading
     // uninitialized data.
-    while (stftProcessor_->isFrameReady())
+    while (lane.stftProcessor->isFrameReady())
     {
-        // Get current frequency domain frame
-        auto complexFrame = stftProcessor_->getCurrentFrame();
+        analyseLaneFrame(lane);
 
-        // Convert to magnitude/phase representation
-        magPhaseFrame_->fromComplex(complexFrame);
+        // Update mask estimator with new frame, then compute separation
+        // masks (mass-conserving 3-way split), unless the gate holds them
+        estimateFrameMasks(lane.silenceGate, *lane.maskEstimator, lane.magPhaseFrame->getMagnitudes(),
+                           lane.lowBand->getMagnitudes(), channel);
+        lane.frameSilent = lane.silenceGate.isSilent();
 
-        // Get magnitude data for mask estimation
-        auto magnitudes = magPhaseFrame_->getMagnitudes();
+        // Apply masks — sum the three gained streams into one real gain per bin.
+        synthesiseLaneFrame(lane, tonal, transient, noise, gains, frameGainsAt(lane.framesThisBlock));
+        publishFrame(channel);
+        ++lane.framesThisBlock;
 
-        // Update mask estimator with new frame
-        maskEstimator_->updateGuides(magnitudes);
-        maskEstimator_->updateStats(magnitudes);
+        // Try to trigger another frame from buffered input
+        // This is safe because pushAndProcess checks getReadableDistance >= fftSize
+        lane.stftProcessor->pushAndProcess(nullptr, 0);
+    }
 
-        // Compute separation masks (mass-conserving 3-way split)
-        maskEstimator_->computeMasks(juce::Span<float>(tonalMaskBuffer_),
-                                     juce::Span<float>(transientMaskBuffer_),
-                                     juce::Span<float>(noiseMaskBuffer_));
+    finishLaneBlock(channel);
+}
 
-        // Get current smoothed gain values for this frame
-        const float currentTonalGain     = tonalGainSmoother_.getCurrentValue();
-        const float currentNoiseGain     = noiseGainSmoother_.getCurrentValue();
-        const float currentTransientGain = transientGainSmoother_.getCurrentValue();
+void HPSSProcessor::runLinkedLaneInput(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    lane.stftProcessor->pushAndProcess(blockInputs_[channel], blockNumSamples_);
+    lane.framesThisBlock = 0;
 
-        // Advance smoothers by hop size (samples per frame) for correct timing
-        const int hopSize = stftProcessor_->getHopSize();
-        tonalGainSmoother_.skip(hopSize);
-        noiseGainSmoother_.skip(hopSize);
-        transientGainSmoother_.skip(hopSize);
+    if (lane.stftProcessor->isFrameReady())
+        analyseLaneFrame(lane);
+    else
+        finishLaneBlock(channel);
+}
 
-        // Apply masks to magnitudes — sum the three gained streams.
-        for (int bin = 0; bin < numBins_; ++bin)
+void HPSSProcessor::runLinkedLaneSynthesis(int channel) noexcept
+{
+    // Linked channels share one mask set (slice 0). Each lane combines the
+    // gains into its own slice so lanes on different workers never write the
+    // same buffer; the combine is three vector ops.
+    auto& lane = lanes_[(size_t) channel];
+    const size_t offset = static_cast<size_t>(channel) * static_cast<size_t>(numBins_);
+    float* gains = binGains_.data() + offset;
+    synthesiseLaneFrame(lane, tonalMasks_.data(), transientMasks_.data(), noiseMasks_.data(), gains,
+                        frameGainsAt(blockFrame_));
+    publishFrame(channel);
+    ++lane.framesThisBlock;
+
+    lane.stftProcessor->pushAndProcess(nullptr, 0);
+    if (lane.stftProcessor->isFrameReady())
+        analyseLaneFrame(lane);
+    else
+        finishLaneBlock(channel);
+}
+
+void HPSSProcessor::analyseLaneFrame(ChannelLane& lane) noexcept
+{
+    if (lane.analysisRestartPending)
+        restartLaneAnalysis(lane);
+    ++lane.analysisFrame;
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, Magnitudes);
+
+        // Analysis only needs magnitudes in the complex path; the polar
+        // reference path also keeps the phase for toComplex().
+        auto complexFrame = lane.stftProcessor->getCurrentFrame();
+        if (maskApplication_ == MaskApplication::Complex)
+            lane.magPhaseFrame->computeMagnitudes(complexFrame);
+        else
+            lane.magPhaseFrame->fromComplex(complexFrame);
+    }
+    analyseLowBand(lane, *lane.stftProcessor);
+}
+
+void HPSSProcessor::analyseLowBand(ChannelLane& lane, const STFTProcessor& stft) noexcept
+{
+    UNRAVEL_PROFILE_STAGE(&lane.profile, LowFreqTracker);
+
+    // Each frame's newest hop is input the low band has not seen yet.
+    const auto input = stft.getCurrentFrameInput();
+    const int hopSize = stft.getHopSize();
+    lane.lowBand->push(input.data() + input.size() - (size_t) hopSize, hopSize);
+    lane.lowBand->analyse();
+}
+
+void HPSSProcessor::synthesiseLaneFrame(ChannelLane& lane, const float* tonal, const float* transient,
+                                        const float* noise, float* gains, const FrameGains& frameGains) noexcept
+{
+    // Unity gains leave every bin as analysed, so there is nothing to
+    // resynthesise: overlap-add the windowed input and skip the inverse FFT.
+    if (transparent_)
+    {
+        lane.stftProcessor->passCurrentFrameThrough();
+        return;
+    }
+
+    if (stemOutputs_)
+    {
+        // As below: partitioned frames are always resynthesised, silent
+        // analysis frames skipped.
+        if (lane.frameSilent && synthesis_ != Synthesis::Partitioned)
+            lane.stftProcessor->skipCurrentFrame();
+        else
+            synthesiseStemFrame(lane, tonal, transient, noise, gains, frameGains,
+                                synthesis_ == Synthesis::Partitioned ? synthesisBins_ : numBins_);
+        return;
+    }
+
+    if (synthesis_ == Synthesis::Partitioned)
+    {
+        // Short-grid gains straight onto the complex bins.
+        auto complexFrame = lane.stftProcessor->getCurrentFrame();
         {
-            const float originalMag = magnitudes[bin];
-            magnitudes[bin] = originalMag * (tonalMaskBuffer_[bin]     * currentTonalGain
-                                           + transientMaskBuffer_[bin] * currentTransientGain
-                                           + noiseMaskBuffer_[bin]     * currentNoiseGain);
+            UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+            computeBinGains(tonal, transient, noise, gains,
+                            frameGains.tonal, frameGains.noise, frameGains.transient, synthesisBins_);
+            for (int bin = 0; bin < synthesisBins_; ++bin)
+                complexFrame[bin] *= gains[bin];
         }
+        lane.stftProcessor->setCurrentFrame(complexFrame);
+        return;
+    }
 
-        // Convert back to complex representation
-        magPhaseFrame_->toComplex(complexFrame);
+    // An all-zero frame has every gained bin zeroed: nothing to add.
+    if (lane.frameSilent)
+    {
+        lane.stftProcessor->skipCurrentFrame();
+        return;
+    }
 
-        // Set the processed frame back to STFT processor
-        stftProcessor_->setCurrentFrame(complexFrame);
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+        computeBinGains(tonal, transient, noise, gains,
+                        frameGains.tonal, frameGains.noise, frameGains.transient, numBins_);
+    }
+    applyBinGains(lane, gains);
+}
 
-        // Try to trigger another frame from buffered input
-        // This is safe because pushAndProcess checks getReadableDistance >= fftSize
-        stftProcessor_->pushAndProcess(nullptr, 0);
+void HPSSProcessor::synthesiseStemFrame(ChannelLane& lane, const float* tonal, const float* transient,
+                                        const float* noise, float* gains, const FrameGains& frameGains,
+                                        int numBins) noexcept
+{
+    // Output order follows the gain arguments: tonal, noise, transient.
+    const float* const masks[] = { tonal, noise, transient };
+    const float streamGains[] = { frameGains.tonal, frameGains.noise, frameGains.transient };
+    const float* weights = numBins == numBins_ ? brightnessWeights_.data() : synthesisBrightnessWeights_.data();
+
+    for (int stream = 0; stream < 3; ++stream)
+    {
+        {
+            UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+            juce::FloatVectorOperations::multiply(gains, masks[stream], streamGains[stream], numBins);
+            if (stream == 0)
+                passOutOfBand(gains, numBins);      // The out-of-band masks are all tonal
+            if (brightnessActive_)
+                juce::FloatVectorOperations::multiply(gains, weights, numBins);
+        }
+        lane.stftProcessor->synthesiseOutput(stream, { gains, (size_t) numBins });
+    }
+    lane.stftProcessor->finishCurrentFrame();
+
+    // The visualiser shows the mix, as without stems (Partitioned scales
+    // its display magnitudes separately).
+    if (synthesis_ == Synthesis::FullFrame)
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+        computeBinGains(tonal, transient, noise, gains,
+                        frameGains.tonal, frameGains.noise, frameGains.transient, numBins_);
+        auto magnitudes = lane.magPhaseFrame->getMagnitudes();
+        juce::FloatVectorOperations::multiply(magnitudes.data(), gains, numBins_);
     }
+}
+
+void HPSSProcessor::finishLaneBlock(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
 
     // 3. Extract output samples from STFT processor
-    stftProcessor_->processOutput(outputBuffer, numSamples);
-    
+    if (stemOutputs_)
+    {
+        float* const outputs[] = {
+            blockOutputs_[channel],
+            blockNoiseOutputs_ != nullptr ? blockNoiseOutputs_[channel] : nullptr,
+            blockTransientOutputs_ != nullptr ? blockTransientOutputs_[channel] : nullptr
+        };
+        lane.stftProcessor->processOutputs(outputs, blockNumSamples_);
+        skipBypassDelay(lane, blockNumSamples_);
+
+        if (safetyLimitingEnabled_)
+            for (auto* output : outputs)
+                if (output != nullptr)
+                    applySafetyLimiting(output, blockNumSamples_);
+        return;
+    }
+    lane.stftProcessor->processOutput(blockOutputs_[channel], blockNumSamples_);
+
+    // Transparent: the overlap-add output only matches the input to FFT
+    // rounding, so play the bit-perfect delay line instead.
+    if (transparent_)
+    {
+        readBypassDelay(lane, blockOutputs_[channel], blockNumSamples_);
+        return;
+    }
+    skipBypassDelay(lane, blockNumSamples_);
+
     // 4. Apply safety limiting
     if (safetyLimitingEnabled_)
-        applySafetyLimiting(outputBuffer, numSamples);
-    
-    // Denormal flushing is handled at the hardware level by the host processor's
-    // juce::ScopedNoDenormals (FTZ/DAZ); no manual per-sample flush needed.
+        applySafetyLimiting(blockOutputs_[channel], blockNumSamples_);
+}
+
+// =============================================================================
+// Pipelined frames
+// =============================================================================
+
+void HPSSProcessor::processPipelinedBlock(int numChannels, int framesDue, bool linked) noexcept
+{
+    runLaneTasks(numChannels, &HPSSProcessor::runPipelinedInput);
+
+    // The STFT holds one frame at a time: one due in this block needs the
+    // held frame finished first. Due or not, the held frame is never more
+    // than a hop old, which the extra hop of output delay covers.
+    PipelineStage stage = pipelineStage_;
+    if (stage != PipelineStage::Idle)
+    {
+        do
+            stage = runPipelineStage(stage, -1, numChannels, linked);
+        while (framesDue > 0 && stage != PipelineStage::Idle);
+    }
+
+    // Every frame but the last has its successor buffered already, so only
+    // the last is left for the callbacks to come.
+    for (int frame = 0; frame < framesDue; ++frame)
+    {
+        stage = PipelineStage::Analysis;
+        do
+            stage = runPipelineStage(stage, frame, numChannels, linked);
+        while (frame + 1 < framesDue && stage != PipelineStage::Idle);
+    }
+
+    pipelineStage_ = stage;
+    blockFrame_ = framesDue;
+    runLaneTasks(numChannels, &HPSSProcessor::finishLaneBlock);
+}
+
+HPSSProcessor::PipelineStage HPSSProcessor::runPipelineStage(PipelineStage stage, int frame,
+                                                              int numChannels, bool linked) noexcept
+{
+    switch (stage)
+    {
+        case PipelineStage::Analysis:
+            pipelineLinked_ = linked;
+            pipelineGains_ = frameGainsAt(frame);
+            runLaneTasks(numChannels, &HPSSProcessor::runPipelinedAnalysis);
+            if (pipelineLinked_)
+                lanes_[0].frameEstimated = beginLinkedMasks(numChannels);
+            return PipelineStage::Masks;
+
+        case PipelineStage::Masks:
+            if (! pipelineLinked_)
+                runLaneTasks(numChannels, &HPSSProcessor::runPipelinedMasks);
+            else if (lanes_[0].frameEstimated)
+                finishFrameMasks(*lanes_[0].maskEstimator,
+                                 juce::Span<const float>(linkedMagnitudes_.data(), (size_t) numBins_), 0);
+            return PipelineStage::Synthesis;
+
+        case PipelineStage::Synthesis:
+            runLaneTasks(numChannels, &HPSSProcessor::runPipelinedSynthesis);
+            return PipelineStage::Idle;
+
+        case PipelineStage::Idle:
+            break;
+    }
+    jassertfalse;
+    return PipelineStage::Idle;
+}
+
+void HPSSProcessor::runPipelinedInput(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    lane.stftProcessor->pushAndProcess(blockInputs_[channel], blockNumSamples_);
+    lane.framesThisBlock = 0;
+}
+
+void HPSSProcessor::runPipelinedAnalysis(int channel) noexcept
+{
+    // Produced by this block's push, or now from input already buffered.
+    auto& lane = lanes_[(size_t) channel];
+    lane.stftProcessor->pushAndProcess(nullptr, 0);
+    jassert(lane.stftProcessor->isFrameReady());
+
+    analyseLaneFrame(lane);
+    if (pipelineLinked_)
+        return;
+
+    lane.frameEstimated = beginFrameMasks(lane.silenceGate, *lane.maskEstimator,
+                                          lane.magPhaseFrame->getMagnitudes(), lane.lowBand->getMagnitudes(),
+                                          channel, channel);
+    lane.frameSilent = lane.silenceGate.isSilent();
+}
+
+void HPSSProcessor::runPipelinedMasks(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    if (lane.frameEstimated)
+        finishFrameMasks(*lane.maskEstimator, lane.magPhaseFrame->getMagnitudes(), channel);
+}
+
+void HPSSProcessor::runPipelinedSynthesis(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    const size_t offset = static_cast<size_t>(pipelineLinked_ ? 0 : channel) * static_cast<size_t>(numBins_);
+    float* gains = binGains_.data() + static_cast<size_t>(channel) * static_cast<size_t>(numBins_);
+    synthesiseLaneFrame(lane, tonalMasks_.data() + offset, transientMasks_.data() + offset,
+                        noiseMasks_.data() + offset, gains, pipelineGains_);
+    publishFrame(channel);
+    ++lane.framesThisBlock;
+}
+
+// =============================================================================
+// Partitioned synthesis
+// =============================================================================
+
+void HPSSProcessor::processPartitionedBlock(int numChannels, bool linked) noexcept
+{
+    // The block is cut into segments that end exactly where a synthesis
+    // frame completes (analysis frames complete on a subset of those), so
+    // each synthesis frame uses the masks of the last analysis frame at or
+    // before it whatever the host block size.
+    const int analysisHop = lanes_[0].analysisStft->getHopSize();
+
+    if (! linked)
+    {
+        // Every lane runs its whole block (all segments) as one task.
+        runLaneTasks(numChannels, &HPSSProcessor::runPartitionedLane);
+
+        for (int start = 0; start < blockNumSamples_;)
+        {
+            const int length = nextSegmentLength(start, analysisCountdown_);
+            start += length;
+            analysisCountdown_ = (length == analysisCountdown_) ? analysisHop : analysisCountdown_ - length;
+        }
+    }
+    else
+    {
+        // Linked lanes meet once per segment for the shared estimate.
+        for (segmentStart_ = 0; segmentStart_ < blockNumSamples_; segmentStart_ += segmentLength_)
+        {
+            segmentLength_ = nextSegmentLength(segmentStart_, analysisCountdown_);
+            const bool analysed = (segmentLength_ == analysisCountdown_);
+
+            runLaneTasks(numChannels, &HPSSProcessor::runPartitionedLinkedAnalysis);
+            if (analysed && estimateLinkedMasks(numChannels))
+                mapMasksToSynthesisGrid(0, linkedMagnitudes_.data());
+            segmentAnalysed_ = analysed;
+            runLaneTasks(numChannels, &HPSSProcessor::runPartitionedLinkedSynthesis);
+
+            analysisCountdown_ = analysed ? analysisHop : analysisCountdown_ - segmentLength_;
+        }
+    }
+
+    blockFrame_ = lanes_[0].framesThisBlock;
+}
+
+void HPSSProcessor::runPartitionedLane(int channel) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    const int analysisHop = lane.analysisStft->getHopSize();
+    lane.framesThisBlock = 0;
+
+    int countdown = analysisCountdown_;
+    for (int start = 0; start < blockNumSamples_;)
+    {
+        const int length = nextSegmentLength(start, countdown);
+        if (analysePartitionedSegment(channel, start, length))
+        {
+            // Held masks keep their short-grid mapping too.
+            auto magnitudes = lane.magPhaseFrame->getMagnitudes();
+            if (estimateFrameMasks(lane.silenceGate, *lane.maskEstimator, magnitudes,
+                                   lane.lowBand->getMagnitudes(), channel))
+                mapMasksToSynthesisGrid(channel, magnitudes.data());
+            scaleDisplayMagnitudes(channel, channel);
+            publishFrame(channel);
+        }
+        synthesisePartitionedSegment(channel, channel, start, length);
+
+        start += length;
+        countdown = (length == countdown) ? analysisHop : countdown - length;
+    }
+
+    finishLaneBlock(channel);
+}
+
+void HPSSProcessor::runPartitionedLinkedAnalysis(int channel) noexcept
+{
+    if (segmentStart_ == 0)
+        lanes_[(size_t) channel].framesThisBlock = 0;
+
+    analysePartitionedSegment(channel, segmentStart_, segmentLength_);
+}
+
+void HPSSProcessor::runPartitionedLinkedSynthesis(int channel) noexcept
+{
+    if (segmentAnalysed_)
+    {
+        scaleDisplayMagnitudes(channel, 0);
+        publishFrame(channel);
+    }
+
+    synthesisePartitionedSegment(channel, 0, segmentStart_, segmentLength_);
+
+    if (segmentStart_ + segmentLength_ >= blockNumSamples_)
+        finishLaneBlock(channel);
+}
+
+bool HPSSProcessor::analysePartitionedSegment(int channel, int start, int length) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    auto& analysis = *lane.analysisStft;
+    analysis.pushAndProcess(blockInputs_[channel] + start, length);
+    if (! analysis.isFrameReady())
+        return false;
+
+    if (lane.analysisRestartPending)
+        restartLaneAnalysis(lane);
+    ++lane.analysisFrame;
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, Magnitudes);
+        lane.magPhaseFrame->computeMagnitudes(analysis.getCurrentFrame());
+    }
+    analyseLowBand(lane, analysis);
+    analysis.passCurrentFrameThrough();     // Analysis only: releases the frame
+    return true;
+}
+
+void HPSSProcessor::synthesisePartitionedSegment(int channel, int maskSlice, int start, int length) noexcept
+{
+    auto& lane = lanes_[(size_t) channel];
+    const size_t maskOffset = static_cast<size_t>(maskSlice) * static_cast<size_t>(synthesisBins_);
+    float* gains = synthesisGains_.data() + static_cast<size_t>(channel) * static_cast<size_t>(synthesisBins_);
+
+    lane.stftProcessor->pushAndProcess(blockInputs_[channel] + start, length);
+    while (lane.stftProcessor->isFrameReady())
+    {
+        synthesiseLaneFrame(lane, synthesisTonalMasks_.data() + maskOffset,
+                            synthesisTransientMasks_.data() + maskOffset,
+                            synthesisNoiseMasks_.data() + maskOffset,
+                            gains, frameGainsAt(lane.framesThisBlock));
+        ++lane.framesThisBlock;
+        lane.stftProcessor->pushAndProcess(nullptr, 0);
+    }
+}
+
+void HPSSProcessor::mapMasksToSynthesisGrid(int slice, const float* magnitudes) noexcept
+{
+    const size_t analysisOffset = static_cast<size_t>(slice) * static_cast<size_t>(numBins_);
+    const size_t synthesisOffset = static_cast<size_t>(slice) * static_cast<size_t>(synthesisBins_);
+    float* power = analysisPower_.data() + analysisOffset;
+    UNRAVEL_PROFILE_STAGE(&lanes_[(size_t) slice].profile, MaskPostProcessing);
+
+    juce::FloatVectorOperations::multiply(power, magnitudes, magnitudes, numBins_);
+    const juce::Span<const float> weights(power, (size_t) numBins_);
+    auto mapSlice = [&](const DspArena::Buffer<float>& analysisMasks, DspArena::Buffer<float>& synthesisMasks) noexcept
+    {
+        maskReconciler_.mapWeighted(juce::Span<const float>(analysisMasks.data() + analysisOffset, (size_t) numBins_),
+                                    weights,
+                                    juce::Span<float>(synthesisMasks.data() + synthesisOffset, (size_t) synthesisBins_));
+    };
+    mapSlice(tonalMasks_, synthesisTonalMasks_);
+    mapSlice(transientMasks_, synthesisTransientMasks_);
+    mapSlice(noiseMasks_, synthesisNoiseMasks_);
+}
+
+void HPSSProcessor::scaleDisplayMagnitudes(int channel, int maskSlice) noexcept
+{
+    // The analysis STFT is never resynthesised, so apply the gains to its
+    // magnitudes here; the visualiser then sees the same post-gain spectrum
+    // as in FullFrame mode.
+    auto& lane = lanes_[(size_t) channel];
+    const size_t maskOffset = static_cast<size_t>(maskSlice) * static_cast<size_t>(numBins_);
+    float* gains = binGains_.data() + static_cast<size_t>(channel) * static_cast<size_t>(numBins_);
+    const auto& frameGains = frameGainsAt(lane.framesThisBlock);
+    UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+
+    computeBinGains(tonalMasks_.data() + maskOffset, transientMasks_.data() + maskOffset,
+                    noiseMasks_.data() + maskOffset, gains,
+                    frameGains.tonal, frameGains.noise, frameGains.transient, numBins_);
+    juce::FloatVectorOperations::multiply(lane.magPhaseFrame->getMagnitudes().data(), gains, numBins_);
+}
+
+void HPSSProcessor::publishFrame(int channel) noexcept
+{
+    if (spectrumHistory_ == nullptr || channel != 0)
+        return;
+
+    // A ring sized for fewer bins (48 kHz's, at a scaled-up rate) takes the
+    // lowest ones: the same band at the same bin width.
+    const auto bins = static_cast<size_t>(std::min(numBins_, spectrumHistory_->getNumBins()));
+    auto lowest = [bins](juce::Span<const float> plane)
+    {
+        return plane.empty() ? plane : juce::Span<const float>(plane.data(), bins);
+    };
+    spectrumHistory_->push(lowest(getCurrentMagnitudes(0)), lowest(getCurrentTonalMask(0)),
+                           lowest(getCurrentTransientMask(0)), lowest(getCurrentNoiseMask(0)));
+}
+
+int HPSSProcessor::nextSegmentLength(int start, int countdown) const noexcept
+{
+    // Both grids complete their first frame at the same sample and the
+    // analysis hop is a multiple of the synthesis hop, so the distance to the
+    // next synthesis frame follows from the analysis countdown.
+    const int synthesisHop = lanes_[0].stftProcessor->getHopSize();
+    return std::min(blockNumSamples_ - start, (countdown - 1) % synthesisHop + 1);
+}
+
+void HPSSProcessor::restartLaneAnalysis(ChannelLane& lane) noexcept
+{
+    // reset()'s analysis half: the frame about to start is the first.
+    lane.maskEstimator->reset();
+    lane.lowBand->reset();
+    lane.silenceGate.reset();
+    lane.frameSilent = false;
+    lane.masksShared = false;
+    lane.analysisFrame = 0;
+    lane.tierFadeFrames = 0;
+    lane.analysisRestartPending = false;
+}
+
+void HPSSProcessor::primeAnalysis(ChannelLane& lane) noexcept
+{
+    // Silence ahead of the first input lines the analysis frames up with the
+    // synthesis frames: both complete fftSize(synthesis) samples after a reset.
+    lane.analysisStft->pushAndProcess(analysisPrimer_.data(), static_cast<int>(analysisPrimer_.size()));
+}
+
+void HPSSProcessor::scheduleFrameGains(int numFrames) noexcept
+{
+    jassert(numFrames <= static_cast<int>(frameGains_.size()));
+    numFrames = std::min(numFrames, static_cast<int>(frameGains_.size()));
+    const int hopSize = lanes_[0].stftProcessor->getHopSize();
+
+    // Each frame reads the smoothers, then they move on by its hop, exactly
+    // as if the frames had read them in turn.
+    int frameEnd = std::max(1, getSamplesUntilNextFrame());
+    for (int frame = 0; frame < numFrames; ++frame, frameEnd += hopSize)
+    {
+        if (gainSource_ != nullptr)
+        {
+            const auto target = gainSource_->getFrameGains(frameEnd - 1);
+            updateParameterSmoothing(target.tonal, target.noise, target.transient);
+        }
+
+        frameGains_[(size_t) frame] = { tonalGainSmoother_.getCurrentValue(),
+                                        noiseGainSmoother_.getCurrentValue(),
+                                        transientGainSmoother_.getCurrentValue() };
+        tonalGainSmoother_.skip(hopSize);
+        noiseGainSmoother_.skip(hopSize);
+        transientGainSmoother_.skip(hopSize);
+    }
+}
+
+const HPSSProcessor::FrameGains& HPSSProcessor::frameGainsAt(int frame) const noexcept
+{
+    jassert(frame >= 0 && frame < static_cast<int>(frameGains_.size()));
+    return frameGains_[(size_t) juce::jlimit(0, static_cast<int>(frameGains_.size()) - 1, frame)];
 }
 
 // =============================================================================
@@ -188,12 +1056,12 @@ void HPSSProcessor::processBlock(const float* inputBuffer,
 
 int HPSSProcessor::getLatencyInSamples() const noexcept
 {
-    return stftProcessor_ ? stftProcessor_->getLatencyInSamples() : 0;
+    return (! lanes_.empty() && lanes_[0].stftProcessor) ? lanes_[0].stftProcessor->getLatencyInSamples() : 0;
 }
 
 double HPSSProcessor::getLatencyInMs(double sampleRate) const noexcept
 {
-    if (sampleRate <= 0.0 || !stftProcessor_)
+    if (sampleRate <= 0.0 || lanes_.empty() || !lanes_[0].stftProcessor)
         return 0.0;
     
     return (getLatencyInSamples() * 1000.0) / sampleRate;
@@ -206,7 +1074,12 @@ int HPSSProcessor::getNumBins() const noexcept
 
 int HPSSProcessor::getFftSize() const noexcept
 {
-    return stftProcessor_ ? stftProcessor_->getFftSize() : 0;
+    return (! lanes_.empty() && lanes_[0].stftProcessor) ? lanes_[0].stftProcessor->getFftSize() : 0;
+}
+
+int HPSSProcessor::getHopSize() const noexcept
+{
+    return (! lanes_.empty() && lanes_[0].stftProcessor) ? lanes_[0].stftProcessor->getHopSize() : 0;
 }
 
 // =============================================================================
@@ -221,27 +1094,102 @@ void HPSSProcessor::setBypass(bool shouldBypass) noexcept
 void HPSSProcessor::setSeparation(float amount) noexcept
 {
     separation_ = juce::jlimit(0.0f, 1.0f, amount);
-    if (maskEstimator_)
+    for (auto& lane : lanes_)
     {
-        maskEstimator_->setSeparation(separation_);
+        if (lane.maskEstimator)
+            lane.maskEstimator->setSeparation(separation_);
     }
 }
 
 void HPSSProcessor::setFocus(float bias) noexcept
 {
     focus_ = juce::jlimit(-1.0f, 1.0f, bias);
-    if (maskEstimator_)
+    for (auto& lane : lanes_)
+    {
+        if (lane.maskEstimator)
+            lane.maskEstimator->setFocus(focus_);
+    }
+}
+
+void HPSSProcessor::setMaskDecimation(int interval) noexcept
+{
+    maskDecimation_ = juce::jlimit(1, MaskEstimator::getMaxMaskDecimation(), interval);
+    for (auto& lane : lanes_)
     {
-        maskEstimator_->setFocus(focus_);
+        if (lane.maskEstimator)
+            configureTier(*lane.maskEstimator);
     }
 }
 
+void HPSSProcessor::setSilenceGate(float thresholdDb) noexcept
+{
+    silenceGateDb_ = std::max(thresholdDb, SilenceGate::kDisabledDb);
+    for (auto& lane : lanes_)
+        lane.silenceGate.setThresholdDb(silenceGateDb_);
+}
+
+void HPSSProcessor::setActiveBand(float lowHz, float highHz, OutOfBand outside) noexcept
+{
+    bandLowHz_ = std::max(0.0f, lowHz);
+    bandHighHz_ = std::max(0.0f, highHz);
+    outOfBand_ = outside;
+    if (isInitialized_)
+        applyActiveBand();
+}
+
+void HPSSProcessor::applyActiveBand() noexcept
+{
+    // Analysis grid: every bin the band touches (rounded outwards).
+    const auto& analysis = lanes_[0].analysisStft ? *lanes_[0].analysisStft : *lanes_[0].stftProcessor;
+    const double binHz = currentSampleRate_ / analysis.getFftSize();
+    const bool toNyquist = bandHighHz_ <= 0.0f || bandHighHz_ >= currentSampleRate_ * 0.5;
+    bandStart_ = juce::jlimit(0, numBins_ - 1, static_cast<int>(std::floor(bandLowHz_ / binHz)));
+    bandEnd_ = toNyquist ? numBins_
+                         : juce::jlimit(bandStart_ + 1, numBins_, static_cast<int>(std::ceil(bandHighHz_ / binHz)) + 1);
+
+    // Synthesis grid (Partitioned): the bins whose centres lie within the
+    // analysis band. The masks mapped onto the ones straddling its edges
+    // already blend in the out-of-band split.
+    synthesisBandStart_ = 0;
+    synthesisBandEnd_ = synthesisBins_;
+    if (synthesis_ == Synthesis::Partitioned)
+    {
+        const double ratio = static_cast<double>(lanes_[0].stftProcessor->getFftSize()) / analysis.getFftSize();
+        synthesisBandStart_ = juce::jlimit(0, synthesisBins_, static_cast<int>(std::ceil(bandStart_ * ratio)));
+        synthesisBandEnd_ = bandEnd_ == numBins_ ? synthesisBins_
+                          : juce::jlimit(synthesisBandStart_, synthesisBins_,
+                                         static_cast<int>(std::floor((bandEnd_ - 1) * ratio)) + 1);
+    }
+
+    for (auto& lane : lanes_)
+    {
+        if (! lane.maskEstimator)
+            continue;
+        if (outOfBand_ == OutOfBand::Noise)
+            lane.maskEstimator->setOutOfBandSplit(0.0f, 0.0f, 1.0f);
+        else
+            lane.maskEstimator->setOutOfBandSplit(1.0f, 0.0f, 0.0f);
+        lane.maskEstimator->setActiveBand(bandStart_, bandEnd_);
+    }
+}
+
+void HPSSProcessor::setSpectralBrightness(float gainDb) noexcept
+{
+    brightnessSmoother_.setTargetValue(juce::jlimit(BrightnessShelf::kMinDb, BrightnessShelf::kMaxDb, gainDb));
+}
+
+void HPSSProcessor::snapSpectralBrightness(float gainDb) noexcept
+{
+    brightnessSmoother_.setCurrentAndTargetValue(juce::jlimit(BrightnessShelf::kMinDb, BrightnessShelf::kMaxDb, gainDb));
+}
+
 void HPSSProcessor::setSpectralFloor(float threshold) noexcept
 {
     spectralFloor_ = juce::jlimit(0.0f, 1.0f, threshold);
-    if (maskEstimator_)
+    for (auto& lane : lanes_)
     {
-        maskEstimator_->setSpectralFloor(spectralFloor_);
+        if (lane.maskEstimator)
+            lane.maskEstimator->setSpectralFloor(spectralFloor_);
     }
 }
 
@@ -249,36 +1197,53 @@ void HPSSProcessor::setSpectralFloor(float threshold) noexcept
 // Debug and Analysis Interface
 // =============================================================================
 
-juce::Span<const float> HPSSProcessor::getCurrentMagnitudes() const noexcept
+juce::Span<const float> HPSSProcessor::getCurrentMagnitudes(int channel) const noexcept
 {
-    if (!magPhaseFrame_ || !magPhaseFrame_->isPrepared())
+    if (channel < 0 || channel >= getNumChannels())
+        return {};
+
+    const auto& frame = lanes_[(size_t) channel].magPhaseFrame;
+    if (!frame || !frame->isPrepared())
         return {};
     
-    return magPhaseFrame_->getMagnitudes();
+    return frame->getMagnitudes();
 }
 
-juce::Span<const float> HPSSProcessor::getCurrentTonalMask() const noexcept
+juce::Span<const float> HPSSProcessor::getCurrentTonalMask(int channel) const noexcept
 {
-    if (tonalMaskBuffer_.empty())
+    if (tonalMasks_.empty() || channel < 0 || channel >= getNumChannels())
         return {};
     
-    return juce::Span<const float>(tonalMaskBuffer_);
+    return juce::Span<const float>(tonalMasks_.data() + maskOffset(channel), (size_t) numBins_);
 }
 
-juce::Span<const float> HPSSProcessor::getCurrentNoiseMask() const noexcept
+juce::Span<const float> HPSSProcessor::getCurrentNoiseMask(int channel) const noexcept
 {
-    if (noiseMaskBuffer_.empty())
+    if (noiseMasks_.empty() || channel < 0 || channel >= getNumChannels())
         return {};
 
-    return juce::Span<const float>(noiseMaskBuffer_);
+    return juce::Span<const float>(noiseMasks_.data() + maskOffset(channel), (size_t) numBins_);
 }
 
-juce::Span<const float> HPSSProcessor::getCurrentTransientMask() const noexcept
+juce::Span<const float> HPSSProcessor::getCurrentTransientMask(int channel) const noexcept
 {
-    if (transientMaskBuffer_.empty())
+    if (transientMasks_.empty() || channel < 0 || channel >= getNumChannels())
         return {};
 
-    return juce::Span<const float>(transientMaskBuffer_);
+    return juce::Span<const float>(transientMasks_.data() + maskOffset(channel), (size_t) numBins_);
+}
+
+void HPSSProcessor::collectStageTicks(DspProfiler::BlockRecord& record) noexcept
+{
+    record.stageTicks.fill(0);
+    record.numFrames = 0;
+    for (auto& lane : lanes_)
+    {
+        for (size_t s = 0; s < record.stageTicks.size(); ++s)
+            record.stageTicks[s] += lane.profile.ticks[s];
+        record.numFrames += static_cast<int>(lane.profile.calls[(size_t) DspProfiler::Stage::ForwardFFT]);
+        lane.profile.clear();
+    }
 }
 
 // =============================================================================
@@ -287,45 +1252,435 @@ juce::Span<const float> HPSSProcessor::getCurrentTransientMask() const noexcept
 
 void HPSSProcessor::initializeComponents() noexcept
 {
-    // Choose STFT configuration based on quality mode
-    STFTProcessor::Config stftConfig = useHighQuality_
-        ? STFTProcessor::Config::highQuality()    // 2048/512 - ~32ms latency
-        : STFTProcessor::Config::lowLatency();    // 1024/256 - ~15ms latency
+    // Choose STFT configuration based on quality mode, hop from the overlap,
+    // both scaled with the sample rate so the window keeps its length in ms
+    // (4096/1024 at 96k) and the masks their reach in Hz and frames
+    STFTProcessor::Config stftConfig = (useHighQuality_
+        ? STFTProcessor::Config::highQuality()    // 2048/512 - ~43ms latency
+        : STFTProcessor::Config::lowLatency())    // 1024/256 - ~21ms latency
+        .withOverlap(overlap_).atSampleRate(currentSampleRate_);
+    pipelining_ = pipelineRequested_ && synthesis_ == Synthesis::FullFrame;
+    stemOutputs_ = stemOutputsRequested_;
+    stftConfig.numOutputs = stemOutputs_ ? 3 : 1;
+
+    for (auto& lane : lanes_)
+    {
+        // Create STFT processor
+        if (synthesis_ == Synthesis::Partitioned)
+        {
+            // Masks are estimated on the quality mode's STFT (analysis only)
+            // and applied on the short synthesis STFT.
+            auto analysisConfig = stftConfig;
+            analysisConfig.analysisOnly = true;
+            analysisConfig.numOutputs = 1;
+            lane.analysisStft = std::make_unique<STFTProcessor>(analysisConfig);
+            lane.analysisStft->prepare(currentSampleRate_, currentBlockSize_);
+            auto synthesisConfig = STFTProcessor::Config::partitionedSynthesis().atSampleRate(currentSampleRate_);
+            synthesisConfig.numOutputs = stftConfig.numOutputs;
+            lane.stftProcessor = std::make_unique<STFTProcessor>(synthesisConfig);
+        }
+        else
+        {
+            lane.analysisStft.reset();
+            lane.stftProcessor = std::make_unique<STFTProcessor>(stftConfig);
+        }
+
+        // A block that ends inside a hop reads part of it before its frame
+        // lands, and the stream would slip by the difference: wait up to a
+        // hop, so the latency is the same at every block size. Always, not
+        // just when the prepared size is unaligned: hosts send shorter and
+        // split blocks under the maximum, so whole-hop blocks at prepare()
+        // promise nothing about the ones that follow.
+        // Pipelining finishes each frame up to a hop late: one hop more.
+        const int synthesisHop = lane.stftProcessor->getHopSize();
+        lane.stftProcessor->setOutputDelay(synthesisHop - 1 + (pipelining_ ? synthesisHop : 0));
+        lane.stftProcessor->prepare(currentSampleRate_, currentBlockSize_);
+
+        // Store number of bins (may have changed with quality mode)
+        numBins_ = stftConfig.getNumBins();
+        synthesisBins_ = lane.stftProcessor->getNumBins();
+
+        // Create magnitude/phase frame
+        lane.magPhaseFrame = std::make_unique<MagPhaseFrame>(numBins_);
 
-    // Create STFT processor
-    stftProcessor_ = std::make_unique<STFTProcessor>(stftConfig);
-    stftProcessor_->prepare(currentSampleRate_, currentBlockSize_);
+        // Create mask estimator. Every lane gets one, even though Linked mode
+        // only drives lane 0's, so switching modes never allocates.
+        lane.maskEstimator = std::make_unique<MaskEstimator>();
+        lane.maskEstimator->setHistoryFormat(historyFormat_);
+        lane.maskEstimator->prepare(numBins_, currentSampleRate_);
 
-    // Store number of bins (may have changed with quality mode)
-    numBins_ = stftProcessor_->getNumBins();
+        // Apply current separation parameters
+        lane.maskEstimator->setSeparation(separation_);
+        lane.maskEstimator->setFocus(focus_);
+        lane.maskEstimator->setSpectralFloor(spectralFloor_);
+        configureTier(*lane.maskEstimator);
+        lane.maskEstimator->setWarmStart(warmStart_);
 
-    // Create magnitude/phase frame
-    magPhaseFrame_ = std::make_unique<MagPhaseFrame>(numBins_);
+        // The tracker's long-window view of the low band (per lane, so a
+        // lane's input only ever reaches its own filter state).
+        lane.lowBand = std::make_unique<LowBandAnalyzer>();
+        lane.lowBand->prepare(currentSampleRate_);
 
-    // Create mask estimator
-    maskEstimator_ = std::make_unique<MaskEstimator>();
-    maskEstimator_->prepare(numBins_, currentSampleRate_);
+        // The gate measures the frames the estimator sees (the analysis STFT's).
+        lane.silenceGate.prepare(stftConfig.fftSize);
+        lane.silenceGate.setThresholdDb(silenceGateDb_);
+        lane.frameSilent = false;
+        lane.masksShared = false;
+        lane.analysisFrame = 0;
+        lane.tierFadeFrames = 0;
+        lane.analysisRestartPending = false;
 
-    // Apply current separation parameters
-    maskEstimator_->setSeparation(separation_);
-    maskEstimator_->setFocus(focus_);
+        // Each lane times into its own accumulator, so lanes running on
+        // different workers never share one (Linked: lane 0's estimator
+        // runs between lane batches, on the audio thread).
+        lane.profile.clear();
+        lane.stftProcessor->setProfileAccumulator(&lane.profile);
+        lane.maskEstimator->setProfileAccumulator(&lane.profile);
+        if (lane.analysisStft)
+            lane.analysisStft->setProfileAccumulator(&lane.profile);
+    }
+
+    // The band on the new grid (or grids).
+    applyActiveBand();
+
+    // One arena block for the engine's channel-major buffers, sized for the
+    // new bin / channel count (critical when switching quality modes) and in
+    // the order a frame uses them: per-frame gains, linked magnitudes, masks,
+    // then the gains applied to the bins. The short-grid buffers (empty
+    // unless Partitioned) sit between the analysis masks and the gains.
+    // A block of maxBlockSize samples can complete at most
+    // ceil(maxBlockSize / hop) frames, plus one already buffered.
+    const bool partitioned = (synthesis_ == Synthesis::Partitioned);
+    const size_t laneBins = lanes_.size() * static_cast<size_t>(numBins_);
+    const size_t synthesisLaneBins = partitioned ? lanes_.size() * static_cast<size_t>(synthesisBins_) : 0;
+    const int hopSize = lanes_[0].stftProcessor->getHopSize();
+    arena_.clear();
+    arena_.add(frameGains_, static_cast<size_t>((currentBlockSize_ + hopSize - 1) / hopSize + 1));
+    arena_.add(brightnessWeights_, static_cast<size_t>(numBins_));
+    arena_.add(synthesisBrightnessWeights_, partitioned ? static_cast<size_t>(synthesisBins_) : 0);
+    arena_.add(linkedMagnitudes_, static_cast<size_t>(numBins_));
+    arena_.add(linkedLowBand_, static_cast<size_t>(lanes_[0].lowBand->getNumBins()));
+    arena_.add(tonalMasks_, laneBins);
+    arena_.add(transientMasks_, laneBins);
+    arena_.add(noiseMasks_, laneBins);
+    arena_.add(analysisPower_, partitioned ? laneBins : 0);
+    arena_.add(synthesisTonalMasks_, synthesisLaneBins);
+    arena_.add(synthesisTransientMasks_, synthesisLaneBins);
+    arena_.add(synthesisNoiseMasks_, synthesisLaneBins);
+    arena_.add(binGains_, laneBins);
+    arena_.add(synthesisGains_, synthesisLaneBins);
+    arena_.add(tierFadeTonal_, laneBins);
+    arena_.add(tierFadeTransient_, laneBins);
+    arena_.add(tierFadeNoise_, laneBins);
+    arena_.add(prerollOutput_, static_cast<size_t>(stftConfig.numOutputs) * lanes_.size()
+                               * static_cast<size_t>(currentBlockSize_));
+    arena_.allocate();                      // Zero-filled
+    std::fill(frameGains_.begin(), frameGains_.end(), FrameGains{});
+
+    // preroll()'s block pointers: inputs per channel, outputs per stream
+    // (unused streams point at the first's slices).
+    prerollInputs_.assign(lanes_.size(), nullptr);
+    prerollOutputs_.assign(3 * lanes_.size(), nullptr);
+    for (size_t i = 0; i < prerollOutputs_.size(); ++i)
+        prerollOutputs_[i] = prerollOutput_.data()
+                           + (i % (static_cast<size_t>(stftConfig.numOutputs) * lanes_.size()))
+                           * static_cast<size_t>(currentBlockSize_);
 
-    // Resize mask buffers for new bin count (critical when switching quality modes)
-    tonalMaskBuffer_.resize(numBins_, 0.0f);
-    noiseMaskBuffer_.resize(numBins_, 0.0f);
-    transientMaskBuffer_.resize(numBins_, 0.0f);
+    // Spectral brightness on the grids the gains are computed on.
+    BrightnessShelf::prepareGrid(brightnessGrid_, currentSampleRate_, stftConfig.fftSize, numBins_);
+    if (partitioned)
+        BrightnessShelf::prepareGrid(synthesisBrightnessGrid_, currentSampleRate_,
+                                     lanes_[0].stftProcessor->getFftSize(), synthesisBins_);
+    brightnessWeightsDb_ = brightnessSmoother_.getCurrentValue();
+    buildBrightnessWeights();
 
-    // Resize and reinitialize bypass buffer for new latency
+    // Partitioned: the analysis STFTs primed so their frames complete on
+    // synthesis frame boundaries (the analysis hop is a whole number of
+    // synthesis hops).
+    analysisCountdown_ = lanes_[0].stftProcessor->getFftSize();
+    if (partitioned)
+    {
+        jassert(stftConfig.fftSize > analysisCountdown_);
+        jassert(stftConfig.hopSize % lanes_[0].stftProcessor->getHopSize() == 0);
+        maskReconciler_.prepare(numBins_, synthesisBins_);
+        analysisPrimer_.assign(static_cast<size_t>(stftConfig.fftSize - analysisCountdown_), 0.0f);
+        for (auto& lane : lanes_)
+            primeAnalysis(lane);
+    }
+
+    // Resize and reinitialize bypass buffers for new latency
+    // Write position starts ahead of read position by latency amount
+    // This creates the proper delay for bypass mode
     const int latencyInSamples = getLatencyInSamples();
-    bypassBuffer_.resize(latencyInSamples + currentBlockSize_, 0.0f);
-    std::fill(bypassBuffer_.begin(), bypassBuffer_.end(), 0.0f);
-    bypassWritePos_ = latencyInSamples;
-    bypassReadPos_ = 0;
+    for (auto& lane : lanes_)
+    {
+        lane.bypassBuffer.assign(static_cast<size_t>(latencyInSamples + currentBlockSize_), 0.0f);
+        lane.bypassWritePos = latencyInSamples;  // Write ahead by latency
+        lane.bypassReadPos = 0;                  // Read from beginning (zeros = initial silence)
+    }
+}
+
+bool HPSSProcessor::estimateLinkedMasks(int numChannels) noexcept
+{
+    const bool estimated = beginLinkedMasks(numChannels);
+    if (estimated)
+        finishFrameMasks(*lanes_[0].maskEstimator,
+                         juce::Span<const float>(linkedMagnitudes_.data(), (size_t) numBins_), 0);
+    return estimated;
+}
+
+bool HPSSProcessor::beginLinkedMasks(int numChannels) noexcept
+{
+    // Per-bin max across channels: a source panned anywhere (or out of
+    // phase between channels) is seen at its loudest.
+    auto* linkedMags = linkedMagnitudes_.data();
+    juce::FloatVectorOperations::copy(linkedMags, lanes_[0].magPhaseFrame->getMagnitudes().data(), numBins_);
+    for (int ch = 1; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::max(linkedMags, linkedMags,
+                                         lanes_[(size_t) ch].magPhaseFrame->getMagnitudes().data(), numBins_);
+
+    // Likewise for the tracker's low-band spectra.
+    auto* linkedLowBand = linkedLowBand_.data();
+    const int lowBandBins = static_cast<int>(linkedLowBand_.size());
+    juce::FloatVectorOperations::copy(linkedLowBand, lanes_[0].lowBand->getMagnitudes().data(), lowBandBins);
+    for (int ch = 1; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::max(linkedLowBand, linkedLowBand,
+                                         lanes_[(size_t) ch].lowBand->getMagnitudes().data(), lowBandBins);
+
+    // The max is all zero only if every channel is, so one gate decides
+    // for all of them.
+    auto& gate = lanes_[0].silenceGate;
+    const bool estimated = beginFrameMasks(gate, *lanes_[0].maskEstimator,
+                                           juce::Span<const float>(linkedMags, (size_t) numBins_),
+                                           juce::Span<const float>(linkedLowBand, (size_t) lowBandBins),
+                                           0, sharedAnalysis_ != nullptr ? sharedAnalysis_->getLinkedSlice() : 0);
+    for (int ch = 0; ch < numChannels; ++ch)
+        lanes_[(size_t) ch].frameSilent = gate.isSilent();
+    return estimated;
+}
+
+bool HPSSProcessor::estimateFrameMasks(SilenceGate& gate, MaskEstimator& estimator,
+                                       juce::Span<const float> magnitudes,
+                                       juce::Span<const float> lowBand, int slice) noexcept
+{
+    if (! beginFrameMasks(gate, estimator, magnitudes, lowBand, slice, slice))
+        return false;
+
+    finishFrameMasks(estimator, magnitudes, slice);
+    return true;
+}
+
+bool HPSSProcessor::beginFrameMasks(SilenceGate& gate, MaskEstimator& estimator,
+                                    juce::Span<const float> magnitudes, juce::Span<const float> lowBand,
+                                    int slice, int sharedSlice) noexcept
+{
+    // Hold: the slice keeps the masks of the last estimated frame, and the
+    // estimator its history of quiet frames, until the signal returns.
+    if (gate.process(magnitudes) == SilenceGate::Action::Hold)
+        return false;
+
+    // Shared: the group's masks are in the slice already, all stages done.
+    auto& lane = lanes_[(size_t) slice];
+    lane.masksShared = sharedAnalysis_ != nullptr && shareFrameMasks(slice, sharedSlice, magnitudes, lowBand);
+    if (lane.masksShared)
+        return true;
+
+    estimator.setLowBand(lowBand);
+    estimator.updateGuides(magnitudes);
+    return true;
+}
+
+void HPSSProcessor::finishFrameMasks(MaskEstimator& estimator, juce::Span<const float> magnitudes, int slice) noexcept
+{
+    auto& lane = lanes_[(size_t) slice];
+    if (! lane.masksShared)
+    {
+        const size_t offset = static_cast<size_t>(slice) * static_cast<size_t>(numBins_);
+        estimator.updateStats(magnitudes);
+        estimator.computeMasks(juce::Span<float>(tonalMasks_.data() + offset, (size_t) numBins_),
+                               juce::Span<float>(transientMasks_.data() + offset, (size_t) numBins_),
+                               juce::Span<float>(noiseMasks_.data() + offset, (size_t) numBins_));
+    }
+
+    if (lane.tierFadeFrames > 0)
+        fadeTierMasks(slice);
+}
+
+void HPSSProcessor::applyQualityTier(int numChannels) noexcept
+{
+    // Each channel fades from the masks it used last (its linked slice, if
+    // it was linked) into its slice under the new tier. Linked after the
+    // change, only slice 0 is estimated, so only it fades; before the first
+    // frame there are no masks to fade from.
+    const auto bins = static_cast<size_t>(numBins_);
+    const bool linkedAfter = (channelLink_ == ChannelLink::Linked
+                              || requestedTier_ >= QualityGovernor::Tier::LinkedAnalysis) && numChannels > 1;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const size_t from = maskOffset(ch);
+        const size_t to = static_cast<size_t>(ch) * bins;
+        std::copy_n(tonalMasks_.data() + from, bins, tierFadeTonal_.data() + to);
+        std::copy_n(transientMasks_.data() + from, bins, tierFadeTransient_.data() + to);
+        std::copy_n(noiseMasks_.data() + from, bins, tierFadeNoise_.data() + to);
+        auto& lane = lanes_[(size_t) ch];
+        lane.tierFadeFrames = ((linkedAfter && ch > 0) || lane.analysisFrame == 0) ? 0 : kTierCrossfadeFrames;
+    }
+
+    qualityTier_ = requestedTier_;
+    for (auto& lane : lanes_)
+        configureTier(*lane.maskEstimator);
+}
+
+void HPSSProcessor::configureTier(MaskEstimator& estimator) const noexcept
+{
+    using Tier = QualityGovernor::Tier;
+    estimator.setLowFreqTracking(qualityTier_ < Tier::NoLowFreqTracker);
+    estimator.setVerticalMedianSize(qualityTier_ < Tier::ShortVerticalMedian
+                                        ? MaskEstimator::getMaxVerticalMedianSize()
+                                        : QualityGovernor::kShortVerticalMedianSize);
+    estimator.setMaskDecimation(qualityTier_ < Tier::DecimatedMasks
+                                    ? maskDecimation_
+                                    : std::max(maskDecimation_, QualityGovernor::kMaskDecimationInterval));
+}
+
+void HPSSProcessor::fadeTierMasks(int slice) noexcept
+{
+    // The old tier's last masks weigh n / (N + 1) on the n-th frame left of
+    // N. Both sets sum to one per bin, so the blend stays mass-conserving.
+    auto& lane = lanes_[(size_t) slice];
+    UNRAVEL_PROFILE_STAGE(&lane.profile, MaskPostProcessing);
+    const float weight = static_cast<float>(lane.tierFadeFrames) / static_cast<float>(kTierCrossfadeFrames + 1);
+    --lane.tierFadeFrames;
+
+    const size_t offset = static_cast<size_t>(slice) * static_cast<size_t>(numBins_);
+    auto fade = [&](DspArena::Buffer<float>& masks, const DspArena::Buffer<float>& before) noexcept
+    {
+        float* mask = masks.data() + offset;
+        const float* old = before.data() + offset;
+        for (int b = 0; b < numBins_; ++b)
+            mask[b] += (old[b] - mask[b]) * weight;
+    };
+    fade(tonalMasks_, tierFadeTonal_);
+    fade(transientMasks_, tierFadeTransient_);
+    fade(noiseMasks_, tierFadeNoise_);
+}
+
+bool HPSSProcessor::shareFrameMasks(int slice, int sharedSlice, juce::Span<const float> magnitudes,
+                                    juce::Span<const float> lowBand) noexcept
+{
+    auto& lane = lanes_[(size_t) slice];
+    const size_t offset = static_cast<size_t>(slice) * static_cast<size_t>(numBins_);
+    const auto bins = static_cast<size_t>(numBins_);
+    const auto outcome = sharedAnalysis_->estimate(sharedSlice, { sharedEpoch_, lane.analysisFrame },
+                                                   { separation_, focus_, spectralFloor_, bandStart_, bandEnd_,
+                                                     outOfBand_ == OutOfBand::Noise },
+                                                   magnitudes, lowBand,
+                                                   juce::Span<float>(tonalMasks_.data() + offset, bins),
+                                                   juce::Span<float>(transientMasks_.data() + offset, bins),
+                                                   juce::Span<float>(noiseMasks_.data() + offset, bins),
+                                                   &lane.profile);
+    return outcome != SharedAnalysis::Outcome::Missed;
+}
+
+void HPSSProcessor::computeBinGains(const float* tonal, const float* transient, const float* noise,
+                                    float* gains, float tonalGain, float noiseGain,
+                                    float transientGain, int numBins) const noexcept
+{
+    juce::FloatVectorOperations::multiply(gains, tonal, tonalGain, numBins);
+    juce::FloatVectorOperations::addWithMultiply(gains, transient, transientGain, numBins);
+    juce::FloatVectorOperations::addWithMultiply(gains, noise, noiseGain, numBins);
+    passOutOfBand(gains, numBins);
+
+    // Partitioned synthesis computes short-grid gains; everything else is on
+    // the analysis grid.
+    if (brightnessActive_)
+        juce::FloatVectorOperations::multiply(gains, numBins == numBins_ ? brightnessWeights_.data()
+                                                                         : synthesisBrightnessWeights_.data(),
+                                              numBins);
+}
+
+void HPSSProcessor::passOutOfBand(float* gains, int numBins) const noexcept
+{
+    if (outOfBand_ != OutOfBand::PassThrough)
+        return;
+
+    const bool analysisGrid = numBins == numBins_;
+    const int start = analysisGrid ? bandStart_ : synthesisBandStart_;
+    const int end = analysisGrid ? bandEnd_ : synthesisBandEnd_;
+    if (start > 0)
+        juce::FloatVectorOperations::fill(gains, 1.0f, start);
+    if (end < numBins)
+        juce::FloatVectorOperations::fill(gains + end, 1.0f, numBins - end);
+}
+
+void HPSSProcessor::updateSpectralBrightness(int numSamples) noexcept
+{
+    const float gainDb = brightnessSmoother_.skip(numSamples);
+    if (gainDb == brightnessWeightsDb_)
+        return;
+
+    brightnessWeightsDb_ = gainDb;
+    buildBrightnessWeights();
+}
+
+void HPSSProcessor::buildBrightnessWeights() noexcept
+{
+    // 0 dB is the identity: skip the multiply rather than apply ones.
+    brightnessActive_ = (brightnessWeightsDb_ != 0.0f);
+    if (! brightnessActive_)
+        return;
+
+    const auto coefficients = BrightnessShelf::design(currentSampleRate_, brightnessWeightsDb_);
+    BrightnessShelf::getMagnitudes(coefficients, brightnessGrid_, brightnessWeights_.data());
+    if (synthesisBrightnessWeights_.size() > 0)
+        BrightnessShelf::getMagnitudes(coefficients, synthesisBrightnessGrid_, synthesisBrightnessWeights_.data());
+}
+
+void HPSSProcessor::applyBinGains(ChannelLane& lane, const float* gains) noexcept
+{
+    auto complexFrame = lane.stftProcessor->getCurrentFrame();
+    auto magnitudes = lane.magPhaseFrame->getMagnitudes();
+
+    // The gained magnitude is written back either way so the visualiser
+    // sees the same post-gain spectrum in both modes.
+    if (maskApplication_ == MaskApplication::Complex)
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+        for (int bin = 0; bin < numBins_; ++bin)
+        {
+            const float gain = gains[bin];
+            const float gainedMag = magnitudes[bin] * gain;
+
+            // Mirror the polar path's zeroing of sub-epsilon magnitudes
+            // so both modes silence exactly the same bins.
+            if (gainedMag < kEpsilon)
+            {
+                magnitudes[bin] = 0.0f;
+                complexFrame[bin] = {};
+            }
+            else
+            {
+                magnitudes[bin] = gainedMag;
+                complexFrame[bin] *= gain;
+            }
+        }
+    }
+    else
+    {
+        UNRAVEL_PROFILE_STAGE(&lane.profile, GainApplication);
+        juce::FloatVectorOperations::multiply(magnitudes.data(), gains, numBins_);
+
+        // Convert back to complex representation
+        lane.magPhaseFrame->toComplex(complexFrame);
+    }
+
+    // Set the processed frame back to STFT processor
+    lane.stftProcessor->setCurrentFrame(complexFrame);
 }
 
 void HPSSProcessor::updateParameterSmoothing(float tonalGain, float noiseGain, float transientGain) noexcept
 {
-    // Set target values for smoothers; advanced per-frame inside processBlock().
+    // Set target values for smoothers; advanced per-frame by scheduleFrameGains().
     tonalGainSmoother_.setTargetValue(tonalGain);
     noiseGainSmoother_.setTargetValue(noiseGain);
     transientGainSmoother_.setTargetValue(transientGain);
@@ -350,29 +1705,43 @@ void HPSSProcessor::applySafetyLimiting(float* buffer, int numSamples) noexcept
     }
 }
 
-void HPSSProcessor::processBypass(const float* inputBuffer, float* outputBuffer, int numSamples) noexcept
+void HPSSProcessor::processBypass(ChannelLane& lane, const float* inputBuffer,
+                                  float* outputBuffer, int numSamples) noexcept
 {
-    const int latency = getLatencyInSamples();
-    const int bufferSize = static_cast<int>(bypassBuffer_.size());
+    writeBypassDelay(lane, inputBuffer, numSamples);
+    readBypassDelay(lane, outputBuffer, numSamples);
+}
+
+void HPSSProcessor::writeBypassDelay(ChannelLane& lane, const float* inputBuffer, int numSamples) noexcept
+{
+    const int bufferSize = static_cast<int>(lane.bypassBuffer.size());
     
     // Write input to delay buffer
     for (int i = 0; i < numSamples; ++i)
     {
-        bypassBuffer_[bypassWritePos_] = inputBuffer[i];
-        bypassWritePos_ = (bypassWritePos_ + 1) % bufferSize;
+        lane.bypassBuffer[(size_t) lane.bypassWritePos] = inputBuffer[i];
+        lane.bypassWritePos = (lane.bypassWritePos + 1) % bufferSize;
     }
+}
+
+void HPSSProcessor::readBypassDelay(ChannelLane& lane, float* outputBuffer, int numSamples) noexcept
+{
+    const int bufferSize = static_cast<int>(lane.bypassBuffer.size());
     
     // Read delayed output
     for (int i = 0; i < numSamples; ++i)
     {
-        outputBuffer[i] = bypassBuffer_[bypassReadPos_];
-        bypassReadPos_ = (bypassReadPos_ + 1) % bufferSize;
+        outputBuffer[i] = lane.bypassBuffer[(size_t) lane.bypassReadPos];
+        lane.bypassReadPos = (lane.bypassReadPos + 1) % bufferSize;
     }
 }
 
-bool HPSSProcessor::tryUnityGainPath(const float* inputBuffer, float* outputBuffer,
-                                    int numSamples,
-                                    float tonalGain, float noiseGain, float transientGain) noexcept
+void HPSSProcessor::skipBypassDelay(ChannelLane& lane, int numSamples) noexcept
+{
+    lane.bypassReadPos = (lane.bypassReadPos + numSamples) % static_cast<int>(lane.bypassBuffer.size());
+}
+
+bool HPSSProcessor::isUnityGain(float tonalGain, float noiseGain, float transientGain) const noexcept
 {
     auto nearUnity = [](float v) noexcept { return std::abs(v - 1.0f) < kEpsilon; };
 
@@ -381,15 +1750,13 @@ bool HPSSProcessor::tryUnityGainPath(const float* inputBuffer, float* outputBuff
     if (! (nearUnity(tonalGain) && nearUnity(noiseGain) && nearUnity(transientGain)))
         return false;
 
-    // And all three smoothers settled at unity (target and current)?
-    if (! (nearUnity(tonalGainSmoother_.getCurrentValue())     && nearUnity(tonalGainSmoother_.getTargetValue())
-        && nearUnity(noiseGainSmoother_.getCurrentValue())     && nearUnity(noiseGainSmoother_.getTargetValue())
-        && nearUnity(transientGainSmoother_.getCurrentValue()) && nearUnity(transientGainSmoother_.getTargetValue())))
+    // A spectral shelf reshapes every frame, unity streams or not.
+    if (brightnessActive_)
         return false;
 
-    // Bit-perfect passthrough with matched latency.
-    processBypass(inputBuffer, outputBuffer, numSamples);
-    return true;
+    // And all three smoothers settled at unity (target and current)? A ramp
+    // towards unity keeps resynthesising until it has landed.
+    return nearUnity(tonalGainSmoother_.getCurrentValue())     && nearUnity(tonalGainSmoother_.getTargetValue())
+        && nearUnity(noiseGainSmoother_.getCurrentValue())     && nearUnity(noiseGainSmoother_.getTargetValue())
+        && nearUnity(transientGainSmoother_.getCurrentValue()) && nearUnity(transientGainSmoother_.getTargetValue());
 }
-
-
@@ -1,12 +1,23 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BrightnessShelf.h"
+#include "DspArena.h"
+#include "DspProfiler.h"
 #include "STFTProcessor.h"
+#include "LowBandAnalyzer.h"
 #include "MagPhaseFrame.h"
 #include "MaskEstimator.h"
+#include "MaskReconciler.h"
+#include "QualityGovernor.h"
+#include "SharedAnalysis.h"
+#include "SilenceGate.h"
+#include "SpectrumHistoryRing.h"
 #include <memory>
 #include <vector>
 
+class ChannelWorkerPool;
+
 /**
  * High-Performance HPSS Processor
  * 
@@ -16,23 +27,38 @@
  * 
  * Key Features:
  * - **Simple Interface**: Drop-in replacement for SinusoidalModelProcessor
- * - **Low Latency**: ~15ms with optimized 1024/256 STFT configuration
+ * - **Multichannel**: One engine processes every channel frame-synchronously;
+ *   per-channel masks and gains live in contiguous channel-major blocks
+ * - **Linked Stereo**: Optional shared mask estimation from the per-bin max
+ *   magnitude across channels (one estimator instead of N, stable image)
+ * - **Parallel Channels**: Optional ChannelWorkerPool runs the channels of
+ *   wide buses concurrently; results are identical to the serial path
+ * - **Low Latency**: ~21ms with optimized 1024/256 STFT configuration, or ~5ms
+ *   with partitioned synthesis (long-window masks on a 256/64 resynthesis)
  * - **Real-time Safe**: Zero allocations in processBlock()
- * - **Unity Gain Transparent**: Perfect passthrough when both gains = 1.0
+ * - **Unity Gain Transparent**: Bit-perfect passthrough when all three gains = 1.0;
+ *   analysis keeps running (no resynthesis), so leaving unity is seamless
+ * - **Silence Gate**: Optional per-frame gate that holds the masks through
+ *   quiet passages and skips the inverse FFT of all-zero frames
+ * - **Stem Outputs**: Optional tonal / noise / transient outputs from one
+ *   analysis, one inverse FFT per stream (processStemBlock())
+ * - **Quality Tiers**: Cheaper estimation settings a QualityGovernor can
+ *   step through under load, crossfaded and allocated up front
  * - **Parameter Smoothing**: Smooth gain transitions to prevent artifacts
  * - **Safety Limiting**: Soft limiting at -0.5dB to prevent clipping
  * - **JUCE Integration**: Compatible with existing plugin architecture
  * 
  * Processing Pipeline:
  * ```
- * Input Audio → STFTProcessor → MagPhaseFrame → MaskEstimator → 
- * Apply Gains + Masks → MagPhaseFrame → STFTProcessor → Output Audio
+ * Input Audio → STFTProcessor → MagPhaseFrame (magnitudes) → MaskEstimator →
+ * Apply Gains + Masks (real gain on the complex bins) → STFTProcessor → Output Audio
  * ```
  * 
  * Performance Targets:
- * - CPU Usage: <10% on modern systems
+ * - CPU Usage: <10% on modern systems (measure with UNRAVEL_DSP_PROFILING:
+ *   per-stage ticks via collectStageTicks(), load % in the editor header)
  * - Memory Usage: ~150KB per channel
- * - Latency: ~15ms at 48kHz (configurable)
+ * - Latency: ~21ms at 48kHz (configurable)
  * - Quality: Transparent separation with minimal artifacts
  * 
  * Usage Example:
@@ -42,17 +68,88 @@
  * 
  * // In audio callback:
  * processor.processBlock(inputBuffer, outputBuffer, numSamples,
- *                       tonalGain, noiseGain);
+ *                       tonalGain, noiseGain, transientGain);
+ *
+ * // Stereo, masks shared between L and R:
+ * processor.prepare(48000.0, 512, 2);
+ * processor.setChannelLink(HPSSProcessor::ChannelLink::Linked);
+ * processor.processBlock(inputs, outputs, 2, numSamples,
+ *                       tonalGain, noiseGain, transientGain);
  * ```
  */
 class HPSSProcessor
 {
 public:
+    /**
+     * How the per-bin stream gain is applied to each STFT frame.
+     *
+     * The combined gain (sum of mask × stream gain) is real and non-negative,
+     * so scaling the complex bins directly is equivalent to scaling the
+     * magnitude and re-attaching the original phase. Complex skips the
+     * atan2 / cos / sin round trip and is the default; Polar is the original
+     * mag/phase path, kept as the reference for the Harness comparison.
+     */
+    enum class MaskApplication
+    {
+        Complex,    ///< Magnitude-only analysis, real gain applied in place on the complex bins
+        Polar       ///< fromComplex → scale magnitudes → toComplex (reference)
+    };
+
+    /**
+     * How masks are estimated when more than one channel is processed.
+     *
+     * Independent runs one MaskEstimator per channel (the original per-channel
+     * behaviour). Linked runs a single estimator on the per-bin maximum
+     * magnitude across channels and applies the resulting masks to every
+     * channel: mask estimation cost no longer scales with the channel count,
+     * and L/R cannot receive different masks for the same source, so the
+     * stereo image does not wobble. Max (not mid) is used so out-of-phase
+     * content cannot cancel out of the analysis.
+     */
+    enum class ChannelLink
+    {
+        Independent,    ///< One mask estimate per channel
+        Linked          ///< One mask estimate from max |X| across channels, shared
+    };
+
+    /**
+     * Which STFT the masks are applied on.
+     *
+     * FullFrame estimates and resynthesises on the same STFT, so the latency
+     * is that STFT's fftSize - hopSize. Partitioned keeps the same
+     * analysis STFT (analysis only) and MaskEstimator, but resynthesises on a
+     * short 256/64 STFT (STFTProcessor::Config::partitionedSynthesis(), ~4 ms
+     * at 48 kHz). Each analysis frame's masks are mapped onto the short grid
+     * with MaskReconciler::mapWeighted() and held for the short frames until
+     * the next analysis frame. Estimation cost is unchanged and the reported
+     * latency is the short STFT's; the masks trail the audio by about half the
+     * analysis window, so onsets are classified a little late. Partitioned
+     * always applies gains to the complex bins (MaskApplication is ignored).
+     */
+    enum class Synthesis
+    {
+        FullFrame,      ///< Masks applied on the analysis STFT (latency = analysis fftSize - hop)
+        Partitioned     ///< Long-window analysis, short-hop resynthesis (latency 255 samples at 48 kHz)
+    };
+
     /**
      * Constructor with configurable quality settings.
-     * @param lowLatency If true, uses 1024/256 config (~15ms), else 2048/512 (~32ms)
+     * @param lowLatency If true, uses 1024/256 config (~21ms), else 2048/512 (~43ms)
+     *                   (Partitioned: the analysis STFT)
+     * @param synthesis  Where masks are applied (see Synthesis)
+     * @param overlap    Frame overlap of that STFT; the hop is fftSize / 2, 4
+     *                   or 8, and FullFrame latency fftSize - hop. Partitioned
+     *                   keeps its 256/64 synthesis grid. The estimator's time
+     *                   constants are in frames, as with the quality mode, so
+     *                   50% reacts over twice the time of 75%.
+     *
+     * The sizes are those at 44.1/48 kHz. prepare() scales every grid by
+     * STFTProcessor::Config::getSampleRateScale() (2048/512 is 4096/1024 at
+     * 96 kHz), so the latency in ms, the bin width in Hz and the time
+     * constants stay the same at any rate.
      */
-    explicit HPSSProcessor(bool lowLatency = true);
+    explicit HPSSProcessor(bool lowLatency = true, Synthesis synthesis = Synthesis::FullFrame,
+                           STFTProcessor::Overlap overlap = STFTProcessor::Overlap::ThreeQuarters);
     
     /**
      * Destructor - cleanup handled by RAII
@@ -63,28 +160,41 @@ public:
     
     /**
      * Prepare the processor for audio processing.
-     * Preallocates all buffers and initializes components.
+     * Preallocates all buffers and initializes components for every channel
+     * (including the estimators Linked mode leaves idle, so switching the
+     * link mode never allocates).
      * 
      * @param sampleRate Sample rate for processing
      * @param maxBlockSize Maximum expected block size
+     * @param numChannels Number of channels processBlock will be given (>= 1)
      */
-    void prepare(double sampleRate, int maxBlockSize) noexcept;
+    void prepare(double sampleRate, int maxBlockSize, int numChannels = 1) noexcept;
     
     /**
      * Reset all internal buffers and processing state.
      * Clears all history and resets to initial state.
      */
     void reset() noexcept;
+
+    /**
+     * Restart the analysis for a jump in the input (a transport relocation):
+     * the estimators, trackers, silence gates and tier crossfades start over
+     * from the next frame, as after reset(), while the STFTs, overlap-add,
+     * bypass delay and gain smoothers keep running, so the output already in
+     * flight plays out instead of a latency of silence. A frame held
+     * between blocks finishes with the history it began with. RT-safe.
+     */
+    void restartAnalysis() noexcept;
     
     /**
      * Process audio block with harmonic-percussive separation.
      * 
      * This is the main processing method that coordinates all components:
      * 1. STFT analysis via STFTProcessor
-     * 2. Magnitude/phase conversion via MagPhaseFrame  
+     * 2. Magnitude analysis via MagPhaseFrame
      * 3. Mask estimation via MaskEstimator
-     * 4. Apply gains and masks with safety limiting
-     * 5. Reconstruction via MagPhaseFrame and STFTProcessor
+     * 4. Apply gains and masks with safety limiting (see MaskApplication)
+     * 5. Reconstruction via STFTProcessor
      * 
      * @param inputBuffer Input audio samples
      * @param outputBuffer Mixed output (tonal + transient + noise)
@@ -100,6 +210,57 @@ public:
                      float noiseGain,
                      float transientGain) noexcept;
 
+    /**
+     * Process a multichannel block. All channels advance in lock step (same
+     * sample count, so their STFT frames become ready together); each frame
+     * is analysed for every channel, masked once per channel or once for all
+     * (see ChannelLink), and resynthesised. Mono processBlock() is this with
+     * numChannels = 1.
+     *
+     * @param inputs Per-channel input pointers (numChannels entries)
+     * @param outputs Per-channel output pointers; may alias inputs
+     * @param numChannels Channels to process (<= the count given to prepare())
+     * @param numSamples Number of samples to process
+     * @param tonalGain Linear gain for tonal component
+     * @param noiseGain Linear gain for noise (sustained / stochastic) component
+     * @param transientGain Linear gain for transient (short / impulsive) component
+     */
+    void processBlock(const float* const* inputs,
+                     float* const* outputs,
+                     int numChannels,
+                     int numSamples,
+                     float tonalGain,
+                     float noiseGain,
+                     float transientGain) noexcept;
+
+    /**
+     * Process a multichannel block into the three streams separately (see
+     * setStemOutputs()): each output carries one stream, masked and gained
+     * as processBlock() would, and the three sum to its mixed output. One
+     * analysis and mask estimate per frame feeds all three; each stream
+     * costs one inverse FFT and overlap-add. Bypassed, the dry (delayed)
+     * input goes to tonalOutputs and the other two are silent.
+     *
+     * @param inputs Per-channel input pointers (numChannels entries)
+     * @param tonalOutputs Per-channel tonal outputs; may alias inputs
+     * @param noiseOutputs Per-channel noise outputs
+     * @param transientOutputs Per-channel transient outputs
+     * @param numChannels Channels to process (<= the count given to prepare())
+     * @param numSamples Number of samples to process
+     * @param tonalGain Linear gain for tonal component
+     * @param noiseGain Linear gain for noise (sustained / stochastic) component
+     * @param transientGain Linear gain for transient (short / impulsive) component
+     */
+    void processStemBlock(const float* const* inputs,
+                          float* const* tonalOutputs,
+                          float* const* noiseOutputs,
+                          float* const* transientOutputs,
+                          int numChannels,
+                          int numSamples,
+                          float tonalGain,
+                          float noiseGain,
+                          float transientGain) noexcept;
+
     /**
      * Snap the three internal gain smoothers to the supplied target values
      * immediately (current = target, no ramp). Call after a host state load
@@ -113,7 +274,9 @@ public:
     
     /**
      * Get processing latency in samples.
-     * @return Latency in samples (depends on STFT configuration)
+     * @return Latency in samples (fftSize - hop of the output STFT, plus
+     *         a hop - 1 wait so the latency holds at any block size, and
+     *         pipelining one hop more)
      */
     int getLatencyInSamples() const noexcept;
     
@@ -126,16 +289,29 @@ public:
     
     /**
      * Get the number of frequency bins used.
-     * @return Number of frequency bins
+     * @return Number of frequency bins (Partitioned: of the analysis STFT,
+     *         which the masks and getCurrentMagnitudes() are on)
      */
     int getNumBins() const noexcept;
     
     /**
      * Get the FFT size used.
-     * @return FFT size in samples
+     * @return FFT size in samples (Partitioned: of the synthesis STFT)
      */
     int getFftSize() const noexcept;
 
+    /**
+     * Get the hop size used.
+     * @return Hop size in samples (Partitioned: of the synthesis STFT)
+     */
+    int getHopSize() const noexcept;
+
+    /**
+     * Get the number of channels prepared.
+     * @return Channel count given to prepare(), or 0 before prepare()
+     */
+    int getNumChannels() const noexcept { return static_cast<int>(lanes_.size()); }
+
     // === Advanced Features ===
     
     /**
@@ -158,6 +334,18 @@ public:
      * @return True if in high quality mode
      */
     bool isHighQuality() const noexcept { return useHighQuality_; }
+
+    /**
+     * Get the synthesis mode (fixed at construction, like the quality mode).
+     * @return Synthesis mode
+     */
+    Synthesis getSynthesis() const noexcept { return synthesis_; }
+
+    /**
+     * Get the frame overlap (fixed at construction, like the quality mode).
+     * @return Overlap of the analysis STFT
+     */
+    STFTProcessor::Overlap getOverlap() const noexcept { return overlap_; }
     
     /**
      * Enable/disable safety limiting.
@@ -172,6 +360,236 @@ public:
      */
     bool isSafetyLimitingEnabled() const noexcept { return safetyLimitingEnabled_; }
 
+    /**
+     * Select how masks are applied to the spectrum (see MaskApplication).
+     * Both modes produce the same masks and the same getCurrentMagnitudes()
+     * content; they differ only by float rounding in the reconstruction.
+     * @param mode Mask application mode
+     */
+    void setMaskApplication(MaskApplication mode) noexcept { maskApplication_ = mode; }
+
+    /**
+     * Get the current mask application mode.
+     * @return Mask application mode
+     */
+    MaskApplication getMaskApplication() const noexcept { return maskApplication_; }
+
+    /**
+     * Storage of the estimators' median history (see
+     * MaskEstimator::setHistoryFormat). Key16 halves the history's memory
+     * for a horizontal guide within 0.2% of the exact one. Call before
+     * prepare(), which allocates for it.
+     * @param format History format
+     */
+    void setHistoryFormat(SlidingMedian::HistoryFormat format) noexcept { historyFormat_ = format; }
+
+    /** The history format the next prepare() uses. */
+    SlidingMedian::HistoryFormat getHistoryFormat() const noexcept { return historyFormat_; }
+
+    /**
+     * Spread each frame's work over the callbacks of its hop instead of
+     * doing all of it in the callback that completes the frame. The callback
+     * that completes a frame runs its forward FFT, magnitudes and guides;
+     * the next callback computes its masks; the one after applies the gains
+     * and runs the inverse FFT. A callback that completes the next frame
+     * first finishes whatever is left of this one. With host blocks shorter
+     * than a hop, the worst callback then carries a fraction of a frame
+     * rather than all of it, for one more hop of latency
+     * (getLatencyInSamples() includes it). Output is the same as without,
+     * delayed by that hop. FullFrame only: Partitioned synthesis already
+     * works in 64-sample frames, so the setting is ignored there. Call
+     * before prepare(), which sets the latency.
+     * @param shouldPipeline True to pipeline frames
+     */
+    void setPipelining(bool shouldPipeline) noexcept { pipelineRequested_ = shouldPipeline; }
+
+    /** True if the prepared engine pipelines frames (requested, and FullFrame). */
+    bool isPipelining() const noexcept { return pipelining_; }
+
+    /**
+     * Resynthesise the tonal, noise and transient streams to separate
+     * outputs (processStemBlock()) instead of one mix. Each frame's bins are
+     * gained once per stream and run through their own inverse FFT into
+     * their own overlap-add buffer, so a frame costs three inverse FFTs
+     * instead of one, and never takes the transparent path (a stream on its
+     * own is not the input, whatever the gains). processBlock() still works,
+     * with the noise and transient streams dropped. Call before prepare(),
+     * which sizes the overlap-add buffers for it.
+     * @param shouldSplit True for stem outputs
+     */
+    void setStemOutputs(bool shouldSplit) noexcept { stemOutputsRequested_ = shouldSplit; }
+
+    /** True if the prepared engine resynthesises the streams separately. */
+    bool hasStemOutputs() const noexcept { return stemOutputs_; }
+
+    /**
+     * Select independent or linked mask estimation (see ChannelLink).
+     * RT-safe; takes effect on the next frame. No effect with one channel.
+     * @param mode Channel link mode
+     */
+    void setChannelLink(ChannelLink mode) noexcept { channelLink_ = mode; }
+
+    /**
+     * Get the current channel link mode.
+     * @return Channel link mode
+     */
+    ChannelLink getChannelLink() const noexcept { return channelLink_; }
+
+    /**
+     * Process channels on a worker pool (nullptr = serially on the calling
+     * thread, the default). The pool is not owned and must outlive its use
+     * here. Output is bit-identical either way: every lane reads the same
+     * precomputed per-frame gains, and linked lanes still join for the
+     * shared mask estimate once per frame.
+     * @param pool Worker pool, or nullptr
+     */
+    void setWorkerPool(ChannelWorkerPool* pool) noexcept;
+
+    /**
+     * Push every frame of channel 0 (post-gain magnitudes and the three
+     * masks, as getCurrentMagnitudes(0) etc. read after it) into a history
+     * ring as the frame completes (nullptr = none, the default). A ring of
+     * fewer bins than getNumBins() gets the lowest ones. The ring is not
+     * owned; set it before processBlock() and keep it until it is unset.
+     * @param history Ring to push to, or nullptr
+     */
+    void setSpectrumHistory(SpectrumHistoryRing* history) noexcept;
+
+    /**
+     * Estimate masks together with the other engines given the same
+     * SharedAnalysis (nullptr = on this engine's own estimators, the
+     * default): each frame's masks are computed once in the group, by
+     * whichever engine gets there first, and copied by the rest. STFTs,
+     * silence gates, gains and resynthesis stay per engine. The group must
+     * have been made for getSharedAnalysisLayout() (anything else is
+     * ignored), is not owned, and must outlive its use here. A frame the
+     * group can no longer supply is estimated here as before. RT-safe.
+     * @param shared Group to join, or nullptr
+     */
+    void setSharedAnalysis(SharedAnalysis* shared) noexcept;
+
+    /** The layout a SharedAnalysis has to match this prepared engine's. */
+    SharedAnalysis::Layout getSharedAnalysisLayout() const noexcept;
+
+    /**
+     * Run at a cheaper quality tier (see QualityGovernor): no low-frequency
+     * tracker, a shorter vertical median, decimated masks, linked analysis. Every tier runs
+     * on what prepare() allocated, so this is RT-safe. The tier changes at
+     * the next block that completes a frame, and each channel's masks then
+     * crossfade from the last ones of the old tier over
+     * kTierCrossfadeFrames frames instead of stepping. Frames handed over
+     * by a SharedAnalysis are estimated at the group's settings.
+     */
+    void setQualityTier(QualityGovernor::Tier tier) noexcept { requestedTier_ = tier; }
+
+    /** The tier frames are being estimated at. */
+    QualityGovernor::Tier getQualityTier() const noexcept { return qualityTier_; }
+
+    /** Frames a tier change is crossfaded over. */
+    static constexpr int kTierCrossfadeFrames = 4;
+
+    /**
+     * Run each estimator's full estimate only every interval-th frame
+     * (MaskEstimator::setMaskDecimation; 1 = every frame, the default, up
+     * to MaskEstimator::getMaxMaskDecimation()). In between the masks are
+     * held and smoothed, with onsets estimated at once, which cuts the
+     * median work on sustained material by up to the interval. The
+     * DecimatedMasks quality tier runs at least every other frame. RT-safe.
+     */
+    void setMaskDecimation(int interval) noexcept;
+    int getMaskDecimation() const noexcept { return maskDecimation_; }
+
+    /**
+     * restartAnalysis(), and number the frames that follow from a new
+     * epoch. Engines share a frame when they agree on its epoch and its
+     * index since, so all members of a group should resync at the same
+     * point of the same input (e.g. at every transport jump, with the host's
+     * timeline position). The epoch also takes in where the next analysis
+     * frame falls, so members whose frame grids are out of phase never
+     * share masks for different content: each then estimates alone, like a
+     * member out of step. prepare() starts every engine at epoch 0. RT-safe.
+     * @param epoch Position the group agrees on
+     */
+    void resyncSharedAnalysis(int64_t epoch) noexcept;
+
+    /**
+     * Warm-start the estimators after prepare() / reset() / a resync
+     * (MaskEstimator::setWarmStart; default off): the first frame seeds the
+     * history it lacks, so the masks do not take ~9 frames to settle after
+     * a session load or a transport jump. Part of getSharedAnalysisLayout()
+     * (a group's slices warm-start at each epoch), so set it before joining
+     * a group. RT-safe.
+     */
+    void setWarmStart(bool enabled) noexcept;
+    bool isWarmStart() const noexcept { return warmStart_; }
+
+    /**
+     * Run look-back audio through the engine, output discarded, so the next
+     * processBlock() continues as if the audio before it had been played:
+     * call after prepare() / reset() with the getPrerollSamples() samples
+     * that precede the first block (e.g. an offline render of a section),
+     * and the section then matches a render of the whole timeline from its
+     * first sample (to -60 dB with constant gains). The smoothers are
+     * snapped to the gains first. Shorter look-back still helps; none at
+     * all leaves only the warm start. RT-safe (any numSamples, processed
+     * in blocks of at most the prepared block size).
+     */
+    void preroll(const float* const* inputs, int numChannels, int numSamples,
+                 float tonalGain, float noiseGain, float transientGain) noexcept;
+
+    /**
+     * Look-back preroll() needs to match a full pass: the latency, one
+     * analysis window (the tracker's long one if longer), and the frames an
+     * estimator takes to forget its past (MaskEstimator::getSettlingFrames()).
+     */
+    int getPrerollSamples() const noexcept;
+
+    /** Stream gains (linear): smoothed per frame, or a GainSource's targets. */
+    struct FrameGains
+    {
+        float tonal = 1.0f;
+        float noise = 1.0f;
+        float transient = 1.0f;
+    };
+
+    /**
+     * Frame-boundary gain automation. With a source set, processBlock()
+     * ignores its gain arguments for the frames it produces (they still
+     * decide the transparent path) and asks the source for the targets at
+     * each frame instead, so where a gain change lands depends on the
+     * sample it happens at and not on the host block size.
+     */
+    class GainSource
+    {
+    public:
+        virtual ~GainSource() = default;
+
+        /**
+         * Target gains at a frame boundary. Called on the thread calling
+         * processBlock(), in order, once per frame before any lane runs.
+         * @param sampleOffset The frame's newest input sample, as an index
+         *                     into the current block
+         */
+        virtual FrameGains getFrameGains(int sampleOffset) noexcept = 0;
+    };
+
+    /**
+     * Pull the gain targets from a source at every frame boundary (nullptr =
+     * the block's gain arguments, the default). Not owned; keep it until it
+     * is unset.
+     * @param source Gain source, or nullptr
+     */
+    void setGainSource(GainSource* source) noexcept;
+
+    /**
+     * Samples processBlock() can take before the next frame completes; a
+     * block shorter than this only moves samples through the STFT buffers
+     * (no frame work, no worker hand-off), and a caller can skip its own
+     * per-frame parameter work for it. (Pipelining: such a block may still
+     * advance a held frame, whose gains are already scheduled.)
+     */
+    int getSamplesUntilNextFrame() const noexcept;
+
     /**
      * Set separation amount (0-1).
      * Controls how aggressively the tonal/noise separation is applied.
@@ -214,52 +632,196 @@ public:
      */
     float getSpectralFloor() const noexcept { return spectralFloor_; }
 
+    /**
+     * Set the silence gate threshold (see SilenceGate), in dB re a full-scale
+     * sine's peak bin. Frames whose loudest bin stays below it, once the
+     * estimator has settled on them, skip mask estimation and keep the last masks;
+     * all-zero frames also skip the gain stage and the inverse FFT.
+     * SilenceGate::kDisabledDb (the default) estimates every frame.
+     * RT-safe; takes effect on the next frame.
+     * @param thresholdDb Gate threshold in dB
+     */
+    void setSilenceGate(float thresholdDb) noexcept;
+
+    /**
+     * Get the silence gate threshold.
+     * @return Threshold in dB (SilenceGate::kDisabledDb when off)
+     */
+    float getSilenceGate() const noexcept { return silenceGateDb_; }
+
+    /** What the bins outside the active band carry (see setActiveBand()). */
+    enum class OutOfBand
+    {
+        PassThrough,    ///< The input, whatever the gains (a stem: the tonal one)
+        Tonal,          ///< All tonal: they follow the tonal gain
+        Noise           ///< All noise: they follow the noise gain
+    };
+
+    /**
+     * Separate only lowHz … highHz, e.g. 0-4 kHz for hum and low-mid
+     * cleanup: the estimators analyse just the analysis-grid bins covering
+     * the band (MaskEstimator::setActiveBand), which skips most of the
+     * per-bin work, and the bins outside it get fixed masks. The band rounds
+     * outwards to whole bins; highHz <= 0 means up to Nyquist, and 0, 0
+     * (the default) is the whole spectrum. Nothing is allocated for any
+     * band, so it may be set before prepare() or switched while running;
+     * a change restarts the estimators. RT-safe.
+     */
+    void setActiveBand(float lowHz, float highHz, OutOfBand outside = OutOfBand::PassThrough) noexcept;
+    float getActiveBandLow() const noexcept { return bandLowHz_; }
+    float getActiveBandHigh() const noexcept { return bandHighHz_; }
+    OutOfBand getOutOfBand() const noexcept { return outOfBand_; }
+
+    /** Analysis-grid bins [start, end) the estimators analyse. */
+    int getActiveBandStart() const noexcept { return bandStart_; }
+    int getActiveBandEnd() const noexcept { return bandEnd_; }
+
+    /**
+     * Fold the brightness shelf (BrightnessShelf) into the per-bin gains
+     * instead of filtering the output: each bin's gain is scaled by the
+     * shelf's magnitude at that bin, so there is no time-domain pass. The
+     * result is the zero-phase counterpart of the shelf. Ramps over the
+     * shelf's 20 ms, a block at a time; 0 dB (the default) leaves the gains
+     * untouched. RT-safe.
+     * @param gainDb Shelf gain in dB (BrightnessShelf::kMinDb … kMaxDb)
+     */
+    void setSpectralBrightness(float gainDb) noexcept;
+
+    /** Jump to a spectral brightness with no ramp (see snapGainSmoothers()). */
+    void snapSpectralBrightness(float gainDb) noexcept;
+
+    /** Target spectral brightness in dB. */
+    float getSpectralBrightness() const noexcept { return brightnessSmoother_.getTargetValue(); }
+
     // === Debug and Analysis Interface ===
 
     /**
      * Get read-only access to current magnitude frame for visualization.
      * Only valid after processing a frame.
+     * @param channel Channel index
      * @return Span of current magnitudes, or empty span if not available
      */
-    juce::Span<const float> getCurrentMagnitudes() const noexcept;
+    juce::Span<const float> getCurrentMagnitudes(int channel = 0) const noexcept;
     
     /**
      * Get read-only access to current tonal mask for visualization.
      * Only valid after processing a frame.
+     * @param channel Channel index (Linked mode: every channel shares one mask)
      * @return Span of current tonal mask, or empty span if not available
      */
-    juce::Span<const float> getCurrentTonalMask() const noexcept;
+    juce::Span<const float> getCurrentTonalMask(int channel = 0) const noexcept;
     
     /**
      * Get read-only access to current noise mask for visualization.
      * Only valid after processing a frame.
+     * @param channel Channel index (Linked mode: every channel shares one mask)
      * @return Span of current noise mask, or empty span if not available
      */
-    juce::Span<const float> getCurrentNoiseMask() const noexcept;
+    juce::Span<const float> getCurrentNoiseMask(int channel = 0) const noexcept;
 
     /**
      * Get read-only access to current transient mask for visualization.
      * Only valid after processing a frame.
+     * @param channel Channel index (Linked mode: every channel shares one mask)
      * @return Span of current transient mask, or empty span if not available
      */
-    juce::Span<const float> getCurrentTransientMask() const noexcept;
+    juce::Span<const float> getCurrentTransientMask(int channel = 0) const noexcept;
+
+    /**
+     * Move the per-stage ticks gathered since the last call (all channels,
+     * all frames) into record.stageTicks and record.numFrames, and restart
+     * the count. Only UNRAVEL_DSP_PROFILING builds gather anything; call from
+     * the audio thread after processBlock().
+     * @param record Block record to fill
+     */
+    void collectStageTicks(DspProfiler::BlockRecord& record) noexcept;
+
+    /**
+     * Soft limiter used by the safety limiting (shared with the offline
+     * renderer so bounces limit exactly like the plugin).
+     * Uses tanh() for smooth compression above -1 dB.
+     * @param input Input sample
+     * @return Limited output sample
+     */
+    static float softLimit(float input) noexcept
+    {
+        // Below threshold: pass through unchanged
+        if (std::abs(input) <= kSafetyThreshold)
+            return input;
+
+        const float sign = (input >= 0.0f) ? 1.0f : -1.0f;
+        const float absInput = std::abs(input);
+        const float excess = absInput - kSafetyThreshold;
+
+        // Soft compression using tanh for smooth knee
+        float compressed = kSafetyThreshold + std::tanh(excess * kSafetyRatio) / kSafetyRatio;
+
+        // Hard ceiling to absolutely prevent clipping
+        if (compressed > kHardCeiling)
+            compressed = kHardCeiling;
+
+        return sign * compressed;
+    }
 
 private:
     // === Core Components ===
-    std::unique_ptr<STFTProcessor> stftProcessor_;      ///< STFT analysis/synthesis
-    std::unique_ptr<MagPhaseFrame> magPhaseFrame_;      ///< Magnitude/phase conversion
-    std::unique_ptr<MaskEstimator> maskEstimator_;      ///< HPSS mask estimation
+
+    /** Per-channel STFT, analysis and estimation state plus its bypass delay line. */
+    struct ChannelLane
+    {
+        std::unique_ptr<STFTProcessor> stftProcessor;   ///< STFT analysis/synthesis (Partitioned: synthesis)
+        std::unique_ptr<STFTProcessor> analysisStft;    ///< Partitioned: long-window analysis-only STFT
+        std::unique_ptr<MagPhaseFrame> magPhaseFrame;   ///< Magnitude/phase conversion
+        std::unique_ptr<MaskEstimator> maskEstimator;   ///< HPSS mask estimation (lane 0 only when linked)
+        std::unique_ptr<LowBandAnalyzer> lowBand;       ///< Decimated low-band spectrum for the tracker
+        SilenceGate silenceGate;                        ///< Gate in front of maskEstimator (lane 0's when linked)
+        bool frameSilent = false;                       ///< Current frame is all zero: skip its resynthesis
+        std::vector<float> bypassBuffer;                ///< Delay buffer for bypass
+        int bypassWritePos = 0;                         ///< Bypass buffer write position
+        int bypassReadPos = 0;                          ///< Bypass buffer read position
+        int framesThisBlock = 0;                        ///< Frames completed in the current block
+        bool frameEstimated = false;                    ///< Pipelining: the gate let the held frame through
+        bool masksShared = false;                       ///< This slice's masks came from the SharedAnalysis
+        int64_t analysisFrame = 0;                      ///< Frames analysed since reset (the shared frame index)
+        int tierFadeFrames = 0;                         ///< Frames of this slice's tier crossfade still to run
+        bool analysisRestartPending = false;            ///< restartAnalysis(): start over at the next frame
+        DspProfiler::Accumulator profile;               ///< Stage ticks of this lane's thread
+    };
+
+    std::vector<ChannelLane> lanes_;                    ///< One lane per prepared channel
     
     // === Configuration ===
     bool useHighQuality_ = false;                       ///< Quality mode setting
+    Synthesis synthesis_ = Synthesis::FullFrame;        ///< Synthesis mode setting
+    STFTProcessor::Overlap overlap_ = STFTProcessor::Overlap::ThreeQuarters; ///< Analysis STFT overlap
     bool bypassEnabled_ = false;                        ///< Bypass mode flag
     bool safetyLimitingEnabled_ = true;                 ///< Safety limiting flag
     bool isInitialized_ = false;                        ///< Initialization state
+    MaskApplication maskApplication_ = MaskApplication::Complex; ///< Gain application mode
+    SlidingMedian::HistoryFormat historyFormat_ = SlidingMedian::HistoryFormat::Float32; ///< Estimator history storage
+    ChannelLink channelLink_ = ChannelLink::Independent;        ///< Mask estimation mode
+    bool framesWereLinked_ = false;                     ///< Link mode of the previous frame
+    bool pipelineRequested_ = false;                    ///< setPipelining(): applied at prepare()
+    bool pipelining_ = false;                           ///< Frames are pipelined (requested, and FullFrame)
+    bool stemOutputsRequested_ = false;                 ///< setStemOutputs(): applied at prepare()
+    bool stemOutputs_ = false;                          ///< The STFTs resynthesise one output per stream
+    QualityGovernor::Tier requestedTier_ = QualityGovernor::Tier::Full; ///< setQualityTier(): applied at a frame
+    QualityGovernor::Tier qualityTier_ = QualityGovernor::Tier::Full;   ///< Tier the estimators run at
+    int maskDecimation_ = 1;                            ///< setMaskDecimation()
+    bool warmStart_ = false;                            ///< setWarmStart()
 
     // === Separation Parameters ===
     float separation_ = 0.75f;                          ///< Separation amount (0-1)
     float focus_ = 0.0f;                                ///< Focus bias (-1 to +1)
     float spectralFloor_ = 0.0f;                        ///< Spectral floor threshold (0-1)
+    float bandLowHz_ = 0.0f;                            ///< setActiveBand()
+    float bandHighHz_ = 0.0f;
+    OutOfBand outOfBand_ = OutOfBand::PassThrough;
+    int bandStart_ = 0;                                 ///< Active band, analysis-grid bins [start, end)
+    int bandEnd_ = 0;
+    int synthesisBandStart_ = 0;                        ///< Partitioned: synthesis-grid bins wholly inside the band
+    int synthesisBandEnd_ = 0;
+    float silenceGateDb_ = SilenceGate::kDisabledDb;    ///< Silence gate threshold (dB)
 
     // === Processing State ===
     double currentSampleRate_ = 48000.0;                ///< Current sample rate
@@ -271,15 +833,80 @@ private:
     juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> noiseGainSmoother_;
     juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> transientGainSmoother_;
 
+    // === Spectral Brightness ===
+    // The shelf's |H| on each grid, rebuilt when the ramped gain moves.
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> brightnessSmoother_;
+    BrightnessShelf::Grid brightnessGrid_;              ///< Analysis-grid cosines
+    BrightnessShelf::Grid synthesisBrightnessGrid_;     ///< Partitioned: synthesis-grid cosines
+    float brightnessWeightsDb_ = 0.0f;                  ///< Gain the weights were built for
+    bool brightnessActive_ = false;                     ///< Weights are not all 1
+
     // === Processing Buffers (Real-time Safe) ===
-    std::vector<float> tonalMaskBuffer_;                ///< Tonal mask storage
-    std::vector<float> noiseMaskBuffer_;                ///< Noise mask storage
-    std::vector<float> transientMaskBuffer_;            ///< Transient mask storage
-    std::vector<float> bypassBuffer_;                   ///< Delay buffer for bypass
-    
-    // === Bypass Implementation ===
-    int bypassWritePos_ = 0;                           ///< Bypass buffer write position
-    int bypassReadPos_ = 0;                            ///< Bypass buffer read position
+    // Channel-major blocks: channel c's bins start at c * numBins_. Linked
+    // mode writes masks to channel 0's slice only. All of them, short-grid
+    // ones included, share one arena block (see initializeComponents()).
+    DspArena arena_;
+    DspArena::Buffer<float> tonalMasks_;                ///< Tonal masks (numChannels × numBins)
+    DspArena::Buffer<float> noiseMasks_;                ///< Noise masks (numChannels × numBins)
+    DspArena::Buffer<float> transientMasks_;            ///< Transient masks (numChannels × numBins)
+    DspArena::Buffer<float> binGains_;                  ///< Combined per-bin gain (numChannels × numBins)
+    DspArena::Buffer<float> linkedMagnitudes_;          ///< Max |X| across channels (numBins)
+    DspArena::Buffer<float> linkedLowBand_;             ///< Max low-band |X| across channels
+    DspArena::Buffer<FrameGains> frameGains_;           ///< Per-frame gains, filled once per block
+    DspArena::Buffer<float> brightnessWeights_;         ///< Shelf |H| per bin (numBins)
+    DspArena::Buffer<float> synthesisBrightnessWeights_;  ///< Shelf |H| per short-grid bin (synthesisBins)
+    DspArena::Buffer<float> tierFadeTonal_;             ///< Masks before a tier change (numChannels × numBins)
+    DspArena::Buffer<float> tierFadeTransient_;
+    DspArena::Buffer<float> tierFadeNoise_;
+    DspArena::Buffer<float> prerollOutput_;             ///< Discarded preroll() output (streams × numChannels × maxBlockSize)
+    std::vector<const float*> prerollInputs_;           ///< preroll(): per-channel input of the current block
+    std::vector<float*> prerollOutputs_;                ///< preroll(): per-stream, per-channel slices of prerollOutput_
+
+    // === Partitioned Synthesis ===
+    // Short-grid masks and gains, channel-major like the analysis-grid
+    // buffers (Linked mode: channel 0's slice only).
+    MaskReconciler maskReconciler_;                     ///< Analysis grid → synthesis grid
+    int synthesisBins_ = 0;                             ///< Bins of the synthesis STFT
+    DspArena::Buffer<float> synthesisTonalMasks_;       ///< Tonal masks (numChannels × synthesisBins)
+    DspArena::Buffer<float> synthesisNoiseMasks_;       ///< Noise masks (numChannels × synthesisBins)
+    DspArena::Buffer<float> synthesisTransientMasks_;   ///< Transient masks (numChannels × synthesisBins)
+    DspArena::Buffer<float> synthesisGains_;            ///< Combined gain (numChannels × synthesisBins)
+    DspArena::Buffer<float> analysisPower_;             ///< |X|² weights for the mapping (numChannels × numBins)
+    std::vector<float> analysisPrimer_;                 ///< Zeros that align the first analysis frame
+    int analysisCountdown_ = 0;                         ///< Samples until the next analysis frame completes
+    int segmentStart_ = 0;                              ///< Linked: current segment of the block
+    int segmentLength_ = 0;
+    bool segmentAnalysed_ = false;                      ///< Linked: the segment ended on an analysis frame
+
+    // === Current Block (read by lane stages, possibly on pool workers) ===
+    ChannelWorkerPool* workerPool_ = nullptr;           ///< Optional channel fan-out (not owned)
+    SpectrumHistoryRing* spectrumHistory_ = nullptr;    ///< Optional frame history for the editor (not owned)
+    SharedAnalysis* sharedAnalysis_ = nullptr;          ///< Optional shared mask estimation (not owned)
+    int64_t sharedEpoch_ = 0;                           ///< Epoch of this engine's frame indices
+    void (HPSSProcessor::*currentStage_)(int) noexcept = nullptr; ///< Stage being fanned out
+    GainSource* gainSource_ = nullptr;                  ///< Per-frame gain targets (see setGainSource)
+    const float* const* blockInputs_ = nullptr;         ///< Per-channel inputs of the current block
+    float* const* blockOutputs_ = nullptr;              ///< Per-channel outputs of the current block
+    float* const* blockNoiseOutputs_ = nullptr;         ///< Stem outputs: noise stream (nullptr = dropped)
+    float* const* blockTransientOutputs_ = nullptr;     ///< Stem outputs: transient stream (nullptr = dropped)
+    int blockNumSamples_ = 0;                           ///< Samples in the current block
+    int blockFrame_ = 0;                                ///< Linked mode: frame index within the block
+    bool transparent_ = false;                          ///< Unity gains: analyse, then pass the delay through
+    int unityHoldoffSamples_ = 0;                       ///< Unity samples left before transparent_ may engage
+
+    // === Pipelining ===
+    // At most one frame is in flight, held in every lane's STFT (lanes stay
+    // in lock step) between callbacks.
+    enum class PipelineStage
+    {
+        Idle,           ///< No frame held
+        Analysis,       ///< Produce the frame: forward FFT, magnitudes, low band, guides
+        Masks,          ///< Stats and masks still to compute
+        Synthesis       ///< Gains, inverse FFT and overlap-add still to run
+    };
+    PipelineStage pipelineStage_ = PipelineStage::Idle; ///< Next stage of the held frame
+    bool pipelineLinked_ = false;                       ///< Link mode the held frame was analysed in
+    FrameGains pipelineGains_;                          ///< Gains scheduled for the held frame
     
     // === Safety Limiting ===
     static constexpr float kSafetyThreshold = 0.891f;  ///< -1dB in linear scale (earlier catch)
@@ -309,50 +936,278 @@ private:
      * @param numSamples Number of samples
      */
     void applySafetyLimiting(float* buffer, int numSamples) noexcept;
-    
+
     /**
-     * Soft limiter function using tanh() for smooth compression.
-     * @param input Input sample
-     * @return Limited output sample
+     * Offset of a channel's slice in the channel-major mask blocks
+     * (always 0 in Linked mode, where all channels share slice 0).
      */
-    inline float softLimit(float input) const noexcept
+    size_t maskOffset(int channel) const noexcept
     {
-        // Below threshold: pass through unchanged
-        if (std::abs(input) <= kSafetyThreshold)
-            return input;
+        const int slice = isLinkedAnalysis() ? 0 : channel;
+        return static_cast<size_t>(slice) * static_cast<size_t>(numBins_);
+    }
 
-        const float sign = (input >= 0.0f) ? 1.0f : -1.0f;
-        const float absInput = std::abs(input);
-        const float excess = absInput - kSafetyThreshold;
+    /** Linked mode, or the quality tier that links the analysis. */
+    bool isLinkedAnalysis() const noexcept
+    {
+        return channelLink_ == ChannelLink::Linked || qualityTier_ >= QualityGovernor::Tier::LinkedAnalysis;
+    }
 
-        // Soft compression using tanh for smooth knee
-        float compressed = kSafetyThreshold + std::tanh(excess * kSafetyRatio) / kSafetyRatio;
+    /**
+     * Switch to the requested quality tier: snapshot every channel's masks
+     * for the crossfade, then reconfigure the estimators.
+     */
+    void applyQualityTier(int numChannels) noexcept;
 
-        // Hard ceiling to absolutely prevent clipping
-        if (compressed > kHardCeiling)
-            compressed = kHardCeiling;
+    /** Set one estimator up for the current quality tier. */
+    void configureTier(MaskEstimator& estimator) const noexcept;
 
-        return sign * compressed;
-    }
+    /** One frame of a slice's tier crossfade, on its freshly estimated masks. */
+    void fadeTierMasks(int slice) noexcept;
+
+    /**
+     * Linked mode: estimate one mask set (slice 0) from the per-bin max of
+     * every lane's current magnitudes. Lanes must already be analysed.
+     * @return True if the masks were estimated (false: the gate held them)
+     */
+    bool estimateLinkedMasks(int numChannels) noexcept;
+
+    /**
+     * First half of estimateLinkedMasks(): the per-lane max, the gate and
+     * the guides.
+     * @return True if the gate let the frame through
+     */
+    bool beginLinkedMasks(int numChannels) noexcept;
+
+    /**
+     * Gate one frame and, unless the gate holds, run the estimator on it
+     * (and the tracker on its low band) into mask slice `slice`.
+     * @return True if the masks were estimated (false: held from before)
+     */
+    bool estimateFrameMasks(SilenceGate& gate, MaskEstimator& estimator,
+                            juce::Span<const float> magnitudes,
+                            juce::Span<const float> lowBand, int slice) noexcept;
+
+    /**
+     * estimateFrameMasks() in two halves, for pipelining: the gate and the
+     * guides, then (if the gate let the frame through) the stats and the
+     * masks of the same magnitudes. With a SharedAnalysis the first half
+     * fetches the slice's masks from it, and the second has nothing left
+     * to do (unless the group missed the frame).
+     * @param sharedSlice The SharedAnalysis slice (the channel, or its linked slice)
+     */
+    bool beginFrameMasks(SilenceGate& gate, MaskEstimator& estimator,
+                         juce::Span<const float> magnitudes, juce::Span<const float> lowBand,
+                         int slice, int sharedSlice) noexcept;
+    void finishFrameMasks(MaskEstimator& estimator, juce::Span<const float> magnitudes, int slice) noexcept;
+
+    /**
+     * Fetch slice `slice`'s masks for its lane's current frame from the
+     * SharedAnalysis.
+     * @return False if the group missed the frame (estimate it here)
+     */
+    bool shareFrameMasks(int slice, int sharedSlice, juce::Span<const float> magnitudes,
+                         juce::Span<const float> lowBand) noexcept;
+
+    /** Run stage(ch) for every channel, on the worker pool if one is set. */
+    void runLaneTasks(int numChannels, void (HPSSProcessor::*stage)(int) noexcept) noexcept;
+
+    /** Independent mode: push, process every frame and output one lane. */
+    void runIndependentLane(int channel) noexcept;
+
+    /** Linked mode: push one lane's input and analyse its first frame (or output). */
+    void runLinkedLaneInput(int channel) noexcept;
+
+    /** Linked mode: apply the shared masks to one lane, then analyse its next frame (or output). */
+    void runLinkedLaneSynthesis(int channel) noexcept;
+
+    /**
+     * Pipelined block (see setPipelining()): the held frame's next stage, or
+     * all of them if this block completes a frame, then each frame the block
+     * completes.
+     */
+    void processPipelinedBlock(int numChannels, int framesDue, bool linked) noexcept;
+
+    /**
+     * Run one stage of the held frame over every lane.
+     * @param frame This block's index of the frame (Analysis only)
+     * @return The stage after it
+     */
+    PipelineStage runPipelineStage(PipelineStage stage, int frame, int numChannels, bool linked) noexcept;
+
+    /** Pipelining, per lane: push the block's input (producing a due frame if none is held). */
+    void runPipelinedInput(int channel) noexcept;
+
+    /** Pipelining, per lane: produce and analyse the frame (Independent: and its guides). */
+    void runPipelinedAnalysis(int channel) noexcept;
+
+    /** Pipelining, per lane: Independent mode's stats and masks. */
+    void runPipelinedMasks(int channel) noexcept;
+
+    /** Pipelining, per lane: gains, inverse FFT and overlap-add; releases the frame. */
+    void runPipelinedSynthesis(int channel) noexcept;
+
+    /** Partitioned pipeline of one block (see Synthesis). */
+    void processPartitionedBlock(int numChannels, bool linked) noexcept;
+
+    /** Partitioned, independent: one lane's whole block, segment by segment. */
+    void runPartitionedLane(int channel) noexcept;
+
+    /** Partitioned, linked: analysis half of the current segment for one lane. */
+    void runPartitionedLinkedAnalysis(int channel) noexcept;
+
+    /** Partitioned, linked: synthesis half of the current segment (and output after the last). */
+    void runPartitionedLinkedSynthesis(int channel) noexcept;
+
+    /**
+     * Push [start, start + length) of a lane's input to its analysis STFT.
+     * Segments end exactly where analysis frames complete, so at most one
+     * frame results; its magnitudes go to the lane's MagPhaseFrame.
+     * @return True if an analysis frame completed
+     */
+    bool analysePartitionedSegment(int channel, int start, int length) noexcept;
+
+    /**
+     * Push the same samples to the synthesis STFT and resynthesise its ready
+     * frames with the synthesis-grid masks of `maskSlice`.
+     */
+    void synthesisePartitionedSegment(int channel, int maskSlice, int start, int length) noexcept;
+
+    /**
+     * Map one mask slice (analysis grid) onto the synthesis grid, weighted by
+     * the analysis power |X|² of the given magnitudes.
+     */
+    void mapMasksToSynthesisGrid(int slice, const float* magnitudes) noexcept;
+
+    /** Scale a lane's analysis magnitudes by the current gains (display, like applyBinGains()). */
+    void scaleDisplayMagnitudes(int channel, int maskSlice) noexcept;
+
+    /** Push channel 0's finished frame to the spectrum history, if one is set. */
+    void publishFrame(int channel) noexcept;
+
+    /** Length of the next segment of the block starting at `start` (see analysisCountdown_). */
+    int nextSegmentLength(int start, int countdown) const noexcept;
+
+    /** Apply a pending restartAnalysis() to a lane whose next frame is starting. */
+    void restartLaneAnalysis(ChannelLane& lane) noexcept;
+
+    /** Fill a lane's analysis STFT with the zeros that align its first frame. */
+    void primeAnalysis(ChannelLane& lane) noexcept;
+
+    /** Analyse a lane's ready frame into its MagPhaseFrame (see MaskApplication). */
+    void analyseLaneFrame(ChannelLane& lane) noexcept;
+
+    /** Feed a lane's LowBandAnalyzer the ready frame's newest hop and analyse it. */
+    void analyseLowBand(ChannelLane& lane, const STFTProcessor& stft) noexcept;
+
+    /**
+     * Read a lane's output for the block (every stream's, with stem
+     * outputs) and apply safety limiting. On the transparent path the STFT
+     * output is consumed (keeping it in step) and replaced by the bypass
+     * delay.
+     */
+    void finishLaneBlock(int channel) noexcept;
+
+    /**
+     * Fill frameGains_ for the numFrames frames this block completes,
+     * stepping the gain smoothers one hop per frame (targets from the
+     * GainSource, if set, at each frame's boundary).
+     */
+    void scheduleFrameGains(int numFrames) noexcept;
+
+    /** Frames the next numSamples input samples complete (every lane's alike). */
+    int getFramesDue(int numSamples) const noexcept;
+
+    /**
+     * A block that completes no frame: input into the STFT buffers, output
+     * out of the overlap-add buffer, serially (nothing to fan out).
+     */
+    void processFramelessBlock(int numChannels) noexcept;
+
+    /** Gains of a frame of the current block. */
+    const FrameGains& frameGainsAt(int frame) const noexcept;
+
+    /**
+     * Combine the three masks with the frame's stream gains into one real
+     * gain per bin: gains = tonal × tonalGain + transient × transientGain
+     * + noise × noiseGain (whole-frame vector ops), unity outside a
+     * pass-through active band, times the spectral brightness weights when
+     * they are active.
+     */
+    void computeBinGains(const float* tonal, const float* transient, const float* noise,
+                         float* gains, float tonalGain, float noiseGain,
+                         float transientGain, int numBins) const noexcept;
+
+    /** OutOfBand::PassThrough: unity gains outside the active band (on the grid numBins says). */
+    void passOutOfBand(float* gains, int numBins) const noexcept;
+
+    /** The active band in bins of both grids, and on every estimator. */
+    void applyActiveBand() noexcept;
+
+    /**
+     * Apply per-bin gains to one lane's current frame (see MaskApplication)
+     * and write the frame back to its STFT.
+     */
+    void applyBinGains(ChannelLane& lane, const float* gains) noexcept;
+
+    /**
+     * Resynthesise one lane's frame from the masks and the frame's gains, or
+     * on the transparent path pass it through untouched (no inverse FFT).
+     */
+    void synthesiseLaneFrame(ChannelLane& lane, const float* tonal, const float* transient,
+                             const float* noise, float* gains, const FrameGains& frameGains) noexcept;
+
+    /**
+     * Stem outputs: resynthesise each stream of one lane's frame into its
+     * own output (tonal, noise, transient = STFT outputs 0, 1, 2), with
+     * gains as scratch. FullFrame also scales the frame's magnitudes by the
+     * mixed gain, for the visualiser.
+     */
+    void synthesiseStemFrame(ChannelLane& lane, const float* tonal, const float* transient,
+                             const float* noise, float* gains, const FrameGains& frameGains,
+                             int numBins) noexcept;
     
     /**
      * Process bypass mode with matched latency.
-     * @param inputBuffer Input samples
+     * @param lane Channel whose delay line is used
+     * @param inputBuffer Input samples  
      * @param outputBuffer Output samples  
      * @param numSamples Number of samples
      */
-    void processBypass(const float* inputBuffer, float* outputBuffer, int numSamples) noexcept;
+    void processBypass(ChannelLane& lane, const float* inputBuffer, float* outputBuffer, int numSamples) noexcept;
+
+    /**
+     * Bypass delay line, split so processBlock() can feed it every block
+     * (before an in-place output overwrites the input) and read it only when
+     * the block is transparent or bypassed. Reading or skipping every block
+     * keeps the read position exactly one latency behind the write position,
+     * so entering either path never plays stale samples.
+     */
+    void writeBypassDelay(ChannelLane& lane, const float* inputBuffer, int numSamples) noexcept;
+    void readBypassDelay(ChannelLane& lane, float* outputBuffer, int numSamples) noexcept;
+    void skipBypassDelay(ChannelLane& lane, int numSamples) noexcept;
     
     /**
-     * Apply unity gain transparency optimization.
-     * When all three stream gains are 1.0, this provides bit-perfect passthrough
-     * (the three mass-conserving masks sum to 1, so unity-scaled they reconstruct
-     * the input exactly).
-     * @return True if unity gain path was used
+     * Unity gain transparency check.
+     * When all three stream gains are 1.0 (targets and smoothers settled),
+     * the mass-conserving masks sum to 1 and the block is the input delayed
+     * by the latency: once the last non-unity frames have left the
+     * overlap-add buffer, processBlock() still runs the analysis (guides,
+     * stats, masks and visualiser data stay current) but skips gain
+     * application and the inverse FFT, and outputs the bit-perfect bypass
+     * delay.
+     * @return True if all three gains are settled at unity
      */
-    bool tryUnityGainPath(const float* inputBuffer, float* outputBuffer,
-                         int numSamples,
-                         float tonalGain, float noiseGain, float transientGain) noexcept;
+    bool isUnityGain(float tonalGain, float noiseGain, float transientGain) const noexcept;
+
+    /**
+     * Advance the spectral brightness ramp over a block and rebuild the
+     * weights if the gain moved.
+     */
+    void updateSpectralBrightness(int numSamples) noexcept;
+
+    /** Shelf magnitudes at brightnessWeightsDb_ onto both grids. */
+    void buildBrightnessWeights() noexcept;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HPSSProcessor)
 };
\ No newline at end of file
@@ -17,7 +17,9 @@
 // reads strongly tonal. Empty bins have H ~ 0 -> tonal ~ 0.
 //
 // RT-safety: everything is pre-allocated in prepare(); process() does NO
-// allocation and NO locks. Medians run in the pre-allocated scratch_ buffer.
+// allocation and NO locks. Both medians are sliding windows (SlidingMedian)
+// sized in prepare(); the horizontal bank is fed the frame leaving the ring.
+// Key16 keeps the ring and the bank as 16-bit keys, and this frame as floats.
 // =============================================================================
 
 namespace
@@ -25,27 +27,6 @@ namespace
     // Match MaskEstimator's constants for consistency.
     constexpr float kEps = 1e-8f;                  // numerical stability epsilon
     constexpr int   kVerticalMedianSize = 13;      // mirror MaskEstimator::verticalMedianSize
-
-    // NOTE: mutates data[]
-    // nth_element median, mirroring MaskEstimator::computeMedian().
-    float computeMedian (float* data, int size) noexcept
-    {
-        if (size <= 0)
-            return 0.0f;
-        if (size == 1)
-            return data[0];
-
-        const int medianIndex = size / 2;
-        std::nth_element (data, data + medianIndex, data + size);
-
-        if (size % 2 == 1)
-            return data[medianIndex];
-
-        const float median1 = data[medianIndex];
-        std::nth_element (data, data + medianIndex - 1, data + size);
-        const float median2 = data[medianIndex - 1];
-        return (median1 + median2) * 0.5f;
-    }
 }
 
 void HarmonicMaskDetector::prepare (int numBins) noexcept
@@ -54,8 +35,22 @@ void HarmonicMaskDetector::prepare (int numBins) noexcept
 
     numBins_ = numBins;
 
-    historyData_.assign (static_cast<size_t> (kMedianFrames) * static_cast<size_t> (numBins), 0.0f);
-    scratch_.assign (static_cast<size_t> (std::max (kMedianFrames, kVerticalMedianSize)), 0.0f);
+    format_ = requestedFormat_;
+    const auto ringSize = static_cast<size_t> (kMedianFrames) * static_cast<size_t> (numBins);
+    const bool keyed = format_ == SlidingMedian::HistoryFormat::Key16;
+    historyData_.assign (keyed ? 0 : ringSize, 0.0f);
+    historyKeys_.assign (keyed ? ringSize : 0, SlidingMedian::Key {});
+    newestKeys_.assign (keyed ? static_cast<size_t> (numBins) : 0, SlidingMedian::Key {});
+    current_.assign (keyed ? static_cast<size_t> (numBins) : 0, 0.0f);
+    horizontal_.assign (static_cast<size_t> (numBins), 0.0f);
+    vertical_.assign (static_cast<size_t> (numBins), 0.0f);
+    horizontalBank_ = {};
+    horizontalKeyBank_ = {};
+    if (keyed)
+        horizontalKeyBank_.prepare (numBins, kMedianFrames);
+    else
+        horizontalBank_.prepare (numBins, kMedianFrames);
+    verticalWindow_.prepare (kVerticalMedianSize);
 
     writeIndex_ = 0;
     framesReceived_ = 0;
@@ -67,6 +62,10 @@ void HarmonicMaskDetector::reset() noexcept
         return;
 
     std::fill (historyData_.begin(), historyData_.end(), 0.0f);
+    std::fill (historyKeys_.begin(), historyKeys_.end(), SlidingMedian::Key {});
+    std::fill (current_.begin(), current_.end(), 0.0f);
+    horizontalBank_.reset();
+    horizontalKeyBank_.reset();
     writeIndex_ = 0;
     framesReceived_ = 0;
 }
@@ -84,47 +83,52 @@ void HarmonicMaskDetector::process (juce::Span<const float> magnitudes,
 
     const int numBins = numBins_;
 
-    // 1) Write the incoming magnitude frame into the history ring.
-    float* writePos = historyData_.data() + (static_cast<size_t> (writeIndex_) * static_cast<size_t> (numBins));
-    std::copy (magnitudes.data(), magnitudes.data() + numBins, writePos);
-    const int currentIndex = writeIndex_;  // most-recently-written frame
+    // 1) Write the incoming magnitude frame into the history ring. Once the
+    //    ring is full the slot being overwritten is the frame leaving the
+    //    horizontal window, so advance the sliding median bank first.
+    const size_t slot = static_cast<size_t> (writeIndex_) * static_cast<size_t> (numBins);
+    const bool full = framesReceived_ == kMedianFrames;
+    const float* currentFrame = nullptr;
+    if (format_ == SlidingMedian::HistoryFormat::Key16)
+    {
+        SlidingMedian::toKeys (magnitudes.data(), newestKeys_.data(), numBins);
+        horizontalKeyBank_.push (newestKeys_.data(), full ? historyKeys_.data() + slot : nullptr);
+        std::copy (newestKeys_.begin(), newestKeys_.end(), historyKeys_.begin() + (std::ptrdiff_t) slot);
+        std::copy (magnitudes.data(), magnitudes.data() + numBins, current_.begin());
+        currentFrame = current_.data();
+    }
+    else
+    {
+        float* writePos = historyData_.data() + slot;
+        horizontalBank_.push (magnitudes.data(), full ? writePos : nullptr);
+        std::copy (magnitudes.data(), magnitudes.data() + numBins, writePos);
+        currentFrame = writePos;  // most-recently-written frame
+    }
     writeIndex_ = (writeIndex_ + 1) % kMedianFrames;
     if (framesReceived_ < kMedianFrames)
         ++framesReceived_;
 
-    const float* currentFrame = historyData_.data()
-                              + (static_cast<size_t> (currentIndex) * static_cast<size_t> (numBins));
-
     // Mask exponent from separation amount, identical curve to MaskEstimator
     // (computeMasks): y = 0.3 + 2t + 2.7t^2.
     const float t = separation_;
     const float maskExponent = 0.3f + t * (2.0f + t * 2.7f);
 
     const float minPower = kEps * 100.0f;  // minimum power floor (mirror MaskEstimator)
-    const int validFrames = std::max (1, framesReceived_);
-    const int halfWindow = kVerticalMedianSize / 2;
+
+    // 2) Horizontal median across the valid time frames per bin -> H (sustained guide).
+    if (format_ == SlidingMedian::HistoryFormat::Key16)
+        horizontalKeyBank_.computeMedians (horizontal_.data());
+    else
+        horizontalBank_.computeMedians (horizontal_.data());
+
+    // 3) Vertical median across a frequency window of the CURRENT frame -> P.
+    SlidingMedian::centredMedianFilter (currentFrame, vertical_.data(), numBins,
+                                        kVerticalMedianSize, verticalWindow_);
 
     for (int bin = 0; bin < numBins; ++bin)
     {
-        // 2) Horizontal median across time frames for this bin -> H (sustained guide).
-        // Gather only the VALID frames from the ring (newest going back).
-        for (int f = 0; f < validFrames; ++f)
-        {
-            // f = 0 -> oldest valid frame, validFrames-1 -> current frame.
-            const int frameSlot = ((currentIndex - (validFrames - 1) + f) % kMedianFrames + kMedianFrames) % kMedianFrames;
-            scratch_[static_cast<size_t> (f)] =
-                historyData_[static_cast<size_t> (frameSlot) * static_cast<size_t> (numBins)
-                             + static_cast<size_t> (bin)];
-        }
-        const float H = computeMedian (scratch_.data(), validFrames);
-
-        // 3) Vertical median across a frequency window of the CURRENT frame -> P.
-        const int startBin = std::max (0, bin - halfWindow);
-        const int endBin = std::min (numBins, bin + halfWindow + 1);
-        const int windowSize = endBin - startBin;
-        for (int i = 0; i < windowSize; ++i)
-            scratch_[static_cast<size_t> (i)] = currentFrame[startBin + i];
-        const float P = computeMedian (scratch_.data(), windowSize);
+        const float H = horizontal_[static_cast<size_t> (bin)];
+        const float P = vertical_[static_cast<size_t> (bin)];
 
         // 4) Wiener-style tonal decision, floored to minPower for stability.
         float tonalPower = std::max (H * H, minPower);
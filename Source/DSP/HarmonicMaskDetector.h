@@ -1,5 +1,6 @@
 #pragma once
 #include <JuceHeader.h>
+#include "SlidingMedian.h"
 #include <vector>
 
 // Long-grid harmonic detector. Maintains a horizontal-median history over the
@@ -13,6 +14,10 @@ public:
     void reset() noexcept;
     void setSeparation (float amount01) noexcept; // sharpness of the tonal decision
 
+    // History storage (SlidingMedian::HistoryFormat); takes effect at the next prepare().
+    void setHistoryFormat (SlidingMedian::HistoryFormat format) noexcept { requestedFormat_ = format; }
+    SlidingMedian::HistoryFormat getHistoryFormat() const noexcept { return format_; }
+
     // Push one long-grid magnitude frame and write the tonal mask (size numBins).
     void process (juce::Span<const float> magnitudes, juce::Span<float> tonalMaskOut) noexcept;
 
@@ -20,8 +25,17 @@ private:
     static constexpr int kMedianFrames = 17;  // long-window horizontal median (sustained-tone bias)
     int numBins_ = 0;
     float separation_ = 0.85f;
-    std::vector<float> historyData_;   // kMedianFrames * numBins flat ring
-    std::vector<float> scratch_;       // median workspace
+    SlidingMedian::HistoryFormat requestedFormat_ = SlidingMedian::HistoryFormat::Float32;
+    SlidingMedian::HistoryFormat format_ = SlidingMedian::HistoryFormat::Float32;
+    std::vector<float> historyData_;   // kMedianFrames * numBins flat ring (Float32)
+    std::vector<SlidingMedian::Key> historyKeys_; // the same ring as keys (Key16)
+    std::vector<SlidingMedian::Key> newestKeys_;  // this frame's keys, numBins (Key16)
+    std::vector<float> current_;       // this frame, numBins (Key16)
+    std::vector<float> horizontal_;    // per-bin horizontal median (H), numBins
+    std::vector<float> vertical_;      // per-bin vertical median (P), numBins
+    SlidingMedian::Bank horizontalBank_;        // sorted 17-frame window per bin
+    SlidingMedian::KeyBank horizontalKeyBank_;  // the same, Key16
+    SlidingMedian::SortedWindow verticalWindow_; // sliding 13-bin window
     int writeIndex_ = 0;
     int framesReceived_ = 0;
 
@@ -0,0 +1,127 @@
+#include "LowBandAnalyzer.h"
+#include "SpectralKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 8192 samples at 48 kHz: the long window the tracker wants.
+    constexpr double kWindowSeconds = 8192.0 / 48000.0;
+}
+
+int LowBandAnalyzer::getDecimation(double sampleRate) noexcept
+{
+    return sampleRate >= 32000.0 ? 16 : 8;
+}
+
+int LowBandAnalyzer::getFftSize(double sampleRate) noexcept
+{
+    const double samples = sampleRate * kWindowSeconds / static_cast<double>(getDecimation(sampleRate));
+    return juce::nextPowerOfTwo(std::max(16, static_cast<int>(std::ceil(samples - 1.0e-6))));
+}
+
+double LowBandAnalyzer::getBinHz(double sampleRate) noexcept
+{
+    return sampleRate / static_cast<double>(getDecimation(sampleRate) * getFftSize(sampleRate));
+}
+
+void LowBandAnalyzer::prepare(double sampleRate)
+{
+    jassert(sampleRate > 0.0);
+
+    sampleRate_ = sampleRate;
+    decimation_ = getDecimation(sampleRate);
+    fftSize_ = getFftSize(sampleRate);
+    numTaps_ = kTapsPerPhase * decimation_ + 1;
+
+    const auto bins = static_cast<size_t>(getNumBins());
+    arena_.clear();
+    arena_.add(taps_, (size_t) numTaps_);
+    arena_.add(history_, 2 * (size_t) numTaps_);
+    arena_.add(decimated_, 2 * (size_t) fftSize_);
+    arena_.add(window_, (size_t) fftSize_);
+    arena_.add(frame_, (size_t) fftSize_);
+    arena_.add(bins_, bins);
+    arena_.add(magnitudes_, bins);
+    arena_.allocate();                      // Zero-filled
+
+    // Blackman-windowed sinc at a third of the decimated rate, unity at DC:
+    // flat enough below the tracker's 300 Hz, and its stopband begins
+    // before anything that would fold back below that.
+    const double cutoff = 1.0 / (3.0 * static_cast<double>(decimation_));   // cycles per input sample
+    const int centre = numTaps_ / 2;
+    double sum = 0.0;
+    for (int n = 0; n < numTaps_; ++n)
+    {
+        const double x = static_cast<double>(n - centre);
+        const double sinc = (n == centre) ? 2.0 * cutoff
+                                          : std::sin(2.0 * juce::MathConstants<double>::pi * cutoff * x)
+                                                / (juce::MathConstants<double>::pi * x);
+        const double phase = 2.0 * juce::MathConstants<double>::pi * n / (numTaps_ - 1);
+        const double blackman = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        taps_[(size_t) n] = static_cast<float>(sinc * blackman);
+        sum += sinc * blackman;
+    }
+    juce::FloatVectorOperations::multiply(taps_.data(), static_cast<float>(1.0 / sum), numTaps_);
+
+    // Periodic Hann, as the main analysis window.
+    for (int n = 0; n < fftSize_; ++n)
+        window_[(size_t) n] = static_cast<float>(
+            0.5 - 0.5 * std::cos(2.0 * juce::MathConstants<double>::pi * n / fftSize_));
+
+    fft_ = FFTBackend::create(juce::roundToInt(std::log2(fftSize_)));
+
+    reset();
+}
+
+void LowBandAnalyzer::reset() noexcept
+{
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    std::fill(decimated_.begin(), decimated_.end(), 0.0f);
+    std::fill(magnitudes_.begin(), magnitudes_.end(), 0.0f);
+    historyPos_ = 0;
+    phase_ = 0;
+    decimatedPos_ = 0;
+}
+
+void LowBandAnalyzer::push(const float* samples, int numSamples) noexcept
+{
+    jassert(fft_ != nullptr);
+
+    float* history = history_.data();
+    float* decimated = decimated_.data();
+    const float* taps = taps_.data();
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        history[historyPos_] = samples[i];
+        history[historyPos_ + numTaps_] = samples[i];
+        historyPos_ = (historyPos_ + 1) % numTaps_;
+
+        // Only every decimation-th output of the filter is kept, so only
+        // those are computed. The taps are symmetric: oldest-first is fine.
+        if (++phase_ < decimation_)
+            continue;
+        phase_ = 0;
+
+        const float* window = history + historyPos_;
+        float out = 0.0f;
+        for (int k = 0; k < numTaps_; ++k)
+            out += taps[k] * window[k];
+
+        decimated[decimatedPos_] = out;
+        decimated[decimatedPos_ + fftSize_] = out;
+        decimatedPos_ = (decimatedPos_ + 1) % fftSize_;
+    }
+}
+
+juce::Span<const float> LowBandAnalyzer::analyse() noexcept
+{
+    jassert(fft_ != nullptr);
+
+    juce::FloatVectorOperations::multiply(frame_.data(), decimated_.data() + decimatedPos_,
+                                          window_.data(), fftSize_);
+    fft_->forward(frame_.data(), bins_.data());
+    SpectralKernels::computeMagnitudes(bins_.data(), magnitudes_.data(), getNumBins(), kZeroThreshold);
+    return getMagnitudes();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspArena.h"
+#include "FFTBackend.h"
+#include <complex>
+#include <memory>
+
+/**
+ * LowBandAnalyzer - decimated long-window spectrum of the bottom of the band
+ *
+ * A 2048-point frame at 48 kHz resolves about 23 Hz per bin, so below 300 Hz
+ * LowFreqPartialTracker sees a hum as a handful of bins with its skirt
+ * spread over the median window, and two partials a few bins apart as one.
+ * A full-band 8192-point FFT would fix the resolution at four times the
+ * transform cost and would move the rest of the engine onto a grid it is
+ * not tuned for (the old multi-resolution path did exactly that).
+ *
+ * This analyzer low-passes and decimates the input by 16 (by 8 below
+ * 32 kHz) and runs a small FFT over the decimated history instead: 512
+ * points at 3 kHz covers the same 170 ms as an 8192-point frame at 48 kHz,
+ * about 5.9 Hz per bin, for the cost of a 129-tap FIR every 16 samples and
+ * one 512-point FFT per hop. The fftSize is chosen per sample rate so the
+ * window stays near 170 ms (and the bin spacing near 6 Hz) at 44.1-192 kHz.
+ * The tracker then picks its peaks on this spectrum, the main grid is left
+ * alone, and the engine's latency does not change: the window ends at the
+ * frame's newest sample, like the main frame's, and only looks further back.
+ *
+ * The anti-alias filter is within 0.4 dB up to 300 Hz and is down 6 dB at
+ * 1 kHz; anything that would fold back below 400 Hz is 75 dB or more
+ * below it.
+ *
+ * Usage: push() every input sample exactly once, in order (the engine pushes
+ * each frame's newest hop), then analyse() whenever a spectrum is wanted.
+ *
+ * RT-safety: prepare() allocates; reset(), push() and analyse() never do.
+ */
+class LowBandAnalyzer
+{
+public:
+    LowBandAnalyzer() = default;
+
+    /** Decimation factor at a sample rate: 16, or 8 below 32 kHz. */
+    static int getDecimation(double sampleRate) noexcept;
+
+    /** Decimated FFT size at a sample rate (power of two, window near 170 ms). */
+    static int getFftSize(double sampleRate) noexcept;
+
+    /** Number of spectrum bins at a sample rate (getFftSize / 2 + 1). */
+    static int getNumBins(double sampleRate) noexcept { return getFftSize(sampleRate) / 2 + 1; }
+
+    /** Spacing of the spectrum's bins in Hz at a sample rate. */
+    static double getBinHz(double sampleRate) noexcept;
+
+    /** Size the filter, history and FFT for a sample rate (allocates). */
+    void prepare(double sampleRate);
+
+    /** Clear the filter state and the decimated history. */
+    void reset() noexcept;
+
+    /**
+     * Feed input samples (any count; the decimation phase carries over).
+     * @param samples    Input samples at the full sample rate
+     * @param numSamples Number of samples
+     */
+    void push(const float* samples, int numSamples) noexcept;
+
+    /**
+     * Window and transform the newest getFftSize() decimated samples.
+     * @return Magnitudes (size getNumBins()), valid until the next analyse()
+     */
+    juce::Span<const float> analyse() noexcept;
+
+    /** The magnitudes of the last analyse() (zero before the first). */
+    juce::Span<const float> getMagnitudes() const noexcept
+    {
+        return { magnitudes_.data(), magnitudes_.size() };
+    }
+
+    int getDecimation() const noexcept { return decimation_; }
+    int getFftSize() const noexcept { return fftSize_; }
+    int getNumBins() const noexcept { return fftSize_ / 2 + 1; }
+    double getBinHz() const noexcept { return sampleRate_ / static_cast<double>(decimation_ * fftSize_); }
+
+private:
+    static constexpr int kTapsPerPhase = 8;         ///< FIR length = kTapsPerPhase × decimation + 1
+    static constexpr float kZeroThreshold = 1e-8f;  ///< As MagPhaseFrame
+
+    double sampleRate_ = 48000.0;
+    int decimation_ = 16;
+    int fftSize_ = 512;
+    int numTaps_ = 0;
+
+    std::unique_ptr<FFTBackend> fft_;
+
+    // Filter taps, input history (mirrored so the FIR reads one contiguous
+    // run), decimated history (mirrored likewise), then the frame buffers.
+    DspArena arena_;
+    DspArena::Buffer<float> taps_;
+    DspArena::Buffer<float> history_;               ///< 2 × numTaps
+    DspArena::Buffer<float> decimated_;             ///< 2 × fftSize
+    DspArena::Buffer<float> window_;                ///< Periodic Hann (fftSize)
+    DspArena::Buffer<float> frame_;                 ///< Windowed decimated samples (fftSize)
+    DspArena::Buffer<std::complex<float>> bins_;    ///< fftSize / 2 + 1
+    DspArena::Buffer<float> magnitudes_;            ///< fftSize / 2 + 1
+
+    int historyPos_ = 0;        ///< Next history_ slot (oldest tap)
+    int phase_ = 0;             ///< Input samples since the last decimated output
+    int decimatedPos_ = 0;      ///< Next decimated_ slot (oldest sample of the window)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LowBandAnalyzer)
+};
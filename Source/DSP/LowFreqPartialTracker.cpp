@@ -1,4 +1,6 @@
 #include "LowFreqPartialTracker.h"
+#include "LowBandAnalyzer.h"
+#include "SlidingMedian.h"
 
 #include <algorithm>
 #include <cmath>
@@ -20,10 +22,17 @@ void LowFreqPartialTracker::prepare(int numBins, double sampleRate) noexcept
     scanBins_ = std::min(numBins,
                          static_cast<int>(std::ceil(kMaxTrackHz / binHz_)) + 2);
 
+    // The same band on the decimated spectrum, when the caller supplies one.
+    lowBandBinHz_ = LowBandAnalyzer::getBinHz(sampleRate);
+    lowBandBins_ = LowBandAnalyzer::getNumBins(sampleRate);
+    lowBandScanBins_ = std::min(lowBandBins_,
+                                static_cast<int>(std::ceil(kMaxTrackHz / lowBandBinHz_)) + 2);
+
+    const auto scratch = static_cast<size_t>(std::max({ scanBins_, lowBandScanBins_, 1 }));
     overrideMask_.assign(static_cast<size_t>(numBins), 0.0f);
-    peakFreqHz_.assign(static_cast<size_t>(std::max(scanBins_, 1)), 0.0f);
-    peakBinPos_.assign(static_cast<size_t>(std::max(scanBins_, 1)), 0.0f);
-    floorScratch_.assign(static_cast<size_t>(std::max(scanBins_, 1)), 0.0f);
+    peakFreqHz_.assign(scratch, 0.0f);
+    peakBinPos_.assign(scratch, 0.0f);
+    floorScratch_.assign(scratch, 0.0f);
 
     reset();
 }
@@ -35,24 +44,30 @@ void LowFreqPartialTracker::reset() noexcept
     std::fill(overrideMask_.begin(), overrideMask_.end(), 0.0f);
 }
 
-void LowFreqPartialTracker::process(juce::Span<const float> magnitudes) noexcept
+void LowFreqPartialTracker::process(juce::Span<const float> magnitudes,
+                                    juce::Span<const float> lowBand) noexcept
 {
     jassert(magnitudes.size() == static_cast<size_t>(numBins_));
+    jassert(lowBand.empty() || lowBand.size() == static_cast<size_t>(lowBandBins_));
 
-    detectPeaks(magnitudes);
+    if (lowBand.empty())
+        detectPeaks(magnitudes.data(), scanBins_, binHz_, nullptr);
+    else
+        detectPeaks(lowBand.data(), lowBandScanBins_, lowBandBinHz_, magnitudes.data());
     updateTracks();
     rebuildOverride();
 }
 
-void LowFreqPartialTracker::detectPeaks(juce::Span<const float> magnitudes) noexcept
+void LowFreqPartialTracker::detectPeaks(const float* spectrum, int scanBins, double spectrumBinHz,
+                                        const float* frame) noexcept
 {
     peakCount_ = 0;
 
     // Strongest low-band magnitude sets the prominence threshold, so a quiet
     // frame (silence) yields no peaks rather than chasing the numerical floor.
     float maxLowMag = 0.0f;
-    for (int b = 0; b < scanBins_; ++b)
-        maxLowMag = std::max(maxLowMag, magnitudes[static_cast<size_t>(b)]);
+    for (int b = 0; b < scanBins; ++b)
+        maxLowMag = std::max(maxLowMag, spectrum[b]);
 
     if (maxLowMag <= kEps)
         return;
@@ -63,19 +78,34 @@ void LowFreqPartialTracker::detectPeaks(juce::Span<const float> magnitudes) noex
     // tracker from locking onto flat noise. Assumes a tracked partial occupies
     // only a small fraction of the low band (true below kMaxTrackHz), so its
     // skirt doesn't lift the median enough to dilute the gate.
-    for (int b = 0; b < scanBins_; ++b)
-        floorScratch_[static_cast<size_t>(b)] = magnitudes[static_cast<size_t>(b)];
-    const auto mid = floorScratch_.begin() + scanBins_ / 2;
-    std::nth_element(floorScratch_.begin(), mid, floorScratch_.begin() + scanBins_);
-    const float bandFloor = *mid;
+    std::copy(spectrum, spectrum + scanBins, floorScratch_.begin());
+    const float bandFloor = SlidingMedian::selectUpperMedian(floorScratch_.data(), scanBins);
 
     const float threshold = std::max(kProminence * maxLowMag, kFloorFactor * bandFloor);
 
-    for (int b = 1; b < scanBins_ - 1; ++b)
+    // The long window also resolves the harmonics of anything periodic in
+    // it, a click or drum pattern included, as steady lines, and still
+    // holds them in frames that fall between the hits. A sustained tone is
+    // also tonal on the frame's own grid, so a low-band peak must pass the
+    // same gates there (at its nearest main bin or either neighbour) too.
+    float frameThreshold = 0.0f;
+    if (frame != nullptr)
     {
-        const float m0 = magnitudes[static_cast<size_t>(b - 1)];
-        const float m1 = magnitudes[static_cast<size_t>(b)];
-        const float m2 = magnitudes[static_cast<size_t>(b + 1)];
+        std::copy(frame, frame + scanBins_, floorScratch_.begin());
+        const float frameMax = *std::max_element(frame, frame + scanBins_);
+        frameThreshold = std::max({ kProminence * frameMax,
+                                    kFloorFactor * SlidingMedian::selectUpperMedian(floorScratch_.data(), scanBins_),
+                                    kEps });
+    }
+
+    // Peak positions are kept in main-grid bins, where the override goes.
+    const float toMainBins = static_cast<float>(spectrumBinHz / binHz_);
+
+    for (int b = 1; b < scanBins - 1; ++b)
+    {
+        const float m0 = spectrum[b - 1];
+        const float m1 = spectrum[b];
+        const float m2 = spectrum[b + 1];
 
         // Strict local maximum, prominent above both the strongest peak and the
         // band-median tonality floor.
@@ -87,11 +117,20 @@ void LowFreqPartialTracker::detectPeaks(juce::Span<const float> magnitudes) noex
         float offset = (std::abs(denom) > kEps) ? 0.5f * (m0 - m2) / denom : 0.0f;
         offset = juce::jlimit(-0.5f, 0.5f, offset);
 
-        const float binPos = static_cast<float>(b) + offset;
+        const float binPos = (static_cast<float>(b) + offset) * toMainBins;
         const float freqHz = binPos * static_cast<float>(binHz_);
         if (freqHz > static_cast<float>(kMaxTrackHz))
             continue;
 
+        if (frame != nullptr)
+        {
+            const int centre = static_cast<int>(std::lround(binPos));
+            const int lo = std::max(0, centre - 1);
+            const int hi = std::min(numBins_ - 1, centre + 1);
+            if (*std::max_element(frame + lo, frame + hi + 1) < frameThreshold)
+                continue;
+        }
+
         peakFreqHz_[static_cast<size_t>(peakCount_)] = freqHz;
         peakBinPos_[static_cast<size_t>(peakCount_)] = binPos;
         ++peakCount_;
@@ -223,11 +262,21 @@ void LowFreqPartialTracker::rebuildOverride() noexcept
     }
 }
 
+int LowFreqPartialTracker::getConfirmedFrequencies(float* hz, int maxCount) const noexcept
+{
+    int count = 0;
+    for (const Track& tr : tracks_)
+        if (tr.active && tr.age >= kConfirmFrames && tr.missing <= kReleaseFrames && count < maxCount)
+            hz[count++] = tr.freqHz;
+    std::sort(hz, hz + count);
+    return count;
+}
+
 void LowFreqPartialTracker::applyOverride(juce::Span<float> tonalMask) const noexcept
 {
     jassert(tonalMask.size() == static_cast<size_t>(numBins_));
 
-    const int hi = std::min(numBins_, scanBins_ + kSkirtRadius + 1);
+    const int hi = getOverrideEnd();
     for (int b = 0; b < hi; ++b)
         tonalMask[static_cast<size_t>(b)] =
             std::max(tonalMask[static_cast<size_t>(b)], overrideMask_[static_cast<size_t>(b)]);
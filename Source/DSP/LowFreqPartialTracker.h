@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <algorithm>
 #include <array>
 #include <vector>
 
@@ -26,6 +27,12 @@
  * only reassigns skirt energy from noise to tonal (mass-conserving downstream),
  * a unity-gain full mix still reconstructs identically.
  *
+ * Peaks are picked on a LowBandAnalyzer spectrum when the caller passes one
+ * (about 6 Hz per bin instead of 23, so partials two main bins apart stay
+ * two tracks and their sub-bin frequencies are four times as precise), and
+ * on the frame's own low bins otherwise. Either way the override is built
+ * on the main grid.
+ *
  * Real-time safe: all state is fixed-size and allocated in prepare(); process()
  * and applyOverride() never allocate or lock.
  */
@@ -49,8 +56,12 @@ public:
      * rebuild the per-bin override from confirmed tracks. Call once per frame
      * before applyOverride().
      * @param magnitudes Magnitude spectrum, size numBins.
+     * @param lowBand    LowBandAnalyzer magnitudes for the same frame (size
+     *                   LowBandAnalyzer::getNumBins(sampleRate)) to pick the
+     *                   peaks on, or empty to pick them on `magnitudes`.
      */
-    void process(juce::Span<const float> magnitudes) noexcept;
+    void process(juce::Span<const float> magnitudes,
+                 juce::Span<const float> lowBand = {}) noexcept;
 
     /**
      * Raise the tonal mask toward 1.0 wherever a confirmed sustained low
@@ -60,6 +71,20 @@ public:
      */
     void applyOverride(juce::Span<float> tonalMask) const noexcept;
 
+    /** The per-bin override applyOverride() takes the max with (size numBins). */
+    const float* getOverrideMask() const noexcept { return overrideMask_.data(); }
+
+    /**
+     * Frequencies of the confirmed partials, lowest first.
+     * @param hz       Receives up to maxCount frequencies
+     * @param maxCount Capacity of hz
+     * @return Number written
+     */
+    int getConfirmedFrequencies(float* hz, int maxCount) const noexcept;
+
+    /** One past the last bin applyOverride() can raise (the rest are 0). */
+    int getOverrideEnd() const noexcept { return std::min(numBins_, scanBins_ + kSkirtRadius + 1); }
+
 private:
     // --- Tuning constants -----------------------------------------------------
     static constexpr int    kMaxTracks      = 8;      // simultaneous low partials tracked
@@ -87,6 +112,9 @@ private:
     double sampleRate_ = 48000.0;
     double binHz_     = 0.0;   // sampleRate / fftSize
     int    scanBins_  = 0;     // number of low bins examined for peaks
+    double lowBandBinHz_   = 0.0;  // LowBandAnalyzer bin spacing at sampleRate_
+    int    lowBandBins_    = 0;    // LowBandAnalyzer spectrum size at sampleRate_
+    int    lowBandScanBins_ = 0;   // low-band bins examined for peaks
 
     std::array<Track, kMaxTracks> tracks_ {};
     std::vector<float> overrideMask_;  // per-bin override [0,1], size numBins (only low band non-zero)
@@ -97,7 +125,13 @@ private:
     std::vector<float> floorScratch_;   // low-band magnitudes for the median tonality floor
     int peakCount_ = 0;
 
-    void detectPeaks(juce::Span<const float> magnitudes) noexcept;
+    /**
+     * Pick peaks on the first scanBins bins of a spectrum spaced spectrumBinHz
+     * apart; with `frame` (the main-grid magnitudes) set, each peak must also
+     * clear the tonality floor there.
+     */
+    void detectPeaks(const float* spectrum, int scanBins, double spectrumBinHz,
+                     const float* frame) noexcept;
     void updateTracks() noexcept;
     void rebuildOverride() noexcept;
 
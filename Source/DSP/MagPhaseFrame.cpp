@@ -1,4 +1,5 @@
 #include "MagPhaseFrame.h"
+#include "SpectralKernels.h"
 #include <algorithm>
 #include <stdexcept>
 #include <numeric>
@@ -51,6 +52,19 @@ void MagPhaseFrame::toComplex(juce::Span<std::complex<float>> complex) const
     }
 }
 
+void MagPhaseFrame::computeMagnitudes(juce::Span<const std::complex<float>> complex) noexcept
+{
+    ensurePrepared();
+    validateSpanSize(complex.size());
+
+    const size_t n = std::min(complex.size(), magnitudeData_.size());
+
+    // Vectorised; same zeroing rule as complexToMagPhase() and bit-identical
+    // to its sqrt(r² + i²).
+    SpectralKernels::computeMagnitudes(complex.data(), magnitudeData_.data(),
+                                       static_cast<int>(n), kEpsilon);
+}
+
 // === Memory Management ===
 
 void MagPhaseFrame::prepare(int numBins)
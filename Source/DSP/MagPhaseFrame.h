@@ -82,6 +82,16 @@ public:
      */
     void toComplex(juce::Span<std::complex<float>> complex) const;
 
+    /**
+     * Compute magnitudes only from complex FFT data (no phase).
+     * For callers that apply a real, non-negative gain directly to the complex
+     * bins and so never need the atan2/cos/sin round trip. Tiny magnitudes are
+     * zeroed exactly as in fromComplex(); phase storage is left untouched.
+     *
+     * @param complex Span of complex frequency domain data
+     */
+    void computeMagnitudes(juce::Span<const std::complex<float>> complex) noexcept;
+
     // === Memory Management ===
     
     /**
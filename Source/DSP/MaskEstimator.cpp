@@ -1,4 +1,5 @@
 #include "MaskEstimator.h"
+#include "LowBandAnalyzer.h"
 #include <algorithm>
 #include <cmath>
 #include <numeric>
@@ -14,35 +15,55 @@ void MaskEstimator::prepare(int numBins, double sampleRate) noexcept
     
     this->numBins = numBins;
     this->sampleRate = sampleRate;
+    bandStart = workStart = 0;
+    bandEnd = workEnd = numBins;
     
-    // Allocate HPSS guide signals
-    horizontalGuide.resize(numBins, 0.0f);
-    verticalGuide.resize(numBins, 0.0f);
-    
-    // Allocate spectral statistics
-    spectralFlux.resize(numBins, 0.0f);
-    spectralFlatness.resize(numBins, 0.0f);
-    
-    // Allocate processing buffers
-    hpssMask.resize(numBins, 0.0f);
-    fluxMask.resize(numBins, 0.0f);
-    flatnessMask.resize(numBins, 0.0f);
-    combinedMask.resize(numBins, 0.0f);
-    smoothedMask.resize(numBins, 0.0f);
-    tempBuffer.resize(std::max(numBins, horizontalMedianSize), 0.0f);
-    
-    // Initialize previous frame data
-    previousMagnitudes.resize(numBins, 0.0f);
-    previousSmoothedMask.resize(numBins, 0.5f); // Start with neutral masks
-    transientEnv.resize(numBins, 0.0f);
+    // One arena block for every per-frame buffer, in the order a frame
+    // touches them: history write + guides (updateGuides), flux / flatness
+    // (updateStats), then the mask chain and the transient follower
+    // (computeMasks). Pre-allocate all memory once - NO allocations during
+    // processing.
+    const auto bins = static_cast<size_t>(numBins);
+    historyFormat = requestedHistoryFormat;
+    const bool keyed = historyFormat == HistoryFormat::Key16;
+    arena.clear();
+    if (keyed)
+    {
+        arena.add(newestKeys, bins);
+        arena.add(historyKeys, static_cast<size_t>(horizontalMedianSize) * bins);
+        arena.add(currentMagnitudes, bins);
+    }
+    else
+        arena.add(magnitudeHistoryData, static_cast<size_t>(horizontalMedianSize) * bins);
+    arena.add(horizontalGuide, bins);
+    arena.add(verticalGuide, bins);
+    arena.add(previousMagnitudes, bins);
+    arena.add(spectralFlux, bins);
+    arena.add(spectralFlatness, bins);
+    arena.add(combinedMask, bins);
+    arena.add(previousSmoothedMask, bins);
+    arena.add(smoothedMask, bins);
+    arena.add(tempBuffer, bins);
+    arena.add(transientEnv, bins);
+    arena.add(lowBandMagnitudes, static_cast<size_t>(LowBandAnalyzer::getNumBins(sampleRate)));
+    arena.allocate();                       // Zero-filled
+    juce::FloatVectorOperations::fill(previousSmoothedMask.data(), 0.5f, numBins); // Start with neutral masks
+
+    flatnessWorkspace.prepare(numBins);
+    // Only the format in use gets its windows.
+    horizontalMedianBank = {};
+    horizontalKeyBank = {};
+    if (keyed)
+        horizontalKeyBank.prepare(numBins, horizontalMedianSize);
+    else
+        horizontalMedianBank.prepare(numBins, horizontalMedianSize);
+    verticalMedianWindow.prepare(verticalMedianSize);
     
-    // Initialize magnitude history (fixed ring buffer for horizontal median)
-    // Pre-allocate all memory once - NO allocations during processing
-    magnitudeHistoryData.resize(horizontalMedianSize * numBins, 0.0f);
     historyWriteIndex = 0;
     framesReceived = 0;  // Start with no valid frames
 
     lowFreqTracker.prepare(numBins, sampleRate);
+    hasLowBand = false;
 
     isInitialized = true;
 }
@@ -61,9 +82,6 @@ void MaskEstimator::reset() noexcept
     juce::FloatVectorOperations::clear(spectralFlatness.data(), numBins);
     
     // Clear processing buffers
-    juce::FloatVectorOperations::clear(hpssMask.data(), numBins);
-    juce::FloatVectorOperations::clear(fluxMask.data(), numBins);
-    juce::FloatVectorOperations::clear(flatnessMask.data(), numBins);
     juce::FloatVectorOperations::clear(combinedMask.data(), numBins);
     juce::FloatVectorOperations::clear(smoothedMask.data(), numBins);
     
@@ -73,12 +91,41 @@ void MaskEstimator::reset() noexcept
     juce::FloatVectorOperations::clear(transientEnv.data(), numBins);
     
     // Clear magnitude history ring buffer and reset write index
-    juce::FloatVectorOperations::clear(magnitudeHistoryData.data(),
-                                       horizontalMedianSize * numBins);
+    std::fill(magnitudeHistoryData.begin(), magnitudeHistoryData.end(), 0.0f);
+    std::fill(historyKeys.begin(), historyKeys.end(), SlidingMedian::Key {});
+    std::fill(currentMagnitudes.begin(), currentMagnitudes.end(), 0.0f);
     historyWriteIndex = 0;
     framesReceived = 0;  // Reset valid frame count
+    horizontalMedianBank.reset();
+    horizontalKeyBank.reset();
 
     lowFreqTracker.reset();
+    hasLowBand = false;
+
+    estimateFrame = true;
+    fluxReady = false;
+    hasEstimate = false;
+    framesSinceEstimate = 0;
+    fluxAverage = 0.0f;
+    seedSmoother = false;
+}
+
+void MaskEstimator::setLowBand(juce::Span<const float> lowBand) noexcept
+{
+    jassert(isInitialized);
+    jassert(lowBand.empty() || lowBand.size() == lowBandMagnitudes.size());
+
+    hasLowBand = ! lowBand.empty();
+    if (hasLowBand)
+        juce::FloatVectorOperations::copy(lowBandMagnitudes.data(), lowBand.data(), (int) lowBand.size());
+}
+
+juce::Span<const float> MaskEstimator::takeLowBand() noexcept
+{
+    if (! hasLowBand)
+        return {};
+    hasLowBand = false;
+    return { lowBandMagnitudes.data(), lowBandMagnitudes.size() };
 }
 
 void MaskEstimator::updateGuides(juce::Span<const float> magnitudes) noexcept
@@ -86,35 +133,250 @@ void MaskEstimator::updateGuides(juce::Span<const float> magnitudes) noexcept
     jassert(isInitialized);
     jassert(magnitudes.size() == static_cast<size_t>(numBins));
 
-    // Write current frame to ring buffer at write index position
-    // This overwrites the oldest frame - NO allocations!
-    float* writePosition = magnitudeHistoryData.data() + (historyWriteIndex * numBins);
-    juce::FloatVectorOperations::copy(writePosition, magnitudes.data(), numBins);
+    if (warmStart && framesReceived == 0)
+        seedHistory(magnitudes);
+    else
+    {
+        UNRAVEL_PROFILE_STAGE(profile, Medians);
+
+        // Write current frame to ring buffer at write index position
+        // This overwrites the oldest frame - NO allocations!
+        // Once the ring is full that slot holds the frame leaving the horizontal
+        // median window, so the sliding median bank is advanced first.
+        const bool full = framesReceived == horizontalMedianSize;
+        if (historyFormat == HistoryFormat::Key16)
+        {
+            // Keys only for the work range, the only windows read; the
+            // whole frame as magnitudes, for the cross-frequency windows.
+            SlidingMedian::Key* writePosition = historyKeys.data() + (historyWriteIndex * numBins);
+            SlidingMedian::toKeys(magnitudes.data() + workStart, newestKeys.data() + workStart, workEnd - workStart);
+            horizontalKeyBank.push(newestKeys.data(), full ? writePosition : nullptr, workStart, workEnd);
+            std::copy(newestKeys.begin() + workStart, newestKeys.begin() + workEnd, writePosition + workStart);
+            juce::FloatVectorOperations::copy(currentMagnitudes.data(), magnitudes.data(), numBins);
+        }
+        else
+        {
+            float* writePosition = magnitudeHistoryData.data() + (historyWriteIndex * numBins);
+            horizontalMedianBank.push(magnitudes.data(), full ? writePosition : nullptr, workStart, workEnd);
+            juce::FloatVectorOperations::copy(writePosition, magnitudes.data(), numBins);
+        }
+
+        // Advance write index (wrap around)
+        historyWriteIndex = (historyWriteIndex + 1) % horizontalMedianSize;
 
-    // Advance write index (wrap around)
-    historyWriteIndex = (historyWriteIndex + 1) % horizontalMedianSize;
+        // Track how many valid frames we have (cap at horizontalMedianSize)
+        if (framesReceived < horizontalMedianSize)
+            framesReceived++;
+    }
 
-    // Track how many valid frames we have (cap at horizontalMedianSize)
-    if (framesReceived < horizontalMedianSize)
-        framesReceived++;
+    // The window advances every frame; the guides are only read on frames
+    // that run the full estimate.
+    estimateFrame = maskDecimation == 1 || isEstimateDue();
+    if (estimateFrame)
+    {
+        UNRAVEL_PROFILE_STAGE(profile, Medians);
 
-    // Compute horizontal and vertical median filters
-    computeHorizontalMedian();
-    computeVerticalMedian();
+        // Compute horizontal and vertical median filters
+        computeHorizontalMedian();
+        computeVerticalMedian();
+    }
 
-    // Track sustained low-frequency partials from this magnitude frame; its
-    // per-bin override is applied later in finalizeMasksFromSmoothed().
-    lowFreqTracker.process(magnitudes);
+    // Track sustained low-frequency partials from this magnitude frame (or
+    // its low-band spectrum); the per-bin override is applied later in
+    // finalizeMasksFromSmoothed().
+    trackLowFrequencies(magnitudes);
 }
 
-void MaskEstimator::updateStats(juce::Span<const float> magnitudes) noexcept
+void MaskEstimator::updateGuides(juce::Span<const float> magnitudes,
+                                 juce::Span<const float> externalHorizontalGuide) noexcept
 {
     jassert(isInitialized);
     jassert(magnitudes.size() == static_cast<size_t>(numBins));
-    
-    // Compute spectral statistics
+    jassert(externalHorizontalGuide.size() == static_cast<size_t>(numBins));
+
+    // Same history ring as the causal path (the vertical median and the
+    // spectral statistics read the current frame from it), but the median
+    // bank is left alone: the horizontal guide comes from the caller.
+    {
+        UNRAVEL_PROFILE_STAGE(profile, Medians);
+        float* writePosition = (historyFormat == HistoryFormat::Key16)
+                             ? currentMagnitudes.data()     // No window to feed: the frame alone
+                             : magnitudeHistoryData.data() + (historyWriteIndex * numBins);
+        juce::FloatVectorOperations::copy(writePosition, magnitudes.data(), numBins);
+        historyWriteIndex = (historyWriteIndex + 1) % horizontalMedianSize;
+        if (framesReceived < horizontalMedianSize)
+            framesReceived++;
+
+        juce::FloatVectorOperations::copy(horizontalGuide.data(), externalHorizontalGuide.data(), numBins);
+        computeVerticalMedian();
+    }
+    estimateFrame = true;
+    hasEstimate = false;    // The held mask is not kept up to date here
+
+    trackLowFrequencies(magnitudes);
+}
+
+void MaskEstimator::trackLowFrequencies(juce::Span<const float> magnitudes) noexcept
+{
+    const auto lowBand = takeLowBand();     // Consumed either way
+    if (! lowFreqTracking)
+        return;
+
+    UNRAVEL_PROFILE_STAGE(profile, LowFreqTracker);
+    lowFreqTracker.process(magnitudes, lowBand);
+}
+
+void MaskEstimator::seedHistory(juce::Span<const float> magnitudes) noexcept
+{
+    UNRAVEL_PROFILE_STAGE(profile, Medians);
+
+    // Every slot holds the frame, so the ring is full and the write index
+    // is back where it started.
+    if (historyFormat == HistoryFormat::Key16)
+    {
+        SlidingMedian::toKeys(magnitudes.data() + workStart, newestKeys.data() + workStart, workEnd - workStart);
+        for (int frame = 0; frame < horizontalMedianSize; ++frame)
+        {
+            horizontalKeyBank.push(newestKeys.data(), nullptr, workStart, workEnd);
+            std::copy(newestKeys.begin() + workStart, newestKeys.begin() + workEnd,
+                      historyKeys.data() + frame * numBins + workStart);
+        }
+        juce::FloatVectorOperations::copy(currentMagnitudes.data(), magnitudes.data(), numBins);
+    }
+    else
+    {
+        for (int frame = 0; frame < horizontalMedianSize; ++frame)
+        {
+            horizontalMedianBank.push(magnitudes.data(), nullptr, workStart, workEnd);
+            juce::FloatVectorOperations::copy(magnitudeHistoryData.data() + frame * numBins,
+                                              magnitudes.data(), numBins);
+        }
+    }
+    framesReceived = horizontalMedianSize;
+
+    // The frame "before" is the frame smoothed across frequency: a steady
+    // bin departs from its neighbours about as far as from its previous
+    // frame (noise a lot, a partial's neighbourhood little), so the first
+    // flux, and the transient follower started on it, are near what a long
+    // stretch of the frame would have settled at. Taking the frame itself
+    // would call everything steady and send all noise to the noise stream.
+    SlidingMedian::centredMedianFilter(magnitudes.data(), previousMagnitudes.data(), numBins,
+                                       activeVerticalMedianSize, verticalMedianWindow);
     computeSpectralFlux();
-    computeSpectralFlatness();
+    juce::FloatVectorOperations::copy(transientEnv.data(), spectralFlux.data(), numBins);
+    seedSmoother = true;
+}
+
+void MaskEstimator::setLowFreqTracking(bool enabled) noexcept
+{
+    if (enabled && ! lowFreqTracking)
+        lowFreqTracker.reset();
+    lowFreqTracking = enabled;
+}
+
+void MaskEstimator::setVerticalMedianSize(int size) noexcept
+{
+    jassert(size >= 3 && size <= verticalMedianSize && (size & 1) == 1);
+    activeVerticalMedianSize = juce::jlimit(3, (int) verticalMedianSize, size | 1);
+}
+
+void MaskEstimator::setMaskDecimation(int interval) noexcept
+{
+    jassert(interval >= 1 && interval <= maxMaskDecimation);
+    const int clamped = juce::jlimit(1, (int) maxMaskDecimation, interval);
+    if (clamped != maskDecimation)
+        hasEstimate = false;    // Estimate the next frame, whatever is held
+    maskDecimation = clamped;
+}
+
+void MaskEstimator::setActiveBand(int firstBin, int endBin) noexcept
+{
+    jassert(isInitialized);
+    jassert(firstBin >= 0 && firstBin < endBin && endBin <= numBins);
+    const int start = juce::jlimit(0, numBins - 1, firstBin);
+    const int end = juce::jlimit(start + 1, numBins, endBin);
+    if (start == bandStart && end == bandEnd)
+        return;
+
+    bandStart = start;
+    bandEnd = end;
+    workStart = std::max(0, start - blurRadius);
+    workEnd = std::min(numBins, end + blurRadius);
+    reset();
+}
+
+void MaskEstimator::setOutOfBandSplit(float tonal, float transient, float noise) noexcept
+{
+    tonal = std::max(tonal, 0.0f);
+    transient = std::max(transient, 0.0f);
+    noise = std::max(noise, 0.0f);
+    const float total = tonal + transient + noise;
+    jassert(total > 0.0f);
+    if (total <= 0.0f)
+        return;
+
+    outOfBandTonal = tonal / total;
+    outOfBandTransient = transient / total;
+    outOfBandNoise = noise / total;
+}
+
+void MaskEstimator::fillOutOfBand(juce::Span<float> tonalMask, juce::Span<float> transientMask,
+                                  juce::Span<float> noiseMask) const noexcept
+{
+    // Below the band, then above it.
+    const int ranges[2][2] = { { 0, bandStart }, { bandEnd, numBins } };
+    for (const auto& range : ranges)
+    {
+        const int n = range[1] - range[0];
+        if (n <= 0)
+            continue;
+        juce::FloatVectorOperations::fill(tonalMask.data() + range[0], outOfBandTonal, n);
+        juce::FloatVectorOperations::fill(transientMask.data() + range[0], outOfBandTransient, n);
+        juce::FloatVectorOperations::fill(noiseMask.data() + range[0], outOfBandNoise, n);
+    }
+}
+
+bool MaskEstimator::isEstimateDue() noexcept
+{
+    UNRAVEL_PROFILE_STAGE(profile, FluxFlatness);
+    computeSpectralFlux();
+    fluxReady = true;
+
+    // Mean flux over the frame, what the transient follower sees: a
+    // broadband onset lifts most bins at once, where the frame-to-frame
+    // wobble of steady noise averages out over the bins.
+    float onsetFlux = 0.0f;
+    for (int i = bandStart; i < bandEnd; ++i)
+        onsetFlux += spectralFlux[(size_t) i];
+    onsetFlux /= static_cast<float>(bandEnd - bandStart);
+    const bool onset = onsetFlux > fluxAverage + onsetFluxRise;
+    fluxAverage += (onsetFlux - fluxAverage) * onsetFluxAverage;
+
+    const bool due = ! hasEstimate || onset || ++framesSinceEstimate >= maskDecimation
+                  || separationAmount != estimatedSeparation || focusBias != estimatedFocus;
+    if (due)
+    {
+        hasEstimate = true;
+        framesSinceEstimate = 0;
+        estimatedSeparation = separationAmount;
+        estimatedFocus = focusBias;
+    }
+    return due;
+}
+
+void MaskEstimator::updateStats(juce::Span<const float> magnitudes) noexcept
+{
+    jassert(isInitialized);
+    jassert(magnitudes.size() == static_cast<size_t>(numBins));
+    UNRAVEL_PROFILE_STAGE(profile, FluxFlatness);
+
+    // Compute spectral statistics (the flux may already be in from the
+    // decimation test; flatness only feeds the Wiener masks).
+    if (! fluxReady)
+        computeSpectralFlux();
+    fluxReady = false;
+    if (estimateFrame)
+        computeSpectralFlatness();
     
     // Store current magnitudes for next frame
     juce::FloatVectorOperations::copy(previousMagnitudes.data(), magnitudes.data(), numBins);
@@ -128,82 +390,22 @@ void MaskEstimator::computeMasks(juce::Span<float> tonalMask,
     jassert(tonalMask.size() == static_cast<size_t>(numBins));
     jassert(transientMask.size() == static_cast<size_t>(numBins));
     jassert(noiseMask.size() == static_cast<size_t>(numBins));
+    UNRAVEL_PROFILE_STAGE(profile, MaskPostProcessing);
 
-    // Wiener-style soft mask: tonalMask = pow(tonalPower/(tonalPower+noisePower), exp).
-    // Exponent < 1 softens separation; > 3 approaches binary masking.
-    //
-    // Mask exponent from separation amount, curve y = 0.3 + 2t + 2.7t².
-    //   t = 0.0  → exp = 0.30 (very soft / natural blending)
-    //   t = 0.5  → exp = 1.98 (above standard Wiener)
-    //   t = 0.75 → exp = 3.32 (strong separation)
-    //   t = 0.85 → exp = 3.95 (near-binary; current default)
-    //   t = 1.0  → exp = 5.00 (extreme isolation)
-    const float t = separationAmount;
-    const float maskExponent = 0.3f + t * (2.0f + t * 2.7f);
-
-    // Compute Wiener-style masks with spectral feature enhancement
-    for (int i = 0; i < numBins; ++i)
+    if (pipeline == Pipeline::Fused)
     {
-        // Power estimates from HPSS guides (squared for power domain)
-        float tonalPower = horizontalGuide[i] * horizontalGuide[i];
-        float noisePower = verticalGuide[i] * verticalGuide[i];
-
-        // NUMERICAL STABILITY: Ensure minimum power levels to prevent
-        // division instability and NaN propagation through the mask exponent.
-        // This is critical when processing starts (few valid frames) or
-        // during silence.
-        const float minPower = eps * 100.0f;  // Minimum power floor
-        tonalPower = std::max(tonalPower, minPower);
-        noisePower = std::max(noisePower, minPower);
-
-        // Enhance discrimination using spectral features:
-        // - High spectral flux indicates transient/noise content
-        // - High spectral flatness indicates noise-like content
-        const float fluxPenalty = spectralFlux[i] * 0.7f;      // Penalize tonal if high flux
-        const float flatnessPenalty = spectralFlatness[i] * 0.5f;  // Penalize tonal if flat
-
-        // Apply penalties to tonal power estimate (clamp to avoid going negative)
-        tonalPower *= std::max(0.01f, (1.0f - fluxPenalty) * (1.0f - flatnessPenalty));
-
-        // Boost noise power estimate based on same features
-        noisePower *= (1.0f + fluxPenalty * 0.5f) * (1.0f + flatnessPenalty * 0.5f);
-
-        // Apply focus bias to shift detection threshold
-        // focusBias: -1 = favor tonal detection, +1 = favor noise detection
-        // Use quadratic boost for more dramatic effect at extremes
-        if (focusBias < 0.0f)
-        {
-            // Tonal focus: boost tonal power estimate
-            const float bias = -focusBias;
-            const float boost = 1.0f + bias * (2.0f + bias * 2.0f);  // Up to 5x boost at extreme
-            tonalPower *= boost;
-        }
-        else if (focusBias > 0.0f)
-        {
-            // Noise focus: boost noise power estimate
-            const float bias = focusBias;
-            const float boost = 1.0f + bias * (2.0f + bias * 2.0f);  // Up to 5x boost at extreme
-            noisePower *= boost;
-        }
-
-        // Wiener gain: ratio of signal power to total power. The eps fallback
-        // is defensive only — tonalPower/noisePower are each floored to
-        // minPower above, so totalPower > eps always holds in practice. We
-        // still default to 0 rather than a "neutral 0.5": a phantom 0.5 tonal
-        // share would otherwise leak through the floor binarisation at the XY
-        // pad corners if that flooring were ever relaxed.
-        const float totalPower = tonalPower + noisePower;
-        const float wienerGain = (totalPower > eps)
-            ? std::clamp(tonalPower / totalPower, 0.0f, 1.0f)
-            : 0.0f;
-
-        // Apply mask exponent for sharpness control
-        // pow(x, exp) where exp > 1 makes the mask more binary/dramatic
-        // Use safe pow that handles edge cases
-        const float safeMask = std::pow(std::max(wienerGain, 0.0f), maskExponent);
-        combinedMask[i] = std::isfinite(safeMask) ? safeMask : 0.5f;  // Fallback to neutral
+        computeMasksFused(nullptr, tonalMask, transientMask, noiseMask);
+        return;
     }
 
+    // Wiener-style soft masks (see getWienerParams); decimated frames keep
+    // the last estimate's.
+    if (estimateFrame)
+        SpectralKernels::computeWienerMasks(horizontalGuide.data() + workStart, verticalGuide.data() + workStart,
+                                            spectralFlux.data() + workStart, spectralFlatness.data() + workStart,
+                                            combinedMask.data() + workStart, workEnd - workStart,
+                                            getWienerParams());
+
     // Apply temporal smoothing with asymmetric attack/release.
     // Fast attack preserves transients, slow release reduces pumping.
     applyAsymmetricSmoothing();
@@ -219,7 +421,8 @@ void MaskEstimator::computeMasks(juce::Span<float> tonalMask,
     // recurrence — a self-stabilising loop that produced the ~0.077 fixed point
     // the dsp-debugger pass found. Capturing the pre-floor/blur output avoids
     // both failure modes.
-    juce::FloatVectorOperations::copy(previousSmoothedMask.data(), smoothedMask.data(), numBins);
+    juce::FloatVectorOperations::copy(previousSmoothedMask.data() + workStart, smoothedMask.data() + workStart,
+                                      workEnd - workStart);
 
     // Apply spectral floor + frequency blur + the mass-conserving 3-stream
     // split. Factored into a shared tail so computeMasksWithTonal() reuses the
@@ -239,6 +442,14 @@ void MaskEstimator::computeMasksWithTonal(juce::Span<const float> externalTonalM
     jassert(tonalMask.size() == static_cast<size_t>(numBins));
     jassert(transientMask.size() == static_cast<size_t>(numBins));
     jassert(noiseMask.size() == static_cast<size_t>(numBins));
+    UNRAVEL_PROFILE_STAGE(profile, MaskPostProcessing);
+    hasEstimate = false;    // Staged reuses combinedMask: no Wiener mask is held past this
+
+    if (pipeline == Pipeline::Fused)
+    {
+        computeMasksFused(externalTonalMask.data(), tonalMask, transientMask, noiseMask);
+        return;
+    }
 
     // Seed combinedMask from the EXTERNALLY supplied tonal mask (already
     // reconciled to this grid by the long-grid HarmonicMaskDetector) instead of
@@ -249,7 +460,7 @@ void MaskEstimator::computeMasksWithTonal(juce::Span<const float> externalTonalM
     // controls keep working. The transient envelope still uses spectralFlux,
     // which the caller is expected to have populated via updateGuides()/
     // updateStats() on THIS grid before calling.
-    for (int i = 0; i < numBins; ++i)
+    for (int i = workStart; i < workEnd; ++i)
         combinedMask[i] = clamp01(externalTonalMask[i]);
 
     // Same temporal smoothing as the normal path.
@@ -257,7 +468,8 @@ void MaskEstimator::computeMasksWithTonal(juce::Span<const float> externalTonalM
 
     // Same snapshot ordering as computeMasks(): capture the smoother's OUTPUT
     // (smoothedMask), BEFORE floor/blur, as next frame's IIR recurrence state.
-    juce::FloatVectorOperations::copy(previousSmoothedMask.data(), smoothedMask.data(), numBins);
+    juce::FloatVectorOperations::copy(previousSmoothedMask.data() + workStart, smoothedMask.data() + workStart,
+                                      workEnd - workStart);
 
     // Same shared tail: floor + blur + mass-conserving 3-stream split.
     finalizeMasksFromSmoothed(tonalMask, transientMask, noiseMask);
@@ -289,8 +501,9 @@ void MaskEstimator::finalizeMasksFromSmoothed(juce::Span<float> tonalMask,
     // at low bins, removing them from the Noise stream. Only ever raises the
     // tonal mask, only at confirmed low partials — mid/high and broadband noise
     // are untouched, so a unity-gain full mix still reconstructs identically.
-    lowFreqTracker.applyOverride(juce::Span<float>(smoothedMask.data(),
-                                                   static_cast<size_t>(numBins)));
+    if (lowFreqTracking)
+        lowFreqTracker.applyOverride(juce::Span<float>(smoothedMask.data(),
+                                                       static_cast<size_t>(numBins)));
 
     // Three-stream split (mass-conserving: tonal + transient + noise = 1 per bin).
     //
@@ -302,21 +515,124 @@ void MaskEstimator::finalizeMasksFromSmoothed(juce::Span<float> tonalMask,
     // Onsets immediately push transientness toward 1 (fast attack) so a short
     // broadband event flows to the Transient stream; as the event sustains the
     // envelope decays (slow release) and the energy moves back into Noise.
-    for (int i = 0; i < numBins; ++i)
+    for (int i = workStart; i < workEnd; ++i)
+        splitBin(i, smoothedMask[(size_t) i], tonalMask.data(), transientMask.data(), noiseMask.data());
+    fillOutOfBand(tonalMask, transientMask, noiseMask);
+}
+
+SpectralKernels::WienerParams MaskEstimator::getWienerParams() const noexcept
+{
+    // Wiener-style soft mask: tonalMask = pow(tonalPower/(tonalPower+noisePower), exp).
+    // Exponent < 1 softens separation; > 3 approaches binary masking.
+    //
+    // Mask exponent from separation amount, curve y = 0.3 + 2t + 2.7t².
+    //   t = 0.0  → exp = 0.30 (very soft / natural blending)
+    //   t = 0.5  → exp = 1.98 (above standard Wiener)
+    //   t = 0.75 → exp = 3.32 (strong separation)
+    //   t = 0.85 → exp = 3.95 (near-binary; current default)
+    //   t = 1.0  → exp = 5.00 (extreme isolation)
+    const float t = separationAmount;
+    const float maskExponent = 0.3f + t * (2.0f + t * 2.7f);
+
+    // Focus bias shifts the detection threshold by boosting one power estimate.
+    // focusBias: -1 = favor tonal detection, +1 = favor noise detection.
+    // Quadratic boost for a more dramatic effect at the extremes (up to 5x).
+    const float bias = std::abs(focusBias);
+    const float focusBoost = 1.0f + bias * (2.0f + bias * 2.0f);
+
+    // Wiener-style masks with spectral feature enhancement, per bin:
+    //   tonalPower = max(H², minPower) · max(0.01, (1 − 0.7·flux)(1 − 0.5·flatness))
+    //   noisePower = max(V², minPower) · (1 + 0.35·flux)(1 + 0.25·flatness)
+    //   mask       = pow(tonalPower / (tonalPower + noisePower), maskExponent)
+    // High flux (transient) and high flatness (noise-like) penalise tonal.
+    // The power floor (eps·100) keeps the ratio and the exponent stable at
+    // start-up and in silence. The mask defaults to 0 rather than a "neutral
+    // 0.5" if total power ever falls below eps: a phantom 0.5 tonal share would
+    // leak through the floor binarisation at the XY pad corners.
+    // Runs as one vectorised kernel (SpectralKernels, accuracy ≤ 2e-6 vs pow()).
+    SpectralKernels::WienerParams wiener;
+    wiener.minPower = eps * 100.0f;
+    wiener.tonalBoost = (focusBias < 0.0f) ? focusBoost : 1.0f;
+    wiener.noiseBoost = (focusBias > 0.0f) ? focusBoost : 1.0f;
+    wiener.exponent = maskExponent;
+    wiener.eps = eps;
+    return wiener;
+}
+
+void MaskEstimator::computeMasksFused(const float* externalTonalMask,
+                                      juce::Span<float> tonalMask,
+                                      juce::Span<float> transientMask,
+                                      juce::Span<float> noiseMask) noexcept
+{
+    // The Staged chain, one tile at a time: the Wiener (or external) mask,
+    // smoothing + recurrence snapshot and floor run over a 64-bin tile held
+    // on the stack; blur, low-frequency override and the split then finish
+    // the bins whose right-hand neighbour is known. The blur therefore
+    // trails by one bin, and `floored` carries the previous tile's last two
+    // bins: [0] = bin start-2, [1] = bin start-1, [2 + k] = bin start+k.
+    // Decimated, the Wiener masks go to combinedMask instead of the tile, to
+    // be held there until the next estimate.
+    const SpectralKernels::WienerParams wiener = getWienerParams();
+    const bool holdWiener = maskDecimation > 1;
+    const bool floorOn = spectralFloorThreshold > 0.0f;
+    const float floorLevel = spectralFloorThreshold * 0.5f;
+    const float ceilingLevel = 1.0f - floorLevel;
+    const float blurMix = 1.0f - juce::jlimit(0.0f, 1.0f, spectralFloorThreshold);
+    const bool blurOn = blurMix > eps;
+    const float* lowFreqOverride = lowFreqTracker.getOverrideMask();
+    const int overrideEnd = lowFreqTracking ? lowFreqTracker.getOverrideEnd() : 0;
+
+    alignas(64) float tile[kTileBins];
+    float floored[kTileBins + 2] = {};
+
+    auto finishBin = [&](int bin, int index) noexcept
+    {
+        float mask = floored[index];
+        if (blurOn)
+            mask = blurBin(floored[index - 1], mask, floored[index + 1], bin > 0, bin < numBins - 1, blurMix);
+        if (bin < overrideEnd)
+            mask = std::max(mask, lowFreqOverride[bin]);
+        splitBin(bin, mask, tonalMask.data(), transientMask.data(), noiseMask.data());
+    };
+
+    for (int start = workStart; start < workEnd; start += kTileBins)
     {
-        const float flux = clamp01(spectralFlux[i]);
-        const float prev = transientEnv[i];
-        const float alpha = (flux > prev) ? transientAttack : transientRelease;
-        transientEnv[i] = prev + (flux - prev) * alpha;
-
-        const float t  = clamp01(smoothedMask[i]);
-        const float tr = clamp01(transientEnv[i]);
-        const float nonTonal = 1.0f - t;
-
-        tonalMask[i]     = t;
-        transientMask[i] = nonTonal * tr;
-        noiseMask[i]     = nonTonal * (1.0f - tr);
+        const int n = std::min(kTileBins, workEnd - start);
+        const float* source = tile;
+        if (externalTonalMask == nullptr)
+        {
+            float* wienerOut = holdWiener ? combinedMask.data() + start : tile;
+            if (estimateFrame)
+                SpectralKernels::computeWienerMasks(horizontalGuide.data() + start, verticalGuide.data() + start,
+                                                    spectralFlux.data() + start, spectralFlatness.data() + start,
+                                                    wienerOut, n, wiener);
+            source = wienerOut;
+        }
+        else
+            for (int k = 0; k < n; ++k)
+                tile[k] = clamp01(externalTonalMask[start + k]);
+
+        float* previous = previousSmoothedMask.data() + start;
+        if (seedSmoother)
+            std::copy(source, source + n, previous);
+        for (int k = 0; k < n; ++k)
+        {
+            const float smoothed = smoothBin(source[k], previous[k]);
+            previous[k] = smoothed;     // Recurrence state: pre-floor/blur, as in Staged
+            floored[2 + k] = floorOn ? floorBin(smoothed, floorLevel, ceilingLevel) : smoothed;
+        }
+
+        // Bins start-1 .. start+n-2 now have both neighbours.
+        for (int k = (start == workStart) ? 1 : 0; k < n; ++k)
+            finishBin(start + k - 1, k + 1);
+
+        floored[0] = floored[n];
+        floored[1] = floored[n + 1];
     }
+
+    finishBin(workEnd - 1, 1);
+    seedSmoother = false;
+    fillOutOfBand(tonalMask, transientMask, noiseMask);
 }
 
 void MaskEstimator::computeHorizontalMedian() noexcept
@@ -324,49 +640,29 @@ void MaskEstimator::computeHorizontalMedian() noexcept
     // Horizontal median: median across time frames for each frequency bin
     // Enhances sustained tones and harmonic content
     //
-    // IMPORTANT: Only use frames that have actually been filled with data!
+    // IMPORTANT: Only frames that have actually been filled with data count!
     // Using uninitialized (zero) frames causes unstable median values that
     // propagate through the Wiener filter as garbage/crackling artifacts.
-    const int validFrames = std::max(1, framesReceived);
-
-    for (int bin = 0; bin < numBins; ++bin)
-    {
-        // Copy magnitudes from only the VALID time frames for this frequency bin
-        // Valid frames are the most recent ones in the ring buffer
-        for (int t = 0; t < validFrames; ++t)
-        {
-            // Access frames from newest to oldest within valid range
-            // getHistoryFrame(horizontalMedianSize - 1) is the newest
-            const int frameOffset = horizontalMedianSize - validFrames + t;
-            tempBuffer[t] = getHistoryFrame(frameOffset)[bin];
-        }
-
-        horizontalGuide[bin] = computeMedian(tempBuffer.data(), validFrames);
-    }
+    // The bank's windows hold exactly the valid frames (it fills up over the
+    // first horizontalMedianSize frames), so no special-casing is needed.
+    if (historyFormat == HistoryFormat::Key16)
+        horizontalKeyBank.computeMedians(horizontalGuide.data(), workStart, workEnd);
+    else
+        horizontalMedianBank.computeMedians(horizontalGuide.data(), workStart, workEnd);
 }
 
 void MaskEstimator::computeVerticalMedian() noexcept
 {
     // Vertical median: median across frequency bins for each frequency bin
-    // Enhances transients and percussive content
-    const float* currentMagnitudes = getCurrentFrame();
-
-    for (int bin = 0; bin < numBins; ++bin)
-    {
-        // Define frequency window around current bin
-        const int halfWindow = verticalMedianSize / 2;
-        const int startBin = std::max(0, bin - halfWindow);
-        const int endBin = std::min(numBins, bin + halfWindow + 1);
-        const int windowSize = endBin - startBin;
-
-        // Copy magnitudes from frequency neighborhood
-        for (int i = 0; i < windowSize; ++i)
-        {
-            tempBuffer[i] = currentMagnitudes[startBin + i];
-        }
-
-        verticalGuide[bin] = computeMedian(tempBuffer.data(), windowSize);
-    }
+    // Enhances transients and percussive content. Centred window, shrinking
+    // at the spectrum edges; slides one bin per step. With an active band
+    // the filter runs over the work range and the half window either side
+    // of it, so the work range's windows are the whole-frame ones.
+    const int halfWindow = activeVerticalMedianSize / 2;
+    const int lo = std::max(0, workStart - halfWindow);
+    const int hi = std::min(numBins, workEnd + halfWindow);
+    SlidingMedian::centredMedianFilter(getCurrentFrame() + lo, verticalGuide.data() + lo, hi - lo,
+                                       activeVerticalMedianSize, verticalMedianWindow);
 }
 
 void MaskEstimator::computeSpectralFlux() noexcept
@@ -374,7 +670,7 @@ void MaskEstimator::computeSpectralFlux() noexcept
     // Spectral flux: frame-to-frame magnitude change |mag[n] - mag[n-1]|
     const float* currentMagnitudes = getCurrentFrame();
 
-    for (int i = 0; i < numBins; ++i)
+    for (int i = workStart; i < workEnd; ++i)
     {
         const float currentMag = currentMagnitudes[i];
         const float prevMag = previousMagnitudes[i];
@@ -395,54 +691,13 @@ void MaskEstimator::computeSpectralFlux() noexcept
 
 void MaskEstimator::computeSpectralFlatness() noexcept
 {
-    // Spectral Flatness Measure: geometric mean / arithmetic mean
-    // SFM close to 0 = tonal (peaked), SFM close to 1 = noise-like (flat)
-    const float* magnitudes = getCurrentFrame();
+    // Spectral Flatness Measure: geometric mean / arithmetic mean over a local
+    // 13-bin window (DC skipped). SFM close to 0 = tonal (peaked), close to
+    // 1 = noise-like (flat); windows with < 3 valid bins are neutral (0.5).
+    // One log per bin plus prefix sums, vectorised in SpectralKernels.
     const int windowSize = 13; // Local frequency window
-    const int halfWindow = windowSize / 2;
-    
-    for (int bin = 0; bin < numBins; ++bin)
-    {
-        // Define local frequency window
-        const int startBin = std::max(1, bin - halfWindow); // Skip DC
-        const int endBin = std::min(numBins, bin + halfWindow + 1);
-        const int actualWindowSize = endBin - startBin;
-        
-        if (actualWindowSize < 3)
-        {
-            spectralFlatness[bin] = 0.5f; // Neutral value for edge cases
-            continue;
-        }
-        
-        // Calculate geometric and arithmetic means
-        double logSum = 0.0;
-        double arithmeticSum = 0.0;
-        int validBins = 0;
-        
-        for (int i = startBin; i < endBin; ++i)
-        {
-            const float mag = magnitudes[i];
-            if (mag > eps)
-            {
-                logSum += std::log(static_cast<double>(mag));
-                arithmeticSum += static_cast<double>(mag);
-                validBins++;
-            }
-        }
-        
-        if (validBins >= 3 && arithmeticSum > eps)
-        {
-            const double geometricMean = std::exp(logSum / validBins);
-            const double arithmeticMean = arithmeticSum / validBins;
-            const double sfm = geometricMean / arithmeticMean;
-            
-            spectralFlatness[bin] = clamp01(static_cast<float>(sfm));
-        }
-        else
-        {
-            spectralFlatness[bin] = 0.5f; // Neutral value
-        }
-    }
+    SpectralKernels::computeSpectralFlatness(getCurrentFrame(), spectralFlatness.data(), numBins,
+                                             workStart, workEnd, windowSize, eps, flatnessWorkspace);
 }
 
 void MaskEstimator::applyAsymmetricSmoothing() noexcept
@@ -450,17 +705,14 @@ void MaskEstimator::applyAsymmetricSmoothing() noexcept
     // Asymmetric smoothing with different attack/release rates
     // Fast attack (α=0.5) preserves transients and quick changes
     // Slow release (α=0.15) reduces pumping artifacts for dramatic separation
-    for (int i = 0; i < numBins; ++i)
-    {
-        const float current = combinedMask[i];
-        const float previous = previousSmoothedMask[i];
-
-        // Choose alpha based on direction of change
-        // Attack when mask increases (more signal), release when decreasing
-        const float alpha = (current > previous) ? attackAlpha : releaseAlpha;
-
-        smoothedMask[i] = alpha * current + (1.0f - alpha) * previous;
-    }
+    // (attack when the mask increases, release when it decreases).
+    // Warm-started, the first mask is its own previous output.
+    if (seedSmoother)
+        juce::FloatVectorOperations::copy(previousSmoothedMask.data() + workStart, combinedMask.data() + workStart,
+                                          workEnd - workStart);
+    seedSmoother = false;
+    for (int i = workStart; i < workEnd; ++i)
+        smoothedMask[(size_t) i] = smoothBin(combinedMask[(size_t) i], previousSmoothedMask[(size_t) i]);
 }
 
 void MaskEstimator::applySpectralFloor() noexcept
@@ -477,26 +729,9 @@ void MaskEstimator::applySpectralFloor() noexcept
     const float floorLevel = halfThreshold;
     const float ceilingLevel = 1.0f - halfThreshold;
 
-    for (int i = 0; i < numBins; ++i)
-    {
-        float mask = smoothedMask[i];
-
-        if (mask < floorLevel)
-        {
-            // Below floor: push toward 0
-            // Smooth transition using cubic interpolation
-            const float t = mask / floorLevel;  // 0 to 1
-            mask = t * t * t * floorLevel;  // Cubic ease-out to 0
-        }
-        else if (mask > ceilingLevel)
-        {
-            // Above ceiling: push toward 1
-            const float t = (mask - ceilingLevel) / (1.0f - ceilingLevel);  // 0 to 1
-            mask = ceilingLevel + (1.0f - ceilingLevel) * (1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t));  // Cubic ease-in to 1
-        }
-
-        smoothedMask[i] = mask;
-    }
+    // Smooth transitions by cubic interpolation on either side.
+    for (int i = workStart; i < workEnd; ++i)
+        smoothedMask[(size_t) i] = floorBin(smoothedMask[(size_t) i], floorLevel, ceilingLevel);
 }
 
 void MaskEstimator::applyFrequencyBlur() noexcept
@@ -509,61 +744,16 @@ void MaskEstimator::applyFrequencyBlur() noexcept
     //   - threshold = 1 (corner isolation): no blur — preserves the binary
     //     decisions made by applySpectralFloor immediately upstream.
     // Anything in between is a smooth mix.
-    juce::FloatVectorOperations::copy(tempBuffer.data(), smoothedMask.data(), numBins);
+    juce::FloatVectorOperations::copy(tempBuffer.data() + workStart, smoothedMask.data() + workStart,
+                                      workEnd - workStart);
 
     const float blurMix = 1.0f - juce::jlimit(0.0f, 1.0f, spectralFloorThreshold);
     if (blurMix <= eps)
         return;  // No blur to apply; smoothedMask already holds the unblurred values.
 
-    for (int i = 0; i < numBins; ++i)
-    {
-        float weightedSum = 0.0f;
-        float totalWeight = 0.0f;
-
-        for (int j = -blurRadius; j <= blurRadius; ++j)
-        {
-            const int neighborBin = i + j;
-            if (neighborBin >= 0 && neighborBin < numBins)
-            {
-                // Gaussian-like weight
-                const float weight = (j == 0) ? 0.5f : 0.25f;
-                weightedSum += tempBuffer[neighborBin] * weight;
-                totalWeight += weight;
-            }
-        }
-
-        if (totalWeight > eps)
-        {
-            const float blurred = weightedSum / totalWeight;
-            smoothedMask[i] = blurMix * blurred + (1.0f - blurMix) * tempBuffer[i];
-        }
-    }
+    static_assert(blurRadius == 1, "blurBin() is the ±1-bin kernel");
+    for (int i = workStart; i < workEnd; ++i)
+        smoothedMask[(size_t) i] = blurBin(i > 0 ? tempBuffer[(size_t) i - 1] : 0.0f, tempBuffer[(size_t) i],
+                                           i + 1 < numBins ? tempBuffer[(size_t) i + 1] : 0.0f,
+                                           i > 0, i + 1 < numBins, blurMix);
 }
-
-float MaskEstimator::computeMedian(float* data, int size) noexcept
-{
-    if (size <= 0)
-        return 0.0f;
-    
-    if (size == 1)
-        return data[0];
-    
-    // Use nth_element for efficient median computation
-    const int medianIndex = size / 2;
-    std::nth_element(data, data + medianIndex, data + size);
-    
-    if (size % 2 == 1)
-    {
-        // Odd size: return middle element
-        return data[medianIndex];
-    }
-    else
-    {
-        // Even size: return average of two middle elements
-        const float median1 = data[medianIndex];
-        std::nth_element(data, data + medianIndex - 1, data + size);
-        const float median2 = data[medianIndex - 1];
-        return (median1 + median2) * 0.5f;
-    }
-}
-
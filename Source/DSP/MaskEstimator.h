@@ -1,7 +1,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DspArena.h"
+#include "DspProfiler.h"
 #include "LowFreqPartialTracker.h"
+#include "SpectralKernels.h"
+#include "SlidingMedian.h"
+#include <algorithm>
 #include <vector>
 
 /**
@@ -18,7 +23,7 @@
  *
  * Optimized for real-time audio processing with:
  * - Zero allocations in processing methods (fixed ring buffer)
- * - SIMD-optimized median filtering
+ * - Incremental (sliding-window) median filtering
  * - Efficient ring buffer management
  * - Robust numerical stability
  */
@@ -46,6 +51,49 @@ public:
      * @param magnitudes Input magnitude spectrum (size: numBins)
      */
     void updateGuides(juce::Span<const float> magnitudes) noexcept;
+
+    /**
+     * Variant of updateGuides() for offline rendering, where the whole file's
+     * frames are known up front: uses a caller-supplied horizontal guide
+     * (e.g. a centred, non-causal median over the neighbouring frames) in
+     * place of the causal running median. The frame history, vertical guide
+     * and low-frequency tracker advance exactly as in updateGuides().
+     *
+     * Do not mix with updateGuides() without a reset() in between: the
+     * causal median windows are not advanced here.
+     *
+     * @param magnitudes      Input magnitude spectrum (size: numBins)
+     * @param externalHorizontalGuide Horizontal median for this frame (size: numBins)
+     */
+    void updateGuides(juce::Span<const float> magnitudes,
+                      juce::Span<const float> externalHorizontalGuide) noexcept;
+
+    /**
+     * Supply the LowBandAnalyzer spectrum of the frame the next updateGuides()
+     * call receives; the low-frequency tracker then picks its peaks on it
+     * instead of the frame's own low bins. Consumed by that call, so frames
+     * without one fall back to the main grid.
+     * @param lowBandMagnitudes Size LowBandAnalyzer::getNumBins(sampleRate), or empty for none
+     */
+    void setLowBand(juce::Span<const float> lowBandMagnitudes) noexcept;
+
+    /** Length of the horizontal (time) median, in frames. */
+    static constexpr int getHorizontalMedianSize() noexcept { return horizontalMedianSize; }
+
+    /**
+     * Frames of constant input after which the estimator's state no longer
+     * remembers what came before (to -60 dB): the median window has turned
+     * over and the slowest recursion, the release of the mask smoother or
+     * the transient follower, has decayed. SilenceGate holds after this many.
+     */
+    static constexpr int getSettlingFrames() noexcept
+    {
+        const float decay = 1.0f - std::min(releaseAlpha, transientRelease);
+        int frames = 0;
+        for (float residue = 1.0f; residue > 1e-3f; residue *= decay)
+            ++frames;
+        return std::max(frames, horizontalMedianSize);
+    }
     
     /**
      * Update spectral statistics with new magnitude frame.
@@ -93,6 +141,40 @@ public:
                                 juce::Span<float> transientMask,
                                 juce::Span<float> noiseMask) noexcept;
 
+    /**
+     * How computeMasks() / computeMasksWithTonal() walk the frame.
+     *
+     * Fused (default): Wiener → smoothing → floor → blur → low-frequency
+     * override → 3-way split in one pass over 64-bin tiles, so each tile's
+     * intermediates stay in L1 and only the masks, the smoother and
+     * transient state, and the guides / statistics are read or written in
+     * memory.
+     * Staged: the original one-pass-per-stage chain through the
+     * frame-sized intermediate buffers, kept as the Harness reference.
+     *
+     * Both run the same per-bin arithmetic in the same order, so their masks
+     * are bit-identical (checked by the Harness).
+     */
+    enum class Pipeline
+    {
+        Fused,
+        Staged
+    };
+
+    void setPipeline(Pipeline newPipeline) noexcept { pipeline = newPipeline; }
+    Pipeline getPipeline() const noexcept { return pipeline; }
+
+    /**
+     * How the horizontal median's frame history and sorted windows are kept
+     * (see SlidingMedian::HistoryFormat): Float32 takes 72 bytes per bin,
+     * Key16 40. The vertical guide and the statistics read the exact current
+     * frame either way. Takes effect at the next prepare().
+     */
+    using HistoryFormat = SlidingMedian::HistoryFormat;
+
+    void setHistoryFormat(HistoryFormat format) noexcept { requestedHistoryFormat = format; }
+    HistoryFormat getHistoryFormat() const noexcept { return historyFormat; }
+
     /**
      * Set separation amount (0-1).
      * 0 = no separation (masks at 0.5), 1 = full separation
@@ -132,6 +214,89 @@ public:
      */
     float getSpectralFloor() const noexcept { return spectralFloorThreshold; }
 
+    /**
+     * Run the low-frequency partial tracker (default on). Off, updateGuides()
+     * skips it and the masks get no override; turning it back on restarts
+     * it, so tracks from before the gap fade in again instead of snapping
+     * back. Cheaper quality tier for HPSSProcessor::setQualityTier().
+     */
+    void setLowFreqTracking(bool enabled) noexcept;
+    bool isLowFreqTracking() const noexcept { return lowFreqTracking; }
+
+    /**
+     * Length of the vertical (frequency) median, in bins: odd, from 3 up to
+     * getMaxVerticalMedianSize() (the default). Takes effect at the next
+     * updateGuides(); the window was sized for the longest, so it never
+     * allocates.
+     */
+    void setVerticalMedianSize(int size) noexcept;
+    int getVerticalMedianSize() const noexcept { return activeVerticalMedianSize; }
+    static constexpr int getMaxVerticalMedianSize() noexcept { return verticalMedianSize; }
+
+    /**
+     * Run the full estimate (medians, flatness, Wiener masks) only every
+     * interval-th frame: 1 (the default) is every frame, up to
+     * getMaxMaskDecimation(). The frames in between keep the last Wiener
+     * mask. It still goes through the attack/release smoother, which glides
+     * the output toward each new estimate. The floor, blur, low-frequency
+     * override and transient split also run on every frame, the split on
+     * that frame's own flux. So only the median and flatness work is skipped.
+     * Some frames are estimated early:
+     * - a frame whose flux rises an onset's worth above its recent average,
+     *   so onsets are never held;
+     * - the first frame after a Separation or Focus change.
+     * The offline updateGuides() overload estimates every frame. A frame
+     * finished by computeMasksWithTonal() leaves no Wiener mask to hold, so
+     * the frame after it is estimated in full.
+     */
+    void setMaskDecimation(int interval) noexcept;
+    int getMaskDecimation() const noexcept { return maskDecimation; }
+    static constexpr int getMaxMaskDecimation() noexcept { return maxMaskDecimation; }
+
+    /** True if the last updateGuides() ran the full estimate (always when undecimated). */
+    bool isFrameEstimated() const noexcept { return estimateFrame; }
+
+    /**
+     * Start cold or warm after prepare() / reset() (default cold). Cold, the
+     * median windows fill one frame at a time, the first frame's flux is
+     * measured against silence (a transient everywhere), and the smoother
+     * rises from neutral 0.5 masks. So the first ~9 frames after a reset or
+     * a transport jump are unstable. Warm, the first frame stands in for
+     * the history it lacks:
+     * - it fills the whole horizontal window;
+     * - its frequency-median stands in for the previous frame, so the flux
+     *   and the transient follower start near a steady stretch's;
+     * - its Wiener mask is the smoother's previous output.
+     * The masks then start where a long stretch of that frame would have
+     * left them. Only the causal updateGuides() warm-starts.
+     */
+    void setWarmStart(bool enabled) noexcept { warmStart = enabled; }
+    bool isWarmStart() const noexcept { return warmStart; }
+
+    /**
+     * Analyse only bins [firstBin, endBin) (default: all of them, which
+     * prepare() restores). Outside the band the masks are the fixed
+     * setOutOfBandSplit() and no per-bin work runs: medians, flux, flatness,
+     * Wiener masks, smoothing and the split only cover the band, plus the one
+     * bin either side the frequency blur reads. The cross-frequency windows
+     * (vertical median, flatness) still read their real neighbours, so
+     * in-band masks match a whole-frame estimate. Changing the band restarts
+     * the estimator (the history outside the old band is stale). RT-safe.
+     */
+    void setActiveBand(int firstBin, int endBin) noexcept;
+    int getActiveBandStart() const noexcept { return bandStart; }
+    int getActiveBandEnd() const noexcept { return bandEnd; }
+
+    /** Masks outside the active band (normalised to sum to 1; default all tonal). */
+    void setOutOfBandSplit(float tonal, float transient, float noise) noexcept;
+
+    /**
+     * Time the medians, flux/flatness, low-frequency tracker and mask stages
+     * into an accumulator (UNRAVEL_DSP_PROFILING builds; nullptr = untimed).
+     * Not owned; written only by the thread calling this estimator.
+     */
+    void setProfileAccumulator(DspProfiler::Accumulator* accumulator) noexcept { profile = accumulator; }
+
 private:
     // Core HPSS algorithm parameters (as per specification)
     static constexpr int horizontalMedianSize = 9;   // 9 time frames for harmonic enhancement
@@ -147,6 +312,15 @@ private:
     static constexpr float attackAlpha = 0.5f;       // Fast attack for transient preservation
     static constexpr float releaseAlpha = 0.15f;    // Slow release to reduce pumping
     static constexpr int blurRadius = 1;             // Frequency blur radius (±1 bin)
+    static constexpr int kTileBins = 64;             // Fused pipeline tile (a multiple of every SIMD width)
+
+    // Mask decimation (setMaskDecimation). The onset test compares the
+    // frame's mean flux with a one-pole average of it, so steadily noisy
+    // material (high flux every frame) does not count as an onset on every
+    // frame.
+    static constexpr int maxMaskDecimation = 4;
+    static constexpr float onsetFluxRise = 0.05f;    // Mean flux above its average that counts as an onset
+    static constexpr float onsetFluxAverage = 0.2f;  // Per-frame rate of that average
 
     // Transient-stream envelope follower (acts on the non-tonal residual).
     // Fast attack so onsets immediately flag as transient; slow release so the
@@ -163,10 +337,46 @@ private:
     float separationAmount = 0.75f;       // 0-1: How aggressively to separate (default 75%)
     float focusBias = 0.0f;               // -1 to +1: Tonal vs noise detection bias
     float spectralFloorThreshold = 0.0f;  // 0-1: Spectral floor for extreme isolation (default OFF)
+    Pipeline pipeline = Pipeline::Fused;
+    HistoryFormat requestedHistoryFormat = HistoryFormat::Float32;  // Applied by prepare()
+    HistoryFormat historyFormat = HistoryFormat::Float32;
+    bool lowFreqTracking = true;          // setLowFreqTracking()
+    int activeVerticalMedianSize = verticalMedianSize;  // setVerticalMedianSize()
+
+    // Mask decimation state: which frames run the full estimate.
+    int maskDecimation = 1;               // setMaskDecimation()
+    bool estimateFrame = true;            // This frame runs the full estimate
+    bool fluxReady = false;               // updateGuides() already computed this frame's flux
+    bool hasEstimate = false;             // A Wiener mask is held (combinedMask)
+    int framesSinceEstimate = 0;
+    float fluxAverage = 0.0f;             // Recent magnitude-weighted flux (onset test)
+    float estimatedSeparation = 0.0f;     // Settings the held mask was estimated at
+    float estimatedFocus = 0.0f;
+
+    bool warmStart = false;               // setWarmStart()
+    bool seedSmoother = false;            // Warm start: the next mask seeds previousSmoothedMask
+
+    // Active band (setActiveBand()); the per-bin stages run over the work
+    // range, the band plus the blur's neighbours.
+    int bandStart = 0;
+    int bandEnd = 0;
+    int workStart = 0;
+    int workEnd = 0;
+    float outOfBandTonal = 1.0f;          // setOutOfBandSplit()
+    float outOfBandTransient = 0.0f;
+    float outOfBandNoise = 0.0f;
     
+    // Per-frame buffers, laid out in one DspArena block in the order a frame
+    // touches them (see prepare()).
+    DspArena arena;
+
     // Magnitude history for HPSS (fixed ring buffer for time frames)
     // Stored as flat contiguous array: [frame0_bin0, frame0_bin1, ..., frame1_bin0, ...]
-    std::vector<float> magnitudeHistoryData;
+    // Key16 keeps the same ring as keys, and the current frame on its own.
+    DspArena::Buffer<float> magnitudeHistoryData;
+    DspArena::Buffer<SlidingMedian::Key> historyKeys;
+    DspArena::Buffer<SlidingMedian::Key> newestKeys;    // This frame's keys, before they enter the ring
+    DspArena::Buffer<float> currentMagnitudes;
     int historyWriteIndex = 0;  // Points to next frame to write (oldest frame)
     int framesReceived = 0;     // Track how many valid frames we have (0 to horizontalMedianSize)
 
@@ -186,6 +396,9 @@ private:
 
     inline float* getCurrentFrame() noexcept
     {
+        if (historyFormat == HistoryFormat::Key16)
+            return currentMagnitudes.data();
+
         // Current frame is the one just before write index (most recently written)
         const int currentIndex = (historyWriteIndex + horizontalMedianSize - 1) % horizontalMedianSize;
         return magnitudeHistoryData.data() + (currentIndex * numBins);
@@ -193,45 +406,78 @@ private:
 
     inline const float* getCurrentFrame() const noexcept
     {
+        if (historyFormat == HistoryFormat::Key16)
+            return currentMagnitudes.data();
+
         const int currentIndex = (historyWriteIndex + horizontalMedianSize - 1) % horizontalMedianSize;
         return magnitudeHistoryData.data() + (currentIndex * numBins);
     }
     
     // Previous frame for spectral flux calculation
-    std::vector<float> previousMagnitudes;
+    DspArena::Buffer<float> previousMagnitudes;
     
     // HPSS guide signals
-    std::vector<float> horizontalGuide;     // Horizontal median (per frequency bin)
-    std::vector<float> verticalGuide;       // Vertical median (per frequency bin)
+    DspArena::Buffer<float> horizontalGuide;     // Horizontal median (per frequency bin)
+    DspArena::Buffer<float> verticalGuide;       // Vertical median (per frequency bin)
     
     // Spectral statistics
-    std::vector<float> spectralFlux;        // Frame-to-frame magnitude change
-    std::vector<float> spectralFlatness;    // SFM per frequency bin
+    DspArena::Buffer<float> spectralFlux;        // Frame-to-frame magnitude change
+    DspArena::Buffer<float> spectralFlatness;    // SFM per frequency bin
     
     // Processing buffers (preallocated for real-time safety)
-    std::vector<float> hpssMask;            // Raw HPSS mask
-    std::vector<float> fluxMask;            // Spectral flux mask
-    std::vector<float> flatnessMask;        // Spectral flatness mask
-    std::vector<float> combinedMask;        // Blended mask before post-processing
-    std::vector<float> smoothedMask;        // After temporal smoothing
-    std::vector<float> tempBuffer;          // Temporary workspace for median calculation
+    DspArena::Buffer<float> combinedMask;        // Blended mask before post-processing (held while decimated)
+    DspArena::Buffer<float> smoothedMask;        // After temporal smoothing
+    DspArena::Buffer<float> tempBuffer;          // Temporary workspace for the frequency blur
+    SpectralKernels::FlatnessWorkspace flatnessWorkspace; // Scratch for the SFM kernel
+
+    // Running medians: one sorted time window per bin (horizontal guide) and
+    // one sliding frequency window (vertical guide). See SlidingMedian.h.
+    SlidingMedian::Bank horizontalMedianBank;
+    SlidingMedian::KeyBank horizontalKeyBank;           // Key16 in place of horizontalMedianBank
+    SlidingMedian::SortedWindow verticalMedianWindow;
     
     // Previous frame data for EMA smoothing
-    std::vector<float> previousSmoothedMask;
+    DspArena::Buffer<float> previousSmoothedMask;
 
     // Per-bin transient envelope follower state (drives the Transient stream).
-    std::vector<float> transientEnv;
+    DspArena::Buffer<float> transientEnv;
 
     // Recovers sustained low-frequency tones the median classifier misses at
     // low bins, and pulls them out of the Noise stream. Fed each frame in
     // updateGuides(); its override is applied in finalizeMasksFromSmoothed().
     LowFreqPartialTracker lowFreqTracker;
+    DspArena::Buffer<float> lowBandMagnitudes;   // setLowBand() copy (LowBandAnalyzer bins)
+    bool hasLowBand = false;                     // lowBandMagnitudes holds this frame's
+
+    /** The tracker's input for this frame: the low band if supplied, then consumed. */
+    juce::Span<const float> takeLowBand() noexcept;
+
+    /** Run the tracker on this frame (consuming its low band), unless tracking is off. */
+    void trackLowFrequencies(juce::Span<const float> magnitudes) noexcept;
+
+    /** Warm start: fill the history with this (first) frame and take it as the previous one. */
+    void seedHistory(juce::Span<const float> magnitudes) noexcept;
+
+    /** Write the out-of-band split outside the active band (nothing when it is the whole frame). */
+    void fillOutOfBand(juce::Span<float> tonalMask, juce::Span<float> transientMask,
+                       juce::Span<float> noiseMask) const noexcept;
+
+    /**
+     * Decimated frames: compute this frame's flux (updateStats() then reuses
+     * it) and decide whether the frame runs the full estimate: the interval
+     * is up, the flux shows an onset, or the settings changed.
+     */
+    bool isEstimateDue() noexcept;
+
+    // Stage timing target (see setProfileAccumulator); unused unless profiling.
+    DspProfiler::Accumulator* profile = nullptr;
 
     // Core HPSS algorithm methods
     
     /**
      * Compute horizontal median filter (9 time frames).
      * Enhances sustained tones and harmonic content.
+     * Reads the sliding per-bin windows advanced in updateGuides().
      */
     void computeHorizontalMedian() noexcept;
     
@@ -287,17 +533,78 @@ private:
                                     juce::Span<float> transientMask,
                                     juce::Span<float> noiseMask) noexcept;
 
-    // Utility methods
-    
+    /** Wiener-stage parameters for the current separation and focus. */
+    SpectralKernels::WienerParams getWienerParams() const noexcept;
+
     /**
-     * Efficient median computation using nth_element.
-     * Optimized for small arrays typical in median filtering.
-     * @param data Array to find median of (will be modified)
-     * @param size Size of array
-     * @return Median value
+     * Pipeline::Fused body of computeMasks() (externalTonalMask == nullptr:
+     * Wiener masks from the guides) and computeMasksWithTonal().
      */
-    float computeMedian(float* data, int size) noexcept;
-    
+    void computeMasksFused(const float* externalTonalMask,
+                           juce::Span<float> tonalMask,
+                           juce::Span<float> transientMask,
+                           juce::Span<float> noiseMask) noexcept;
+
+    // Per-bin stage arithmetic, shared by both pipelines so they agree bit
+    // for bit.
+
+    /** One-pole smoother step: attack when rising, release when falling. */
+    static float smoothBin(float current, float previous) noexcept
+    {
+        const float alpha = (current > previous) ? attackAlpha : releaseAlpha;
+        return alpha * current + (1.0f - alpha) * previous;
+    }
+
+    /** Cubic push toward 0 below floorLevel and toward 1 above ceilingLevel. */
+    static float floorBin(float mask, float floorLevel, float ceilingLevel) noexcept
+    {
+        if (mask < floorLevel)
+        {
+            const float t = mask / floorLevel;  // 0 to 1
+            return t * t * t * floorLevel;  // Cubic ease-out to 0
+        }
+        if (mask > ceilingLevel)
+        {
+            const float t = (mask - ceilingLevel) / (1.0f - ceilingLevel);  // 0 to 1
+            return ceilingLevel + (1.0f - ceilingLevel) * (1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t));  // Cubic ease-in to 1
+        }
+        return mask;
+    }
+
+    /** [0.25 0.5 0.25] blur of one bin (edges renormalised), mixed by blurMix. */
+    static float blurBin(float left, float centre, float right, bool hasLeft, bool hasRight, float blurMix) noexcept
+    {
+        float weightedSum = 0.0f;
+        float totalWeight = 0.0f;
+        if (hasLeft)  { weightedSum += left * 0.25f;  totalWeight += 0.25f; }
+        weightedSum += centre * 0.5f;
+        totalWeight += 0.5f;
+        if (hasRight) { weightedSum += right * 0.25f; totalWeight += 0.25f; }
+
+        const float blurred = weightedSum / totalWeight;
+        return blurMix * blurred + (1.0f - blurMix) * centre;
+    }
+
+    /** Transient follower step and mass-conserving 3-way split of one bin. */
+    void splitBin(int bin, float mask, float* tonalMask, float* transientMask, float* noiseMask) noexcept
+    {
+        const float flux = clamp01(spectralFlux[(size_t) bin]);
+        const float prev = transientEnv[(size_t) bin];
+        const float alpha = (flux > prev) ? transientAttack : transientRelease;
+        const float env = prev + (flux - prev) * alpha;
+        transientEnv[(size_t) bin] = env;
+
+        const float t  = clamp01(mask);
+        const float tr = clamp01(env);
+        const float nonTonal = 1.0f - t;
+
+        tonalMask[bin]     = t;
+        transientMask[bin] = nonTonal * tr;
+        noiseMask[bin]     = nonTonal * (1.0f - tr);
+    }
+
+    // Utility methods
+
     /**
      * Safe clamping to [0, 1] range with denormal protection.
      * @param value Input value
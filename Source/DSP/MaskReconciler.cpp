@@ -9,6 +9,10 @@ void MaskReconciler::prepare (int numBinsLong, int numBinsShort) noexcept
 
     startBin_.resize ((size_t) numBinsShort);
     endBin_.resize   ((size_t) numBinsShort);
+    lobeStart_.assign  ((size_t) numBinsShort, 0);
+    lobeEnd_.assign    ((size_t) numBinsShort, numBinsLong);
+    lobeOffset_.assign ((size_t) numBinsShort, 0);
+    lobeWeights_.assign ((size_t) numBinsLong, 1.0f);
 
     if (numBinsShort <= 1)
     {
@@ -37,6 +41,32 @@ void MaskReconciler::prepare (int numBinsLong, int numBinsShort) noexcept
         startBin_[(size_t) s] = start;
         endBin_[(size_t) s]   = end;
     }
+
+    // Hann main lobe: +-2 short bins. Power response of a periodic Hann at
+    // x bins off centre, |sinc(x) / (1 - x^2)|^2 (0.25 at x = +-1).
+    lobeWeights_.clear();
+    for (int s = 0; s < numBinsShort; ++s)
+    {
+        const double centre = s * ratio;
+        const int start = std::max (0, (int) std::ceil (centre - 2.0 * ratio));
+        const int end   = std::min (numBinsLong, (int) std::floor (centre + 2.0 * ratio) + 1);
+
+        lobeStart_[(size_t) s]  = start;
+        lobeEnd_[(size_t) s]    = end;
+        lobeOffset_[(size_t) s] = (int) lobeWeights_.size();
+        for (int b = start; b < end; ++b)
+        {
+            const double x = std::abs (b - centre) / ratio;
+            double response = 0.0;
+            if (x < 1e-9)
+                response = 1.0;
+            else if (std::abs (x - 1.0) < 1e-9)
+                response = 0.5;
+            else if (x < 2.0)
+                response = std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x) / (1.0 - x * x);
+            lobeWeights_.push_back ((float) (response * response));
+        }
+    }
 }
 
 void MaskReconciler::map (juce::Span<const float> longMask,
@@ -55,3 +85,35 @@ void MaskReconciler::map (juce::Span<const float> longMask,
         shortMaskOut[(size_t) s] = sum / (float) count;
     }
 }
+
+void MaskReconciler::mapWeighted (juce::Span<const float> longMask,
+                                  juce::Span<const float> weights,
+                                  juce::Span<float>       shortMaskOut) const noexcept
+{
+    for (int s = 0; s < numBinsShort_; ++s)
+    {
+        const int start = lobeStart_[(size_t) s];
+        const int end   = lobeEnd_[(size_t) s];
+        const float* lobe = lobeWeights_.data() + lobeOffset_[(size_t) s] - start;
+
+        float sum = 0.0f, weightSum = 0.0f;
+        for (int b = start; b < end; ++b)
+        {
+            const float w = weights[(size_t) b] * lobe[b];
+            sum       += longMask[(size_t) b] * w;
+            weightSum += w;
+        }
+
+        if (weightSum > 1e-20f)
+        {
+            shortMaskOut[(size_t) s] = sum / weightSum;
+        }
+        else
+        {
+            float plainSum = 0.0f;
+            for (int b = startBin_[(size_t) s]; b < endBin_[(size_t) s]; ++b)
+                plainSum += longMask[(size_t) b];
+            shortMaskOut[(size_t) s] = plainSum / (float) (endBin_[(size_t) s] - startBin_[(size_t) s]);
+        }
+    }
+}
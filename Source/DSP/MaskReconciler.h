@@ -14,9 +14,22 @@ public:
     void prepare (int numBinsLong, int numBinsShort) noexcept;
     void map (juce::Span<const float> longMask, juce::Span<float> shortMaskOut) const noexcept;
 
+    // Energy-weighted variant for resynthesising on the short grid: each
+    // short bin takes the long-grid mask weighted by `weights` (|X|^2 on the
+    // long grid) times the short Hann window's power response around that
+    // bin, i.e. the share of the energy the short bin actually picks up that
+    // the mask assigns. A tone then owns every short bin its main lobe
+    // reaches instead of being diluted by the empty long bins beside it.
+    // Masks that sum to 1 per long bin still sum to 1 per short bin. A band
+    // with no energy falls back to map().
+    void mapWeighted (juce::Span<const float> longMask, juce::Span<const float> weights,
+                      juce::Span<float> shortMaskOut) const noexcept;
+
 private:
     int numBinsLong_ = 0, numBinsShort_ = 0;
     std::vector<int> startBin_, endBin_;  // per short bin, the long-bin averaging window [start, end)
+    std::vector<int> lobeStart_, lobeEnd_, lobeOffset_;  // per short bin, the long bins under its Hann main lobe
+    std::vector<float> lobeWeights_;      // Hann power response for those bins (flat, indexed via lobeOffset_)
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MaskReconciler)
 };
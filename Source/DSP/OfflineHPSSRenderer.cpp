@@ -0,0 +1,386 @@
+#include "OfflineHPSSRenderer.h"
+#include "ChannelWorkerPool.h"
+#include "SpectralKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+    // Tasks per thread in a parallel stage: contiguous ranges, a few per
+    // thread so one slow range does not hold the whole stage up.
+    constexpr int kSlotsPerThread = 4;
+
+    // Bins gathered per pass of the horizontal median, so the strided reads
+    // across frames use whole cache lines.
+    constexpr int kBinsPerGroup = 16;
+
+    // Same zeroing threshold as MagPhaseFrame and HPSSProcessor::applyBinGains.
+    constexpr float kEpsilon = 1e-8f;
+}
+
+OfflineHPSSRenderer::OfflineHPSSRenderer() = default;
+
+OfflineHPSSRenderer::~OfflineHPSSRenderer() = default;
+
+//==============================================================================
+void OfflineHPSSRenderer::render(const float* const* inputs, float* const* outputs,
+                                 int numChannels, int numSamples, double sampleRate)
+{
+    jassert(inputs != nullptr && outputs != nullptr);
+    jassert(numChannels >= 1 && numSamples >= 0);
+    jassert(sampleRate > 0.0);
+    if (numChannels <= 0 || numSamples <= 0)
+        return;
+
+    // Masks are mass-conserving, so unity on all three streams is the input.
+    auto nearUnity = [](float v) noexcept { return std::abs(v - 1.0f) < kEpsilon; };
+    if (nearUnity(settings_.tonalGain) && nearUnity(settings_.noiseGain) && nearUnity(settings_.transientGain))
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (outputs[ch] != inputs[ch])
+                juce::FloatVectorOperations::copy(outputs[ch], inputs[ch], numSamples);
+        return;
+    }
+
+    juce::ScopedNoDenormals noDenormals;
+    allocate(numChannels, numSamples, sampleRate);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::copy(signal_.data() + (size_t) ch * (size_t) paddedLength_ + (size_t) padding_,
+                                          inputs[ch], numSamples);
+
+    // 1. Every frame of every channel, independently.
+    parallelFor(numChannels * numFrames_,
+                [this](Slot& slot, int begin, int end) noexcept { analyseFrames(slot, begin, end); });
+
+    if (numEstimators() == 1 && numChannels_ > 1)
+        parallelFor(numFrames_, [this](Slot&, int begin, int end) noexcept { linkMagnitudes(begin, end); });
+
+    // 2. Centred horizontal medians, in groups of bins.
+    const int groupsPerEstimator = (numBins_ + kBinsPerGroup - 1) / kBinsPerGroup;
+    parallelFor(numEstimators() * groupsPerEstimator,
+                [this](Slot& slot, int begin, int end) noexcept { computeHorizontalGuides(slot, begin, end); });
+
+    // 3. Masks and bin gains, frame by frame per estimator.
+    parallelFor(numEstimators(), [this](Slot&, int begin, int end) noexcept
+    {
+        for (int estimator = begin; estimator < end; ++estimator)
+            estimateMasks(estimator);
+    });
+
+    // 4. Resynthesis into the (now free) padded input buffer.
+    std::fill(signal_.begin(), signal_.end(), 0.0f);
+    const int numChunks = (numFrames_ + kFramesPerChunk - 1) / kFramesPerChunk;
+    for (int parity = 0; parity < 2; ++parity)
+    {
+        const int chunksPerChannel = (numChunks - parity + 1) / 2;
+        parallelFor(numChannels * chunksPerChannel, [this, parity](Slot& slot, int begin, int end) noexcept
+        {
+            synthesiseChunks(slot, parity, begin, end);
+        });
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* rendered = signal_.data() + (size_t) ch * (size_t) paddedLength_ + (size_t) padding_;
+        if (settings_.safetyLimiting)
+            for (int i = 0; i < numSamples; ++i)
+                outputs[ch][i] = HPSSProcessor::softLimit(rendered[i]);
+        else
+            juce::FloatVectorOperations::copy(outputs[ch], rendered, numSamples);
+    }
+}
+
+//==============================================================================
+template <typename Fn>
+void OfflineHPSSRenderer::parallelFor(int numItems, Fn&& fn)
+{
+    if (numItems <= 0)
+        return;
+
+    struct Batch
+    {
+        OfflineHPSSRenderer* self;
+        std::remove_reference_t<Fn>* fn;
+        int numItems;
+        int numTasks;
+    };
+    Batch batch { this, &fn, numItems, std::min(numItems, static_cast<int>(slots_.size())) };
+
+    auto task = [](void* context, int index) noexcept
+    {
+        auto& b = *static_cast<Batch*>(context);
+        const int begin = static_cast<int>((int64_t) b.numItems * index / b.numTasks);
+        const int end = static_cast<int>((int64_t) b.numItems * (index + 1) / b.numTasks);
+        (*b.fn)(b.self->slots_[(size_t) index], begin, end);
+    };
+
+    if (workerPool_ != nullptr)
+        workerPool_->run(batch.numTasks, task, &batch);
+    else
+        for (int i = 0; i < batch.numTasks; ++i)
+            task(&batch, i);
+}
+
+void OfflineHPSSRenderer::allocate(int numChannels, int numSamples, double sampleRate)
+{
+    config_ = (settings_.highQuality ? STFTProcessor::Config::highQuality()
+                                     : STFTProcessor::Config::lowLatency())
+                  .withOverlap(settings_.overlap).atSampleRate(sampleRate);
+    jassert(config_.isValid());
+    const int fftSize = config_.fftSize;
+    const int hopSize = config_.hopSize;
+
+    // Even chunks must never overlap each other (see the class comment).
+    jassert(kFramesPerChunk * hopSize >= fftSize - hopSize);
+
+    // Periodic Hann, unnormalised: the STFTProcessor analysis window. The
+    // synthesis window (COLA-normalised, see below) is STFTProcessor's too.
+    window_ = std::make_unique<juce::dsp::WindowingFunction<float>>(
+        fftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+
+    // fftSize - hopSize leading zeros put the first real sample where the
+    // overlap-add is already complete; the frames then run until the last
+    // sample is covered by every frame that overlaps it.
+    numChannels_ = numChannels;
+    numSamples_ = numSamples;
+    numBins_ = config_.getNumBins();
+    padding_ = fftSize - hopSize;
+    numFrames_ = (padding_ + numSamples - 1) / hopSize + 1;
+    paddedLength_ = (numFrames_ - 1) * hopSize + fftSize;
+
+    const size_t frameBins = static_cast<size_t>(numFrames_) * static_cast<size_t>(numBins_);
+    const int estimators = numEstimators();
+    signal_.assign(static_cast<size_t>(numChannels) * static_cast<size_t>(paddedLength_), 0.0f);
+    spectra_.assign(static_cast<size_t>(numChannels) * frameBins, {});
+    magnitudes_.assign(static_cast<size_t>(numChannels) * frameBins, 0.0f);
+    linkedMagnitudes_.assign((estimators == 1 && numChannels > 1) ? frameBins : 0, 0.0f);
+    guides_.assign(static_cast<size_t>(estimators) * frameBins, 0.0f);
+    masks_.assign(static_cast<size_t>(estimators) * 3 * static_cast<size_t>(numBins_), 0.0f);
+    silentFrames_.assign(static_cast<size_t>(estimators) * static_cast<size_t>(numFrames_), 0);
+
+    estimators_.resize(static_cast<size_t>(estimators));
+    for (auto& estimator : estimators_)
+    {
+        estimator = std::make_unique<MaskEstimator>();
+        estimator->prepare(numBins_, sampleRate);
+        estimator->setSeparation(settings_.separation);
+        estimator->setFocus(settings_.focus);
+        estimator->setSpectralFloor(settings_.spectralFloor);
+    }
+
+    lowBands_.resize(static_cast<size_t>(numChannels));
+    for (auto& lowBand : lowBands_)
+    {
+        lowBand = std::make_unique<LowBandAnalyzer>();
+        lowBand->prepare(sampleRate);
+    }
+    linkedLowBand_.assign(estimators == 1 && numChannels > 1 ? (size_t) lowBands_[0]->getNumBins() : 0, 0.0f);
+
+    const int numThreads = workerPool_ != nullptr ? workerPool_->getNumWorkers() + 1 : 1;
+    slots_.resize(static_cast<size_t>(numThreads == 1 ? 1 : numThreads * kSlotsPerThread));
+    for (auto& slot : slots_)
+    {
+        slot.fft = FFTBackend::create(static_cast<int>(std::log2(fftSize)));
+        slot.fftBuffer.assign(static_cast<size_t>(fftSize), 0.0f);
+        slot.bins.assign(static_cast<size_t>(numBins_), {});
+        slot.column.assign(static_cast<size_t>(kBinsPerGroup) * static_cast<size_t>(numFrames_), 0.0f);
+        slot.medians.assign(static_cast<size_t>(kBinsPerGroup) * static_cast<size_t>(numFrames_), 0.0f);
+        slot.window.prepare(MaskEstimator::getHorizontalMedianSize());
+    }
+
+    // Every slot's backend is the same kind, so one table serves them all.
+    synthesisWindow_.resize(static_cast<size_t>(fftSize));
+    STFTProcessor::computeSynthesisWindow(config_, synthesisWindow_.data());
+    juce::FloatVectorOperations::multiply(synthesisWindow_.data(), 1.0f / slots_[0].fft->getRoundTripGain(), fftSize);
+}
+
+//==============================================================================
+void OfflineHPSSRenderer::analyseFrames(Slot& slot, int begin, int end) noexcept
+{
+    const int fftSize = config_.fftSize;
+    const bool gated = settings_.silenceGateDb > SilenceGate::kDisabledDb;
+    float* buffer = slot.fftBuffer.data();
+
+    for (int item = begin; item < end; ++item)
+    {
+        const int ch = item / numFrames_;
+        const int frame = item % numFrames_;
+        const float* samples = signal_.data() + (size_t) ch * (size_t) paddedLength_
+                             + (size_t) frame * (size_t) config_.hopSize;
+
+        // Digital silence transforms to the zeros the rows already hold.
+        if (gated && std::all_of(samples, samples + fftSize, [](float x) { return x == 0.0f; }))
+            continue;
+
+        // Same transform as STFTProcessor::processForwardTransform().
+        std::copy(samples, samples + fftSize, buffer);
+        window_->multiplyWithWindowingTable(buffer, (size_t) fftSize);
+
+        auto* bins = spectra_.data() + rowOffset(ch, frame);
+        slot.fft->forward(buffer, bins);
+        SpectralKernels::computeMagnitudes(bins, magnitudes_.data() + rowOffset(ch, frame), numBins_, kEpsilon);
+    }
+}
+
+void OfflineHPSSRenderer::linkMagnitudes(int begin, int end) noexcept
+{
+    // Per-bin max across channels, as HPSSProcessor's Linked mode.
+    for (int frame = begin; frame < end; ++frame)
+    {
+        float* linked = linkedMagnitudes_.data() + rowOffset(0, frame);
+        juce::FloatVectorOperations::copy(linked, magnitudes_.data() + rowOffset(0, frame), numBins_);
+        for (int ch = 1; ch < numChannels_; ++ch)
+            juce::FloatVectorOperations::max(linked, linked, magnitudes_.data() + rowOffset(ch, frame), numBins_);
+    }
+}
+
+juce::Span<const float> OfflineHPSSRenderer::advanceLowBand(int estimatorIndex, int frame) noexcept
+{
+    // Each frame's newest hop, as HPSSProcessor feeds its lanes.
+    const int hopSize = config_.hopSize;
+    const size_t newest = (size_t) frame * (size_t) hopSize + (size_t) (config_.fftSize - hopSize);
+    auto advance = [&](int ch) noexcept
+    {
+        auto& lowBand = *lowBands_[(size_t) ch];
+        lowBand.push(signal_.data() + (size_t) ch * (size_t) paddedLength_ + newest, hopSize);
+        return lowBand.analyse();
+    };
+
+    if (linkedLowBand_.empty())
+        return advance(estimatorIndex);
+
+    const int bins = static_cast<int>(linkedLowBand_.size());
+    juce::FloatVectorOperations::copy(linkedLowBand_.data(), advance(0).data(), bins);
+    for (int ch = 1; ch < numChannels_; ++ch)
+        juce::FloatVectorOperations::max(linkedLowBand_.data(), linkedLowBand_.data(), advance(ch).data(), bins);
+    return { linkedLowBand_.data(), linkedLowBand_.size() };
+}
+
+const float* OfflineHPSSRenderer::estimatorMagnitudes(int estimator) const noexcept
+{
+    if (! linkedMagnitudes_.empty())
+        return linkedMagnitudes_.data();
+    return magnitudes_.data() + rowOffset(estimator, 0);
+}
+
+void OfflineHPSSRenderer::computeHorizontalGuides(Slot& slot, int begin, int end) noexcept
+{
+    const int groupsPerEstimator = (numBins_ + kBinsPerGroup - 1) / kBinsPerGroup;
+    const size_t frames = static_cast<size_t>(numFrames_);
+
+    for (int item = begin; item < end; ++item)
+    {
+        const int estimator = item / groupsPerEstimator;
+        const int firstBin = (item % groupsPerEstimator) * kBinsPerGroup;
+        const int groupBins = std::min(kBinsPerGroup, numBins_ - firstBin);
+        const float* magnitudes = estimatorMagnitudes(estimator) + firstBin;
+        float* guides = guides_.data() + rowOffset(estimator, 0) + firstBin;
+
+        // Transpose the group to one contiguous column per bin, filter each
+        // column, transpose back.
+        for (size_t frame = 0; frame < frames; ++frame)
+            for (int j = 0; j < groupBins; ++j)
+                slot.column[(size_t) j * frames + frame] = magnitudes[frame * (size_t) numBins_ + (size_t) j];
+
+        for (int j = 0; j < groupBins; ++j)
+            SlidingMedian::centredMedianFilter(slot.column.data() + (size_t) j * frames,
+                                               slot.medians.data() + (size_t) j * frames,
+                                               numFrames_, MaskEstimator::getHorizontalMedianSize(),
+                                               slot.window);
+
+        for (size_t frame = 0; frame < frames; ++frame)
+            for (int j = 0; j < groupBins; ++j)
+                guides[frame * (size_t) numBins_ + (size_t) j] = slot.medians[(size_t) j * frames + frame];
+    }
+}
+
+void OfflineHPSSRenderer::estimateMasks(int estimatorIndex) noexcept
+{
+    auto& estimator = *estimators_[(size_t) estimatorIndex];
+    const size_t bins = static_cast<size_t>(numBins_);
+    float* tonal = masks_.data() + (size_t) estimatorIndex * 3 * bins;
+    float* transient = tonal + bins;
+    float* noise = transient + bins;
+    const float* magnitudes = estimatorMagnitudes(estimatorIndex);
+    auto* silent = silentFrames_.data() + (size_t) estimatorIndex * (size_t) numFrames_;
+
+    // Consecutive frames, like the real-time engine's gate (the linked max
+    // is all zero only if every channel is).
+    SilenceGate gate;
+    gate.prepare(config_.fftSize);
+    gate.setThresholdDb(settings_.silenceGateDb);
+
+    for (int frame = 0; frame < numFrames_; ++frame)
+    {
+        const juce::Span<const float> frameMagnitudes(magnitudes + (size_t) frame * bins, bins);
+        float* guide = guides_.data() + rowOffset(estimatorIndex, frame);
+
+        // The low band sees every frame, held or not, like the real-time lanes.
+        const auto lowBand = advanceLowBand(estimatorIndex, frame);
+
+        // Held frames keep the previous masks (and so the previous gains).
+        const bool hold = gate.process(frameMagnitudes) == SilenceGate::Action::Hold;
+        silent[frame] = gate.isSilent() ? 1 : 0;
+        if (! hold)
+        {
+            estimator.setLowBand(lowBand);
+            estimator.updateGuides(frameMagnitudes, juce::Span<const float>(guide, bins));
+            estimator.updateStats(frameMagnitudes);
+            estimator.computeMasks(juce::Span<float>(tonal, bins),
+                                   juce::Span<float>(transient, bins),
+                                   juce::Span<float>(noise, bins));
+        }
+
+        // The guide row has been consumed; it now holds the frame's bin gains.
+        juce::FloatVectorOperations::multiply(guide, tonal, settings_.tonalGain, numBins_);
+        juce::FloatVectorOperations::addWithMultiply(guide, transient, settings_.transientGain, numBins_);
+        juce::FloatVectorOperations::addWithMultiply(guide, noise, settings_.noiseGain, numBins_);
+    }
+}
+
+void OfflineHPSSRenderer::synthesiseChunks(Slot& slot, int parity, int begin, int end) noexcept
+{
+    const int fftSize = config_.fftSize;
+    const int hopSize = config_.hopSize;
+    const int numChunks = (numFrames_ + kFramesPerChunk - 1) / kFramesPerChunk;
+    const int chunksPerChannel = (numChunks - parity + 1) / 2;
+    const bool linked = numEstimators() == 1;
+    float* buffer = slot.fftBuffer.data();
+    auto* gained = slot.bins.data();
+
+    for (int item = begin; item < end; ++item)
+    {
+        const int ch = item / chunksPerChannel;
+        const int chunk = 2 * (item % chunksPerChannel) + parity;
+        const int firstFrame = chunk * kFramesPerChunk;
+        const int lastFrame = std::min(numFrames_, firstFrame + kFramesPerChunk);
+        float* sum = signal_.data() + (size_t) ch * (size_t) paddedLength_;
+
+        for (int frame = firstFrame; frame < lastFrame; ++frame)
+        {
+            // Every gained bin of an all-zero frame is zeroed: nothing to add.
+            if (silentFrames_[(size_t) (linked ? 0 : ch) * (size_t) numFrames_ + (size_t) frame] != 0)
+                continue;
+
+            const float* gains = guides_.data() + rowOffset(linked ? 0 : ch, frame);
+            const float* magnitudes = magnitudes_.data() + rowOffset(ch, frame);
+            const auto* bins = spectra_.data() + rowOffset(ch, frame);
+
+            // Real gain on the complex bins, zeroing exactly the bins
+            // HPSSProcessor::applyBinGains() zeroes.
+            for (int bin = 0; bin < numBins_; ++bin)
+            {
+                const float gain = gains[bin];
+                const bool silent = magnitudes[bin] * gain < kEpsilon;
+                gained[bin] = silent ? std::complex<float>() : std::complex<float>(bins[bin].real() * gain,
+                                                                                   bins[bin].imag() * gain);
+            }
+
+            slot.fft->inverse(gained, buffer);
+            juce::FloatVectorOperations::multiply(buffer, synthesisWindow_.data(), fftSize);
+            juce::FloatVectorOperations::add(sum + (size_t) frame * (size_t) hopSize, buffer, fftSize);
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FFTBackend.h"
+#include "HPSSProcessor.h"
+#include "LowBandAnalyzer.h"
+#include "MaskEstimator.h"
+#include "SilenceGate.h"
+#include "SlidingMedian.h"
+#include "STFTProcessor.h"
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ChannelWorkerPool;
+
+/**
+ * OfflineHPSSRenderer - whole-file HPSS for bounces and batch processing
+ *
+ * The real-time engine (HPSSProcessor) is causal: it sees one hop at a time,
+ * its horizontal median looks only backwards (so tonal decisions lag an
+ * onset by about half the window), and its output is delayed by the STFT
+ * latency. When the whole file is available none of that is necessary, and
+ * throughput matters more than latency. This renderer:
+ *
+ *  1. analyses every STFT frame of the file up front, frames split across
+ *     the worker pool;
+ *  2. takes the horizontal (time) median centred on each frame, ±4 frames,
+ *     shrinking at the file edges — no look-behind lag;
+ *  3. runs MaskEstimator over the frames in order (its smoothers and the
+ *     low-frequency tracker are recursive), one estimator per channel in
+ *     parallel, or one shared estimator in Linked mode;
+ *  4. applies the masks, inverse-transforms and overlap-adds, frames split
+ *     across the pool again.
+ *
+ * Output is time-aligned with the input (no latency) and bit-identical
+ * whatever the number of worker threads: overlap-add is done in chunks of
+ * kFramesPerChunk frames, even chunks then odd chunks, so no two threads
+ * write the same sample and every sample sums its frames in order.
+ *
+ * Stream gains are static for the whole render (no gain smoothing); the
+ * spectral processing is otherwise the plugin's: same STFT configuration,
+ * MaskEstimator, complex-domain mask application and safety limiter. With
+ * all three gains at unity the input is copied through, like the real-time
+ * unity path.
+ *
+ * With Settings::silenceGateDb set, quiet frames hold their masks exactly as
+ * in HPSSProcessor::setSilenceGate(), and frames of digital silence skip the
+ * forward FFT, the estimator's work and the inverse FFT altogether, which is
+ * most of the render on sparse effects libraries.
+ *
+ * Not real-time safe: render() holds about four floats per bin per frame
+ * per channel, roughly eight times the file's own size at 75% overlap.
+ */
+class OfflineHPSSRenderer
+{
+public:
+    /** Render parameters; gains are linear, the rest as in HPSSProcessor. */
+    struct Settings
+    {
+        bool highQuality = true;        ///< 2048/512 (the plugin's mode) or 1024/256, at 48 kHz (scaled with the rate)
+        STFTProcessor::Overlap overlap = STFTProcessor::Overlap::ThreeQuarters;  ///< Hop = fftSize / 2, 4, 8
+        HPSSProcessor::ChannelLink channelLink = HPSSProcessor::ChannelLink::Independent;
+        float separation = 0.75f;       ///< 0-1
+        float focus = 0.0f;             ///< -1 to +1
+        float spectralFloor = 0.0f;     ///< 0-1
+        float tonalGain = 1.0f;
+        float noiseGain = 1.0f;
+        float transientGain = 1.0f;
+        bool safetyLimiting = true;
+        float silenceGateDb = SilenceGate::kDisabledDb;  ///< See HPSSProcessor::setSilenceGate()
+    };
+
+    OfflineHPSSRenderer();
+    ~OfflineHPSSRenderer();
+
+    /**
+     * Split the frame stages across a worker pool (nullptr = render on the
+     * calling thread). Not owned; must outlive render().
+     * @param pool Worker pool, or nullptr
+     */
+    void setWorkerPool(ChannelWorkerPool* pool) noexcept { workerPool_ = pool; }
+
+    void setSettings(const Settings& settings) noexcept { settings_ = settings; }
+    const Settings& getSettings() const noexcept { return settings_; }
+
+    /**
+     * Render a whole file. Allocates; call from a non-real-time thread.
+     * @param inputs      Per-channel input pointers (numChannels entries)
+     * @param outputs     Per-channel output pointers; may alias inputs
+     * @param numChannels Channel count (>= 1)
+     * @param numSamples  Samples per channel
+     * @param sampleRate  Sample rate of the material
+     */
+    void render(const float* const* inputs, float* const* outputs,
+                int numChannels, int numSamples, double sampleRate);
+
+    /** Frames per overlap-add chunk (see class comment). */
+    static constexpr int kFramesPerChunk = 64;
+
+private:
+    /** Per-slot scratch: one slot per concurrently running task. */
+    struct Slot
+    {
+        std::unique_ptr<FFTBackend> fft;            ///< Backends keep per-call workspace: one per slot
+        std::vector<float> fftBuffer;               ///< fftSize time-domain samples
+        std::vector<std::complex<float>> bins;      ///< numBins gained bins for the inverse
+        std::vector<float> column;                  ///< One bin across every frame
+        std::vector<float> medians;                 ///< Centred medians of column
+        SlidingMedian::SortedWindow window;         ///< Median window scratch
+    };
+
+    /** Run fn(slot, begin, end) over [0, numItems), split into contiguous slot ranges. */
+    template <typename Fn>
+    void parallelFor(int numItems, Fn&& fn);
+
+    void allocate(int numChannels, int numSamples, double sampleRate);
+
+    void analyseFrames(Slot& slot, int begin, int end) noexcept;
+    void linkMagnitudes(int begin, int end) noexcept;
+    void computeHorizontalGuides(Slot& slot, int begin, int end) noexcept;
+    void estimateMasks(int estimator) noexcept;
+    void synthesiseChunks(Slot& slot, int parity, int begin, int end) noexcept;
+
+    /** Magnitudes the estimator reads (its channel's, or the linked max). */
+    const float* estimatorMagnitudes(int estimator) const noexcept;
+
+    /** Feed frame's newest hop to the estimator's low band(s); its (linked: max) spectrum. */
+    juce::Span<const float> advanceLowBand(int estimatorIndex, int frame) noexcept;
+
+    int numEstimators() const noexcept
+    {
+        return settings_.channelLink == HPSSProcessor::ChannelLink::Linked ? 1 : numChannels_;
+    }
+
+    size_t rowOffset(int channel, int frame) const noexcept
+    {
+        return (static_cast<size_t>(channel) * static_cast<size_t>(numFrames_) + static_cast<size_t>(frame))
+             * static_cast<size_t>(numBins_);
+    }
+
+    Settings settings_;
+    ChannelWorkerPool* workerPool_ = nullptr;
+
+    // === Current render ===
+    STFTProcessor::Config config_;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window_;
+    std::vector<float> synthesisWindow_;        ///< STFTProcessor::computeSynthesisWindow() / FFT gain
+    int numChannels_ = 0;
+    int numSamples_ = 0;
+    int numBins_ = 0;
+    int numFrames_ = 0;
+    int padding_ = 0;                           ///< Leading zeros so the first sample is fully overlapped
+    int paddedLength_ = 0;
+
+    // Channel-major, frame-major blocks: channel c, frame f starts at rowOffset(c, f).
+    std::vector<float> signal_;                 ///< Padded input, reused as the overlap-add sum
+    std::vector<std::complex<float>> spectra_;  ///< Every frame's bins
+    std::vector<float> magnitudes_;             ///< |spectra_|
+    std::vector<float> linkedMagnitudes_;       ///< Linked: max |X| across channels (frames × bins)
+    std::vector<float> guides_;                 ///< Per estimator: horizontal guides, then bin gains
+    std::vector<float> masks_;                  ///< Per estimator: tonal, transient, noise (3 × bins)
+    std::vector<uint8_t> silentFrames_;         ///< Per estimator × frame: all zero, not resynthesised
+    std::vector<std::unique_ptr<MaskEstimator>> estimators_;
+    std::vector<std::unique_ptr<LowBandAnalyzer>> lowBands_;   ///< Per channel, fed frame by frame in estimateMasks()
+    std::vector<float> linkedLowBand_;          ///< Linked: max low-band |X| across channels
+    std::vector<Slot> slots_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineHPSSRenderer)
+};
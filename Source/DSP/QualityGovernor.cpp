@@ -0,0 +1,66 @@
+#include "QualityGovernor.h"
+#include <cmath>
+
+const char* QualityGovernor::getTierName(Tier tier) noexcept
+{
+    switch (tier)
+    {
+        case Tier::Full:                return "Full";
+        case Tier::NoLowFreqTracker:    return "No LF Tracker";
+        case Tier::ShortVerticalMedian: return "Short Median";
+        case Tier::DecimatedMasks:      return "Half-Rate Masks";
+        case Tier::LinkedAnalysis:      return "Linked";
+    }
+    return "";
+}
+
+void QualityGovernor::setLowestTier(Tier tier) noexcept
+{
+    lowestTier_ = tier;
+    if (static_cast<int>(tier_) > static_cast<int>(lowestTier_))
+        tier_ = lowestTier_;
+}
+
+void QualityGovernor::reset() noexcept
+{
+    tier_ = Tier::Full;
+    load_ = 0.0f;
+    hasLoad_ = false;
+    sinceChange_ = 0.0;
+    calm_ = 0.0;
+}
+
+QualityGovernor::Tier QualityGovernor::update(double elapsedSeconds, double blockSeconds) noexcept
+{
+    jassert(blockSeconds > 0.0);
+    if (blockSeconds <= 0.0)
+        return tier_;
+
+    // One-pole average with a time constant in seconds of audio, so a
+    // 32-sample host reacts as fast as a 2048-sample one.
+    const auto load = static_cast<float>(elapsedSeconds / blockSeconds);
+    const auto alpha = static_cast<float>(1.0 - std::exp(-blockSeconds / settings_.averageSeconds));
+    load_ = hasLoad_ ? load_ + (load - load_) * alpha : load;
+    hasLoad_ = true;
+
+    sinceChange_ += blockSeconds;
+    calm_ = (load_ < settings_.restoreBelow) ? calm_ + blockSeconds : 0.0;
+
+    const int tier = static_cast<int>(tier_);
+    if (load_ > settings_.degradeAbove && sinceChange_ >= settings_.averageSeconds
+        && tier < static_cast<int>(lowestTier_))
+    {
+        // The average still carries the old tier's cost: wait a full
+        // averaging time before judging whether this step was enough.
+        tier_ = static_cast<Tier>(tier + 1);
+        sinceChange_ = 0.0;
+        calm_ = 0.0;
+    }
+    else if (calm_ >= settings_.holdSeconds && tier > 0)
+    {
+        tier_ = static_cast<Tier>(tier - 1);
+        sinceChange_ = 0.0;
+        calm_ = 0.0;
+    }
+    return tier_;
+}
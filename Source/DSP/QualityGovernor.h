@@ -0,0 +1,101 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * QualityGovernor - picks a quality tier from the measured callback load
+ *
+ * The engine's cost per frame is fixed by its configuration, however close
+ * the host is to dropping out. The governor watches how long each callback
+ * took against the real time of the audio it produced and steps the engine
+ * down through cheaper tiers while the load stays high, and back up once
+ * it has stayed low for a while. It only decides: HPSSProcessor::
+ * setQualityTier() applies a tier, with everything every tier needs
+ * allocated in prepare(), so moving between them never allocates.
+ *
+ * Tiers are cumulative; each keeps the savings of the ones before it:
+ * - NoLowFreqTracker: the low-frequency partial tracker is skipped (low hums
+ *   fall back to the median classifier).
+ * - ShortVerticalMedian: the vertical median runs over 7 bins instead of 13.
+ * - DecimatedMasks: the full estimate runs every other frame, held in
+ *   between unless the flux shows an onset (MaskEstimator::setMaskDecimation).
+ * - LinkedAnalysis: one mask estimate for all channels (ChannelLink::Linked),
+ *   which only saves anything on multichannel buses.
+ *
+ * The load is averaged over averageSeconds of audio (time-based, so the
+ * host's buffer size does not change how fast it reacts). Above degradeAbove
+ * the governor steps down one tier, and again after another averageSeconds
+ * if that was not enough; below restoreBelow for holdSeconds it steps back
+ * up one. The gap between the two thresholds and the hold keep it from
+ * hunting between neighbouring tiers.
+ *
+ * RT-safety: everything is allocation-free; update() is called from the
+ * audio thread once per callback.
+ */
+class QualityGovernor
+{
+public:
+    enum class Tier
+    {
+        Full,                   ///< Everything on
+        NoLowFreqTracker,       ///< No low-frequency partial tracker
+        ShortVerticalMedian,    ///< And a 7-bin vertical median
+        DecimatedMasks,         ///< And masks estimated every other frame
+        LinkedAnalysis          ///< And one mask estimate for every channel
+    };
+
+    static constexpr int kNumTiers = 5;
+
+    /** Vertical median length (bins) from ShortVerticalMedian down. */
+    static constexpr int kShortVerticalMedianSize = 7;
+
+    /** Mask decimation interval (frames) from DecimatedMasks down. */
+    static constexpr int kMaskDecimationInterval = 2;
+
+    /** Short display name of a tier ("Full", ...). */
+    static const char* getTierName(Tier tier) noexcept;
+
+    /** Load thresholds, as a fraction of each callback's real time. */
+    struct Settings
+    {
+        float degradeAbove = 0.35f;     ///< Average load that steps a tier down
+        float restoreBelow = 0.15f;     ///< Average load that (held) steps a tier up
+        double averageSeconds = 0.25;   ///< Averaging time, and the wait between steps down
+        double holdSeconds = 2.0;       ///< Time below restoreBelow before stepping up
+    };
+
+    QualityGovernor() = default;
+
+    void setSettings(const Settings& settings) noexcept { settings_ = settings; }
+    const Settings& getSettings() const noexcept { return settings_; }
+
+    /** Lowest tier the governor may step down to (default LinkedAnalysis). */
+    void setLowestTier(Tier tier) noexcept;
+
+    /** Back to Full with no load history. */
+    void reset() noexcept;
+
+    /**
+     * Fold in one callback.
+     * @param elapsedSeconds Time the callback took
+     * @param blockSeconds   Real time of the audio it produced (> 0)
+     * @return The tier to run from the next callback on
+     */
+    Tier update(double elapsedSeconds, double blockSeconds) noexcept;
+
+    Tier getTier() const noexcept { return tier_; }
+
+    /** Averaged load (fraction of real time). */
+    float getLoad() const noexcept { return load_; }
+
+private:
+    Settings settings_;
+    Tier tier_ = Tier::Full;
+    Tier lowestTier_ = Tier::LinkedAnalysis;
+    float load_ = 0.0f;
+    bool hasLoad_ = false;
+    double sinceChange_ = 0.0;          ///< Seconds of audio since the last step
+    double calm_ = 0.0;                 ///< Seconds of audio spent below restoreBelow
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QualityGovernor)
+};
@@ -4,7 +4,7 @@
 #include <numeric>
 
 //==============================================================================
-STFTProcessor::STFTProcessor(const Config& config)
+STFTProcessor::STFTProcessor(const Config& config, FFTBackend::Kind fftKind)
     : config_(config)
 {
     jassert(config_.isValid());
@@ -13,20 +13,14 @@ STFTProcessor::STFTProcessor(const Config& config)
     const int fftOrder = static_cast<int>(std::log2(config_.fftSize));
     
     // Create FFT and windowing functions
-    fft_ = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fft_ = FFTBackend::create(fftOrder, fftKind);
     
     // CRITICAL: Use fftSize+1 trick for periodic windows (required for proper overlap-add)
     // and set normalize to false
     analysisWindow_ = std::make_unique<juce::dsp::WindowingFunction<float>>(
         config_.fftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
 
-    // Synthesis window is only needed for the inverse/overlap-add path.
-    if (! config_.analysisOnly)
-        synthesisWindow_ = std::make_unique<juce::dsp::WindowingFunction<float>>(
-            config_.fftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
-
-    // Calculate optimal window scaling for COLA reconstruction
-    calculateWindowScaling();
+    // The synthesis windows live in the arena (see prepare()).
 }
 
 STFTProcessor::~STFTProcessor() = default;
@@ -36,30 +30,36 @@ void STFTProcessor::prepare(double sampleRate, int maxBlockSize) noexcept
 {
     sampleRate_ = sampleRate;
     
-    // Calculate buffer sizes with safety margins
-    const int inputBufferSize = config_.fftSize * 4; // Large enough for circular buffering
-
-    // Resize input ring buffer (analysis path — always needed)
-    inputBuffer_.resize(inputBufferSize);
-
-    // Allocate analysis processing buffers (aligned for SIMD operations)
-    fftInputBuffer_.resize(config_.fftSize, 0.0f);
-    complexBuffer_.resize(config_.fftSize * 2, 0.0f); // Interleaved real/imag
-    currentFrame_.resize(config_.getNumBins());
-    magnitudeBuffer_.assign(config_.getNumBins(), 0.0f);
-
-    // Synthesis-only buffers: output ring buffer + IFFT time-domain output.
-    // Skipped entirely in analysis-only mode (no IFFT / overlap-add).
+    // Calculate buffer sizes with safety margins. A whole host block is
+    // written (input) or produced (output) before any of it is consumed, so
+    // blocks larger than the FFT need room on top of the usual margin.
+    const int inputBufferSize = config_.fftSize * 4 + maxBlockSize; // Large enough for circular buffering
+
+    // One arena block in frame order: input ring, analysis buffers, then the
+    // synthesis buffers and output ring. Synthesis-only buffers are skipped
+    // entirely in analysis-only mode (no IFFT / overlap-add).
+    arena_.clear();
+    inputBuffer_.layout(arena_, inputBufferSize);
+    arena_.add(fftInputBuffer_, (size_t) config_.fftSize);
+    arena_.add(currentFrame_, (size_t) config_.getNumBins());
+    arena_.add(magnitudeBuffer_, (size_t) config_.getNumBins());
     if (! config_.analysisOnly)
     {
-        const int outputBufferSize = config_.fftSize * 4; // Extra space for overlap-add
-        outputBuffer_.resize(outputBufferSize);
-        fftOutputBuffer_.resize(config_.fftSize, 0.0f);
+        const int outputBufferSize = config_.fftSize * 4 + maxBlockSize + outputDelay_; // Extra space for overlap-add
+        arena_.add(outputFrame_, (size_t) config_.getNumBins());
+        arena_.add(fftOutputBuffer_, (size_t) config_.fftSize);
+        arena_.add(synthesisWindow_, (size_t) config_.fftSize);
+        arena_.add(passThroughWindow_, (size_t) config_.fftSize);
+        for (int output = 0; output < config_.numOutputs; ++output)
+            outputBuffers_[(size_t) output].layout(arena_, outputBufferSize);
     }
+    arena_.allocate();                      // Zero-filled
+    if (! config_.analysisOnly)
+        computeSynthesisWindows();
     
     // Initialize state
     samplesInInputBuffer_ = 0;
-    samplesInOutputBuffer_ = 0; // Start with empty output buffer
+    samplesInOutputBuffer_ = 0; // clearOutput() queues the latency below
     frameReady_.store(false, std::memory_order_release);
     isInitialized_ = true;
     isFirstFrame_ = true;  // First frame needs fftSize samples
@@ -67,9 +67,7 @@ void STFTProcessor::prepare(double sampleRate, int maxBlockSize) noexcept
     // Clear all buffers to ensure clean start
     inputBuffer_.clear();
     if (! config_.analysisOnly)
-        outputBuffer_.clear();
-
-    juce::ignoreUnused(maxBlockSize); // Used for documentation only
+        clearOutput();
 }
 
 void STFTProcessor::reset() noexcept
@@ -81,21 +79,34 @@ void STFTProcessor::reset() noexcept
     inputBuffer_.clear();
 
     std::fill(fftInputBuffer_.begin(), fftInputBuffer_.end(), 0.0f);
-    std::fill(complexBuffer_.begin(), complexBuffer_.end(), 0.0f);
     std::fill(currentFrame_.begin(), currentFrame_.end(), std::complex<float>(0.0f, 0.0f));
     std::fill(magnitudeBuffer_.begin(), magnitudeBuffer_.end(), 0.0f);
 
-    if (! config_.analysisOnly)
-    {
-        outputBuffer_.clear();
-        std::fill(fftOutputBuffer_.begin(), fftOutputBuffer_.end(), 0.0f);
-    }
-    
     // Reset state
     samplesInInputBuffer_ = 0;
-    samplesInOutputBuffer_ = 0; // Start with empty output buffer
+    samplesInOutputBuffer_ = 0; // clearOutput() queues the latency below
     frameReady_.store(false, std::memory_order_release);
     isFirstFrame_ = true;  // Reset to first frame state
+
+    if (! config_.analysisOnly)
+    {
+        clearOutput();
+        std::fill(fftOutputBuffer_.begin(), fftOutputBuffer_.end(), 0.0f);
+    }
+}
+
+void STFTProcessor::clearOutput() noexcept
+{
+    // Queue the latency as silence ahead of the first frame. The first frame
+    // then lands exactly fftSize - hopSize samples after its input whatever
+    // the block size; with an empty queue, a block longer than that latency
+    // would play its first frames early (zero delay) and then jump.
+    for (int output = 0; output < config_.numOutputs; ++output)
+    {
+        outputBuffers_[(size_t) output].clear();
+        outputBuffers_[(size_t) output].advanceWritePosition(getLatencyInSamples());
+    }
+    samplesInOutputBuffer_ = getLatencyInSamples();
 }
 
 //==============================================================================
@@ -150,6 +161,15 @@ juce::Span<std::complex<float>> STFTProcessor::getCurrentFrame() noexcept
     return juce::Span<std::complex<float>>(currentFrame_.data(), currentFrame_.size());
 }
 
+juce::Span<const float> STFTProcessor::getCurrentFrameInput() const noexcept
+{
+    jassert(isInitialized_);
+
+    // The read position has already moved on by one hop.
+    const int start = inputBuffer_.getSize() - config_.hopSize;
+    return { inputBuffer_.view(start), (size_t) config_.fftSize };
+}
+
 void STFTProcessor::setCurrentFrame(juce::Span<const std::complex<float>> frame) noexcept
 {
     if (config_.analysisOnly) return;
@@ -166,91 +186,166 @@ void STFTProcessor::setCurrentFrame(juce::Span<const std::complex<float>> frame)
     frameReady_.store(false, std::memory_order_release);
 }
 
-void STFTProcessor::processOutput(float* outputSamples, int numSamples) noexcept
+void STFTProcessor::passCurrentFrameThrough() noexcept
+{
+    if (config_.analysisOnly)
+    {
+        frameReady_.store(false, std::memory_order_release);
+        return;
+    }
+    jassert(isInitialized_);
+    jassert(isFrameReady());
+    UNRAVEL_PROFILE_STAGE(profile_, InverseFFT);
+
+    // fftInputBuffer_ still holds this frame's windowed input: exactly what
+    // the inverse FFT of the untouched spectrum would return.
+    // No FFT round trip here, so the window without the backend's gain.
+    juce::FloatVectorOperations::copy(fftOutputBuffer_.data(), fftInputBuffer_.data(), config_.fftSize);
+    overlapAddOutputFrame(passThroughWindow_.data());
+
+    frameReady_.store(false, std::memory_order_release);
+}
+
+void STFTProcessor::skipCurrentFrame() noexcept
+{
+    if (! config_.analysisOnly)
+    {
+        jassert(isInitialized_);
+        jassert(isFrameReady());
+
+        // The ring is cleared as it is read, so the hop ahead already holds
+        // only the earlier frames' tails: adding zeros would change nothing.
+        advanceOutputs();
+    }
+
+    frameReady_.store(false, std::memory_order_release);
+}
+
+void STFTProcessor::synthesiseOutput(int output, juce::Span<const float> gains) noexcept
 {
     if (config_.analysisOnly) return;
     jassert(isInitialized_);
+    jassert(isFrameReady());
+    jassert(output >= 0 && output < config_.numOutputs);
+    jassert(gains.size() == static_cast<size_t>(config_.getNumBins()));
+
+    {
+        UNRAVEL_PROFILE_STAGE(profile_, GainApplication);
+        for (int bin = 0; bin < config_.getNumBins(); ++bin)
+            outputFrame_[(size_t) bin] = currentFrame_[(size_t) bin] * gains[(size_t) bin];
+    }
+
+    UNRAVEL_PROFILE_STAGE(profile_, InverseFFT);
+    fft_->inverse(outputFrame_.data(), fftOutputBuffer_.data());
+    juce::FloatVectorOperations::multiply(fftOutputBuffer_.data(), synthesisWindow_.data(), config_.fftSize);
+    outputBuffers_[(size_t) output].overlapAdd(fftOutputBuffer_.data(), config_.fftSize);
+}
+
+void STFTProcessor::finishCurrentFrame() noexcept
+{
+    // Every output has had its overlap-add at this frame's position; moving
+    // on is the same as for a skipped frame.
+    skipCurrentFrame();
+}
+
+void STFTProcessor::processOutput(float* outputSamples, int numSamples) noexcept
+{
     jassert(outputSamples != nullptr);
+
+    float* outputs[kMaxOutputs] = { outputSamples };   // The rest dropped
+    processOutputs(outputs, numSamples);
+}
+
+void STFTProcessor::processOutputs(float* const* outputs, int numSamples) noexcept
+{
+    if (config_.analysisOnly) return;
+    jassert(isInitialized_);
+    jassert(outputs != nullptr);
     jassert(numSamples >= 0);
     
     if (numSamples == 0)
         return;
     
-    // Extract samples from output buffer
+    // Extract samples from the output buffers (all at the same position)
     const int samplesToExtract = std::min(numSamples, samplesInOutputBuffer_);
     
-    if (samplesToExtract > 0)
+    for (int output = 0; output < config_.numOutputs; ++output)
     {
-        outputBuffer_.readAndClear(outputSamples, samplesToExtract);
-        outputBuffer_.advance(samplesToExtract);
-        samplesInOutputBuffer_ -= samplesToExtract;
-    }
+        auto& ring = outputBuffers_[(size_t) output];
+        float* outputSamples = outputs[output];
+        if (samplesToExtract > 0)
+        {
+            if (outputSamples != nullptr)
+                ring.readAndClear(outputSamples, samplesToExtract);
+            else
+                ring.discard(samplesToExtract);
+            ring.advance(samplesToExtract);
+        }
     
-    // Zero-fill remaining samples if needed
-    if (samplesToExtract < numSamples)
-    {
-        std::fill(outputSamples + samplesToExtract, 
-                 outputSamples + numSamples, 0.0f);
+        // Zero-fill remaining samples if needed
+        if (outputSamples != nullptr && samplesToExtract < numSamples)
+        {
+            std::fill(outputSamples + samplesToExtract, 
+                     outputSamples + numSamples, 0.0f);
+        }
     }
+    samplesInOutputBuffer_ -= samplesToExtract;
 }
 
 //==============================================================================
-void STFTProcessor::calculateWindowScaling() noexcept
+void STFTProcessor::computeSynthesisWindow(const Config& config, float* window) noexcept
 {
     // STFT Reconstruction Scaling
     //
-    // Perfect reconstruction requires compensating for two factors:
-    //
-    // Round-trip scaling: JUCE's performRealOnlyInverseTransform applies 1/N
-    // internally, so the FFT round-trip is unity. The Hann²(n) overlap-add at
-    // 75% overlap sums to 1.5; we divide by that with synthesisScale = 2/3.
-    // For 50% overlap the sum is 1.0; for other overlaps fall back to 2/overlap.
-    const float overlapFactor = static_cast<float>(config_.fftSize) / config_.hopSize;
-    analysisScale_ = 1.0f;
-    if (std::abs(overlapFactor - 4.0f) < 0.001f)        // 75% overlap
-        synthesisScale_ = 2.0f / 3.0f;
-    else if (std::abs(overlapFactor - 2.0f) < 0.001f)   // 50% overlap
-        synthesisScale_ = 1.0f;
-    else
-        synthesisScale_ = 2.0f / overlapFactor;
+    // Frames are windowed twice (Hann analysis, Hann synthesis), so the
+    // overlap-add reconstructs x·Σ_k w²(n + k·hop). That sum is periodic in
+    // the hop: tabulate it once, over every frame overlapping sample n, and
+    // divide the synthesis window by it. At 75% and 87.5% the table is flat
+    // (1.5 and 3.0); at 50% it is not, and a scalar can't fix that.
+    const int fftSize = config.fftSize;
+    const int hopSize = config.hopSize;
+
+    // The exact Hann values the analysis WindowingFunction applies.
+    juce::dsp::WindowingFunction<float> hann(fftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+    std::fill(window, window + fftSize, 1.0f);
+    hann.multiplyWithWindowingTable(window, (size_t) fftSize);
+
+    std::vector<double> overlapSum(static_cast<size_t>(hopSize), 0.0);
+    for (int n = 0; n < fftSize; ++n)
+        overlapSum[(size_t) (n % hopSize)] += (double) window[n] * (double) window[n];
+
+    // No overlap at all (hop == fftSize) leaves the frame edges at zero.
+    for (int n = 0; n < fftSize; ++n)
+    {
+        const double sum = overlapSum[(size_t) (n % hopSize)];
+        window[n] = sum > 1.0e-12 ? (float) ((double) window[n] / sum) : 0.0f;
+    }
+}
+
+void STFTProcessor::computeSynthesisWindows() noexcept
+{
+    // The pass-through overlap-adds the analysis-windowed input directly;
+    // the inverse path also divides out the FFT backend's round-trip gain
+    // (1 for JUCE, whose inverse applies 1/N; N for the unscaled ones), a
+    // power of two, so both tables hold the same window to the bit.
+    const int fftSize = config_.fftSize;
+    computeSynthesisWindow(config_, passThroughWindow_.data());
+    juce::FloatVectorOperations::multiply(synthesisWindow_.data(), passThroughWindow_.data(),
+                                          1.0f / fft_->getRoundTripGain(), fftSize);
 }
 
 void STFTProcessor::processForwardTransform() noexcept
 {
+    UNRAVEL_PROFILE_STAGE(profile_, ForwardFFT);
+
     // Read input frame from ring buffer
     inputBuffer_.read(fftInputBuffer_.data(), config_.fftSize);
 
     // Apply analysis window
     applyAnalysisWindow(fftInputBuffer_.data(), config_.fftSize);
 
-    // JUCE FFT expects: real samples in FIRST HALF of buffer (indices 0 to fftSize-1)
-    // Copy windowed samples directly to first half of complex buffer
-    for (int i = 0; i < config_.fftSize; ++i)
-    {
-        complexBuffer_[i] = fftInputBuffer_[i];
-    }
-    // Clear second half (used as working space by FFT)
-    for (int i = config_.fftSize; i < config_.fftSize * 2; ++i)
-    {
-        complexBuffer_[i] = 0.0f;
-    }
-
-    // Perform forward FFT
-    fft_->performRealOnlyForwardTransform(complexBuffer_.data());
-
-    // JUCE FFT outputs standard interleaved complex format:
-    // - [0,1] = bin 0 (DC) as [real, imag]
-    // - [2,3] = bin 1 as [real, imag]
-    // - [2*k, 2*k+1] = bin k as [real, imag]
-    // Only first (fftSize/2 + 1) bins are unique for real input
-    const int numBins = config_.getNumBins();  // fftSize/2 + 1
-
-    for (int i = 0; i < numBins; ++i)
-    {
-        const float real = complexBuffer_[i * 2];
-        const float imag = complexBuffer_[i * 2 + 1];
-        currentFrame_[i] = std::complex<float>(real, imag);
-    }
+    // Straight into the frame: the backend writes numBins complex bins.
+    fft_->forward(fftInputBuffer_.data(), currentFrame_.data());
 
     // Populate magnitude buffer for analysis-only consumers (no allocation;
     // magnitudeBuffer_ is pre-sized in prepare()).
@@ -268,33 +363,31 @@ juce::Span<const float> STFTProcessor::getCurrentMagnitudes() const noexcept
 void STFTProcessor::processInverseTransform() noexcept
 {
     if (config_.analysisOnly) return;
-    // Convert std::complex format back to standard interleaved format for JUCE FFT
-    const int numBins = config_.getNumBins();  // fftSize/2 + 1
-
-    for (int i = 0; i < numBins; ++i)
-    {
-        complexBuffer_[i * 2] = currentFrame_[i].real();
-        complexBuffer_[i * 2 + 1] = currentFrame_[i].imag();
-    }
+    UNRAVEL_PROFILE_STAGE(profile_, InverseFFT);
 
-    // Perform inverse FFT
-    // Output: real samples in FIRST HALF of complexBuffer_ (indices 0 to fftSize-1)
-    fft_->performRealOnlyInverseTransform(complexBuffer_.data());
+    // Straight from the frame into the output buffer (scaled by the
+    // backend's round-trip gain, divided out in synthesisWindow_).
+    fft_->inverse(currentFrame_.data(), fftOutputBuffer_.data());
 
-    // Extract real samples from first half of buffer
-    for (int i = 0; i < config_.fftSize; ++i)
-    {
-        fftOutputBuffer_[i] = complexBuffer_[i];
-    }
+    overlapAddOutputFrame(synthesisWindow_.data());
+}
 
-    // Apply synthesis window
-    applySynthesisWindow(fftOutputBuffer_.data(), config_.fftSize);
+void STFTProcessor::overlapAddOutputFrame(const float* window) noexcept
+{
+    // Apply synthesis window (COLA normalisation folded in)
+    juce::FloatVectorOperations::multiply(fftOutputBuffer_.data(), window, config_.fftSize);
 
     // Overlap-add to output buffer at current write position
-    outputBuffer_.overlapAdd(fftOutputBuffer_.data(), config_.fftSize);
+    outputBuffers_[0].overlapAdd(fftOutputBuffer_.data(), config_.fftSize);
 
     // Advance write position by hop size (new samples produced)
-    outputBuffer_.advanceWritePosition(config_.hopSize);
+    advanceOutputs();
+}
+
+void STFTProcessor::advanceOutputs() noexcept
+{
+    for (int output = 0; output < config_.numOutputs; ++output)
+        outputBuffers_[(size_t) output].advanceWritePosition(config_.hopSize);
     samplesInOutputBuffer_ += config_.hopSize;
 }
 
@@ -307,14 +400,3 @@ void STFTProcessor::applyAnalysisWindow(float* data, int size) noexcept
     
     // No additional scaling needed for analysis (JUCE handles it)
 }
-
-void STFTProcessor::applySynthesisWindow(float* data, int size) noexcept
-{
-    jassert(size == config_.fftSize);
-    
-    // Apply Hann window (using only first fftSize samples of fftSize+1 window)
-    synthesisWindow_->multiplyWithWindowingTable(data, size);
-    
-    // Apply COLA correction scaling for proper reconstruction
-    juce::FloatVectorOperations::multiply(data, synthesisScale_, size);
-}
\ No newline at end of file
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DspArena.h"
+#include "FFTBackend.h"
+#include "DspProfiler.h"
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <memory>
 #include <complex>
 #include <atomic>
+#include <cmath>
 
 /**
  * High-Performance STFT Processor for Real-Time Audio Processing
@@ -19,11 +25,11 @@
  * - Phase-coherent processing with proper COLA scaling
  * - Thread-safe design (no locks needed in audio thread)
  * - Efficient memory layout optimized for modern CPUs
- * - JUCE integration with juce::dsp::FFT and WindowingFunction
+ * - Pluggable FFT backend (FFTBackend) working in the frame buffers directly
  * 
  * Specifications:
  * - Default FFT Size: 2048 samples
- * - Default Hop Size: 512 samples (25% overlap, 75% hop)
+ * - Default Hop Size: 512 samples (75% overlap; 50% / 87.5% via Config::withOverlap)
  * - Window: Hann with proper COLA scaling
  * - Frequency bins: 1025 (for real FFT)
  * - Latency: fftSize - hopSize samples
@@ -31,6 +37,34 @@
 class STFTProcessor
 {
 public:
+    /**
+     * Frame overlap, as a fraction of fftSize: the hop is fftSize / 2, / 4
+     * or / 8. Fewer frames means proportionally less FFT and mask work per
+     * second; more overlap means a smoother overlap-add (less audible mask
+     * modulation) at the cost of more frames. Latency is fftSize - hop.
+     */
+    enum class Overlap
+    {
+        Half,           ///< 50%: hop fftSize/2, half the frames of ThreeQuarters
+        ThreeQuarters,  ///< 75%: hop fftSize/4 (the shipping default)
+        SevenEighths    ///< 87.5%: hop fftSize/8, twice the frames of ThreeQuarters
+    };
+
+    /** Hop divisor for an overlap (2, 4 or 8). */
+    static constexpr int getOverlapFactor(Overlap overlap) noexcept
+    {
+        return overlap == Overlap::Half ? 2 : overlap == Overlap::SevenEighths ? 8 : 4;
+    }
+
+    /** Most overlap-add outputs one processor resynthesises (Config::numOutputs). */
+    static constexpr int kMaxOutputs = 3;
+
+    /** Largest FFT a Config may use (was 8192; raised for long analysis FFT). */
+    static constexpr int kMaxFftSize = 16384;
+
+    /** Rate the Config presets are sized for (see Config::atSampleRate()). */
+    static constexpr double kReferenceSampleRate = 48000.0;
+
     /**
      * Configuration structure for STFT parameters.
      * Allows runtime configuration for different latency requirements.
@@ -40,6 +74,7 @@ public:
         int fftSize = 2048;     // FFT size (must be power of 2)
         int hopSize = 512;      // Hop size (recommended: fftSize/4)
         bool analysisOnly = false;  // Skip IFFT/synthesis buffers — forward analysis only.
+        int numOutputs = 1;         // Overlap-add outputs, 1 to kMaxOutputs (see synthesiseOutput()).
         
         // Alternative low-latency configuration
         static Config lowLatency() noexcept 
@@ -52,6 +87,45 @@ public:
         { 
             return {2048, 512}; // ~32ms latency at 48kHz
         }
+
+        // Short-hop resynthesis for HPSSProcessor's partitioned mode
+        static Config partitionedSynthesis() noexcept
+        {
+            return {256, 64}; // ~4ms latency at 48kHz
+        }
+
+        // Same FFT size, hop set by the overlap (analysisOnly kept)
+        Config withOverlap(Overlap overlap) const noexcept
+        {
+            Config config = *this;
+            config.hopSize = fftSize / getOverlapFactor(overlap);
+            return config;
+        }
+
+        /**
+         * Power of two the 48 kHz sizes scale by at a sample rate: the one
+         * nearest sampleRate / 48000 (1 at 44.1/48k, 2 at 88.2/96k, 4 at
+         * 176.4/192k), so the window and hop keep their length in ms and the
+         * bins their width in Hz.
+         */
+        static int getSampleRateScale(double sampleRate) noexcept
+        {
+            int scale = 1;
+            while (scale < kMaxFftSize && sampleRate / kReferenceSampleRate >= 1.5 * scale)
+                scale *= 2;
+            return scale;
+        }
+
+        // FFT and hop scaled for the sample rate (see getSampleRateScale()),
+        // the FFT capped at kMaxFftSize with the overlap kept
+        Config atSampleRate(double sampleRate) const noexcept
+        {
+            Config config = *this;
+            const int scale = std::min(getSampleRateScale(sampleRate), std::max(1, kMaxFftSize / fftSize));
+            config.fftSize = fftSize * scale;
+            config.hopSize = hopSize * scale;
+            return config;
+        }
         
         // Validate configuration
         bool isValid() const noexcept
@@ -60,18 +134,33 @@ public:
                    (fftSize & (fftSize - 1)) == 0 && // Power of 2
                    hopSize > 0 && 
                    hopSize <= fftSize &&
-                   fftSize <= 16384; // Reasonable upper limit (was 8192; raised for long analysis FFT)
+                   numOutputs >= 1 && numOutputs <= kMaxOutputs &&
+                   fftSize <= kMaxFftSize;
         }
         
         int getNumBins() const noexcept { return fftSize / 2 + 1; }
         int getLatencyInSamples() const noexcept { return fftSize - hopSize; }
     };
 
+    /**
+     * Synthesis window for a config: the Hann window divided by the
+     * steady-state overlap-add sum of Hann analysis × Hann synthesis at its
+     * hop (a table of hop values, computed in double). The overlap-add of
+     * analysis × this window is then exactly 1 at every sample, whatever the
+     * overlap: 2/3·Hann at 75% and 1/3·Hann at 87.5%, where the Hann² sum is
+     * constant, and a per-sample correction at 50%, where it ripples between
+     * 0.5 and 1. Multiply by 1/gain for an FFT backend that scales by gain.
+     * @param config STFT configuration
+     * @param window fftSize values out
+     */
+    static void computeSynthesisWindow(const Config& config, float* window) noexcept;
+
     /**
      * Constructor with configurable STFT parameters.
      * @param config STFT configuration (FFT size, hop size)
      */
-    explicit STFTProcessor(const Config& config = Config::highQuality());
+    explicit STFTProcessor(const Config& config = Config::highQuality(),
+                           FFTBackend::Kind fftKind = FFTBackend::Kind::Default);
     
     /**
      * Destructor - no cleanup needed due to RAII
@@ -115,6 +204,13 @@ public:
      */
     juce::Span<const float> getCurrentMagnitudes() const noexcept;
 
+    /**
+     * Get the current frame's input samples, unwindowed (size fftSize,
+     * oldest first). Only valid while isFrameReady() == true.
+     * @return Span of the frame's input samples
+     */
+    juce::Span<const float> getCurrentFrameInput() const noexcept;
+
     /**
      * Set the current frequency domain frame after processing.
      * Use this after modifying the frame obtained from getCurrentFrame().
@@ -124,15 +220,66 @@ public:
      */
     void setCurrentFrame(juce::Span<const std::complex<float>> frame) noexcept;
 
+    /**
+     * Finish the current frame unmodified without an inverse FFT.
+     * With every bin left as analysed, the inverse FFT would only return the
+     * analysis-windowed input, so this overlap-adds that directly (synthesis
+     * window and scale as usual). The output buffer stays exactly where
+     * setCurrentFrame() would have left it, to FFT rounding, so a caller can
+     * switch between the two frame by frame without a discontinuity.
+     * In analysisOnly mode this just releases the frame, so the next one
+     * can be produced.
+     */
+    void passCurrentFrameThrough() noexcept;
+
+    /**
+     * Finish the current frame as silence without an inverse FFT: the output
+     * advances by one hop and nothing is overlap-added, exactly what
+     * setCurrentFrame() of an all-zero frame would leave. For frames the
+     * caller knows resynthesise to zero (see SilenceGate::isSilent()).
+     * In analysisOnly mode this just releases the frame.
+     */
+    void skipCurrentFrame() noexcept;
+
+    /**
+     * Resynthesise the current frame with every bin scaled by a real gain
+     * into one of the outputs (Config::numOutputs): inverse FFT, synthesis
+     * window and overlap-add at the frame's position, the current frame
+     * itself left as analysed. Several outputs can each take their own
+     * gains of the same frame. Finish the frame with finishCurrentFrame()
+     * afterwards, which moves every output on by one hop; an output given
+     * nothing for the frame just gets silence for it.
+     * @param output 0 … numOutputs - 1
+     * @param gains  Per-bin gain (numBins)
+     */
+    void synthesiseOutput(int output, juce::Span<const float> gains) noexcept;
+
+    /**
+     * Finish the current frame after synthesiseOutput(): every output
+     * advances by one hop. Without any synthesiseOutput() call this is
+     * skipCurrentFrame().
+     */
+    void finishCurrentFrame() noexcept;
+
     /**
      * Process output samples from the overlap-add buffer.
      * Extracts reconstructed audio samples from the internal output buffer.
+     * With more than one output, this is output 0 and the others' samples
+     * are dropped (see processOutputs()).
      * 
      * @param outputSamples Pointer to output buffer
      * @param numSamples Number of output samples to extract
      */
     void processOutput(float* outputSamples, int numSamples) noexcept;
 
+    /**
+     * As processOutput(), for every output at once (they all advance
+     * together). A nullptr entry drops that output's samples.
+     * @param outputs    numOutputs output pointers
+     * @param numSamples Number of output samples to extract from each
+     */
+    void processOutputs(float* const* outputs, int numSamples) noexcept;
+
     /**
      * Reset all internal buffers and state.
      * Clears all buffers to zero and resets processing positions.
@@ -145,11 +292,48 @@ public:
      */
     bool isFrameReady() const noexcept { return frameReady_.load(std::memory_order_acquire); }
 
+    /**
+     * Input samples still to push before the next frame is produced (0 when
+     * one is ready or already buffered).
+     */
+    int getSamplesUntilNextFrame() const noexcept
+    {
+        // A frame is read once a whole window is buffered past the read position.
+        if (isFrameReady())
+            return 0;
+        return getSamplesUntilFollowingFrame();
+    }
+
+    /**
+     * As getSamplesUntilNextFrame(), but for a caller holding the ready frame
+     * across blocks: input samples still to push before the frame after it
+     * can be produced (0 once it is buffered).
+     */
+    int getSamplesUntilFollowingFrame() const noexcept
+    {
+        return std::max(0, config_.fftSize - inputBuffer_.getReadableDistance());
+    }
+
+    /**
+     * Extra output delay on top of fftSize - hopSize, for callers whose blocks
+     * are not whole hops: each frame's first hop is final only once the
+     * frame lands, and a block that reads it earlier would find it empty.
+     * A caller that finishes each frame up to one hop after it is produced
+     * (HPSSProcessor::setPipelining()) adds a whole hop on top.
+     * Takes effect at the next prepare() or reset().
+     * @param samples 0 to 2 × hopSize - 1 (hopSize - 1 covers any block size)
+     */
+    void setOutputDelay(int samples) noexcept
+    {
+        jassert(samples >= 0 && samples < 2 * config_.hopSize);
+        outputDelay_ = samples;
+    }
+
     /**
      * Get the processing latency in samples.
-     * @return Latency in samples (fftSize - hopSize)
+     * @return Latency in samples (fftSize - hopSize, plus the output delay)
      */
-    int getLatencyInSamples() const noexcept { return config_.getLatencyInSamples(); }
+    int getLatencyInSamples() const noexcept { return config_.getLatencyInSamples() + outputDelay_; }
 
     /**
      * Get the processing latency in milliseconds.
@@ -160,6 +344,9 @@ public:
         return (sampleRate_ > 0.0) ? (getLatencyInSamples() * 1000.0 / sampleRate_) : 0.0; 
     }
 
+    /** Overlap-add outputs resynthesised (Config::numOutputs). */
+    int getNumOutputs() const noexcept { return config_.numOutputs; }
+
     /**
      * Get the number of frequency bins.
      * @return Number of frequency bins (fftSize/2 + 1)
@@ -178,23 +365,35 @@ public:
      */
     int getHopSize() const noexcept { return config_.hopSize; }
 
+    /** The FFT backend in use (FFTBackend::Kind::Default resolved). */
+    const FFTBackend& getFFTBackend() const noexcept { return *fft_; }
+
+    /**
+     * Time the forward and inverse transforms into an accumulator
+     * (UNRAVEL_DSP_PROFILING builds; nullptr = untimed). Not owned.
+     * @param accumulator Accumulator written by the thread driving this processor
+     */
+    void setProfileAccumulator(DspProfiler::Accumulator* accumulator) noexcept { profile_ = accumulator; }
+
 private:
     // Configuration
     Config config_;
     double sampleRate_ = 48000.0;
     
     // FFT processing objects
-    std::unique_ptr<juce::dsp::FFT> fft_;
+    std::unique_ptr<FFTBackend> fft_;
     std::unique_ptr<juce::dsp::WindowingFunction<float>> analysisWindow_;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> synthesisWindow_;
+
+    // Stage timing target (see setProfileAccumulator)
+    DspProfiler::Accumulator* profile_ = nullptr;
     
     // Efficient ring buffer implementation
     class RingBuffer
     {
     public:
-        void resize(int size) 
+        void layout(DspArena& arena, int size)
         {
-            data_.resize(size * 2, 0.0f); // Double size to avoid modulo operations
+            arena.add(data_, static_cast<size_t>(size) * 2); // Double size to avoid modulo operations
             size_ = size;
             writePos_ = 0;
             readPos_ = 0;
@@ -229,6 +428,17 @@ private:
                 data_[pos + size_] = 0.0f; // Clear mirror too
             }
         }
+
+        void discard(int numSamples) noexcept
+        {
+            // Clear without reading: an output nobody listens to
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const int pos = (readPos_ + i) % size_;
+                data_[pos] = 0.0f;
+                data_[pos + size_] = 0.0f;
+            }
+        }
         
         void advance(int numSamples) noexcept
         {
@@ -261,6 +471,13 @@ private:
         
         int getSize() const noexcept { return size_; }
 
+        // Contiguous view from the read position + offset (the mirror keeps
+        // any run up to size_ in one piece)
+        const float* view(int offset) const noexcept
+        {
+            return data_.data() + (readPos_ + offset) % size_;
+        }
+
         // Get the number of readable samples (distance from read to write position)
         int getReadableDistance() const noexcept
         {
@@ -271,7 +488,7 @@ private:
         }
 
     private:
-        std::vector<float> data_;
+        DspArena::Buffer<float> data_;
         int size_ = 0;
         int writePos_ = 0;
         int readPos_ = 0;
@@ -279,35 +496,33 @@ private:
     
     // Ring buffers for input and output
     RingBuffer inputBuffer_;
-    RingBuffer outputBuffer_;
+    std::array<RingBuffer, kMaxOutputs> outputBuffers_;   // numOutputs used, advanced together
     
-    // Processing buffers (aligned for SIMD)
-    alignas(32) std::vector<float> fftInputBuffer_;      // Time domain input (windowed)
-    alignas(32) std::vector<float> fftOutputBuffer_;     // Time domain output (IFFT result)
-    alignas(32) std::vector<float> complexBuffer_;       // Complex FFT data (interleaved real/imag)
-    alignas(32) std::vector<std::complex<float>> currentFrame_; // Current frequency domain frame
-    alignas(32) std::vector<float> magnitudeBuffer_;   // |currentFrame_| for analysis-only consumers
+    // Processing buffers (64-byte aligned for SIMD). The rings above and these
+    // share one arena block, laid out in frame order by prepare().
+    DspArena arena_;
+    DspArena::Buffer<float> fftInputBuffer_;      // Time domain input (windowed)
+    DspArena::Buffer<float> fftOutputBuffer_;     // Time domain output (IFFT result)
+    DspArena::Buffer<std::complex<float>> currentFrame_; // Current frequency domain frame
+    DspArena::Buffer<std::complex<float>> outputFrame_;  // currentFrame_ × gains (synthesiseOutput)
+    DspArena::Buffer<float> magnitudeBuffer_;   // |currentFrame_| for analysis-only consumers
+    DspArena::Buffer<float> synthesisWindow_;   // computeSynthesisWindow() / FFT round-trip gain
+    DspArena::Buffer<float> passThroughWindow_; // computeSynthesisWindow() (no FFT in the path)
     
     // Processing state
     int samplesInInputBuffer_ = 0;
     int samplesInOutputBuffer_ = 0;
+    int outputDelay_ = 0;       // See setOutputDelay()
     std::atomic<bool> frameReady_{false};
     bool isInitialized_ = false;
     bool isFirstFrame_ = true;  // Tracks if we need fftSize samples for first frame
     
-    // Window scaling factors for perfect reconstruction (COLA)
-    float analysisScale_ = 1.0f;
-    float synthesisScale_ = 1.0f;
-    
     // Constants for numerical stability
     static constexpr float kEpsilon = 1e-8f;
     
-    /**
-     * Calculate optimal window scaling factors for COLA reconstruction.
-     * Uses the overlap factor to determine proper scaling.
-     */
-    void calculateWindowScaling() noexcept;
-    
+    /** Fill the synthesis window tables for this config and FFT backend. */
+    void computeSynthesisWindows() noexcept;
+
     /**
      * Process forward FFT: windowing → FFT → complex to frame
      * This method is called when enough input samples are available.
@@ -315,10 +530,19 @@ private:
     void processForwardTransform() noexcept;
     
     /**
-     * Process inverse FFT: frame to complex → IFFT → overlap-add
+     * Process inverse FFT: frame → IFFT → overlap-add
      * This method is called after frequency domain processing is complete.
      */
     void processInverseTransform() noexcept;
+
+    /** Synthesis window + overlap-add of fftOutputBuffer_, then advance by one hop. */
+    void overlapAddOutputFrame(const float* window) noexcept;
+
+    /** Move every output ring on by one hop (the frame's first hop is final). */
+    void advanceOutputs() noexcept;
+
+    /** Empty the output rings and queue the latency's worth of silence. */
+    void clearOutput() noexcept;
     
     /**
      * Apply analysis window with proper scaling.
@@ -327,12 +551,5 @@ private:
      */
     void applyAnalysisWindow(float* data, int size) noexcept;
     
-    /**
-     * Apply synthesis window with proper scaling.
-     * @param data Pointer to time domain data
-     * @param size Number of samples
-     */
-    void applySynthesisWindow(float* data, int size) noexcept;
-    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(STFTProcessor)
 };
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "SharedAnalysis.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    /** Spin-wait hint (as ChannelWorkerPool's). */
+    inline void cpuRelax() noexcept
+    {
+       #if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+       #elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+       #endif
+    }
+}
+
+bool SharedAnalysis::Layout::operator==(const Layout& other) const noexcept
+{
+    return sampleRate == other.sampleRate && fftSize == other.fftSize && hopSize == other.hopSize
+        && numChannels == other.numChannels && partitioned == other.partitioned
+        && historyFormat == other.historyFormat && warmStart == other.warmStart;
+}
+
+SharedAnalysis::SharedAnalysis(const Layout& layout)
+    : layout_(layout),
+      numBins_(layout.fftSize / 2 + 1)
+{
+    jassert(layout.sampleRate > 0.0 && layout.fftSize > 0 && layout.hopSize > 0 && layout.numChannels > 0);
+
+    slices_.reset(new Slice[(size_t) getNumSlices()]);
+    for (int s = 0; s < getNumSlices(); ++s)
+    {
+        auto& slice = slices_[(size_t) s];
+        slice.estimator = std::make_unique<MaskEstimator>();
+        slice.estimator->setHistoryFormat(layout.historyFormat);
+        slice.estimator->setWarmStart(layout.warmStart);
+        slice.estimator->prepare(numBins_, layout.sampleRate);
+        slice.slots.reset(new Slot[(size_t) kRingFrames]);
+        slice.masks.assign((size_t) kRingFrames * 3 * (size_t) numBins_, 0.0f);
+    }
+}
+
+SharedAnalysis::~SharedAnalysis() = default;
+
+SharedAnalysis::Outcome SharedAnalysis::estimate(int slice, FrameKey key, const Settings& settings,
+                                                 juce::Span<const float> magnitudes,
+                                                 juce::Span<const float> lowBand,
+                                                 juce::Span<float> tonal, juce::Span<float> transient,
+                                                 juce::Span<float> noise,
+                                                 DspProfiler::Accumulator* profile) noexcept
+{
+    jassert(slice >= 0 && slice < getNumSlices());
+    jassert(key.index > 0);
+    jassert(magnitudes.size() == (size_t) numBins_ && tonal.size() == (size_t) numBins_
+            && transient.size() == (size_t) numBins_ && noise.size() == (size_t) numBins_);
+
+    auto& s = slices_[(size_t) slice];
+    for (;;)
+    {
+        if (read(s, key, tonal, transient, noise))
+        {
+            shared_.fetch_add(1, std::memory_order_relaxed);
+            return Outcome::Shared;
+        }
+
+        if (isBehind(s, key))
+            break;
+
+        // Another member is estimating on this slice: wait for it, then look
+        // again (it may have been this very frame).
+        if (s.busy.exchange(true, std::memory_order_acquire))
+        {
+            while (s.busy.load(std::memory_order_relaxed))
+                cpuRelax();
+            continue;
+        }
+
+        // Published between the read and the claim, or overtaken.
+        if (read(s, key, tonal, transient, noise) || isBehind(s, key))
+        {
+            s.busy.store(false, std::memory_order_release);
+            continue;
+        }
+
+        // A new epoch restarts the history: frames before it are another
+        // stretch of the timeline.
+        if (key.epoch != s.epoch.load(std::memory_order_relaxed))
+        {
+            s.estimator->reset();
+            s.latest.store(0, std::memory_order_relaxed);
+            s.epoch.store(key.epoch, std::memory_order_release);
+        }
+
+        auto& estimator = *s.estimator;
+        estimator.setProfileAccumulator(profile);
+        estimator.setSeparation(settings.separation);
+        estimator.setFocus(settings.focus);
+        estimator.setSpectralFloor(settings.spectralFloor);
+        estimator.setOutOfBandSplit(settings.outOfBandNoise ? 0.0f : 1.0f, 0.0f, settings.outOfBandNoise ? 1.0f : 0.0f);
+        estimator.setActiveBand(settings.bandStart, settings.bandEnd > 0 ? settings.bandEnd : numBins_);
+        estimator.setLowBand(lowBand);
+        estimator.updateGuides(magnitudes);
+        estimator.updateStats(magnitudes);
+
+        const size_t slotIndex = static_cast<size_t>(key.index % kRingFrames);
+        auto& slot = s.slots[slotIndex];
+        float* masks = s.masks.data() + slotIndex * 3 * (size_t) numBins_;
+        const auto bins = (size_t) numBins_;
+
+        slot.sequence.fetch_add(1, std::memory_order_relaxed);  // -> odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        estimator.computeMasks(juce::Span<float>(masks, bins), juce::Span<float>(masks + bins, bins),
+                               juce::Span<float>(masks + 2 * bins, bins));
+        slot.epoch.store(key.epoch, std::memory_order_relaxed);
+        slot.index.store(key.index, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sequence.fetch_add(1, std::memory_order_release);  // -> even: stable
+
+        std::copy(masks, masks + bins, tonal.data());
+        std::copy(masks + bins, masks + 2 * bins, transient.data());
+        std::copy(masks + 2 * bins, masks + 3 * bins, noise.data());
+
+        s.latest.store(key.index, std::memory_order_release);
+        s.busy.store(false, std::memory_order_release);
+        computed_.fetch_add(1, std::memory_order_relaxed);
+        return Outcome::Computed;
+    }
+
+    missed_.fetch_add(1, std::memory_order_relaxed);
+    return Outcome::Missed;
+}
+
+bool SharedAnalysis::isBehind(const Slice& slice, FrameKey key) const noexcept
+{
+    // Same epoch: the history has moved past the frame (a gap ahead of it,
+    // where every member's gate held, is fine). Another epoch: only a member
+    // that has just resynced may restart the history, so one left behind on
+    // an old epoch cannot keep resetting it under the others.
+    if (key.epoch == slice.epoch.load(std::memory_order_acquire))
+        return key.index <= slice.latest.load(std::memory_order_acquire);
+    return key.index > kRingFrames;
+}
+
+bool SharedAnalysis::read(const Slice& slice, FrameKey key, juce::Span<float> tonal,
+                          juce::Span<float> transient, juce::Span<float> noise) const noexcept
+{
+    const size_t slotIndex = static_cast<size_t>(key.index % kRingFrames);
+    const auto& slot = slice.slots[slotIndex];
+    const uint32_t s1 = slot.sequence.load(std::memory_order_acquire);
+    if ((s1 & 1u) || slot.index.load(std::memory_order_relaxed) != key.index
+        || slot.epoch.load(std::memory_order_relaxed) != key.epoch)
+        return false;                                   // Being written, or another frame
+
+    const float* masks = slice.masks.data() + slotIndex * 3 * (size_t) numBins_;
+    const auto bins = (size_t) numBins_;
+    std::copy(masks, masks + bins, tonal.data());
+    std::copy(masks + bins, masks + 2 * bins, transient.data());
+    std::copy(masks + 2 * bins, masks + 3 * bins, noise.data());
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == s1;  // Else lapped mid-copy
+}
+
+SharedAnalysis::Stats SharedAnalysis::getStats() const noexcept
+{
+    Stats stats;
+    stats.computed = computed_.load(std::memory_order_relaxed);
+    stats.shared = shared_.load(std::memory_order_relaxed);
+    stats.missed = missed_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// =============================================================================
+// SharedAnalysisRegistry
+// =============================================================================
+
+std::shared_ptr<SharedAnalysis> SharedAnalysisRegistry::join(int groupId, const SharedAnalysis::Layout& layout)
+{
+    jassert(groupId >= 1);
+
+    static std::mutex mutex;
+    static std::map<int, std::weak_ptr<SharedAnalysis>> groups;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = groups[groupId];
+    if (auto group = entry.lock())
+        if (group->getLayout() == layout)
+            return group;
+
+    auto group = std::make_shared<SharedAnalysis>(layout);
+    entry = group;
+    return group;
+}
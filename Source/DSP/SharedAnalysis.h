@@ -0,0 +1,186 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspProfiler.h"
+#include "MaskEstimator.h"
+#include "SlidingMedian.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * SharedAnalysis - one mask estimate for several engines on the same source
+ *
+ * A stem-split session runs one engine per stem on parallel sends of the
+ * same track: one solos the tonal stream, one the transient, one the
+ * noise. Each would run the same median guides and masks on the same
+ * frames. Engines given the same SharedAnalysis (HPSSProcessor::
+ * setSharedAnalysis()) estimate each frame once between them: whichever
+ * reaches a frame first runs this object's estimator on its magnitudes and
+ * publishes the masks, and the others copy them. Every engine keeps its
+ * own STFT, silence gate, gains and resynthesis, so each still processes
+ * its own input; all of them apply the same masks to the same frame, so
+ * the stems sum to the source.
+ *
+ * Frames are matched by FrameKey: a timeline epoch the engines agree on
+ * (HPSSProcessor::resyncSharedAnalysis()) and the frame's index since it.
+ * A frame is published into a ring of kRingFrames per slice (one slice per
+ * channel, plus one for linked masks), read under a per-slot seqlock like
+ * SpectrumHistoryRing's. An engine that asks for a frame the ring no longer
+ * holds, or for an older epoch, gets Outcome::Missed and estimates the frame
+ * itself. An engine that finds another one estimating the same slice spins
+ * until it finishes, as ChannelWorkerPool waits for a task a worker has
+ * started: the estimate never blocks, so the wait is one estimate at most.
+ *
+ * The estimator runs with the Separation / Focus / Floor of the engine that
+ * computes the frame, so the members of a group should share them.
+ *
+ * RT-safety: construction allocates; estimate() is allocation- and
+ * lock-free (bar the bounded spin above). Any number of threads.
+ */
+class SharedAnalysis
+{
+public:
+    /** What the members of a group must agree on. */
+    struct Layout
+    {
+        double sampleRate = 0.0;
+        int fftSize = 0;
+        int hopSize = 0;
+        int numChannels = 0;
+        bool partitioned = false;   ///< Partitioned engines align their analysis frames differently
+        SlidingMedian::HistoryFormat historyFormat = SlidingMedian::HistoryFormat::Float32;
+        bool warmStart = false;     ///< Slice estimators warm-start (MaskEstimator::setWarmStart) at each epoch
+
+        bool operator==(const Layout& other) const noexcept;
+        bool operator!=(const Layout& other) const noexcept { return ! (*this == other); }
+    };
+
+    /** Estimator settings of the engine asking for a frame. */
+    struct Settings
+    {
+        float separation = 0.75f;
+        float focus = 0.0f;
+        float spectralFloor = 0.0f;
+        int bandStart = 0;              ///< MaskEstimator::setActiveBand() (bandEnd 0: the whole frame)
+        int bandEnd = 0;
+        bool outOfBandNoise = false;    ///< Out-of-band masks all noise, else all tonal
+    };
+
+    /** A frame: the epoch it belongs to and its index since (from 1). */
+    struct FrameKey
+    {
+        int64_t epoch = 0;
+        int64_t index = 0;
+    };
+
+    enum class Outcome
+    {
+        Computed,   ///< This call estimated the frame and published it
+        Shared,     ///< Another member had: its masks were copied
+        Missed      ///< Not available to share: estimate it locally
+    };
+
+    /** Frames each slice keeps published, about 0.35 s at 2048/512, 48 kHz. */
+    static constexpr int kRingFrames = 32;
+
+    /** Build the estimators and rings for a layout (allocates). */
+    explicit SharedAnalysis(const Layout& layout);
+    ~SharedAnalysis();
+
+    const Layout& getLayout() const noexcept { return layout_; }
+    int getNumBins() const noexcept { return numBins_; }
+
+    /** Slices: one per channel, then the linked slice. */
+    int getNumSlices() const noexcept { return layout_.numChannels + 1; }
+    int getLinkedSlice() const noexcept { return layout_.numChannels; }
+
+    /**
+     * The masks of one frame of a slice: copied if another member has
+     * published it, otherwise estimated from these magnitudes and published.
+     * @param slice      0 … numChannels - 1, or getLinkedSlice()
+     * @param key        The frame
+     * @param settings   Estimator settings, for a frame this call computes
+     * @param magnitudes The caller's magnitudes (numBins)
+     * @param lowBand    The caller's low-band magnitudes
+     * @param tonal, transient, noise  Output masks (numBins each)
+     * @param profile    Stage ticks of the calling lane, or nullptr
+     * @return How the masks were obtained; on Missed the outputs are
+     *         unspecified (the caller estimates the frame into them)
+     */
+    Outcome estimate(int slice, FrameKey key, const Settings& settings,
+                     juce::Span<const float> magnitudes, juce::Span<const float> lowBand,
+                     juce::Span<float> tonal, juce::Span<float> transient, juce::Span<float> noise,
+                     DspProfiler::Accumulator* profile = nullptr) noexcept;
+
+    /** Frames estimated, copied and missed so far, all slices. */
+    struct Stats
+    {
+        uint64_t computed = 0;
+        uint64_t shared = 0;
+        uint64_t missed = 0;
+    };
+    Stats getStats() const noexcept;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence { 0 };   ///< Odd while being written
+        // Keys: atomic (relaxed, inside the sequence bracket) since other
+        // members' audio threads read them while this one writes.
+        std::atomic<int64_t> epoch { 0 };
+        std::atomic<int64_t> index { 0 };       ///< 0 = never written
+    };
+
+    struct Slice
+    {
+        std::unique_ptr<MaskEstimator> estimator;
+        std::unique_ptr<Slot[]> slots;          ///< kRingFrames
+        std::vector<float> masks;               ///< kRingFrames × [tonal | transient | noise]
+        std::atomic<bool> busy { false };       ///< A member is estimating on this slice
+        std::atomic<int64_t> epoch { 0 };       ///< Epoch of the estimator's history
+        std::atomic<int64_t> latest { 0 };      ///< Newest index estimated in it (0 = none)
+    };
+
+    /** Copy a published frame out; false if the slot holds another frame or was torn. */
+    bool read(const Slice& slice, FrameKey key, juce::Span<float> tonal,
+              juce::Span<float> transient, juce::Span<float> noise) const noexcept;
+
+    /** True if the frame can no longer be estimated here (only read, if still held). */
+    bool isBehind(const Slice& slice, FrameKey key) const noexcept;
+
+    Layout layout_;
+    int numBins_ = 0;
+    std::unique_ptr<Slice[]> slices_;
+
+    std::atomic<uint64_t> computed_ { 0 };
+    std::atomic<uint64_t> shared_ { 0 };
+    std::atomic<uint64_t> missed_ { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedAnalysis)
+};
+
+/**
+ * SharedAnalysisRegistry - process-wide SharedAnalysis groups by ID
+ *
+ * Plugin instances find each other here: every instance that joins group
+ * N with the same Layout gets the same SharedAnalysis. A group lives while
+ * any member holds it. Joining with another layout (a sample-rate change
+ * reaches the members one prepareToPlay() at a time) starts a new group
+ * under the ID; members still on the old layout keep the old one until
+ * they join again. Instances in other processes (sandboxed hosts) never
+ * meet, and simply run their own analysis.
+ *
+ * join() locks and allocates: call it from prepareToPlay(), and drop the
+ * pointer there (or in releaseResources()), never on the audio thread.
+ */
+class SharedAnalysisRegistry
+{
+public:
+    /** Join group groupId (>= 1) at a layout, creating the group if needed. */
+    static std::shared_ptr<SharedAnalysis> join(int groupId, const SharedAnalysis::Layout& layout);
+
+private:
+    SharedAnalysisRegistry() = delete;
+};
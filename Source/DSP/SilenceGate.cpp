@@ -0,0 +1,54 @@
+#include "SilenceGate.h"
+#include <algorithm>
+
+void SilenceGate::prepare(int fftSize) noexcept
+{
+    jassert(fftSize > 0);
+
+    // A full-scale sine on a bin centre through the periodic Hann window
+    // (sum fftSize / 2) peaks at half the window sum.
+    referenceMagnitude_ = 0.25f * static_cast<float>(fftSize);
+    setThresholdDb(thresholdDb_);
+    reset();
+}
+
+void SilenceGate::reset() noexcept
+{
+    quietFrames_ = 0;
+    silent_ = false;
+}
+
+void SilenceGate::setThresholdDb(float thresholdDb) noexcept
+{
+    thresholdDb_ = std::max(thresholdDb, kDisabledDb);
+    thresholdMagnitude_ = referenceMagnitude_ * juce::Decibels::decibelsToGain(thresholdDb_, kDisabledDb);
+}
+
+SilenceGate::Action SilenceGate::process(juce::Span<const float> magnitudes) noexcept
+{
+    if (! isEnabled())
+    {
+        silent_ = false;
+        return Action::Estimate;
+    }
+
+    const float peak = juce::FloatVectorOperations::findMaximum(magnitudes.data(), (int) magnitudes.size());
+    const bool wasSilent = silent_;
+    silent_ = peak <= 0.0f;
+
+    if (peak >= thresholdMagnitude_)
+    {
+        quietFrames_ = 0;
+        return Action::Estimate;
+    }
+
+    // Room tone settling into digital silence (or back) is a new quiet
+    // stretch: the estimator has to settle on it again before holding.
+    if (silent_ != wasSilent)
+        quietFrames_ = 0;
+
+    // Counting past the warm-up would only risk wrapping on hours of silence.
+    if (quietFrames_ <= getWarmupFrames())
+        ++quietFrames_;
+    return quietFrames_ > getWarmupFrames() ? Action::Hold : Action::Estimate;
+}
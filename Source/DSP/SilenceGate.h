@@ -0,0 +1,94 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MaskEstimator.h"
+
+/**
+ * SilenceGate - per-frame energy gate in front of mask estimation
+ *
+ * Library material is full of room-tone tails and digital silence, and the
+ * medians, statistics and mask chain cost the same on a frame of silence as
+ * on a full mix. The gate looks at each frame's magnitudes straight after the
+ * forward FFT and tells the caller how much of the frame's work it can skip:
+ *
+ * - Estimate: run the estimator as usual.
+ * - Hold: the frame's loudest bin is below the threshold and the estimator
+ *   has already seen getWarmupFrames() such frames in a row. By then its
+ *   median window holds only quiet frames and its smoothers have settled
+ *   on them (MaskEstimator::getSettlingFrames()), so more of them would
+ *   change next to nothing: skip it and keep the previous masks (and every
+ *   piece of estimator state) until the signal returns. The first loud frame
+ *   then meets the state any long quiet stretch would have left, so the
+ *   masks do not jump. Quiet stretches shorter than the warm-up (about
+ *   0.6 s at 2048/512, 48 kHz) save nothing, and room tone fading into
+ *   digital silence (or back) starts a new warm-up, since the smoothers
+ *   settle on zeros differently from on a noise floor.
+ *
+ * Independently of that, isSilent() reports a frame whose magnitudes are all
+ * zero (digital silence, after MagPhaseFrame's zeroing threshold). Every
+ * gained bin of such a frame is zeroed anyway, so the caller can skip the
+ * gain stage and the inverse FFT and overlap-add nothing
+ * (STFTProcessor::skipCurrentFrame()); the output is unchanged.
+ *
+ * The threshold is the loudest bin's level in dB relative to a full-scale
+ * sine through the Hann analysis window (peak bin fftSize / 4), so a quiet
+ * tone keeps the gate open where a frame-energy measure would average it
+ * into room tone. A disabled gate (the default) estimates every frame and
+ * scans nothing.
+ *
+ * RT-safety: everything but prepare() is allocation-free (prepare() is too;
+ * it only derives the reference level).
+ */
+class SilenceGate
+{
+public:
+    enum class Action
+    {
+        Estimate,   ///< Run mask estimation for this frame
+        Hold        ///< Keep the previous masks; the estimator is left untouched
+    };
+
+    /** Thresholds at or below this disable the gate. */
+    static constexpr float kDisabledDb = -200.0f;
+
+    /** Threshold the plugin and unravel_render use by default. */
+    static constexpr float kDefaultThresholdDb = -100.0f;
+
+    /** Quiet frames the estimator still sees before the gate holds. */
+    static constexpr int getWarmupFrames() noexcept { return MaskEstimator::getSettlingFrames(); }
+
+    /** Set the analysis FFT size, which fixes the full-scale reference. */
+    void prepare(int fftSize) noexcept;
+
+    /** Forget the quiet run (call with the estimator's own reset()). */
+    void reset() noexcept;
+
+    /**
+     * Set the threshold, in dB re a full-scale sine's peak bin.
+     * RT-safe; takes effect on the next frame. kDisabledDb (or lower) disables.
+     */
+    void setThresholdDb(float thresholdDb) noexcept;
+
+    float getThresholdDb() const noexcept { return thresholdDb_; }
+    bool isEnabled() const noexcept { return thresholdDb_ > kDisabledDb; }
+
+    /**
+     * Classify one frame and advance the quiet-run count.
+     * @param magnitudes The frame's magnitudes (as the estimator would see them)
+     * @return What the caller should do with the frame
+     */
+    Action process(juce::Span<const float> magnitudes) noexcept;
+
+    /** Whether the last processed frame was all zero (always false when disabled). */
+    bool isSilent() const noexcept { return silent_; }
+
+    /** Consecutive below-threshold frames up to the last one (counts stop at getWarmupFrames() + 1). */
+    int getQuietFrames() const noexcept { return quietFrames_; }
+
+private:
+    float thresholdDb_ = kDisabledDb;
+    float referenceMagnitude_ = 0.0f;   ///< Peak bin of a full-scale sine
+    float thresholdMagnitude_ = 0.0f;   ///< referenceMagnitude_ × 10^(thresholdDb / 20)
+    int quietFrames_ = 0;
+    bool silent_ = false;
+};
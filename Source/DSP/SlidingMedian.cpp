@@ -0,0 +1,208 @@
+#include "SlidingMedian.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SlidingMedian
+{
+
+void toKeys(const float* magnitudes, Key* keys, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        keys[i] = toKey(magnitudes[i]);
+}
+
+float selectMedian(float* data, int size) noexcept
+{
+    if (size <= 0)
+        return 0.0f;
+
+    if (size == 1)
+        return data[0];
+
+    const int medianIndex = size / 2;
+    std::nth_element(data, data + medianIndex, data + size);
+
+    if (size % 2 == 1)
+        return data[medianIndex];
+
+    // Even size: average of the two middle elements. After the first
+    // nth_element everything below medianIndex is <= data[medianIndex], so the
+    // lower middle is simply the maximum of that half.
+    const float upper = data[medianIndex];
+    const float lower = *std::max_element(data, data + medianIndex);
+    return (upper + lower) * 0.5f;
+}
+
+float selectUpperMedian(float* data, int size) noexcept
+{
+    if (size <= 0)
+        return 0.0f;
+
+    const int medianIndex = size / 2;
+    std::nth_element(data, data + medianIndex, data + size);
+    return data[medianIndex];
+}
+
+//==============================================================================
+void SortedWindow::prepare(int capacity)
+{
+    jassert(capacity > 0);
+    values_.assign(static_cast<size_t>(capacity), 0.0f);
+    size_ = 0;
+}
+
+void SortedWindow::insert(float value) noexcept
+{
+    jassert(size_ < capacity());
+    float* begin = values_.data();
+    float* pos = std::upper_bound(begin, begin + size_, value);
+    std::memmove(pos + 1, pos, static_cast<size_t>(begin + size_ - pos) * sizeof(float));
+    *pos = value;
+    ++size_;
+}
+
+void SortedWindow::erase(float value) noexcept
+{
+    float* begin = values_.data();
+    float* pos = std::lower_bound(begin, begin + size_, value);
+    jassert(pos != begin + size_ && *pos == value);
+    if (pos == begin + size_)
+        return;
+    std::memmove(pos, pos + 1, static_cast<size_t>(begin + size_ - pos - 1) * sizeof(float));
+    --size_;
+}
+
+void SortedWindow::replace(float oldValue, float newValue) noexcept
+{
+    erase(oldValue);
+    insert(newValue);
+}
+
+//==============================================================================
+namespace
+{
+    // Replace oldValue with newValue in a full sorted run of length n using a
+    // single directional shift (no separate erase + insert pass).
+    template <typename Value>
+    inline void replaceSorted(Value* s, int n, Value oldValue, Value newValue) noexcept
+    {
+        int pos = static_cast<int>(std::lower_bound(s, s + n, oldValue) - s);
+        jassert(pos < n && s[pos] == oldValue);
+        if (pos >= n)
+            return;
+
+        if (newValue > oldValue)
+        {
+            while (pos + 1 < n && s[pos + 1] < newValue)
+            {
+                s[pos] = s[pos + 1];
+                ++pos;
+            }
+        }
+        else
+        {
+            while (pos > 0 && s[pos - 1] > newValue)
+            {
+                s[pos] = s[pos - 1];
+                --pos;
+            }
+        }
+        s[pos] = newValue;
+    }
+
+    template <typename Value>
+    inline void insertSorted(Value* s, int n, Value value) noexcept
+    {
+        int pos = n;
+        while (pos > 0 && s[pos - 1] > value)
+        {
+            s[pos] = s[pos - 1];
+            --pos;
+        }
+        s[pos] = value;
+    }
+
+    // Keys: the same rule as medianOfSorted(), on the magnitudes they stand for.
+    inline float medianOfSorted(const Key* sorted, int size) noexcept
+    {
+        if (size <= 0)
+            return 0.0f;
+        const int mid = size / 2;
+        if (size % 2 == 1)
+            return fromKey(sorted[mid]);
+        return (fromKey(sorted[mid]) + fromKey(sorted[mid - 1])) * 0.5f;
+    }
+}
+
+template <typename Value>
+void BasicBank<Value>::prepare(int numBins, int windowSize)
+{
+    jassert(numBins > 0 && windowSize > 0);
+    numBins_ = numBins;
+    windowSize_ = windowSize;
+    sorted_.assign(static_cast<size_t>(numBins) * static_cast<size_t>(windowSize), Value {});
+    count_ = 0;
+}
+
+template <typename Value>
+void BasicBank<Value>::push(const Value* newest, const Value* evicted, int beginBin, int endBin) noexcept
+{
+    jassert(newest != nullptr);
+    jassert(beginBin >= 0 && beginBin <= endBin && endBin <= numBins_);
+    // Evicted frame is required exactly when the windows are full.
+    jassert((evicted != nullptr) == (count_ == windowSize_));
+
+    Value* s = sorted_.data() + static_cast<size_t>(beginBin) * static_cast<size_t>(windowSize_);
+    if (evicted != nullptr && count_ == windowSize_)
+    {
+        for (int bin = beginBin; bin < endBin; ++bin, s += windowSize_)
+            replaceSorted(s, windowSize_, evicted[bin], newest[bin]);
+    }
+    else
+    {
+        for (int bin = beginBin; bin < endBin; ++bin, s += windowSize_)
+            insertSorted(s, count_, newest[bin]);
+        ++count_;
+    }
+}
+
+template <typename Value>
+void BasicBank<Value>::computeMedians(float* out, int beginBin, int endBin) const noexcept
+{
+    jassert(beginBin >= 0 && beginBin <= endBin && endBin <= numBins_);
+    const Value* s = sorted_.data() + static_cast<size_t>(beginBin) * static_cast<size_t>(windowSize_);
+    for (int bin = beginBin; bin < endBin; ++bin, s += windowSize_)
+        out[bin] = medianOfSorted(s, count_);
+}
+
+template class BasicBank<float>;
+template class BasicBank<Key>;
+
+//==============================================================================
+void centredMedianFilter(const float* in, float* out, int n, int windowSize,
+                         SortedWindow& window) noexcept
+{
+    const int halfWindow = windowSize / 2;
+    jassert(window.capacity() >= 2 * halfWindow + 1);
+
+    window.clear();
+    int windowStart = 0; // first bin currently in the window
+    int windowEnd = 0;   // one past the last bin currently in the window
+
+    for (int bin = 0; bin < n; ++bin)
+    {
+        const int startBin = std::max(0, bin - halfWindow);
+        const int endBin = std::min(n, bin + halfWindow + 1);
+
+        // Slide: retire bins that fell off the low edge, admit the new high edge.
+        // Retire first so the window never exceeds its capacity.
+        for (; windowStart < startBin; ++windowStart)
+            window.erase(in[windowStart]);
+        for (; windowEnd < endBin; ++windowEnd)
+            window.insert(in[windowEnd]);
+
+        out[bin] = window.median();
+    }
+}
+
+} // namespace SlidingMedian
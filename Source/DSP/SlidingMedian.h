@@ -0,0 +1,203 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * SlidingMedian - incremental median filters shared by the HPSS stages
+ *
+ * The HPSS guides are running medians: along time per bin (MaskEstimator's
+ * 9-frame horizontal guide, HarmonicMaskDetector's 17-frame long-grid
+ * guide) and along frequency within a frame (the 13-bin vertical guide).
+ * Consecutive windows share all but one value, so instead of re-selecting
+ * each window from scratch with nth_element these keep the window sorted
+ * and update it with one erase + one insert per step.
+ *
+ * The windows are small (tens of values), so a sorted contiguous array with
+ * binary search + a short memmove beats heap- or skiplist-based structures
+ * in practice: the search is O(log k) and the shift touches one or two
+ * cache lines. Cost per step therefore stays nearly flat as the median size
+ * grows, where re-selection grows linearly.
+ *
+ * Results are exactly the reference medians: the odd-size median is the
+ * middle value, the even-size median is (upper + lower) * 0.5, matching
+ * selectMedian() bit for bit.
+ *
+ * A median only needs the order of its values, so a time window can also
+ * hold 16-bit keys instead of floats (KeyBank): half the memory and
+ * bandwidth of the window and of the caller's frame history. A key is the
+ * magnitude's float bit pattern without the sign, rounded to 8 exponent and
+ * 8 mantissa bits: piecewise-linear in log2, ordered like the magnitudes,
+ * and within 0.2% (0.02 dB) of them over the whole float range. A median of
+ * keys is then exactly the median of the rounded magnitudes.
+ *
+ * RT-safety: all storage is sized in prepare(); nothing allocates afterwards.
+ */
+namespace SlidingMedian
+{
+    /** A non-negative magnitude as a 16-bit ordered key (see above). */
+    using Key = uint16_t;
+
+    /** Key of a magnitude (negative and NaN → 0; rounds to nearest). */
+    inline Key toKey(float magnitude) noexcept
+    {
+        if (! (magnitude > 0.0f))
+            return 0;
+        uint32_t bits;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        return static_cast<Key>(std::min<uint32_t>((bits + (1u << 14)) >> 15, 0xffffu));
+    }
+
+    /** Magnitude a key stands for. */
+    inline float fromKey(Key key) noexcept
+    {
+        const uint32_t bits = static_cast<uint32_t>(key) << 15;
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        return magnitude;
+    }
+
+    /** Keys of n magnitudes. */
+    void toKeys(const float* magnitudes, Key* keys, int n) noexcept;
+
+    /**
+     * Storage for a time median's frame history: linear magnitudes (Bank),
+     * or keys (KeyBank), whose medians are within 0.2% of the linear ones.
+     */
+    enum class HistoryFormat
+    {
+        Float32,    ///< Floats (exact)
+        Key16       ///< 16-bit keys, half the size
+    };
+
+    /**
+     * Reference median by selection (mutates data). Odd size → middle value,
+     * even size → mean of the two middle values; 0 for an empty range.
+     */
+    float selectMedian(float* data, int size) noexcept;
+
+    /**
+     * Upper median by selection (mutates data): the element at index size/2
+     * of the sorted range. For odd sizes this equals selectMedian().
+     */
+    float selectUpperMedian(float* data, int size) noexcept;
+
+    /**
+     * Median of an already sorted range, using the same rule as selectMedian().
+     */
+    inline float medianOfSorted(const float* sorted, int size) noexcept
+    {
+        if (size <= 0)
+            return 0.0f;
+        const int mid = size / 2;
+        if (size % 2 == 1)
+            return sorted[mid];
+        return (sorted[mid] + sorted[mid - 1]) * 0.5f;
+    }
+
+    /**
+     * A bounded sorted multiset of floats: insert and erase by value, median
+     * in O(1). Capacity is fixed at prepare().
+     */
+    class SortedWindow
+    {
+    public:
+        SortedWindow() = default;
+
+        /** Allocate room for up to capacity values and clear. */
+        void prepare(int capacity);
+
+        /** Remove all values (keeps storage). */
+        void clear() noexcept { size_ = 0; }
+
+        /** Insert a value, keeping the window sorted. Window must not be full. */
+        void insert(float value) noexcept;
+
+        /** Remove one occurrence of value, which must be present. */
+        void erase(float value) noexcept;
+
+        /** Replace one occurrence of oldValue with newValue (single shift). */
+        void replace(float oldValue, float newValue) noexcept;
+
+        float median() const noexcept { return medianOfSorted(values_.data(), size_); }
+        int size() const noexcept { return size_; }
+        int capacity() const noexcept { return static_cast<int>(values_.size()); }
+
+    private:
+        std::vector<float> values_;
+        int size_ = 0;
+    };
+
+    /**
+     * One sorted time window per bin, updated as frames arrive. The caller owns
+     * the frame history (its ring buffer) and passes the frame that drops out
+     * of the window alongside the new one, so the bank holds only the sorted
+     * copies: numBins × windowSize values, contiguous per bin.
+     *
+     * Value is float (Bank) or Key (KeyBank, frames given as keys; the
+     * medians come back as magnitudes).
+     */
+    template <typename Value>
+    class BasicBank
+    {
+    public:
+        BasicBank() = default;
+
+        /**
+         * Allocate storage and clear.
+         * @param numBins    Number of independent windows (frequency bins)
+         * @param windowSize Window length in frames
+         */
+        void prepare(int numBins, int windowSize);
+
+        /** Empty every window (keeps storage). */
+        void reset() noexcept { count_ = 0; }
+
+        /**
+         * Advance every window by one frame.
+         * @param newest  Incoming frame (numBins values)
+         * @param evicted Frame leaving the window, or nullptr while the
+         *                window is still filling (fewer than windowSize frames)
+         */
+        void push(const Value* newest, const Value* evicted) noexcept { push(newest, evicted, 0, numBins_); }
+
+        /**
+         * push() for bins [beginBin, endBin) only (frames still indexed from
+         * bin 0). The other windows are left as they were, a frame behind:
+         * only read them again after a reset().
+         */
+        void push(const Value* newest, const Value* evicted, int beginBin, int endBin) noexcept;
+
+        /** Write the current median of every window (numBins values). */
+        void computeMedians(float* out) const noexcept { computeMedians(out, 0, numBins_); }
+
+        /** computeMedians() for bins [beginBin, endBin) (out indexed from bin 0). */
+        void computeMedians(float* out, int beginBin, int endBin) const noexcept;
+
+        /** Frames currently in each window (0 … windowSize). */
+        int getCount() const noexcept { return count_; }
+        int getWindowSize() const noexcept { return windowSize_; }
+
+    private:
+        std::vector<Value> sorted_;     ///< numBins × windowSize, each bin's window sorted ascending
+        int numBins_ = 0;
+        int windowSize_ = 0;
+        int count_ = 0;
+    };
+
+    using Bank = BasicBank<float>;
+    using KeyBank = BasicBank<Key>;
+
+    /**
+     * Centred running median along a frame: out[b] is the median of
+     * in[max(0, b - h) … min(n, b + h + 1)), h = windowSize / 2, so windows
+     * shrink at the edges exactly like the per-bin nth_element form. An even
+     * windowSize therefore spans 2h + 1 bins, as the reference does.
+     * @param window Scratch prepared with capacity >= 2 * (windowSize / 2) + 1
+     */
+    void centredMedianFilter(const float* in, float* out, int n, int windowSize,
+                             SortedWindow& window) noexcept;
+}
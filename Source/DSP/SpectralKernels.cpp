@@ -0,0 +1,221 @@
+#include "SpectralKernels.h"
+#include "SpectralKernelsImpl.h"
+#include <algorithm>
+#include <atomic>
+
+namespace SpectralKernels
+{
+namespace detail
+{
+    // Widest instruction set this TU was compiled for: the baseline of the
+    // target (or AVX2 when the whole build asks for it).
+#if defined(__AVX2__)
+    using BaselineIsa = VecAVX2;
+    constexpr auto kBaseline = InstructionSet::AVX2;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    using BaselineIsa = VecNEON;
+    constexpr auto kBaseline = InstructionSet::NEON;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    using BaselineIsa = VecSSE2;
+    constexpr auto kBaseline = InstructionSet::SSE2;
+#else
+    using BaselineIsa = VecScalar;
+    constexpr auto kBaseline = InstructionSet::Scalar;
+#endif
+
+    const KernelTable& getScalarKernels() noexcept
+    {
+        static constexpr KernelTable table = makeKernelTable<VecScalar>(InstructionSet::Scalar);
+        return table;
+    }
+
+    const KernelTable& getBaselineKernels() noexcept
+    {
+        static constexpr KernelTable table = makeKernelTable<BaselineIsa>(kBaseline);
+        return table;
+    }
+}
+
+namespace
+{
+    // The table every kernel call goes through; nullptr until the first
+    // selectInstructionSet() (or kernel call). Every variant computes the
+    // same results to the accuracy contract, so a race between two first
+    // calls only picks the same table twice.
+    std::atomic<const detail::KernelTable*> activeKernels { nullptr };
+
+    /** The variant's table, or nullptr if it isn't built in or the CPU lacks it. */
+    const detail::KernelTable* findKernels(InstructionSet set) noexcept
+    {
+        if (set == InstructionSet::Scalar)
+            return &detail::getScalarKernels();
+
+        if (set == InstructionSet::AVX2)
+        {
+            // Compiled in its own TU; only call it on a CPU (and OS) with AVX2.
+            if (auto* avx2 = detail::getAvx2Kernels(); avx2 != nullptr && juce::SystemStats::hasAVX2())
+                return avx2;
+        }
+
+        return set == detail::kBaseline ? &detail::getBaselineKernels() : nullptr;
+    }
+
+    const detail::KernelTable& kernels() noexcept
+    {
+        if (auto* table = activeKernels.load(std::memory_order_acquire))
+            return *table;
+        selectInstructionSet();
+        return *activeKernels.load(std::memory_order_acquire);
+    }
+}
+
+const char* getInstructionSetName(InstructionSet set) noexcept
+{
+    switch (set)
+    {
+        case InstructionSet::SSE2: return "sse2";
+        case InstructionSet::NEON: return "neon";
+        case InstructionSet::AVX2: return "avx2";
+        case InstructionSet::Scalar: break;
+    }
+    return "scalar";
+}
+
+bool isAvailable(InstructionSet set) noexcept
+{
+    return findKernels(set) != nullptr;
+}
+
+void selectInstructionSet() noexcept
+{
+    if (activeKernels.load(std::memory_order_acquire) != nullptr)
+        return;
+
+    for (auto set : { InstructionSet::AVX2, InstructionSet::NEON, InstructionSet::SSE2, InstructionSet::Scalar })
+        if (auto* table = findKernels(set))
+        {
+            activeKernels.store(table, std::memory_order_release);
+            return;
+        }
+}
+
+bool setInstructionSet(InstructionSet set) noexcept
+{
+    auto* table = findKernels(set);
+    if (table == nullptr)
+        return false;
+
+    activeKernels.store(table, std::memory_order_release);
+    return true;
+}
+
+InstructionSet getInstructionSet() noexcept
+{
+    return kernels().instructionSet;
+}
+
+const char* getInstructionSetName() noexcept
+{
+    return getInstructionSetName(getInstructionSet());
+}
+
+void computeMagnitudes(const std::complex<float>* bins, float* magnitudes,
+                       int numBins, float zeroThreshold) noexcept
+{
+    jassert(bins != nullptr && magnitudes != nullptr);
+    kernels().magnitudes(bins, magnitudes, numBins, zeroThreshold);
+}
+
+void computeWienerMasks(const float* horizontalGuide, const float* verticalGuide,
+                        const float* spectralFlux, const float* spectralFlatness,
+                        float* mask, int numBins, const WienerParams& params) noexcept
+{
+    kernels().wienerMasks(horizontalGuide, verticalGuide, spectralFlux, spectralFlatness,
+                          mask, numBins, params.minPower, params.tonalBoost,
+                          params.noiseBoost, params.exponent, params.eps);
+}
+
+void computeLog(const float* in, float* out, int n, float floorValue) noexcept
+{
+    jassert(floorValue >= 1.17549435e-38f);
+    kernels().log(in, out, n, floorValue);
+}
+
+void FlatnessWorkspace::prepare(int numBins)
+{
+    const size_t n = static_cast<size_t>(std::max(numBins, 0));
+    logMagnitude.assign(n, 0.0f);
+    meanLog.assign(n, 0.0f);
+    arithmeticMean.assign(n, 0.0f);
+    logPrefix.assign(n + 1, 0.0);
+    magPrefix.assign(n + 1, 0.0);
+    countPrefix.assign(n + 1, 0);
+}
+
+void computeSpectralFlatness(const float* magnitudes, float* flatness, int numBins,
+                             int windowSize, float eps, FlatnessWorkspace& ws) noexcept
+{
+    computeSpectralFlatness(magnitudes, flatness, numBins, 0, numBins, windowSize, eps, ws);
+}
+
+void computeSpectralFlatness(const float* magnitudes, float* flatness, int numBins,
+                             int beginBin, int endBin, int windowSize, float eps,
+                             FlatnessWorkspace& ws) noexcept
+{
+    jassert(ws.logMagnitude.size() >= static_cast<size_t>(numBins));
+    jassert(beginBin >= 0 && beginBin <= endBin && endBin <= numBins);
+
+    // The bins the range's windows reach; prefix sums run from lo
+    // (prefix[i - lo] sums bins lo .. i-1).
+    const int halfWindow = windowSize / 2;
+    const int lo = std::max(0, beginBin - halfWindow);
+    const int hi = std::min(numBins, endBin + halfWindow);
+    if (hi <= lo)
+        return;
+
+    // 1. One log per bin (vector), instead of one per bin per window position.
+    const auto& table = kernels();
+    table.log(magnitudes + lo, ws.logMagnitude.data() + lo, hi - lo, eps);
+
+    // 2. Prefix sums over valid bins, in double like the reference sums.
+    ws.logPrefix[0] = 0.0;
+    ws.magPrefix[0] = 0.0;
+    ws.countPrefix[0] = 0;
+    for (int i = lo; i < hi; ++i)
+    {
+        const bool valid = magnitudes[i] > eps;
+        const auto p = static_cast<size_t>(i - lo);
+        ws.logPrefix[p + 1]   = ws.logPrefix[p] + (valid ? (double) ws.logMagnitude[(size_t) i] : 0.0);
+        ws.magPrefix[p + 1]   = ws.magPrefix[p] + (valid ? (double) magnitudes[i] : 0.0);
+        ws.countPrefix[p + 1] = ws.countPrefix[p] + (valid ? 1 : 0);
+    }
+
+    // 3. Window means. arithmeticMean == 0 marks a neutral (0.5) bin.
+    for (int bin = beginBin; bin < endBin; ++bin)
+    {
+        const int startBin = std::max(1, bin - halfWindow); // Skip DC
+        const int endWindow = std::min(numBins, bin + halfWindow + 1);
+
+        ws.meanLog[(size_t) bin] = 0.0f;
+        ws.arithmeticMean[(size_t) bin] = 0.0f;
+
+        if (endWindow - startBin < 3)
+            continue;
+
+        const auto first = static_cast<size_t>(startBin - lo);
+        const auto last = static_cast<size_t>(endWindow - lo);
+        const int validBins = ws.countPrefix[last] - ws.countPrefix[first];
+        const double arithmeticSum = ws.magPrefix[last] - ws.magPrefix[first];
+        if (validBins >= 3 && arithmeticSum > eps)
+        {
+            const double logSum = ws.logPrefix[last] - ws.logPrefix[first];
+            ws.meanLog[(size_t) bin] = static_cast<float>(logSum / validBins);
+            ws.arithmeticMean[(size_t) bin] = static_cast<float>(arithmeticSum / validBins);
+        }
+    }
+
+    // 4. exp(mean log) / mean, clamped, vectorised.
+    table.flatnessRatio(ws.meanLog.data() + beginBin, ws.arithmeticMean.data() + beginBin,
+                        flatness + beginBin, endBin - beginBin);
+}
+} // namespace SpectralKernels
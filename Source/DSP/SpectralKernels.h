@@ -0,0 +1,145 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <vector>
+
+/**
+ * SpectralKernels - vectorised whole-frame kernels for the HPSS hot path
+ *
+ * The per-bin maths that runs for every bin of every frame of every channel:
+ * complex → magnitude, the Wiener ratio + mask exponent of
+ * MaskEstimator::computeMasks(), and the log-mean behind the spectral
+ * flatness measure. Each kernel processes a whole frame. Every build has a
+ * baseline variant, compiled for whatever the target always has (SSE2 on
+ * x86-64, NEON on arm64, scalar otherwise), and x86 builds an AVX2 variant
+ * as well, in its own translation unit with its own flags
+ * (SpectralKernelsAVX2.cpp). The kernels run through a table of function
+ * pointers chosen once by selectInstructionSet(): the widest variant the
+ * CPU supports, so the x86 slice of the universal binary and the Windows
+ * build use AVX2 where there is one without requiring it.
+ *
+ * Accuracy contract (checked by the Harness against the libm reference):
+ * - computeMagnitudes: bit-identical to sqrt(re² + im²) with the same
+ *   zero-below-threshold rule (IEEE sqrt / mul / add on every ISA).
+ * - computeWienerMasks: |mask − pow(gain, exponent)| ≤ 2e-6 absolute over
+ *   [0, 1]. Results below ~1e-38 flush to 0 (ScopedNoDenormals would flush
+ *   them anyway). The power/penalty stage is the same IEEE arithmetic as the
+ *   scalar loop it replaces, so only the pow() evaluation differs.
+ * - computeSpectralFlatness: |sfm − reference| ≤ 1e-5 absolute. Logs are
+ *   taken once per bin (float, ≤ 2 ulp) and the 13-bin window sums come from
+ *   double prefix sums instead of 13 double logs per bin.
+ * - All kernels are deterministic for a given ISA and frame length. AVX2 is
+ *   built without FMA contraction, so it matches SSE2 to the bit.
+ */
+namespace SpectralKernels
+{
+    /** Kernel variants, narrowest first. */
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE2,
+        NEON,
+        AVX2
+    };
+
+    /** "scalar", "sse2", "neon" or "avx2". */
+    const char* getInstructionSetName(InstructionSet set) noexcept;
+
+    /** True if the variant is compiled into this build and this CPU runs it. */
+    bool isAvailable(InstructionSet set) noexcept;
+
+    /**
+     * Point the kernels at the widest available variant. The first call
+     * queries the CPU; later ones change nothing unless setInstructionSet()
+     * has picked another variant since. Call it from prepare code (the
+     * kernels otherwise select on their first call).
+     */
+    void selectInstructionSet() noexcept;
+
+    /**
+     * Run every kernel on one variant, for every caller in the process
+     * (tests and benchmarks comparing variants).
+     * @return false, changing nothing, if the variant is not available
+     */
+    bool setInstructionSet(InstructionSet set) noexcept;
+
+    /** The variant the kernels run on. */
+    InstructionSet getInstructionSet() noexcept;
+
+    /** Name of the variant the kernels run on. */
+    const char* getInstructionSetName() noexcept;
+
+    /**
+     * magnitudes[i] = |bins[i]|, or 0 where |bins[i]| <= zeroThreshold.
+     * @param bins          Complex spectrum (size numBins)
+     * @param magnitudes    Output magnitudes (size numBins)
+     * @param numBins       Number of bins
+     * @param zeroThreshold Magnitudes at or below this are written as 0
+     */
+    void computeMagnitudes(const std::complex<float>* bins, float* magnitudes,
+                           int numBins, float zeroThreshold) noexcept;
+
+    /** Scalar inputs of the Wiener stage (see MaskEstimator::computeMasks). */
+    struct WienerParams
+    {
+        float minPower = 1e-6f;     ///< Floor applied to both power estimates
+        float tonalBoost = 1.0f;    ///< Focus boost on tonal power (1 = none)
+        float noiseBoost = 1.0f;    ///< Focus boost on noise power (1 = none)
+        float exponent = 1.0f;      ///< Mask sharpness exponent
+        float eps = 1e-8f;          ///< Total-power threshold below which the mask is 0
+    };
+
+    /**
+     * Wiener-style tonal mask: pow(tonalPower / (tonalPower + noisePower), exponent),
+     * with the flux / flatness penalties and focus boosts of MaskEstimator.
+     * All arrays are size numBins.
+     */
+    void computeWienerMasks(const float* horizontalGuide, const float* verticalGuide,
+                            const float* spectralFlux, const float* spectralFlatness,
+                            float* mask, int numBins, const WienerParams& params) noexcept;
+
+    /**
+     * out[i] = ln(in[i]) where in[i] > floorValue, else 0.
+     * @param floorValue Must be >= the smallest normal float
+     */
+    void computeLog(const float* in, float* out, int n, float floorValue) noexcept;
+
+    /** Scratch storage for computeSpectralFlatness(); size it once in prepare(). */
+    struct FlatnessWorkspace
+    {
+        void prepare(int numBins);
+
+        std::vector<float> logMagnitude;    ///< ln|X| per bin (0 where invalid)
+        std::vector<float> meanLog;         ///< Window mean of ln|X|
+        std::vector<float> arithmeticMean;  ///< Window mean of |X| (0 = neutral bin)
+        std::vector<double> logPrefix;      ///< Prefix sums of logMagnitude (numBins + 1)
+        std::vector<double> magPrefix;      ///< Prefix sums of valid magnitudes (numBins + 1)
+        std::vector<int> countPrefix;       ///< Prefix counts of valid bins (numBins + 1)
+    };
+
+    /**
+     * Spectral flatness (geometric / arithmetic mean) over a centred window
+     * that starts no lower than bin 1 (DC skipped). Bins with fewer than 3
+     * valid (> eps) magnitudes in their window get the neutral value 0.5.
+     * @param magnitudes Input magnitudes (size numBins)
+     * @param flatness   Output SFM in [0, 1] (size numBins)
+     * @param numBins    Number of bins
+     * @param windowSize Window length in bins (odd)
+     * @param eps        Validity threshold for a magnitude
+     * @param workspace  Prepared scratch (prepare(numBins) called beforehand)
+     */
+    void computeSpectralFlatness(const float* magnitudes, float* flatness, int numBins,
+                                 int windowSize, float eps, FlatnessWorkspace& workspace) noexcept;
+
+    /**
+     * computeSpectralFlatness() for bins [beginBin, endBin) only, reading
+     * magnitudes half a window either side (arrays still size numBins,
+     * indexed from bin 0). The whole range is the function above, bit for
+     * bit; a range starting above the window's reach sums from there, so
+     * within the accuracy contract of the whole-frame result.
+     */
+    void computeSpectralFlatness(const float* magnitudes, float* flatness, int numBins,
+                                 int beginBin, int endBin, int windowSize, float eps,
+                                 FlatnessWorkspace& workspace) noexcept;
+}
@@ -0,0 +1,22 @@
+// The AVX2 variant of the spectral kernels. The build gives this TU (and
+// only this one) AVX2 code generation, without FMA or contraction
+// (-ffp-contract=off) so results match SSE2 to the bit; SpectralKernels.cpp calls into it only on a CPU with AVX2.
+// Built without the flag (arm64, or a build that doesn't set it) it
+// exports no variant.
+#include "SpectralKernelsImpl.h"
+
+namespace SpectralKernels
+{
+namespace detail
+{
+    const KernelTable* getAvx2Kernels() noexcept
+    {
+#if defined(__AVX2__)
+        static constexpr KernelTable table = makeKernelTable<VecAVX2>(InstructionSet::AVX2);
+        return &table;
+#else
+        return nullptr;
+#endif
+    }
+}
+} // namespace SpectralKernels
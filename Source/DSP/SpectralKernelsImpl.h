@@ -0,0 +1,438 @@
+#pragma once
+
+// =============================================================================
+// SpectralKernelsImpl.h — ISA abstraction + templated per-frame kernels
+// =============================================================================
+// Internal to SpectralKernels*.cpp. Each Vec* type wraps one instruction set
+// behind the same small set of static operations (load/store, arithmetic,
+// compare/select, the bit tricks needed by log/exp). The kernels below are
+// written once against that interface and instantiated for whichever Vec the
+// translation unit was compiled for, so every ISA runs the same maths in the
+// same order — only the lane width changes. Each TU exports its variant as a
+// KernelTable.
+//
+// Everything below the table has internal linkage: the TUs are built with
+// different ISA flags, and an inline function shared between them (the
+// scalar tails, say) must not let the linker keep the AVX2 copy for all.
+//
+// Do not include this from anywhere except SpectralKernels*.cpp.
+// =============================================================================
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "SpectralKernels.h"
+
+#if defined(__AVX2__)
+ #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+ #include <arm_neon.h>
+#endif
+
+namespace SpectralKernels
+{
+namespace detail
+{
+
+/** One variant's kernels (see SpectralKernels.cpp for the dispatch). */
+struct KernelTable
+{
+    InstructionSet instructionSet;
+    void (*magnitudes)(const std::complex<float>* bins, float* out, int n, float zeroThreshold) noexcept;
+    void (*wienerMasks)(const float* horizontalGuide, const float* verticalGuide,
+                        const float* flux, const float* flatness, float* out, int n,
+                        float minPower, float tonalBoost, float noiseBoost,
+                        float exponent, float eps) noexcept;
+    void (*log)(const float* in, float* out, int n, float floorValue) noexcept;
+    void (*flatnessRatio)(const float* meanLog, const float* arithmeticMean, float* out, int n) noexcept;
+};
+
+/** Scalar and baseline (widest the TU's flags allow) variants: SpectralKernels.cpp. */
+const KernelTable& getScalarKernels() noexcept;
+const KernelTable& getBaselineKernels() noexcept;
+
+/** The AVX2 variant (SpectralKernelsAVX2.cpp), nullptr unless built with AVX2. */
+const KernelTable* getAvx2Kernels() noexcept;
+
+namespace
+{
+
+//==============================================================================
+// Scalar reference lane (1 wide). Also the tail path for every other ISA.
+struct VecScalar
+{
+    static constexpr int width = 1;
+    static constexpr const char* name = "scalar";
+
+    struct V { float x; };
+
+    static V load(const float* p) noexcept                 { return { *p }; }
+    static void store(float* p, V v) noexcept              { *p = v.x; }
+    static V set(float s) noexcept                         { return { s }; }
+    static V add(V a, V b) noexcept                        { return { a.x + b.x }; }
+    static V sub(V a, V b) noexcept                        { return { a.x - b.x }; }
+    static V mul(V a, V b) noexcept                        { return { a.x * b.x }; }
+    static V div(V a, V b) noexcept                        { return { a.x / b.x }; }
+    static V min(V a, V b) noexcept                        { return { b.x < a.x ? b.x : a.x }; }
+    static V max(V a, V b) noexcept                        { return { a.x < b.x ? b.x : a.x }; }
+    static V sqrt(V a) noexcept                            { return { std::sqrt(a.x) }; }
+
+    // Masks are all-ones / all-zeros bit patterns, as on the vector ISAs.
+    static V fromBits(uint32_t b) noexcept                 { float f; std::memcpy(&f, &b, 4); return { f }; }
+    static uint32_t bits(V a) noexcept                     { uint32_t b; std::memcpy(&b, &a.x, 4); return b; }
+    static V cmpGt(V a, V b) noexcept                      { return fromBits(a.x > b.x ? 0xffffffffu : 0u); }
+    static V cmpLt(V a, V b) noexcept                      { return fromBits(a.x < b.x ? 0xffffffffu : 0u); }
+    static V select(V m, V a, V b) noexcept                { return bits(m) != 0 ? a : b; }
+
+    // log/exp helpers: exponent/mantissa split and 2^n construction.
+    static V roundToIntAsFloat(V a) noexcept               { return { (float) std::lrint(a.x) }; }
+    static V exponentOf(V a) noexcept                      { return { (float) ((int) ((bits(a) >> 23) & 0xff) - 126) }; }
+    static V mantissaOf(V a) noexcept                      { return fromBits((bits(a) & 0x807fffffu) | 0x3f000000u); }
+    static V pow2i(V n) noexcept                           { return fromBits((uint32_t) ((int) n.x + 127) << 23); }
+
+    static void loadComplex(const std::complex<float>* p, V& re, V& im) noexcept { re.x = p->real(); im.x = p->imag(); }
+};
+
+//==============================================================================
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+struct VecSSE2
+{
+    static constexpr int width = 4;
+    static constexpr const char* name = "sse2";
+
+    using V = __m128;
+
+    static V load(const float* p) noexcept                 { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) noexcept              { _mm_storeu_ps(p, v); }
+    static V set(float s) noexcept                         { return _mm_set1_ps(s); }
+    static V add(V a, V b) noexcept                        { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) noexcept                        { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) noexcept                        { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) noexcept                        { return _mm_div_ps(a, b); }
+    static V min(V a, V b) noexcept                        { return _mm_min_ps(a, b); }
+    static V max(V a, V b) noexcept                        { return _mm_max_ps(a, b); }
+    static V sqrt(V a) noexcept                            { return _mm_sqrt_ps(a); }
+    static V cmpGt(V a, V b) noexcept                      { return _mm_cmpgt_ps(a, b); }
+    static V cmpLt(V a, V b) noexcept                      { return _mm_cmplt_ps(a, b); }
+    static V select(V m, V a, V b) noexcept                { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+    static V roundToIntAsFloat(V a) noexcept               { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+    static V exponentOf(V a) noexcept
+    {
+        const __m128i e = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(a), 23), _mm_set1_epi32(0xff));
+        return _mm_cvtepi32_ps(_mm_sub_epi32(e, _mm_set1_epi32(126)));
+    }
+    static V mantissaOf(V a) noexcept
+    {
+        const __m128i m = _mm_and_si128(_mm_castps_si128(a), _mm_set1_epi32((int) 0x807fffffu));
+        return _mm_castsi128_ps(_mm_or_si128(m, _mm_set1_epi32(0x3f000000)));
+    }
+    static V pow2i(V n) noexcept
+    {
+        const __m128i e = _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+
+    static void loadComplex(const std::complex<float>* p, V& re, V& im) noexcept
+    {
+        const float* f = reinterpret_cast<const float*>(p);
+        const __m128 a = _mm_loadu_ps(f);        // r0 i0 r1 i1
+        const __m128 b = _mm_loadu_ps(f + 4);    // r2 i2 r3 i3
+        re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+};
+#endif
+
+//==============================================================================
+#if defined(__AVX2__)
+struct VecAVX2
+{
+    static constexpr int width = 8;
+    static constexpr const char* name = "avx2";
+
+    using V = __m256;
+
+    static V load(const float* p) noexcept                 { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) noexcept              { _mm256_storeu_ps(p, v); }
+    static V set(float s) noexcept                         { return _mm256_set1_ps(s); }
+    static V add(V a, V b) noexcept                        { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) noexcept                        { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) noexcept                        { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) noexcept                        { return _mm256_div_ps(a, b); }
+    static V min(V a, V b) noexcept                        { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) noexcept                        { return _mm256_max_ps(a, b); }
+    static V sqrt(V a) noexcept                            { return _mm256_sqrt_ps(a); }
+    static V cmpGt(V a, V b) noexcept                      { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V cmpLt(V a, V b) noexcept                      { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V select(V m, V a, V b) noexcept                { return _mm256_blendv_ps(b, a, m); }
+
+    static V roundToIntAsFloat(V a) noexcept               { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(a)); }
+    static V exponentOf(V a) noexcept
+    {
+        const __m256i e = _mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(a), 23), _mm256_set1_epi32(0xff));
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(126)));
+    }
+    static V mantissaOf(V a) noexcept
+    {
+        const __m256i m = _mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32((int) 0x807fffffu));
+        return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_set1_epi32(0x3f000000)));
+    }
+    static V pow2i(V n) noexcept
+    {
+        const __m256i e = _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+
+    static void loadComplex(const std::complex<float>* p, V& re, V& im) noexcept
+    {
+        const float* f = reinterpret_cast<const float*>(p);
+        const __m256 a = _mm256_loadu_ps(f);     // r0 i0 r1 i1 | r2 i2 r3 i3
+        const __m256 b = _mm256_loadu_ps(f + 8); // r4 i4 r5 i5 | r6 i6 r7 i7
+        // In-lane shuffle gives r0 r1 r4 r5 | r2 r3 r6 r7; the 64-bit permute
+        // restores ascending bin order.
+        re = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+        im = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+};
+#endif
+
+//==============================================================================
+#if defined(__ARM_NEON) && defined(__aarch64__)
+struct VecNEON
+{
+    static constexpr int width = 4;
+    static constexpr const char* name = "neon";
+
+    using V = float32x4_t;
+
+    static V load(const float* p) noexcept                 { return vld1q_f32(p); }
+    static void store(float* p, V v) noexcept              { vst1q_f32(p, v); }
+    static V set(float s) noexcept                         { return vdupq_n_f32(s); }
+    static V add(V a, V b) noexcept                        { return vaddq_f32(a, b); }
+    static V sub(V a, V b) noexcept                        { return vsubq_f32(a, b); }
+    static V mul(V a, V b) noexcept                        { return vmulq_f32(a, b); }
+    static V div(V a, V b) noexcept                        { return vdivq_f32(a, b); }
+    static V min(V a, V b) noexcept                        { return vminq_f32(a, b); }
+    static V max(V a, V b) noexcept                        { return vmaxq_f32(a, b); }
+    static V sqrt(V a) noexcept                            { return vsqrtq_f32(a); }
+    static V cmpGt(V a, V b) noexcept                      { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+    static V cmpLt(V a, V b) noexcept                      { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+    static V select(V m, V a, V b) noexcept                { return vbslq_f32(vreinterpretq_u32_f32(m), a, b); }
+
+    static V roundToIntAsFloat(V a) noexcept               { return vcvtq_f32_s32(vcvtnq_s32_f32(a)); }
+    static V exponentOf(V a) noexcept
+    {
+        const uint32x4_t e = vandq_u32(vshrq_n_u32(vreinterpretq_u32_f32(a), 23), vdupq_n_u32(0xff));
+        return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(e), vdupq_n_s32(126)));
+    }
+    static V mantissaOf(V a) noexcept
+    {
+        const uint32x4_t m = vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x807fffffu));
+        return vreinterpretq_f32_u32(vorrq_u32(m, vdupq_n_u32(0x3f000000u)));
+    }
+    static V pow2i(V n) noexcept
+    {
+        const int32x4_t e = vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127));
+        return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+    }
+
+    static void loadComplex(const std::complex<float>* p, V& re, V& im) noexcept
+    {
+        const float32x4x2_t d = vld2q_f32(reinterpret_cast<const float*>(p));
+        re = d.val[0];
+        im = d.val[1];
+    }
+};
+#endif
+
+//==============================================================================
+// Polynomial log / exp (Cephes single-precision coefficients). Valid for
+// finite positive normal inputs to log and inputs in [-87.3, 88.3] to exp;
+// callers clamp and mask everything outside that range. Both are within a
+// few ulp of the libm float result, which is what the accuracy contract in
+// SpectralKernels.h is built on.
+
+template <typename I>
+inline typename I::V logApprox(typename I::V x) noexcept
+{
+    using V = typename I::V;
+    V e = I::exponentOf(x);          // x = m * 2^e, m in [0.5, 1)
+    V m = I::mantissaOf(x);
+
+    // Shift m into [sqrt(0.5), sqrt(2)) so the polynomial sees |m - 1| < 0.29.
+    const V small = I::cmpLt(m, I::set(0.707106781186547524f));
+    e = I::select(small, I::sub(e, I::set(1.0f)), e);
+    m = I::select(small, I::add(m, m), m);
+    m = I::sub(m, I::set(1.0f));
+
+    const V z = I::mul(m, m);
+    V y = I::set(7.0376836292e-2f);
+    y = I::add(I::mul(y, m), I::set(-1.1514610310e-1f));
+    y = I::add(I::mul(y, m), I::set( 1.1676998740e-1f));
+    y = I::add(I::mul(y, m), I::set(-1.2420140846e-1f));
+    y = I::add(I::mul(y, m), I::set( 1.4249322787e-1f));
+    y = I::add(I::mul(y, m), I::set(-1.6668057665e-1f));
+    y = I::add(I::mul(y, m), I::set( 2.0000714765e-1f));
+    y = I::add(I::mul(y, m), I::set(-2.4999993993e-1f));
+    y = I::add(I::mul(y, m), I::set( 3.3333331174e-1f));
+    y = I::mul(I::mul(y, m), z);
+
+    y = I::add(y, I::mul(e, I::set(-2.12194440e-4f)));
+    y = I::sub(y, I::mul(z, I::set(0.5f)));
+    return I::add(I::add(m, y), I::mul(e, I::set(0.693359375f)));
+}
+
+template <typename I>
+inline typename I::V expApprox(typename I::V x) noexcept
+{
+    using V = typename I::V;
+    x = I::min(I::max(x, I::set(-87.3f)), I::set(88.3f));
+
+    // x = n*ln2 + r, |r| <= ln2/2, ln2 split hi/lo for exact reduction.
+    const V n = I::roundToIntAsFloat(I::mul(x, I::set(1.44269504088896341f)));
+    V r = I::sub(x, I::mul(n, I::set(0.693359375f)));
+    r = I::sub(r, I::mul(n, I::set(-2.12194440e-4f)));
+
+    const V z = I::mul(r, r);
+    V y = I::set(1.9875691500e-4f);
+    y = I::add(I::mul(y, r), I::set(1.3981999507e-3f));
+    y = I::add(I::mul(y, r), I::set(8.3334519073e-3f));
+    y = I::add(I::mul(y, r), I::set(4.1665795894e-2f));
+    y = I::add(I::mul(y, r), I::set(1.6666665459e-1f));
+    y = I::add(I::mul(y, r), I::set(5.0000001201e-1f));
+    y = I::add(I::add(I::mul(y, z), r), I::set(1.0f));
+
+    return I::mul(y, I::pow2i(n));
+}
+
+//==============================================================================
+// Kernels. Each runs the ISA over whole vectors, then finishes the tail with
+// the scalar lane so results never depend on the frame length.
+
+template <typename I>
+inline void magnitudesImpl(const std::complex<float>* bins, float* out, int n, float zeroThreshold) noexcept
+{
+    const auto threshold = I::set(zeroThreshold);
+    const auto zero = I::set(0.0f);
+
+    int i = 0;
+    for (; i + I::width <= n; i += I::width)
+    {
+        typename I::V re, im;
+        I::loadComplex(bins + i, re, im);
+        const auto mag = I::sqrt(I::add(I::mul(re, re), I::mul(im, im)));
+        I::store(out + i, I::select(I::cmpGt(mag, threshold), mag, zero));
+    }
+
+    if constexpr (I::width > 1)
+        magnitudesImpl<VecScalar>(bins + i, out + i, n - i, zeroThreshold);
+}
+
+template <typename I>
+inline void wienerMasksImpl(const float* horizontalGuide, const float* verticalGuide,
+                            const float* flux, const float* flatness, float* out, int n,
+                            float minPower, float tonalBoost, float noiseBoost,
+                            float exponent, float eps) noexcept
+{
+    const auto vMinPower   = I::set(minPower);
+    const auto vTonalBoost = I::set(tonalBoost);
+    const auto vNoiseBoost = I::set(noiseBoost);
+    const auto vExponent   = I::set(exponent);
+    const auto vEps        = I::set(eps);
+    const auto one         = I::set(1.0f);
+    const auto zero        = I::set(0.0f);
+    const auto half        = I::set(0.5f);
+    const auto minLogInput = I::set(1.17549435e-38f);   // smallest normal; below → mask 0
+    const auto minExpInput = I::set(-87.3f);            // exp underflow → mask 0
+
+    int i = 0;
+    for (; i + I::width <= n; i += I::width)
+    {
+        const auto h = I::load(horizontalGuide + i);
+        const auto v = I::load(verticalGuide + i);
+        auto tonalPower = I::max(I::mul(h, h), vMinPower);
+        auto noisePower = I::max(I::mul(v, v), vMinPower);
+
+        const auto fluxPenalty     = I::mul(I::load(flux + i), I::set(0.7f));
+        const auto flatnessPenalty = I::mul(I::load(flatness + i), half);
+
+        tonalPower = I::mul(tonalPower, I::max(I::set(0.01f), I::mul(I::sub(one, fluxPenalty),
+                                                                      I::sub(one, flatnessPenalty))));
+        noisePower = I::mul(noisePower, I::mul(I::add(one, I::mul(fluxPenalty, half)),
+                                               I::add(one, I::mul(flatnessPenalty, half))));
+        tonalPower = I::mul(tonalPower, vTonalBoost);
+        noisePower = I::mul(noisePower, vNoiseBoost);
+
+        const auto totalPower = I::add(tonalPower, noisePower);
+        auto gain = I::min(I::max(I::div(tonalPower, totalPower), zero), one);
+        gain = I::select(I::cmpGt(totalPower, vEps), gain, zero);
+
+        // pow(gain, exponent) = exp(exponent * ln(gain)) for gain in (0, 1].
+        const auto y = I::mul(vExponent, logApprox<I>(I::max(gain, minLogInput)));
+        auto mask = expApprox<I>(y);
+        mask = I::select(I::cmpLt(gain, minLogInput), zero, mask);
+        mask = I::select(I::cmpLt(y, minExpInput), zero, mask);
+        mask = I::min(mask, one);
+        I::store(out + i, mask);
+    }
+
+    if constexpr (I::width > 1)
+        wienerMasksImpl<VecScalar>(horizontalGuide + i, verticalGuide + i, flux + i, flatness + i,
+                                   out + i, n - i, minPower, tonalBoost, noiseBoost, exponent, eps);
+}
+
+template <typename I>
+inline void logImpl(const float* in, float* out, int n, float floorValue) noexcept
+{
+    const auto vFloor = I::set(floorValue);
+    const auto zero = I::set(0.0f);
+
+    int i = 0;
+    for (; i + I::width <= n; i += I::width)
+    {
+        const auto x = I::load(in + i);
+        const auto valid = I::cmpGt(x, vFloor);
+        I::store(out + i, I::select(valid, logApprox<I>(I::max(x, vFloor)), zero));
+    }
+
+    if constexpr (I::width > 1)
+        logImpl<VecScalar>(in + i, out + i, n - i, floorValue);
+}
+
+template <typename I>
+inline void flatnessRatioImpl(const float* meanLog, const float* arithmeticMean, float* out, int n) noexcept
+{
+    const auto zero = I::set(0.0f);
+    const auto one  = I::set(1.0f);
+    const auto half = I::set(0.5f);
+
+    int i = 0;
+    for (; i + I::width <= n; i += I::width)
+    {
+        const auto am = I::load(arithmeticMean + i);
+        const auto ok = I::cmpGt(am, zero);
+        const auto sfm = I::div(expApprox<I>(I::load(meanLog + i)), I::select(ok, am, one));
+        I::store(out + i, I::select(ok, I::min(I::max(sfm, zero), one), half));
+    }
+
+    if constexpr (I::width > 1)
+        flatnessRatioImpl<VecScalar>(meanLog + i, arithmeticMean + i, out + i, n - i);
+}
+
+//==============================================================================
+template <typename I>
+constexpr KernelTable makeKernelTable(InstructionSet instructionSet) noexcept
+{
+    return { instructionSet, &magnitudesImpl<I>, &wienerMasksImpl<I>, &logImpl<I>, &flatnessRatioImpl<I> };
+}
+
+} // namespace
+} // namespace detail
+} // namespace SpectralKernels
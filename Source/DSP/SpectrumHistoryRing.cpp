@@ -0,0 +1,218 @@
+#include "SpectrumHistoryRing.h"
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    // Bins [first, end) of one column: equal runs, the remainder spread out.
+    int columnStart(int column, int columns, int numBins) noexcept
+    {
+        return static_cast<int>(static_cast<int64_t>(column) * numBins / columns);
+    }
+}
+
+void SpectrumHistoryRing::prepare(int numBins, int capacity)
+{
+    jassert(numBins > 0 && numBins <= 0xffff);
+    jassert(capacity > 0);
+
+    numBins_ = numBins;
+    capacity_ = capacity;
+    slots_.reset(new Slot[(size_t) capacity]);
+    rows_.assign((size_t) capacity * (size_t) getRowSize(numBins), 0.0f);
+    accum_.assign((size_t) getRowSize(numBins), 0.0f);
+    written_.store(0, std::memory_order_release);
+    setResolution({});
+    resetAccumulation();
+}
+
+float SpectrumHistoryRing::getColumnCentreBin(int column, int columns, int numBins) noexcept
+{
+    const int first = columnStart(column, columns, numBins);
+    const int end = columnStart(column + 1, columns, numBins);
+    return 0.5f * static_cast<float>(first + end - 1);
+}
+
+uint32_t SpectrumHistoryRing::pack(Resolution resolution) noexcept
+{
+    return static_cast<uint32_t>(resolution.columns)
+         | (static_cast<uint32_t>(resolution.framesPerRow - 1) << 16)
+         | (resolution.reduction == Reduction::Decimate ? (1u << 24) : 0u);
+}
+
+SpectrumHistoryRing::Resolution SpectrumHistoryRing::unpack(uint32_t packed) noexcept
+{
+    Resolution resolution;
+    resolution.columns = static_cast<int>(packed & 0xffffu);
+    resolution.framesPerRow = static_cast<int>((packed >> 16) & 0xffu) + 1;
+    resolution.reduction = (packed & (1u << 24)) != 0 ? Reduction::Decimate : Reduction::PeakHold;
+    return resolution;
+}
+
+void SpectrumHistoryRing::setResolution(Resolution resolution) noexcept
+{
+    resolution.columns = (resolution.columns <= 0) ? numBins_ : std::min(resolution.columns, numBins_);
+    resolution.framesPerRow = juce::jlimit(1, kMaxFramesPerRow, resolution.framesPerRow);
+    resolution_.store(pack(resolution), std::memory_order_relaxed);
+}
+
+SpectrumHistoryRing::Resolution SpectrumHistoryRing::getResolution() const noexcept
+{
+    return unpack(resolution_.load(std::memory_order_relaxed));
+}
+
+void SpectrumHistoryRing::resetAccumulation() noexcept
+{
+    rowFrames_ = 0;
+}
+
+void SpectrumHistoryRing::push(juce::Span<const float> magnitudes, juce::Span<const float> tonal,
+                               juce::Span<const float> transient, juce::Span<const float> noise) noexcept
+{
+    if (numBins_ == 0)
+        return;
+
+    // A row keeps the resolution it started with, so a change never mixes two.
+    if (rowFrames_ == 0)
+        rowResolution_ = getResolution();
+
+    const float* planes[kNumPlanes] = { magnitudes.data(), tonal.data(), transient.data(), noise.data() };
+    const size_t sizes[kNumPlanes] = { magnitudes.size(), tonal.size(), transient.size(), noise.size() };
+    for (int p = 0; p < kNumPlanes; ++p)
+    {
+        jassert(sizes[p] == 0 || sizes[p] == (size_t) numBins_);
+        if (sizes[p] != (size_t) numBins_)
+            planes[p] = nullptr;                // Zeros
+    }
+
+    ++rowFrames_;
+    const bool lastOfRow = rowFrames_ >= rowResolution_.framesPerRow;
+
+    // Decimation only ever looks at the row's last frame.
+    if (rowResolution_.reduction == Reduction::PeakHold || lastOfRow)
+        reduceFrame(planes, rowFrames_ == 1);
+
+    if (lastOfRow)
+    {
+        writeRow();
+        rowFrames_ = 0;
+    }
+}
+
+void SpectrumHistoryRing::reduceFrame(const float* const* planes, bool firstOfRow) noexcept
+{
+    const int columns = rowResolution_.columns;
+    const bool decimate = rowResolution_.reduction == Reduction::Decimate;
+    const bool overwrite = firstOfRow || decimate;
+
+    for (int p = 0; p < kNumPlanes; ++p)
+    {
+        const float* src = planes[p];
+        float* dst = accum_.data() + (size_t) p * (size_t) columns;
+        const bool isMagnitude = (p == 0);
+
+        if (columns == numBins_)
+        {
+            // Full resolution: the frame itself, folded into the row.
+            if (src == nullptr)
+            {
+                if (overwrite)
+                    juce::FloatVectorOperations::clear(dst, columns);
+            }
+            else if (overwrite)
+                juce::FloatVectorOperations::copy(dst, src, columns);
+            else if (isMagnitude)
+                juce::FloatVectorOperations::max(dst, dst, src, columns);
+            else
+                juce::FloatVectorOperations::add(dst, src, columns);
+            continue;
+        }
+
+        for (int c = 0; c < columns; ++c)
+        {
+            const int first = columnStart(c, columns, numBins_);
+            const int end = columnStart(c + 1, columns, numBins_);
+            float value = 0.0f;
+            if (src != nullptr)
+            {
+                if (decimate)
+                    value = src[(first + end - 1) / 2];
+                else if (isMagnitude)
+                    value = *std::max_element(src + first, src + end);
+                else
+                    value = std::accumulate(src + first, src + end, 0.0f) / static_cast<float>(end - first);
+            }
+
+            if (overwrite)
+                dst[c] = value;
+            else if (isMagnitude)
+                dst[c] = std::max(dst[c], value);
+            else
+                dst[c] += value;
+        }
+    }
+}
+
+void SpectrumHistoryRing::writeRow() noexcept
+{
+    const int columns = rowResolution_.columns;
+    const int rowSize = getRowSize(columns);
+
+    // Summed masks back to a mean over the row's frames.
+    if (rowResolution_.reduction == Reduction::PeakHold && rowResolution_.framesPerRow > 1)
+        juce::FloatVectorOperations::multiply(accum_.data() + columns,
+                                              1.0f / static_cast<float>(rowResolution_.framesPerRow),
+                                              rowSize - columns);
+
+    // Single writer: written_ is only ever stored by this thread.
+    const uint64_t index = written_.load(std::memory_order_relaxed);
+    const size_t slotIndex = static_cast<size_t>(index % static_cast<uint64_t>(capacity_));
+    auto& slot = slots_[slotIndex];
+    float* row = rows_.data() + slotIndex * (size_t) getRowSize(numBins_);
+
+    slot.sequence.fetch_add(1, std::memory_order_relaxed);  // -> odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    std::copy(accum_.data(), accum_.data() + rowSize, row);
+    slot.index = index;
+    slot.columns = columns;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sequence.fetch_add(1, std::memory_order_release);  // -> even: stable
+
+    written_.store(index + 1, std::memory_order_release);
+}
+
+int SpectrumHistoryRing::read(uint64_t& cursor, float* rows, int maxRows, int columns) const noexcept
+{
+    if (capacity_ == 0)
+        return 0;
+
+    const uint64_t written = written_.load(std::memory_order_acquire);
+
+    // Anything older than one ring's worth has been overwritten (and a cursor
+    // ahead of the ring is from before a prepare()).
+    const auto capacity = static_cast<uint64_t>(capacity_);
+    if (cursor > written || written - cursor > capacity)
+        cursor = written > capacity ? written - capacity : 0;
+
+    const int rowSize = getRowSize(columns);
+    int count = 0;
+    for (; cursor < written && count < maxRows; ++cursor)
+    {
+        const size_t slotIndex = static_cast<size_t>(cursor % static_cast<uint64_t>(capacity_));
+        const auto& slot = slots_[slotIndex];
+        const uint32_t s1 = slot.sequence.load(std::memory_order_acquire);
+        if ((s1 & 1u) || slot.columns != columns)
+            continue;                                   // Being rewritten, or another resolution
+
+        const float* row = rows_.data() + slotIndex * (size_t) getRowSize(numBins_);
+        float* out = rows + (size_t) count * (size_t) rowSize;
+        std::copy(row, row + rowSize, out);
+        const uint64_t index = slot.index;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != s1 || index != cursor)
+            continue;                                   // Torn, or already a newer row
+
+        ++count;
+    }
+    return count;
+}
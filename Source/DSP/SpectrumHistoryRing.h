@@ -0,0 +1,135 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * SpectrumHistoryRing - recent analysis frames for the editor, one row each
+ *
+ * The engine pushes every analysis frame (magnitudes plus the tonal,
+ * transient and noise masks) as it finishes it; the editor drains whatever
+ * arrived since its last repaint in one read(). A single latest-frame
+ * snapshot loses the two or three frames produced between 30 Hz polls and
+ * can hand the reader a torn frame to retry; here nothing is lost until the
+ * reader falls a whole ring behind, which is what a scrolling spectrogram
+ * needs.
+ *
+ * Single producer (whichever thread runs channel 0's frames in that block;
+ * the engine joins its workers before the block returns), single consumer.
+ * Each slot is a seqlock like DspProfiler::Ring's: push() is wait-free, and
+ * the reader drops a row the writer lapped mid-copy.
+ *
+ * The reader sets the resolution it will draw at, and the writer reduces to
+ * it before writing, so the audio thread copies only what is displayed:
+ *
+ * - columns: bins are grouped into this many equal runs (all bins = none).
+ * - framesPerRow: this many frames make one row.
+ * - Reduction::PeakHold: a row's magnitude is the loudest bin and frame of
+ *   its group; masks are averaged, so the three still sum to one.
+ *   Reduction::Decimate: the centre bin of the group's last frame; the other
+ *   frames are never read.
+ *
+ * Rows are laid out [magnitudes | tonal | transient | noise], `columns`
+ * floats each.
+ *
+ * RT-safety: prepare() allocates and must not overlap push() or read();
+ * everything else is allocation-free.
+ */
+class SpectrumHistoryRing
+{
+public:
+    enum class Reduction
+    {
+        PeakHold,   ///< Loudest magnitude, mean masks over the group
+        Decimate    ///< One bin of one frame per group
+    };
+
+    struct Resolution
+    {
+        int columns = 0;        ///< 0 or numBins and up = every bin
+        int framesPerRow = 1;   ///< 1 to kMaxFramesPerRow
+        Reduction reduction = Reduction::PeakHold;
+    };
+
+    static constexpr int kNumPlanes = 4;            ///< Magnitudes, tonal, transient, noise
+    static constexpr int kDefaultCapacity = 64;     ///< About 0.7 s at 2048/512, 48 kHz
+    static constexpr int kMaxFramesPerRow = 256;
+
+    SpectrumHistoryRing() = default;
+
+    /** Size the ring for a bin count (allocates; full resolution, no rows). */
+    void prepare(int numBins, int capacity = kDefaultCapacity);
+
+    int getNumBins() const noexcept { return numBins_; }
+    int getCapacity() const noexcept { return capacity_; }
+
+    /** Floats in one row at a column count (kNumPlanes × columns). */
+    static int getRowSize(int columns) noexcept { return kNumPlanes * columns; }
+
+    /** Centre of a column's run of bins, in (fractional) bins. */
+    static float getColumnCentreBin(int column, int columns, int numBins) noexcept;
+
+    /**
+     * Reader: resolution for rows started from now on (clamped to the bin
+     * count; a row already being accumulated finishes at the old one).
+     */
+    void setResolution(Resolution resolution) noexcept;
+
+    /** The resolution last set, as clamped. */
+    Resolution getResolution() const noexcept;
+
+    /**
+     * Writer: add one analysis frame (each span numBins long, or empty for a
+     * frame of zeros, e.g. while bypassed).
+     */
+    void push(juce::Span<const float> magnitudes, juce::Span<const float> tonal,
+              juce::Span<const float> transient, juce::Span<const float> noise) noexcept;
+
+    /** Writer: drop a partly accumulated row (call with the engine's reset). */
+    void resetAccumulation() noexcept;
+
+    /**
+     * Reader: copy rows written since `cursor`, oldest first, and advance the
+     * cursor. Rows at another column count (from before a resolution change)
+     * and rows the writer overwrote are skipped.
+     * @param rows     Output, maxRows × getRowSize(columns) floats
+     * @param columns  The column count the reader set
+     * @return Number of rows written to `rows`
+     */
+    int read(uint64_t& cursor, float* rows, int maxRows, int columns) const noexcept;
+
+    /** Rows written so far. */
+    uint64_t getNumWritten() const noexcept { return written_.load(std::memory_order_acquire); }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence { 0 };
+        uint64_t index = 0;
+        int columns = 0;
+    };
+
+    static uint32_t pack(Resolution resolution) noexcept;
+    static Resolution unpack(uint32_t packed) noexcept;
+
+    void reduceFrame(const float* const* planes, bool firstOfRow) noexcept;
+    void writeRow() noexcept;
+
+    int numBins_ = 0;
+    int capacity_ = 0;
+
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<float> rows_;                   ///< capacity × getRowSize(numBins)
+    std::atomic<uint64_t> written_ { 0 };
+    std::atomic<uint32_t> resolution_ { 0 };
+
+    // Writer only: the row being accumulated, at the resolution it started with.
+    std::vector<float> accum_;                  ///< getRowSize(numBins)
+    Resolution rowResolution_;
+    int rowFrames_ = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumHistoryRing)
+};
@@ -1,4 +1,5 @@
 #include "SpectrumDisplay.h"
+#include <algorithm>
 #include <cmath>
 
 SpectrumDisplay::SpectrumDisplay()
@@ -19,9 +20,28 @@ SpectrumDisplay::~SpectrumDisplay()
     stopTimer();
 }
 
-void SpectrumDisplay::setSnapshotCallback(SnapshotCallback cb)
+void SpectrumDisplay::setSpectrumHistory(SpectrumHistoryRing* history)
 {
-    getSnapshot = std::move(cb);
+    history_ = history;
+    historyCursor_ = history_ != nullptr ? history_->getNumWritten() : 0;
+    historyColumns_ = 0;
+    updateHistoryResolution();
+}
+
+void SpectrumDisplay::updateHistoryResolution()
+{
+    if (history_ == nullptr)
+        return;
+
+    const int numBins = history_->getNumBins();
+    SpectrumHistoryRing::Resolution resolution;
+    resolution.columns = useLogScale ? numBins : juce::jlimit(1, numBins, getWidth() > 0 ? getWidth() : numBins);
+    resolution.reduction = SpectrumHistoryRing::Reduction::PeakHold;
+    history_->setResolution(resolution);
+
+    historyColumns_ = history_->getResolution().columns;
+    historyRows_.resize((size_t) history_->getCapacity()
+                        * (size_t) SpectrumHistoryRing::getRowSize(historyColumns_));
 }
 
 void SpectrumDisplay::setEnabled(bool shouldBeEnabled)
@@ -55,84 +75,214 @@ void SpectrumDisplay::updateTimerState()
 
 void SpectrumDisplay::setSampleRate(double sampleRate)
 {
+    // The editor calls this on every tick; only a change moves anything.
+    if (sampleRate == currentSampleRate)
+        return;
+
     currentSampleRate = sampleRate;
-    repaint();
+    invalidateLayout();
+}
+
+void SpectrumDisplay::setAnalysisFftSize(int fftSize)
+{
+    if (fftSize == analysisFftSize_)
+        return;
+
+    analysisFftSize_ = fftSize;
+    invalidateLayout();
 }
 
 void SpectrumDisplay::setLogScale(bool useLog)
 {
     useLogScale = useLog;
+    updateHistoryResolution();
+    invalidateLayout();
+}
+
+void SpectrumDisplay::invalidateLayout()
+{
+    layerScale_ = 0.0f;
+    rebuildPixelColumns();
+    updateColumnGeometry();
     repaint();
 }
 
 void SpectrumDisplay::timerCallback()
 {
-    if (!isEnabled || !getSnapshot)
+    if (!isEnabled || history_ == nullptr || historyColumns_ <= 0)
         return;
 
-    // Pull a consistent snapshot of the latest analysis frame into our own buffers.
-    if (!getSnapshot(snapMag_, snapTonal_, snapTransient_, snapNoise_))
+    // One bulk copy of every frame since the last repaint (rows written at a
+    // previous resolution are skipped by the read).
+    const int numColumns = historyColumns_;
+    const int rowSize = SpectrumHistoryRing::getRowSize(numColumns);
+    const int numRows = history_->read(historyCursor_, historyRows_.data(), history_->getCapacity(), numColumns);
+    if (numRows <= 0)
         return;
 
-    const int numBins = static_cast<int>(snapMag_.size());
-    if (numBins <= 0)
-        return;
+    // Resize display buffers if the column count changed
+    if (cachedNumBins != numColumns)
+    {
+        cachedNumBins = numColumns;
+        if (sourceNumBins_ != history_->getNumBins())
+            layerScale_ = 0.0f;     // The axis spans the source bins (getTopFrequency())
+        sourceNumBins_ = history_->getNumBins();
+        displayMagnitudes.assign(static_cast<size_t>(numColumns), 0.0f);
+        displayTonalMask.assign(static_cast<size_t>(numColumns), 0.33f);
+        displayTransientMask.assign(static_cast<size_t>(numColumns), 0.33f);
+        displayNoiseMask.assign(static_cast<size_t>(numColumns), 0.34f);
+        rebuildPixelColumns();
+        repaint();
+    }
 
-    // Resize display buffers if the bin count changed
-    if (cachedNumBins != numBins)
+    // Magnitudes peak-hold across the frames since the last repaint, so a
+    // transient between repaints still shows; the masks are the newest frame's.
+    float* magnitudes = historyRows_.data();
+    for (int row = 1; row < numRows; ++row)
     {
-        cachedNumBins = numBins;
-        displayMagnitudes.resize(static_cast<size_t>(numBins), 0.0f);
-        displayTonalMask.resize(static_cast<size_t>(numBins), 0.33f);
-        displayTransientMask.resize(static_cast<size_t>(numBins), 0.33f);
-        displayNoiseMask.resize(static_cast<size_t>(numBins), 0.34f);
+        const float* other = historyRows_.data() + (size_t) row * (size_t) rowSize;
+        for (int c = 0; c < numColumns; ++c)
+            magnitudes[c] = juce::jmax(magnitudes[c], other[c]);
     }
+    const float* newest = historyRows_.data() + (size_t) (numRows - 1) * (size_t) rowSize;
+    const float* tonal = newest + numColumns;
+    const float* transient = tonal + numColumns;
+    const float* noise = transient + numColumns;
 
-    // Detect whether the snapshot carries any real energy (silent / bypassed
+    // Detect whether the frames carry any real energy (silent / bypassed
     // frames are all zeros) so paint() can show a "waiting for audio" hint.
     float maxMag = 0.0f;
-    for (float m : snapMag_)
-        maxMag = juce::jmax(maxMag, m);
+    for (int c = 0; c < numColumns; ++c)
+        maxMag = juce::jmax(maxMag, magnitudes[c]);
+    const bool hadSignal = hasSignal_;
     hasSignal_ = maxMag > 1.0e-3f;
+    if (hasSignal_ != hadSignal)
+        repaint();
 
-    // Smooth the display data toward the snapshot
-    for (size_t i = 0; i < snapMag_.size() && i < displayMagnitudes.size(); ++i)
-        displayMagnitudes[i] = displayMagnitudes[i] * (1.0f - smoothingCoeff) + snapMag_[i] * smoothingCoeff;
+    // Smooth the display data toward the new frames
+    for (size_t i = 0; i < displayMagnitudes.size(); ++i)
+        displayMagnitudes[i] = displayMagnitudes[i] * (1.0f - smoothingCoeff) + magnitudes[i] * smoothingCoeff;
 
-    for (size_t i = 0; i < snapTonal_.size() && i < displayTonalMask.size(); ++i)
-        displayTonalMask[i] = displayTonalMask[i] * (1.0f - smoothingCoeff) + snapTonal_[i] * smoothingCoeff;
+    for (size_t i = 0; i < displayTonalMask.size(); ++i)
+        displayTonalMask[i] = displayTonalMask[i] * (1.0f - smoothingCoeff) + tonal[i] * smoothingCoeff;
 
-    for (size_t i = 0; i < snapTransient_.size() && i < displayTransientMask.size(); ++i)
-        displayTransientMask[i] = displayTransientMask[i] * (1.0f - smoothingCoeff) + snapTransient_[i] * smoothingCoeff;
+    for (size_t i = 0; i < displayTransientMask.size(); ++i)
+        displayTransientMask[i] = displayTransientMask[i] * (1.0f - smoothingCoeff) + transient[i] * smoothingCoeff;
 
-    for (size_t i = 0; i < snapNoise_.size() && i < displayNoiseMask.size(); ++i)
-        displayNoiseMask[i] = displayNoiseMask[i] * (1.0f - smoothingCoeff) + snapNoise_[i] * smoothingCoeff;
+    for (size_t i = 0; i < displayNoiseMask.size(); ++i)
+        displayNoiseMask[i] = displayNoiseMask[i] * (1.0f - smoothingCoeff) + noise[i] * smoothingCoeff;
 
-    repaint();
+    // Repaint only the strip of pixel columns whose curves moved. A settled
+    // display (silence, a held drone) repaints nothing at all.
+    const auto dirty = updateColumnGeometry();
+    if (! dirty.isEmpty())
+        repaint(dirty);
 }
 
-void SpectrumDisplay::paint(juce::Graphics& g)
+void SpectrumDisplay::rebuildPixelColumns()
+{
+    // Consecutive bins that land in the same pixel column share one vertex:
+    // the top octaves of a 1025-bin frame collapse to a few hundred points,
+    // while low bins (wider than a pixel on the log axis) keep one each.
+    pixelColumns_.clear();
+    const float width = static_cast<float>(getWidth());
+    if (cachedNumBins <= 1 || width <= 0.0f)
+        return;
+
+    pixelColumns_.reserve(static_cast<size_t>(juce::jmin(cachedNumBins, getWidth() + 1)));
+    int lastPixel = -1;
+    for (int bin = 1; bin < cachedNumBins; ++bin)  // Skip DC
+    {
+        const float x = binToX(bin, cachedNumBins, width);
+        const int pixel = static_cast<int>(x);
+        if (pixel == lastPixel)
+            pixelColumns_.back().endBin = bin + 1;
+        else
+            pixelColumns_.push_back({ bin, bin + 1, x });
+        lastPixel = pixel;
+    }
+
+    const size_t n = pixelColumns_.size();
+    spectrumY_.assign(n, 0.0f);
+    tonalY_.assign(n, 0.0f);
+    stackY_.assign(n, 0.0f);
+}
+
+juce::Rectangle<int> SpectrumDisplay::updateColumnGeometry()
 {
-    drawBackground(g);
+    const float height = static_cast<float>(getHeight());
+    const float bandH = height * kRibbonHeight;
+    juce::Rectangle<int> dirty;
+
+    for (size_t i = 0; i < pixelColumns_.size(); ++i)
+    {
+        const auto& column = pixelColumns_[i];
 
+        // Spectrum: the loudest bin of the column, so a narrow peak survives.
+        // Ribbon: the column's mean split (still mass-conserving).
+        float peak = 0.0f, tonal = 0.0f, transient = 0.0f;
+        for (int bin = column.firstBin; bin < column.endBin; ++bin)
+        {
+            peak = juce::jmax(peak, displayMagnitudes[(size_t) bin]);
+            tonal += juce::jlimit(0.0f, 1.0f, displayTonalMask[(size_t) bin]);
+            transient += juce::jlimit(0.0f, 1.0f, displayTransientMask[(size_t) bin]);
+        }
+        const float count = static_cast<float>(column.endBin - column.firstBin);
+        tonal /= count;
+        transient /= count;
+
+        const float spectrumY = dbToY(magnitudeToDb(peak), height);
+        const float tonalY = height - tonal * bandH;
+        const float stackY = height - juce::jmin(1.0f, tonal + transient) * bandH;
+
+        // Half a pixel is below what anti-aliasing shows.
+        const bool moved = std::abs(spectrumY - spectrumY_[i]) >= 0.5f
+                        || std::abs(tonalY - tonalY_[i]) >= 0.5f
+                        || std::abs(stackY - stackY_[i]) >= 0.5f;
+        spectrumY_[i] = spectrumY;
+        tonalY_[i] = tonalY;
+        stackY_[i] = stackY;
+
+        if (moved)
+        {
+            // The segments either side of this vertex move with it.
+            const float left = i > 0 ? pixelColumns_[i - 1].x : 0.0f;
+            const float right = i + 1 < pixelColumns_.size() ? pixelColumns_[i + 1].x : static_cast<float>(getWidth());
+            const auto strip = juce::Rectangle<int>(static_cast<int>(left) - 1, 0,
+                                                    static_cast<int>(right - left) + 3, getHeight());
+            dirty = dirty.isEmpty() ? strip : dirty.getUnion(strip);
+        }
+    }
+    return dirty;
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
     if (!isEnabled)
     {
+        drawBackground(g);
         g.setColour(juce::Colour(0xff666666));
         g.setFont(juce::FontOptions(Theme::fontLabel));
         g.drawText("Spectrum Display", getLocalBounds(), juce::Justification::centred);
         return;
     }
 
-    // cachedNumBins is set on the first successful snapshot, so it doubles as
-    // a "have any frames been published yet?" flag — no separate `hasValidData`
-    // tracking needed.
-    if (cachedNumBins > 0)
+    // Grid below the curves, labels above them; both cached (see ensureLayers).
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    ensureLayers(scale);
+    const auto unscale = juce::AffineTransform::scale(1.0f / layerScale_);
+    g.drawImageTransformed(backgroundLayer_, unscale);
+
+    // cachedNumBins is set on the first frames read, so it doubles as a
+    // "have any frames been published yet?" flag — no separate
+    // `hasValidData` tracking needed.
+    if (cachedNumBins > 0 && ! pixelColumns_.empty())
     {
         drawSpectrum(g);
         drawMasks(g);
     }
 
-    drawLabels(g);
+    g.drawImageTransformed(labelLayer_, unscale);
 
     // Empty state: nothing flowing yet (silent / bypassed) — tell the user the
     // display is alive and waiting rather than just showing a flat line.
@@ -146,7 +296,36 @@ void SpectrumDisplay::paint(juce::Graphics& g)
 
 void SpectrumDisplay::resized()
 {
-    // Nothing specific needed
+    // The linear axis asks for about one column per pixel.
+    if (!useLogScale)
+        updateHistoryResolution();
+    invalidateLayout();
+}
+
+void SpectrumDisplay::ensureLayers(float scale)
+{
+    if (scale == layerScale_ && backgroundLayer_.isValid())
+        return;
+
+    // Rendered at the display's physical pixel scale, so a retina screen
+    // gets full-resolution text and grid lines from the cached images.
+    layerScale_ = scale;
+    const int w = juce::jmax(1, juce::roundToInt(static_cast<float>(getWidth()) * scale));
+    const int h = juce::jmax(1, juce::roundToInt(static_cast<float>(getHeight()) * scale));
+
+    backgroundLayer_ = juce::Image(juce::Image::RGB, w, h, false);
+    {
+        juce::Graphics layer(backgroundLayer_);
+        layer.addTransform(juce::AffineTransform::scale(scale));
+        drawBackground(layer);
+    }
+
+    labelLayer_ = juce::Image(juce::Image::ARGB, w, h, true);
+    {
+        juce::Graphics layer(labelLayer_);
+        layer.addTransform(juce::AffineTransform::scale(scale));
+        drawLabels(layer);
+    }
 }
 
 void SpectrumDisplay::drawBackground(juce::Graphics& g)
@@ -169,7 +348,7 @@ void SpectrumDisplay::drawBackground(juce::Graphics& g)
 
     // Draw frequency grid lines at musical frequencies, using the same freqToX
     // mapping as the labels and the spectrum so everything lines up.
-    const float nyquist = static_cast<float>(currentSampleRate * 0.5);
+    const float nyquist = getTopFrequency();
     const float freqMarkers[] = {100.0f, 1000.0f, 10000.0f};
 
     for (float freq : freqMarkers)
@@ -185,34 +364,21 @@ void SpectrumDisplay::drawSpectrum(juce::Graphics& g)
     const float width = bounds.getWidth();
     const float height = bounds.getHeight();
 
-    juce::Path spectrumPath;
-    bool pathStarted = false;
-
-    for (int bin = 1; bin < cachedNumBins; ++bin)  // Skip DC
-    {
-        const float x = binToX(bin, cachedNumBins, width);
-        const float db = magnitudeToDb(displayMagnitudes[bin]);
-        const float y = dbToY(db, height);
-
-        if (!pathStarted)
-        {
-            spectrumPath.startNewSubPath(x, y);
-            pathStarted = true;
-        }
-        else
-        {
-            spectrumPath.lineTo(x, y);
-        }
-    }
+    // One vertex per pixel column (see rebuildPixelColumns); the path keeps
+    // its storage between frames.
+    spectrumPath_.clear();
+    spectrumPath_.startNewSubPath(pixelColumns_[0].x, spectrumY_[0]);
+    for (size_t i = 1; i < pixelColumns_.size(); ++i)
+        spectrumPath_.lineTo(pixelColumns_[i].x, spectrumY_[i]);
 
     // Close path to bottom
-    spectrumPath.lineTo(width, height);
-    spectrumPath.lineTo(0.0f, height);
-    spectrumPath.closeSubPath();
+    spectrumPath_.lineTo(width, height);
+    spectrumPath_.lineTo(0.0f, height);
+    spectrumPath_.closeSubPath();
 
     // Fill spectrum
     g.setColour(spectrumColour);
-    g.fillPath(spectrumPath);
+    g.fillPath(spectrumPath_);
 }
 
 void SpectrumDisplay::drawMasks(juce::Graphics& g)
@@ -220,70 +386,55 @@ void SpectrumDisplay::drawMasks(juce::Graphics& g)
     auto bounds = getLocalBounds().toFloat();
     const float width = bounds.getWidth();
     const float height = bounds.getHeight();
-
-    if (cachedNumBins <= 1)
-        return;
+    const size_t n = pixelColumns_.size();
 
     // Bottom "mask ribbon": at each frequency the band [bandTop..bottom] is split
     // into the three streams' actual shares — tonal (blue) at the bottom,
     // transient (yellow) in the middle, noise (orange) on top. Because the masks
     // are mass-conserving (tonal + transient + noise = 1), the three regions
     // exactly fill the band, faithfully showing the per-frequency split.
-    const float bandH   = height * 0.18f;
-    const float bandTop = height - bandH;
+    // tonalY_ is the top of the tonal region, stackY_ the top of tonal +
+    // transient, per pixel column (updateColumnGeometry()).
+    const float bandTop = height - height * kRibbonHeight;
 
-    auto splitTonalY = [&](int bin)
-    {
-        // Top of the tonal region = bottom - tonal * bandH
-        const float t = juce::jlimit(0.0f, 1.0f, displayTonalMask[bin]);
-        return height - t * bandH;
-    };
-    auto splitTransientY = [&](int bin)
-    {
-        // Top of the (tonal + transient) stack = bottom - (tonal+transient)*bandH
-        const float t  = juce::jlimit(0.0f, 1.0f, displayTonalMask[bin]);
-        const float tr = juce::jlimit(0.0f, 1.0f, displayTransientMask[bin]);
-        return height - juce::jmin(1.0f, t + tr) * bandH;
-    };
-
-    // Each path extends to x=0 using bin-1's split height so the three regions
-    // close vertically at the left edge — otherwise the curve from bin 1 back
-    // to x=0 would slope diagonally and leave a visible mass-conservation gap
-    // in the leftmost (~5% in LOG mode) strip.
+    // Each path extends to x=0 using the first column's split height so the
+    // three regions close vertically at the left edge — otherwise the curve
+    // from the first column back to x=0 would slope diagonally and leave a
+    // visible mass-conservation gap in the leftmost (~5% in LOG mode) strip.
 
     // Noise share (orange): bandTop (straight top) down to the tonal+transient split.
-    juce::Path noisePath;
-    noisePath.startNewSubPath(0.0f, bandTop);
-    noisePath.lineTo(width, bandTop);
-    for (int bin = cachedNumBins - 1; bin >= 1; --bin)
-        noisePath.lineTo(binToX(bin, cachedNumBins, width), splitTransientY(bin));
-    noisePath.lineTo(0.0f, splitTransientY(1)); // vertical close at left edge
-    noisePath.closeSubPath();
+    noisePath_.clear();
+    noisePath_.startNewSubPath(0.0f, bandTop);
+    noisePath_.lineTo(width, bandTop);
+    for (size_t i = n; i-- > 0;)
+        noisePath_.lineTo(pixelColumns_[i].x, stackY_[i]);
+    noisePath_.lineTo(0.0f, stackY_[0]); // vertical close at left edge
+    noisePath_.closeSubPath();
     g.setColour(noiseColour);
-    g.fillPath(noisePath);
+    g.fillPath(noisePath_);
 
     // Transient share (yellow): between the (tonal+transient) top curve and the tonal top curve.
-    juce::Path transientPath;
-    transientPath.startNewSubPath(0.0f, splitTransientY(1));   // start at x=0, top of stack
-    for (int bin = 1; bin < cachedNumBins; ++bin)
-        transientPath.lineTo(binToX(bin, cachedNumBins, width), splitTransientY(bin));
-    for (int bin = cachedNumBins - 1; bin >= 1; --bin)
-        transientPath.lineTo(binToX(bin, cachedNumBins, width), splitTonalY(bin));
-    transientPath.lineTo(0.0f, splitTonalY(1));                // vertical close at left edge
-    transientPath.closeSubPath();
+    transientPath_.clear();
+    transientPath_.startNewSubPath(0.0f, stackY_[0]);   // start at x=0, top of stack
+    for (size_t i = 0; i < n; ++i)
+        transientPath_.lineTo(pixelColumns_[i].x, stackY_[i]);
+    for (size_t i = n; i-- > 0;)
+        transientPath_.lineTo(pixelColumns_[i].x, tonalY_[i]);
+    transientPath_.lineTo(0.0f, tonalY_[0]);            // vertical close at left edge
+    transientPath_.closeSubPath();
     g.setColour(transientColour);
-    g.fillPath(transientPath);
+    g.fillPath(transientPath_);
 
     // Tonal share (blue): between the tonal top curve and the bottom (straight).
-    juce::Path tonalPath;
-    tonalPath.startNewSubPath(0.0f, height);
-    tonalPath.lineTo(width, height);
-    for (int bin = cachedNumBins - 1; bin >= 1; --bin)
-        tonalPath.lineTo(binToX(bin, cachedNumBins, width), splitTonalY(bin));
-    tonalPath.lineTo(0.0f, splitTonalY(1)); // vertical close at left edge
-    tonalPath.closeSubPath();
+    tonalPath_.clear();
+    tonalPath_.startNewSubPath(0.0f, height);
+    tonalPath_.lineTo(width, height);
+    for (size_t i = n; i-- > 0;)
+        tonalPath_.lineTo(pixelColumns_[i].x, tonalY_[i]);
+    tonalPath_.lineTo(0.0f, tonalY_[0]); // vertical close at left edge
+    tonalPath_.closeSubPath();
     g.setColour(tonalColour);
-    g.fillPath(tonalPath);
+    g.fillPath(tonalPath_);
 }
 
 void SpectrumDisplay::drawLabels(juce::Graphics& g)
@@ -337,7 +488,7 @@ void SpectrumDisplay::drawFrequencyLabels(juce::Graphics& g)
     // Musical frequency markers, positioned with the same freqToX mapping the
     // spectrum and grid use (so labels sit exactly under their grid lines in
     // both LOG and LIN modes).
-    const float nyquist = static_cast<float>(currentSampleRate * 0.5);
+    const float nyquist = getTopFrequency();
     const float freqMarkers[] = {50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f, 20000.0f};
 
     for (float freq : freqMarkers)
@@ -355,10 +506,32 @@ void SpectrumDisplay::drawFrequencyLabels(juce::Graphics& g)
 
 float SpectrumDisplay::binToFrequency(int bin, int totalBins) const
 {
-    if (totalBins <= 1) return 0.0f;
-    const float nyquist = static_cast<float>(currentSampleRate * 0.5);
-    // Bin (totalBins-1) maps to nyquist for a real FFT (numBins = fftSize/2 + 1).
-    return (static_cast<float>(bin) / static_cast<float>(totalBins - 1)) * nyquist;
+    // `bin` is a display column; with fewer columns than analysis bins it
+    // stands for the centre of its run of bins.
+    const int numBins = sourceNumBins_ > 1 ? sourceNumBins_ : totalBins;
+    if (numBins <= 1) return 0.0f;
+    const float nyquist = getTopFrequency();
+    const float sourceBin = (totalBins == numBins) ? static_cast<float>(bin)
+                                                   : SpectrumHistoryRing::getColumnCentreBin(bin, totalBins, numBins);
+    // Bin (numBins-1) maps to nyquist for a real FFT (numBins = fftSize/2 + 1),
+    // or to the top of the band the scaled engine pushed.
+    return (sourceBin / static_cast<float>(numBins - 1)) * nyquist;
+}
+
+int SpectrumDisplay::getSourceFftSize() const
+{
+    if (analysisFftSize_ > 0)
+        return analysisFftSize_;
+    return (sourceNumBins_ > 1) ? 2 * (sourceNumBins_ - 1) : 2048;
+}
+
+float SpectrumDisplay::getTopFrequency() const
+{
+    const double nyquist = currentSampleRate * 0.5;
+    if (sourceNumBins_ <= 1)
+        return static_cast<float>(nyquist);
+    const double top = (sourceNumBins_ - 1) * currentSampleRate / getSourceFftSize();
+    return static_cast<float>(std::min(nyquist, top));
 }
 
 juce::String SpectrumDisplay::formatFrequency(float freq) const
@@ -371,7 +544,7 @@ juce::String SpectrumDisplay::formatFrequency(float freq) const
 
 float SpectrumDisplay::freqToX(float freq, float width) const
 {
-    const float nyquist = static_cast<float>(currentSampleRate * 0.5);
+    const float nyquist = getTopFrequency();
     if (nyquist <= 0.0f || width <= 0.0f)
         return 0.0f;
 
@@ -406,7 +579,7 @@ float SpectrumDisplay::magnitudeToDb(float magnitude) const
     // Approximate dBFS. The analysis-frame bin magnitude for a full-scale sine
     // through a Hann-windowed FFT peaks near fftSize/4, so normalise by that
     // reference instead of treating the raw bin magnitude as dBFS.
-    const int fftSize = (cachedNumBins > 1) ? 2 * (cachedNumBins - 1) : 2048;
+    const int fftSize = getSourceFftSize();
     const float reference = static_cast<float>(fftSize) * 0.25f;
     const float db = 20.0f * std::log10(magnitude / reference);
     return juce::jlimit(minDb, maxDb, db);
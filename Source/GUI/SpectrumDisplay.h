@@ -2,8 +2,8 @@
 
 #include <JuceHeader.h>
 #include <vector>
-#include <functional>
 #include "Theme.h"
+#include "../DSP/SpectrumHistoryRing.h"
 
 /**
  * SpectrumDisplay - Real-time spectral visualization for tonal/noise separation
@@ -18,27 +18,27 @@
  * - Decibel magnitude scaling
  * - Frequency labels (Hz/kHz)
  * - Smooth visual updates at 30Hz
- * - Efficient rendering using cached paths
+ *
+ * Rendering: the grid and the labels never change between frames, so they
+ * are drawn once into images (at the screen's pixel scale) and blitted; bins
+ * are grouped per pixel column, so a frame draws at most about width vertices
+ * per curve; and a tick repaints only the columns whose curves moved.
  */
 class SpectrumDisplay : public juce::Component,
                         public juce::SettableTooltipClient,
                         private juce::Timer
 {
 public:
-    // Callback that fills the four buffers with a consistent snapshot of the
-    // latest analysis frame (magnitudes + tonal/transient/noise masks). Returns
-    // false if no data is available. The display owns the buffers — it never
-    // reads the processor's live DSP storage.
-    using SnapshotCallback = std::function<bool(std::vector<float>& /* magnitudes */,
-                                                std::vector<float>& /* tonalMask */,
-                                                std::vector<float>& /* transientMask */,
-                                                std::vector<float>& /* noiseMask */)>;
-
     SpectrumDisplay();
     ~SpectrumDisplay() override;
 
-    /** Set the callback used to pull a thread-safe spectrum snapshot from the processor. */
-    void setSnapshotCallback(SnapshotCallback cb);
+    /**
+     * Set the processor's frame history (nullptr = none). Each repaint drains
+     * the frames that arrived since the last one in a single read, and the
+     * display sets the resolution they are written at. The ring must outlive
+     * the display.
+     */
+    void setSpectrumHistory(SpectrumHistoryRing* history);
 
     /**
      * Set the sample rate for accurate frequency display.
@@ -46,6 +46,14 @@ public:
      */
     void setSampleRate(double sampleRate);
 
+    /**
+     * Set the analysis FFT size the history's bins come from. An engine
+     * scaled up for the rate pushes only its lowest bins, so the display
+     * spans those (to 24 kHz at 96 kHz) and not up to Nyquist.
+     * @param fftSize FFT size in samples (0 = 2 × (bins − 1), up to Nyquist)
+     */
+    void setAnalysisFftSize(int fftSize);
+
     /**
      * Toggle between logarithmic and linear frequency scaling.
      * @param useLog True for logarithmic, false for linear
@@ -79,12 +87,25 @@ private:
     // Start/stop the refresh timer to match "enabled AND showing".
     void updateTimerState();
 
-    // Data callback (thread-safe snapshot) + scratch buffers it fills.
-    SnapshotCallback getSnapshot;
-    std::vector<float> snapMag_;
-    std::vector<float> snapTonal_;
-    std::vector<float> snapTransient_;
-    std::vector<float> snapNoise_;
+    // Ask the history for what is drawn: every bin on the log axis (its
+    // low end needs them all), about one column per pixel on the linear one.
+    void updateHistoryResolution();
+
+    // Grid/label images, pixel columns and curve heights are rebuilt on a
+    // resize, scale toggle or sample-rate change.
+    void invalidateLayout();
+    void ensureLayers(float scale);
+    void rebuildPixelColumns();
+
+    // Recompute each pixel column's curve heights from the display data.
+    // @return The area whose curves moved (empty if none did)
+    juce::Rectangle<int> updateColumnGeometry();
+
+    // Frame history (not owned), the read cursor, and the rows read per repaint.
+    SpectrumHistoryRing* history_ = nullptr;
+    uint64_t historyCursor_ = 0;
+    int historyColumns_ = 0;
+    std::vector<float> historyRows_;
 
     // Display settings
     static constexpr float minDb = -80.0f;
@@ -96,7 +117,30 @@ private:
     std::vector<float> displayTonalMask;
     std::vector<float> displayTransientMask;
     std::vector<float> displayNoiseMask;
-    int cachedNumBins = 0;
+    int cachedNumBins = 0;      // Display columns (the history's bins, or fewer)
+    int sourceNumBins_ = 0;     // Analysis bins the columns are reduced from
+
+    // One vertex per pixel column: the display columns [firstBin, endBin)
+    // that land in it, drawn at the first one's x.
+    struct PixelColumn
+    {
+        int firstBin = 0;
+        int endBin = 0;
+        float x = 0.0f;
+    };
+    std::vector<PixelColumn> pixelColumns_;
+    std::vector<float> spectrumY_;  // Loudest bin's dB, as y
+    std::vector<float> tonalY_;     // Top of the tonal share of the ribbon
+    std::vector<float> stackY_;     // Top of the tonal + transient share
+
+    // Static layers (see ensureLayers) and the paths reused every frame.
+    juce::Image backgroundLayer_;
+    juce::Image labelLayer_;
+    float layerScale_ = 0.0f;       // Scale the layers were drawn at (0 = stale)
+    juce::Path spectrumPath_, noisePath_, transientPath_, tonalPath_;
+
+    // Mask ribbon height, as a fraction of the display height
+    static constexpr float kRibbonHeight = 0.18f;
 
     // Smoothing for visual display
     static constexpr float smoothingCoeff = 0.3f;
@@ -106,6 +150,7 @@ private:
     bool hasSignal_ = false;   // true once the snapshot carries non-trivial energy
     bool useLogScale = true;  // Default to logarithmic
     double currentSampleRate = 48000.0;
+    int analysisFftSize_ = 0;   // setAnalysisFftSize()
 
     // Drawing helpers
     void drawBackground(juce::Graphics& g);
@@ -121,6 +166,8 @@ private:
     float dbToY(float db, float height) const;
     float magnitudeToDb(float magnitude) const;
     float binToFrequency(int bin, int totalBins) const;
+    int getSourceFftSize() const;
+    float getTopFrequency() const;  // Frequency of the last source bin (Nyquist unless scaled)
     juce::String formatFrequency(float freq) const;
 
     // Colors
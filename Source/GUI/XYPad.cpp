@@ -92,6 +92,75 @@ XYPad::~XYPad()
 }
 
 void XYPad::paint(juce::Graphics& g)
+{
+    // Everything under the thumb depends only on the size and the view, so
+    // it is drawn once per view into an image (at the screen's pixel scale)
+    // and blitted while the thumb animates.
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    ensureStaticLayer(scale);
+    g.drawImageTransformed(staticLayer_, juce::AffineTransform::scale(1.0f / scale));
+
+    auto bounds = getLocalBounds().toFloat();
+
+    // Draw thumb
+    drawThumb(g);
+    
+    // Draw value readout
+    drawValueReadout(g);
+
+    // Draw minimap when zoomed
+    drawMinimap(g);
+
+    // Draw zoom indicator when zoomed in
+    if (zoomLevel_ > 1.0f)
+    {
+        g.setColour(thumbColour.withAlpha(0.8f));
+        g.setFont(juce::FontOptions(11.0f));
+        juce::String zoomText = juce::String(zoomLevel_, 1) + "x";
+        g.drawText(zoomText,
+                   bounds.getRight() - 70, bounds.getY() + 6,  // Moved left to avoid buttons
+                   34, 14,
+                   juce::Justification::right);
+    }
+
+    // Draw axis labels
+    drawAxisLabels(g);
+
+    // Draw hint text (fades after first use)
+    drawHintText(g);
+
+    // Draw boundary flash when panning hits edge
+    drawBoundaryFlash(g);
+
+    // Border
+    g.setColour(gridColour);
+    g.drawRect(getLocalBounds(), 1);
+
+    // Focus ring for accessibility
+    if (hasFocus_)
+    {
+        g.setColour(thumbColour.withAlpha(0.6f));
+        g.drawRect(getLocalBounds().reduced(2), 3);  // Increased from 2 to 3 for better visibility
+    }
+}
+
+void XYPad::ensureStaticLayer(float scale)
+{
+    const StaticLayerKey key { getWidth(), getHeight(), scale, zoomLevel_, zoomCenterX_, zoomCenterY_ };
+    if (key == staticLayerKey_ && staticLayer_.isValid())
+        return;
+
+    staticLayerKey_ = key;
+    staticLayer_ = juce::Image(juce::Image::RGB,
+                               juce::jmax(1, juce::roundToInt(static_cast<float>(getWidth()) * scale)),
+                               juce::jmax(1, juce::roundToInt(static_cast<float>(getHeight()) * scale)),
+                               false);
+    juce::Graphics layer(staticLayer_);
+    layer.addTransform(juce::AffineTransform::scale(scale));
+    drawStaticLayer(layer);
+}
+
+void XYPad::drawStaticLayer(juce::Graphics& g)
 {
     // Background
     g.fillAll(backgroundColour);
@@ -155,47 +224,6 @@ void XYPad::paint(juce::Graphics& g)
 
     // Draw labels
     drawLabels(g);
-    
-    // Draw thumb
-    drawThumb(g);
-    
-    // Draw value readout
-    drawValueReadout(g);
-
-    // Draw minimap when zoomed
-    drawMinimap(g);
-
-    // Draw zoom indicator when zoomed in
-    if (zoomLevel_ > 1.0f)
-    {
-        g.setColour(thumbColour.withAlpha(0.8f));
-        g.setFont(juce::FontOptions(11.0f));
-        juce::String zoomText = juce::String(zoomLevel_, 1) + "x";
-        g.drawText(zoomText,
-                   bounds.getRight() - 70, bounds.getY() + 6,  // Moved left to avoid buttons
-                   34, 14,
-                   juce::Justification::right);
-    }
-
-    // Draw axis labels
-    drawAxisLabels(g);
-
-    // Draw hint text (fades after first use)
-    drawHintText(g);
-
-    // Draw boundary flash when panning hits edge
-    drawBoundaryFlash(g);
-
-    // Border
-    g.setColour(gridColour);
-    g.drawRect(getLocalBounds(), 1);
-
-    // Focus ring for accessibility
-    if (hasFocus_)
-    {
-        g.setColour(thumbColour.withAlpha(0.6f));
-        g.drawRect(getLocalBounds().reduced(2), 3);  // Increased from 2 to 3 for better visibility
-    }
 }
 
 void XYPad::resized()
@@ -292,6 +320,7 @@ void XYPad::mouseDrag(const juce::MouseEvent& event)
         if (std::abs(newX - desiredX) > 0.001f || std::abs(newY - desiredY) > 0.001f)
         {
             panBoundaryFlash_ = 0.5f;  // Trigger flash
+            wakeAnimation();
         }
 
         zoomCenterX_ = newX;
@@ -431,6 +460,17 @@ void XYPad::timerCallback()
     // whole pad 60x/second while idle.
     if (changed)
         repaint();
+
+    // Settled, with no hint left to fade and no flash to decay: nothing will
+    // change until an edit, an automation update or a pan (wakeAnimation()).
+    if (currentPosition == targetPosition && !showHint_ && panBoundaryFlash_ <= 0.0f)
+        stopTimer();
+}
+
+void XYPad::wakeAnimation()
+{
+    if (isVisible() && !isTimerRunning())
+        startTimerHz(60);
 }
 
 void XYPad::parameterChanged(const juce::String& parameterID, float newValue)
@@ -462,6 +502,7 @@ void XYPad::handleAsyncUpdate()
         noiseNorm = juce::jlimit(0.0f, 1.0f, noiseNorm);
 
         targetPosition = { tonalNorm, 1.0f - noiseNorm }; // Y inverted for UI
+        wakeAnimation();
     }
 }
 
@@ -529,6 +570,8 @@ void XYPad::updateParameters()
         float normalizedValue = range.convertTo0to1(noiseDb);
         noiseParam->setValueNotifyingHost(normalizedValue);
     }
+
+    wakeAnimation();
 }
 
 void XYPad::drawGrid(juce::Graphics& g)
@@ -1064,8 +1107,9 @@ void XYPad::focusLost(FocusChangeType /*cause*/)
 void XYPad::visibilityChanged()
 {
     // Manage timer based on visibility to save CPU when not displayed
+    // (the timer then stops itself once the pad has settled)
     if (isVisible())
-        startTimerHz(60);
+        wakeAnimation();
     else
         stopTimer();
 }
@@ -6,6 +6,10 @@
  * XY Pad component for intuitive 2D control.
  * X-axis: Tonal Gain
  * Y-axis: Noise Gain
+ *
+ * The background (grid, gradients, corner labels) is cached per view and
+ * only the thumb and overlays are drawn per frame; the 60 Hz animation timer
+ * stops once the thumb has settled and restarts on the next change.
  */
 class XYPad : public juce::Component,
               public juce::SettableTooltipClient,
@@ -78,6 +82,21 @@ private:
     bool isDragging = false;
     bool hasFocus_ = false;
 
+    // Cached background, valid for the size, scale and view it was drawn at
+    struct StaticLayerKey
+    {
+        int width = 0, height = 0;
+        float scale = 0.0f, zoom = 0.0f, centreX = 0.0f, centreY = 0.0f;
+
+        bool operator==(const StaticLayerKey& other) const
+        {
+            return width == other.width && height == other.height && scale == other.scale
+                && zoom == other.zoom && centreX == other.centreX && centreY == other.centreY;
+        }
+    };
+    juce::Image staticLayer_;
+    StaticLayerKey staticLayerKey_;
+
     // Panning state (middle mouse button)
     bool isPanning_ = false;
     juce::Point<float> panStartCenter_;      // Zoom center when pan started
@@ -132,6 +151,21 @@ private:
      */
     void updateParameters();
     
+    /**
+     * Redraw the cached background if the size, scale or view changed.
+     */
+    void ensureStaticLayer(float scale);
+
+    /**
+     * Draw everything under the thumb (background, grid, gradients, labels).
+     */
+    void drawStaticLayer(juce::Graphics& g);
+
+    /**
+     * Restart the animation timer (it stops itself when idle).
+     */
+    void wakeAnimation();
+
     /**
      * Draw the background grid.
      */
@@ -22,6 +22,12 @@ namespace ParameterIDs
     const juce::String separation = "separation";      // 0-100%: How aggressively to separate
     const juce::String focus = "focus";                // -100 to +100: Tonal (-) vs Noise (+) bias
     const juce::String spectralFloor = "spectralFloor"; // 0-100%: Extreme isolation gating (default 0=OFF)
+    const juce::String stereoLink = "stereoLink";      // Estimate one mask set for all channels (default OFF)
+    const juce::String lowLatency = "lowLatency";      // Partitioned 256/64 synthesis, ~4 ms (default OFF)
+    const juce::String overlap = "overlap";            // STFT frame overlap: 50 / 75 / 87.5% (default 75%)
+    const juce::String pipelining = "pipelining";      // Spread each frame over its hop's callbacks, +1 hop latency (default OFF)
+    const juce::String analysisGroup = "analysisGroup"; // Share mask estimation with instances in the same group (default OFF)
+    const juce::String autoQuality = "autoQuality";    // Step down to cheaper quality tiers under DSP load (default OFF)
 
     // Post-processing
     const juce::String brightness = "brightness";             // High shelf filter for treble adjustment
@@ -17,15 +17,19 @@ UnravelAudioProcessorEditor::UnravelAudioProcessorEditor(UnravelAudioProcessor&
 
     // Spectrum Display
     spectrumDisplay = std::make_unique<SpectrumDisplay>();
-    spectrumDisplay->setSnapshotCallback(
-        [this](std::vector<float>& mag,
-               std::vector<float>& tonal,
-               std::vector<float>& transient,
-               std::vector<float>& noise)
-        {
-            return audioProcessor.readSpectrumSnapshot(mag, tonal, transient, noise);
-        });
+    spectrumDisplay->setSpectrumHistory(&audioProcessor.getSpectrumHistory());
     spectrumDisplay->setSampleRate(audioProcessor.getSampleRate());
+    spectrumDisplay->setAnalysisFftSize(audioProcessor.getAnalysisFftSize());
+
+    const auto tier = audioProcessor.getQualityTier();
+    if (tier != shownQualityTier)
+    {
+        shownQualityTier = tier;
+        qualityLabel.setText(tier == QualityGovernor::Tier::Full
+                                 ? juce::String()
+                                 : juce::String("Q: ") + QualityGovernor::getTierName(tier),
+                             juce::dontSendNotification);
+    }
     spectrumDisplay->setTooltip("Spectrum Display: Shows the frequency content of your audio. "
                                 "Blue = tonal components, Orange = noise components. "
                                 "Click LOG/LIN to switch between logarithmic and linear frequency scales.");
@@ -65,12 +69,19 @@ UnravelAudioProcessorEditor::UnravelAudioProcessorEditor(UnravelAudioProcessor&
     const int storedH = liveH > 0 ? liveH : static_cast<int>(state.getProperty("editorHeight", defaultHeight));
     setSize(juce::jlimit(480, 750, storedW), juce::jlimit(600, 900, storedH));
 
+   #if UNRAVEL_GPU_EDITOR
+    openGLContext.attachTo(*this);
+   #endif
+
     startTimerHz(30);
 }
 
 UnravelAudioProcessorEditor::~UnravelAudioProcessorEditor()
 {
     stopTimer();
+   #if UNRAVEL_GPU_EDITOR
+    openGLContext.detach();
+   #endif
     // No size persistence here: resized() reports the live size to the
     // processor on every layout, and getStateInformation() stamps it into the
     // saved state. Writing the ValueTree from the destructor would dirty the
@@ -100,6 +111,23 @@ void UnravelAudioProcessorEditor::setupHeader()
     addAndMakeVisible(bypassButton);
     bypassAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.getAPVTS(), ParameterIDs::bypass, bypassButton);
+
+    // Quality tier: blank at full quality, the tier's name while Auto
+    // Quality has stepped the engine down
+    qualityLabel.setFont(juce::FontOptions(Theme::fontSmall).withStyle("Bold"));
+    qualityLabel.setColour(juce::Label::textColourId, textDim);
+    qualityLabel.setJustificationType(juce::Justification::centredRight);
+    qualityLabel.setTooltip("Auto Quality has reduced the analysis to keep up with the DSP load.");
+    addAndMakeVisible(qualityLabel);
+
+   #if UNRAVEL_DSP_PROFILING
+    // DSP load: time in processBlock over the audio it produced
+    cpuLabel.setText("DSP --", juce::dontSendNotification);
+    cpuLabel.setFont(juce::FontOptions(Theme::fontSmall).withStyle("Bold"));
+    cpuLabel.setColour(juce::Label::textColourId, textDim);
+    cpuLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(cpuLabel);
+   #endif
 }
 
 void UnravelAudioProcessorEditor::setupKnobs()
@@ -382,6 +410,11 @@ void UnravelAudioProcessorEditor::resized()
     auto headerRight = header.removeFromRight(72);
     bypassButton.setBounds(headerRight.removeFromRight(64).reduced(2, 8));
 
+   #if UNRAVEL_DSP_PROFILING
+    cpuLabel.setBounds(header.removeFromRight(60).reduced(0, 8));
+   #endif
+    qualityLabel.setBounds(header.removeFromRight(90).reduced(0, 8));
+
     // Center: Preset dropdown
     auto presetArea = header.reduced(20, 8);
     presetLabel.setBounds(presetArea.removeFromLeft(50));
@@ -462,4 +495,39 @@ void UnravelAudioProcessorEditor::resized()
 void UnravelAudioProcessorEditor::timerCallback()
 {
     spectrumDisplay->setSampleRate(audioProcessor.getSampleRate());
+    spectrumDisplay->setAnalysisFftSize(audioProcessor.getAnalysisFftSize());
+
+   #if UNRAVEL_DSP_PROFILING
+    updateLoadReadout();
+   #endif
+}
+
+#if UNRAVEL_DSP_PROFILING
+void UnravelAudioProcessorEditor::updateLoadReadout()
+{
+    // Drain the ring every tick (it holds 128 blocks) but refresh the text at
+    // ~2 Hz so the figure is readable.
+    loadMeter.update(audioProcessor.getProfileRing());
+    if (--loadRefreshCountdown > 0)
+        return;
+    loadRefreshCountdown = 15;
+
+    if (loadMeter.getTicksPerSecond() <= 0.0)
+        return;
+
+    cpuLabel.setText("DSP " + juce::String(loadMeter.getLoadPercent(), 1) + "%", juce::dontSendNotification);
+
+    juce::String tooltip;
+    tooltip << "DSP load " << juce::String(loadMeter.getLoadPercent(), 1) << "% (peak "
+            << juce::String(loadMeter.getPeakLoadPercent(), 1) << "%)\n"
+            << "Per block: " << juce::String(loadMeter.getBlockMicroseconds(), 1) << " us";
+    for (int s = 0; s < DspProfiler::kNumStages; ++s)
+    {
+        const auto stage = static_cast<DspProfiler::Stage>(s);
+        tooltip << "\n  " << DspProfiler::getStageName(stage) << ": "
+                << juce::String(loadMeter.getStageMicroseconds(stage), 1) << " us";
+    }
+    cpuLabel.setTooltip(tooltip);
+    loadMeter.resetPeak();
 }
+#endif
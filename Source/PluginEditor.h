@@ -76,6 +76,24 @@ private:
     // Spectrum scale toggle
     juce::TextButton scaleToggleButton;
 
+    // Quality tier readout (Auto Quality): header label, blank at Full
+    juce::Label qualityLabel;
+    QualityGovernor::Tier shownQualityTier = QualityGovernor::Tier::Full;
+
+   #if UNRAVEL_DSP_PROFILING
+    // DSP load readout (profiling builds only): header label + per-stage tooltip
+    juce::Label cpuLabel;
+    DspProfiler::LoadMeter loadMeter;
+    int loadRefreshCountdown = 0;
+    void updateLoadReadout();
+   #endif
+
+   #if UNRAVEL_GPU_EDITOR
+    // GPU compositing (UNRAVEL_GPU_EDITOR builds): the whole editor renders
+    // through this context; detached before the components go away.
+    juce::OpenGLContext openGLContext;
+   #endif
+
     // Tooltip window (required for tooltips to display)
     // 300ms delay for faster feedback (accessibility improvement)
     juce::TooltipWindow tooltipWindow{this, 300};
@@ -5,15 +5,24 @@
 UnravelAudioProcessor::UnravelAudioProcessor()
      : AudioProcessor(BusesProperties()
                       .withInput("Input", juce::AudioChannelSet::stereo(), true)
-                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+                      .withOutput("Noise Stem", juce::AudioChannelSet::stereo(), false)
+                      .withOutput("Transient Stem", juce::AudioChannelSet::stereo(), false)),
        apvts(*this, nullptr, "Parameters", createParameterLayout())
 {
-    // Pre-size the spectrum snapshot once (bin count is fixed) so prepareToPlay
+    // Size the spectrum history once (bin count is fixed) so prepareToPlay
     // never reallocates the storage the UI reader points at.
-    snapMagnitudes_.assign(static_cast<size_t>(numBins), 0.0f);
-    snapTonalMask_.assign(static_cast<size_t>(numBins), 0.0f);
-    snapTransientMask_.assign(static_cast<size_t>(numBins), 0.0f);
-    snapNoiseMask_.assign(static_cast<size_t>(numBins), 0.0f);
+    spectrumHistory_.prepare(numBins);
+
+    tonalGainParam_     = apvts.getRawParameterValue(ParameterIDs::tonalGain);
+    noisyGainParam_     = apvts.getRawParameterValue(ParameterIDs::noisyGain);
+    transientGainParam_ = apvts.getRawParameterValue(ParameterIDs::transientGain);
+    soloParams_[0] = apvts.getRawParameterValue(ParameterIDs::soloTonal);
+    soloParams_[1] = apvts.getRawParameterValue(ParameterIDs::soloNoise);
+    soloParams_[2] = apvts.getRawParameterValue(ParameterIDs::soloTransient);
+    muteParams_[0] = apvts.getRawParameterValue(ParameterIDs::muteTonal);
+    muteParams_[1] = apvts.getRawParameterValue(ParameterIDs::muteNoise);
+    muteParams_[2] = apvts.getRawParameterValue(ParameterIDs::muteTransient);
 }
 
 UnravelAudioProcessor::~UnravelAudioProcessor()
@@ -149,6 +158,73 @@ juce::AudioProcessorValueTreeState::ParameterLayout UnravelAudioProcessor::creat
         }
     ));
 
+    // Stereo Link: one mask estimate from max(|L|, |R|) applied to both
+    // channels. Halves mask-estimation cost on stereo and keeps a source's
+    // L/R masks identical, so the image cannot wobble. Off by default so
+    // existing sessions render as before.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        ParameterIDs::stereoLink,
+        "Stereo Link",
+        false
+    ));
+
+    // Low Latency: resynthesise on a 256/64 STFT with masks from the usual
+    // 2048/512 analysis (HPSSProcessor::Synthesis::Partitioned), for ~5 ms
+    // latency instead of ~43 ms. Changes the reported latency, so it takes
+    // effect at the next prepareToPlay(). Off by default.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        ParameterIDs::lowLatency,
+        "Low Latency",
+        false
+    ));
+
+    // Overlap: hop of the analysis STFT (STFTProcessor::Overlap). 50% halves
+    // the FFT and mask work for cleanup where artefacts matter less; 87.5%
+    // doubles it for the smoothest overlap-add. Changes the latency (and
+    // the frame rate the estimator runs at), so it takes effect at the
+    // next prepareToPlay(). 75% by default, as before.
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::overlap,
+        "Overlap",
+        juce::StringArray { "50%", "75%", "87.5%" },
+        1
+    ));
+
+    // Pipelining: spread each frame's FFTs, guides and masks over the host
+    // callbacks inside its hop (HPSSProcessor::setPipelining()), so small
+    // buffers see a fraction of a frame per callback instead of all of it
+    // every few callbacks. One hop more latency, so it takes effect at the
+    // next prepareToPlay(). Off by default.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        ParameterIDs::pipelining,
+        "Pipelining",
+        false
+    ));
+
+    // Analysis Group: instances in this process with the same group (a stem
+    // split on parallel sends of one track) estimate each frame's masks once
+    // between them (SharedAnalysis) and still resynthesise their own input,
+    // so their stems sum to the source. The group is joined at the next
+    // prepareToPlay(). Off by default.
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::analysisGroup,
+        "Analysis Group",
+        juce::StringArray { "Off", "1", "2", "3", "4", "5", "6", "7", "8" },
+        0
+    ));
+
+    // Auto Quality: a QualityGovernor watches the callback time and steps
+    // the engine through cheaper quality tiers while the load stays high
+    // (HPSSProcessor::setQualityTier()), and back once it has eased. Every
+    // tier is prepared up front, so it switches on the audio thread without
+    // allocating. Off by default: the engine's quality never depends on how
+    // busy the machine happens to be.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        ParameterIDs::autoQuality,
+        "Auto Quality",
+        false
+    ));
+
     // Brightness: High shelf filter for post-processing treble adjustment
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         ParameterIDs::brightness,
@@ -204,14 +280,15 @@ double UnravelAudioProcessor::getTailLengthSeconds() const
     // one analysis window past the last input — i.e. ~`fftSize` samples (the
     // tight tail is `fftSize - hopSize`; using `fftSize` overshoots by one hop,
     // which is harmless and keeps offline renders from truncating the last frame).
-    if (!channelProcessors.empty() && channelProcessors[0] && currentSampleRate > 0.0)
+    if (hpssProcessor && currentSampleRate > 0.0)
     {
-        const int fftSize = channelProcessors[0]->getFftSize();
+        const int fftSize = hpssProcessor->getFftSize();
         if (fftSize > 0)
             return static_cast<double>(fftSize) / currentSampleRate;
     }
 
-    // Fallback before prepareToPlay: high-quality config (2048) ≈ 43ms at 48k.
+    // Fallback before prepareToPlay: high-quality config (2048) ≈ 43ms at 48k
+    // (the engine scales it with the rate, so the same time at any).
     return 2048.0 / 48000.0;
 }
 
@@ -255,73 +332,94 @@ void UnravelAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
     
     const int numInputChannels = getTotalNumInputChannels();
     
-    // Initialize HPSS processors
-    channelProcessors.clear();
-
-    for (int ch = 0; ch < numInputChannels; ++ch)
-    {
-        auto processor = std::make_unique<HPSSProcessor>(false); // High-quality mode (2048/512); built once here
-        processor->prepare(sampleRate, samplesPerBlock);
-        channelProcessors.push_back(std::move(processor));
-    }
+    // Initialize the HPSS engine with one lane per input channel. High-quality
+    // analysis (2048/512) either way; Low Latency only swaps the synthesis grid.
+    const bool lowLatency = apvts.getRawParameterValue(ParameterIDs::lowLatency)->load() > 0.5f;
+    const int overlapIndex = juce::roundToInt(apvts.getRawParameterValue(ParameterIDs::overlap)->load());
+    const auto overlap = overlapIndex == 0 ? STFTProcessor::Overlap::Half
+                       : overlapIndex == 2 ? STFTProcessor::Overlap::SevenEighths
+                                           : STFTProcessor::Overlap::ThreeQuarters;
+    hpssProcessor = std::make_unique<HPSSProcessor>(false, lowLatency ? HPSSProcessor::Synthesis::Partitioned
+                                                                      : HPSSProcessor::Synthesis::FullFrame,
+                                                    overlap);
+    hpssProcessor->setPipelining(apvts.getRawParameterValue(ParameterIDs::pipelining)->load() > 0.5f);
+    hpssProcessor->setStemOutputs(hasStemBuses());
+    hpssProcessor->prepare(sampleRate, samplesPerBlock, std::max(1, numInputChannels));
+
+    // Above 48 kHz the STFT grows with the rate (same bin width), so the
+    // bins past 48 kHz's Nyquist are the extra ones. Keep the mask work to
+    // the 48 kHz band; the ultrasonic bins pass through unprocessed, so no
+    // gain, solo or mute silently removes them.
+    const int rateScale = STFTProcessor::Config::getSampleRateScale(sampleRate);
+    if (rateScale > 1)
+        hpssProcessor->setActiveBand(0.0f, static_cast<float>(sampleRate * 0.5 / rateScale),
+                                     HPSSProcessor::OutOfBand::PassThrough);
+    analysisFftSize_.store(2 * (hpssProcessor->getNumBins() - 1), std::memory_order_relaxed);
+
+    // Hold the masks through room tone and skip the inverse FFT of digital
+    // silence; far below anything the gains could lift into audibility.
+    hpssProcessor->setSilenceGate(SilenceGate::kDefaultThresholdDb);
+
+    // Masks that start settled after a session load or a transport jump
+    // (before joining a group: the slices warm-start too).
+    hpssProcessor->setWarmStart(true);
+
+    // Join the analysis group for the new engine's layout (allocates and
+    // locks, so here rather than on the audio thread). The old engine,
+    // the only user of the old group pointer, is already gone.
+    const int analysisGroup = juce::roundToInt(apvts.getRawParameterValue(ParameterIDs::analysisGroup)->load());
+    sharedAnalysis_ = analysisGroup > 0
+        ? SharedAnalysisRegistry::join(analysisGroup, hpssProcessor->getSharedAnalysisLayout())
+        : nullptr;
+    hpssProcessor->setSharedAnalysis(sharedAnalysis_.get());
+    expectedTimelineSample_ = -1;
+
+    // Spawn channel workers for wide buses (threads are created here, never
+    // on the audio thread). The audio thread itself takes one share, so at
+    // most channels - 1 helpers, and never more than the spare cores.
+    const int numWorkers = numInputChannels >= kParallelChannelThreshold
+        ? juce::jmin(numInputChannels - 1, juce::SystemStats::getNumCpus() - 1) : 0;
+    if (numWorkers != workerPool_.getNumWorkers())
+        workerPool_.prepare(juce::jmax(0, numWorkers));
+    hpssProcessor->setWorkerPool(workerPool_.getNumWorkers() > 0 ? &workerPool_ : nullptr);
+
+    // A new engine starts at full quality; the linked tier only saves
+    // anything with more than one channel.
+    autoQualityParam_ = apvts.getRawParameterValue(ParameterIDs::autoQuality);
+    qualityGovernor_.reset();
+    qualityGovernor_.setLowestTier(numInputChannels > 1 ? QualityGovernor::Tier::LinkedAnalysis
+                                                        : QualityGovernor::Tier::DecimatedMasks);
+    qualityTier_.store(static_cast<int>(QualityGovernor::Tier::Full), std::memory_order_relaxed);
     
-    // (Per-stream gain smoothers live inside each HPSSProcessor; reset
+    // (Per-stream gain smoothers live inside the HPSSProcessor; reset
     // there in HPSSProcessor::prepare() above. No processor-level smoothers
     // to set up here.)
 
-    // Initialize brightness filter (post-processing high shelf)
+    // Initialize brightness filter (post-processing high shelf): the
+    // coefficient table and per-channel state are built here, off the audio
+    // thread, and start at the current parameter value.
     brightnessParam_ = apvts.getRawParameterValue(ParameterIDs::brightness);
     const float initialBrightness = brightnessParam_ != nullptr ? brightnessParam_->load() : 0.0f;
-    brightnessGainSmoother_.reset(sampleRate, 0.02);  // 20ms ramp
-    brightnessGainSmoother_.setCurrentAndTargetValue(initialBrightness);
-
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<uint32_t>(samplesPerBlock);
-    spec.numChannels = 1;
-
-    for (auto& filter : brightnessFilters_)
-        filter.prepare(spec);
-
-    // Build the high-shelf coefficient table once (allocates here, never on the audio thread)
-    // and point the filters at the entry matching the current parameter value.
-    rebuildBrightnessTable(sampleRate);
-    // Enforce the invariant the audio-thread snap path relies on: every entry
-    // in brightnessCoeffTable_ must be order-2, so juce::dsp::IIR::Filter::reset()
-    // can be called from the audio thread (via applyParameterStateSnapOnAudioThread)
-    // without triggering its conditional state-resize allocation.
-    for ([[maybe_unused]] const auto& coeffs : brightnessCoeffTable_)
-    {
-        jassert(coeffs != nullptr);
-        jassert(coeffs->getFilterOrder() == 2);
-    }
-    for (auto& filter : brightnessFilters_)
-    {
-        filter.coefficients = brightnessCoeffTable_[static_cast<size_t>(brightnessTableIndex(initialBrightness))];
-        // reset() AFTER assigning the order-2 coefficients so the filter's cached order is
-        // synced here (off the audio thread). Otherwise the first processSample() would see the
-        // order change and reallocate filter state on the audio thread. All table entries are
-        // order-2 high shelves, so the per-block coefficient swaps in processBlock never realloc.
-        filter.reset();
-    }
+    brightnessShelf_.prepare(sampleRate, std::max(1, std::max(numInputChannels, getTotalNumOutputChannels())));
+    brightnessShelf_.snapGainDb(initialBrightness);
+   #if UNRAVEL_SPECTRAL_BRIGHTNESS
+    hpssProcessor->snapSpectralBrightness(initialBrightness);
+   #endif
 
-    // Snapshot vectors are construct-only: sized once in the ctor to numBins,
-    // never reallocated, so the UI reader iterates by .size() without sync.
-    // Only zero contents here; storage identity is stable.
-    [[maybe_unused]] const int snapBins = (!channelProcessors.empty() && channelProcessors[0])
-        ? channelProcessors[0]->getNumBins() : numBins;
-    jassert(snapBins == numBins);
-    jassert(snapMagnitudes_.size() == static_cast<size_t>(numBins));
-    std::fill(snapMagnitudes_.begin(),    snapMagnitudes_.end(),    0.0f);
-    std::fill(snapTonalMask_.begin(),     snapTonalMask_.end(),     0.0f);
-    std::fill(snapTransientMask_.begin(), snapTransientMask_.end(), 0.0f);
-    std::fill(snapNoiseMask_.begin(),     snapNoiseMask_.end(),     0.0f);
-    snapSeq_.store(0, std::memory_order_release);
+    // The history ring is construct-only: sized once in the ctor to numBins
+    // and never reallocated (a scaled-up engine pushes its lowest numBins,
+    // the 48 kHz band). Only drop a row the old engine left half built.
+    [[maybe_unused]] const int historyBins = hpssProcessor ? hpssProcessor->getNumBins() : numBins;
+    jassert(historyBins >= spectrumHistory_.getNumBins());
+    spectrumHistory_.resetAccumulation();
+    hpssProcessor->setSpectrumHistory(&spectrumHistory_);
+    hpssProcessor->setGainSource(this);
+    bypassDisplaySamples_ = 0;
 
     // Report latency to host for proper delay compensation
-    if (!channelProcessors.empty() && channelProcessors[0])
+    if (hpssProcessor)
     {
-        setLatencySamples(channelProcessors[0]->getLatencyInSamples());
+        setLatencySamples(hpssProcessor->getLatencyInSamples());
     }
 
     updateParameters();
@@ -329,41 +427,56 @@ void UnravelAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
 
 void UnravelAudioProcessor::releaseResources()
 {
-    channelProcessors.clear();
+    hpssProcessor.reset();
+    sharedAnalysis_.reset();
+    workerPool_.release();
 }
 
 bool UnravelAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    // Input must match output; we support mono and stereo. The per-channel HPSS
-    // pipeline (one processor per input channel) handles either case unchanged,
-    // which lets the plugin load on mono tracks (e.g. dialogue editing).
+    // Input must match output; we support mono, stereo and surround / discrete
+    // layouts up to kMaxChannels. The HPSS engine (one lane per input channel)
+    // handles any count unchanged, which lets the plugin load on mono tracks
+    // (e.g. dialogue editing) and on 5.1 / 7.1 / wider beds.
     const auto& mainIn  = layouts.getMainInputChannelSet();
     const auto& mainOut = layouts.getMainOutputChannelSet();
 
     if (mainIn != mainOut)
         return false;
 
-    return mainIn == juce::AudioChannelSet::mono()
-        || mainIn == juce::AudioChannelSet::stereo();
+    // The stem buses go together, in the main bus's layout (the main output
+    // then carries the tonal stream).
+    if (layouts.outputBuses.size() >= 3)
+    {
+        const auto& noiseOut = layouts.getChannelSet(false, 1);
+        const auto& transientOut = layouts.getChannelSet(false, 2);
+        const bool stemsOff = noiseOut.isDisabled() && transientOut.isDisabled();
+        if (! stemsOff && (noiseOut != mainOut || transientOut != mainOut))
+            return false;
+    }
+
+    return ! mainIn.isDisabled() && mainIn.size() <= kMaxChannels;
 }
 
-void UnravelAudioProcessor::updateParameters() noexcept
+bool UnravelAudioProcessor::hasStemBuses() const
+{
+    return getBusCount(false) >= 3 && getBus(false, 1)->isEnabled() && getBus(false, 2)->isEnabled();
+}
+
+HPSSProcessor::FrameGains UnravelAudioProcessor::computeStreamGains() noexcept
 {
     // Get parameter values from APVTS
-    const float tonalGainDb     = apvts.getRawParameterValue(ParameterIDs::tonalGain)->load();
-    const float noisyGainDb     = apvts.getRawParameterValue(ParameterIDs::noisyGain)->load();
-    const float transientGainDb = apvts.getRawParameterValue(ParameterIDs::transientGain)->load();
-    const float separationPercent = apvts.getRawParameterValue(ParameterIDs::separation)->load();
-    const float focusValue = apvts.getRawParameterValue(ParameterIDs::focus)->load();
-    const float spectralFloorPercent = apvts.getRawParameterValue(ParameterIDs::spectralFloor)->load();
+    const float tonalGainDb     = tonalGainParam_->load();
+    const float noisyGainDb     = noisyGainParam_->load();
+    const float transientGainDb = transientGainParam_->load();
 
     // Get per-stream solo/mute states (three streams)
-    soloTonal     = apvts.getRawParameterValue(ParameterIDs::soloTonal)->load()     > 0.5f;
-    soloNoise     = apvts.getRawParameterValue(ParameterIDs::soloNoise)->load()     > 0.5f;
-    soloTransient = apvts.getRawParameterValue(ParameterIDs::soloTransient)->load() > 0.5f;
-    muteTonal     = apvts.getRawParameterValue(ParameterIDs::muteTonal)->load()     > 0.5f;
-    muteNoise     = apvts.getRawParameterValue(ParameterIDs::muteNoise)->load()     > 0.5f;
-    muteTransient = apvts.getRawParameterValue(ParameterIDs::muteTransient)->load() > 0.5f;
+    soloTonal     = soloParams_[0]->load() > 0.5f;
+    soloNoise     = soloParams_[1]->load() > 0.5f;
+    soloTransient = soloParams_[2]->load() > 0.5f;
+    muteTonal     = muteParams_[0]->load() > 0.5f;
+    muteNoise     = muteParams_[1]->load() > 0.5f;
+    muteTransient = muteParams_[2]->load() > 0.5f;
 
     // Convert dB to linear gain (with -60dB treated as 0 gain)
     auto dbToLinear = [](float db) noexcept
@@ -398,11 +511,33 @@ void UnravelAudioProcessor::updateParameters() noexcept
     if (muteNoise)     noisyGain     = 0.0f;
     if (muteTransient) transientGain = 0.0f;
 
-    // Per-stream gain smoothing happens inside each HPSSProcessor; targets
-    // are set from these values via processBlock's updateParameterSmoothing.
-    currentTonalGain     = tonalGain;
-    currentNoisyGain     = noisyGain;
-    currentTransientGain = transientGain;
+    return { tonalGain, noisyGain, transientGain };
+}
+
+HPSSProcessor::FrameGains UnravelAudioProcessor::getFrameGains(int sampleOffset) noexcept
+{
+    // No sub-block automation reaches a JUCE plugin, so the offset has
+    // nothing to select; the latest values still land on this frame rather
+    // than at the next block.
+    juce::ignoreUnused(sampleOffset);
+    return computeStreamGains();
+}
+
+void UnravelAudioProcessor::updateParameters() noexcept
+{
+    const float separationPercent = apvts.getRawParameterValue(ParameterIDs::separation)->load();
+    const float focusValue = apvts.getRawParameterValue(ParameterIDs::focus)->load();
+    const float spectralFloorPercent = apvts.getRawParameterValue(ParameterIDs::spectralFloor)->load();
+    currentStereoLink = apvts.getRawParameterValue(ParameterIDs::stereoLink)->load() > 0.5f;
+
+    // Per-stream gain smoothing happens inside the HPSSProcessor, which pulls
+    // its per-frame targets through getFrameGains(); these block values pick
+    // the transparent path and shape the floor below.
+    const auto gains = computeStreamGains();
+    const bool anySolo = soloTonal || soloNoise || soloTransient;
+    currentTonalGain     = gains.tonal;
+    currentNoisyGain     = gains.noise;
+    currentTransientGain = gains.transient;
 
     // Update separation parameters (0-100% -> 0-1, -100..+100 -> -1..+1)
     currentSeparation = separationPercent / 100.0f;
@@ -432,17 +567,21 @@ void UnravelAudioProcessor::updateParameters() noexcept
     }
     currentSpectralFloor = std::max(userSpectralFloor, cornerFactor);
 
-    // Apply separation/focus/floor to all channel processors.
+    // Apply separation/focus/floor/link to every channel of the engine.
     // Quality (FFT size) is fixed at construction in prepareToPlay, so nothing
     // here reallocates or changes latency on the audio thread.
-    for (auto& processor : channelProcessors)
+    if (hpssProcessor)
     {
-        if (processor)
-        {
-            processor->setSeparation(currentSeparation);
-            processor->setFocus(currentFocus);
-            processor->setSpectralFloor(currentSpectralFloor);
-        }
+        hpssProcessor->setSeparation(currentSeparation);
+        hpssProcessor->setFocus(currentFocus);
+        hpssProcessor->setSpectralFloor(currentSpectralFloor);
+        hpssProcessor->setChannelLink(currentStereoLink ? HPSSProcessor::ChannelLink::Linked
+                                                        : HPSSProcessor::ChannelLink::Independent);
+       #if UNRAVEL_SPECTRAL_BRIGHTNESS
+        // The shelf rides on the bin gains: no time-domain pass afterwards.
+        if (brightnessParam_ != nullptr)
+            hpssProcessor->setSpectralBrightness(brightnessParam_->load());
+       #endif
     }
 }
 
@@ -450,6 +589,10 @@ void UnravelAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+   #if UNRAVEL_DSP_PROFILING
+    const uint64_t profileStartTicks = DspProfiler::readTicks();
+   #endif
+    const int64_t governorStartTicks = juce::Time::getHighResolutionTicks();
     
     const auto totalNumInputChannels = getTotalNumInputChannels();
     const auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -462,15 +605,15 @@ void UnravelAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     // Handle bypass with HPSS processor built-in bypass
     const bool isBypassed = apvts.getRawParameterValue(ParameterIDs::bypass)->load() > 0.5f;
     
-    // Set bypass state on all processors
-    for (auto& processor : channelProcessors)
-    {
-        if (processor)
-            processor->setBypass(isBypassed);
-    }
+    // Set bypass state on the engine (all channels)
+    if (hpssProcessor)
+        hpssProcessor->setBypass(isBypassed);
     
-    // Update parameters once per block - this gets the current target values
-    updateParameters();
+    // Parameters only act at frames: a block that completes none (small host
+    // buffers) skips the refresh, unless a state snap needs fresh values.
+    const bool frameDue = hpssProcessor == nullptr || hpssProcessor->getSamplesUntilNextFrame() <= numSamples;
+    if (frameDue || snapRequested_.load(std::memory_order_relaxed))
+        updateParameters();
 
     // Pick up any pending message-thread snap request now that the smoother
     // targets reflect the freshly-loaded APVTS values. acquire-exchange
@@ -479,48 +622,92 @@ void UnravelAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     if (snapRequested_.exchange(false, std::memory_order_acq_rel))
         applyParameterStateSnapOnAudioThread();
 
-    // Process each channel with HPSS separation
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    // Process all channels with HPSS separation in one pass (in place:
+    // the engine consumes each channel's input before writing its output).
+    // Wide buses fan out across workerPool_; processBlock joins before it
+    // returns, so the snapshot below always reads settled buffers.
+    const int numEngineChannels = hpssProcessor
+        ? std::min(static_cast<int>(totalNumInputChannels), hpssProcessor->getNumChannels()) : 0;
+    if (numEngineChannels > 0)
     {
-        if (channel >= static_cast<int>(channelProcessors.size()))
-            continue;
-            
-        auto& processor = *channelProcessors[channel];
-        const float* inputData = buffer.getReadPointer(channel);
-        float* outputData = buffer.getWritePointer(channel);
-        
+        syncTimeline(numSamples);
+
         // Process with HPSS using current gain values (updated in updateParameters).
-        processor.processBlock(inputData, outputData,
-                             numSamples,
-                             currentTonalGain,
-                             currentNoisyGain,
-                             currentTransientGain);
+        if (hpssProcessor->hasStemOutputs())
+        {
+            // Tonal in place on the main bus, noise and transient on their own.
+            auto noiseBus = getBusBuffer(buffer, false, 1);
+            auto transientBus = getBusBuffer(buffer, false, 2);
+            hpssProcessor->processStemBlock(buffer.getArrayOfReadPointers(),
+                                            buffer.getArrayOfWritePointers(),
+                                            noiseBus.getArrayOfWritePointers(),
+                                            transientBus.getArrayOfWritePointers(),
+                                            numEngineChannels,
+                                            numSamples,
+                                            currentTonalGain,
+                                            currentNoisyGain,
+                                            currentTransientGain);
+        }
+        else
+        {
+            hpssProcessor->processBlock(buffer.getArrayOfReadPointers(),
+                                        buffer.getArrayOfWritePointers(),
+                                        numEngineChannels,
+                                        numSamples,
+                                        currentTonalGain,
+                                        currentNoisyGain,
+                                        currentTransientGain);
+        }
     }
 
-    // Publish the latest analysis frame for the UI (lock-free; no UI access to live buffers).
-    publishSpectrumSnapshot(isBypassed);
+    // The engine pushes its frames for the UI as it completes them; bypassed,
+    // it completes none, so publish frames of zeros instead.
+    if (isBypassed)
+        publishBypassedFrame(numSamples);
 
-    // Apply brightness filter (post-HPSS high shelf processing)
+    // Apply brightness filter (post-HPSS high shelf processing). Every
+    // channel in one pass; settled at 0 dB the shelf is the identity and
+    // leaves the buffer alone.
+   #if ! UNRAVEL_SPECTRAL_BRIGHTNESS
     if (brightnessParam_ != nullptr)
     {
-        brightnessGainSmoother_.setTargetValue(brightnessParam_->load());
+        // With stem buses, every stream's channels (they follow the main bus).
+        const bool stems = hpssProcessor != nullptr && hpssProcessor->hasStemOutputs();
+        brightnessShelf_.setGainDb(brightnessParam_->load());
+        brightnessShelf_.process(buffer.getArrayOfWritePointers(),
+                                 static_cast<int>(stems ? totalNumOutputChannels : totalNumInputChannels),
+                                 numSamples);
+    }
+   #endif
 
-        // Advance the 20ms smoother across this block and select the matching
-        // precomputed coefficient set. No allocation, no on/off threshold gating:
-        // a 0 dB high shelf is an identity filter, so always processing is transparent
-        // and avoids the click the old threshold produced.
-        const float smoothedBrightness = brightnessGainSmoother_.skip(numSamples);
-        const auto& coeffs = brightnessCoeffTable_[static_cast<size_t>(brightnessTableIndex(smoothedBrightness))];
+    updateQualityGovernor(governorStartTicks, numSamples);
 
-        for (int channel = 0; channel < totalNumInputChannels && channel < 2; ++channel)
-        {
-            brightnessFilters_[channel].coefficients = coeffs;
-            auto* channelData = buffer.getWritePointer(channel);
+   #if UNRAVEL_DSP_PROFILING
+    publishProfileRecord(profileStartTicks, numEngineChannels, numSamples);
+   #endif
+}
 
-            for (int i = 0; i < numSamples; ++i)
-                channelData[i] = brightnessFilters_[channel].processSample(channelData[i]);
-        }
+void UnravelAudioProcessor::updateQualityGovernor(int64_t startTicks, int numSamples) noexcept
+{
+    // Audio thread, end of processBlock: the whole callback's time against
+    // the audio it produced picks the tier the next frames run at.
+    if (hpssProcessor == nullptr || numSamples <= 0)
+        return;
+
+    auto tier = QualityGovernor::Tier::Full;
+    if (autoQualityParam_ != nullptr && autoQualityParam_->load() > 0.5f)
+    {
+        const double elapsed = static_cast<double>(juce::Time::getHighResolutionTicks() - startTicks)
+                             / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        tier = qualityGovernor_.update(elapsed, numSamples / currentSampleRate);
+    }
+    else if (qualityGovernor_.getTier() != QualityGovernor::Tier::Full)
+    {
+        qualityGovernor_.reset();
     }
+
+    hpssProcessor->setQualityTier(tier);
+    qualityTier_.store(static_cast<int>(tier), std::memory_order_relaxed);
 }
 
 void UnravelAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer,
@@ -539,37 +726,90 @@ void UnravelAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buff
 
     // Route through HPSS's bypass delay so output stays PDC-aligned with
     // setLatencySamples (JUCE's default zeros output and breaks parallel routes).
-    for (auto& processor : channelProcessors)
-        if (processor) processor->setBypass(true);
+    if (hpssProcessor)
+        hpssProcessor->setBypass(true);
 
     // Route input through the in-plugin bypass delay line on each channel.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        if (channel >= static_cast<int>(channelProcessors.size()))
-        {
-            // No processor for this channel (e.g. between releaseResources
-            // and the next prepareToPlay). Zero the output rather than
-            // leaving stale input in the buffer.
-            buffer.clear(channel, 0, numSamples);
-            continue;
-        }
+    const int numEngineChannels = hpssProcessor
+        ? std::min(static_cast<int>(totalNumInputChannels), hpssProcessor->getNumChannels()) : 0;
+
+    // Channels without an engine lane (e.g. between releaseResources and the
+    // next prepareToPlay) are zeroed rather than left holding stale input.
+    for (int channel = numEngineChannels; channel < totalNumInputChannels; ++channel)
+        buffer.clear(channel, 0, numSamples);
 
-        auto& processor = *channelProcessors[channel];
-        const float* inputData  = buffer.getReadPointer(channel);
-        float*       outputData = buffer.getWritePointer(channel);
+    if (numEngineChannels > 0)
+    {
         // Pass unity gains: HPSS's bypass path short-circuits to the delay
         // line regardless, but call it consistently with the active
         // processBlock so future maintenance doesn't drift.
-        processor.processBlock(inputData, outputData, numSamples, 1.0f, 1.0f, 1.0f);
+        hpssProcessor->processBlock(buffer.getArrayOfReadPointers(),
+                                    buffer.getArrayOfWritePointers(),
+                                    numEngineChannels, numSamples, 1.0f, 1.0f, 1.0f);
     }
 
+    // The engine's STFT stands still while bypassed: the next processBlock
+    // starts a new stretch rather than jumping from this one.
+    expectedTimelineSample_ = -1;
+
     // Do NOT drain snapRequested_ here — bypass overwrites smoother targets
     // with 1.0, so the snap is deferred to the first un-bypassed processBlock.
 
-    // Publish zero-valued snapshot so the UI reflects bypass state honestly.
-    publishSpectrumSnapshot(true);
+    // Publish zero-valued frames so the UI reflects bypass state honestly.
+    publishBypassedFrame(numSamples);
+}
+
+void UnravelAudioProcessor::syncTimeline(int numSamples) noexcept
+{
+    // After a jump the history belongs to another stretch of the timeline:
+    // restart the analysis there, and the warm start seeds it from the first
+    // frame of the new one. The synthesis runs on, so the output in flight
+    // plays out across a loop wrap or a scrub. Every member of a group sees the jump in the same
+    // callback, at the same timeline position: resyncing there numbers the
+    // frames after it alike in all of them. Stopped, the engines just keep
+    // counting.
+    auto* playHead = getPlayHead();
+    if (playHead == nullptr)
+        return;
+
+    const auto position = playHead->getPosition();
+    if (! position.hasValue() || ! position->getIsPlaying())
+        return;
+
+    const auto timeInSamples = position->getTimeInSamples();
+    if (! timeInSamples.hasValue())
+        return;
+
+    // (The first block after prepare or bypass is a jump for a group, which
+    // has to agree on an epoch; a lone engine just carries on.)
+    if (*timeInSamples != expectedTimelineSample_)
+    {
+        if (sharedAnalysis_ != nullptr)
+            hpssProcessor->resyncSharedAnalysis(*timeInSamples);
+        else if (expectedTimelineSample_ >= 0)
+            hpssProcessor->restartAnalysis();
+    }
+    expectedTimelineSample_ = *timeInSamples + numSamples;
 }
 
+void UnravelAudioProcessor::publishBypassedFrame(int numSamples) noexcept
+{
+    const int hopSize = hpssProcessor ? hpssProcessor->getHopSize() : 0;
+    bypassDisplaySamples_ += numSamples;
+    if (bypassDisplaySamples_ < hopSize)
+        return;
+
+    bypassDisplaySamples_ = 0;
+    spectrumHistory_.push({}, {}, {}, {});
+}
+
+#if UNRAVEL_HAS_AUDIO_WORKGROUP
+void UnravelAudioProcessor::audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup)
+{
+    workerPool_.setAudioWorkgroup(workgroup);
+}
+#endif
+
 // Note: The HPSSProcessor provides a much simpler and more efficient interface
 // compared to the previous SinusoidalModelProcessor, with superior audio quality
 // and dramatically reduced CPU usage through optimized HPSS algorithm.
@@ -633,27 +873,27 @@ void UnravelAudioProcessor::applyParameterStateSnapOnAudioThread() noexcept
     // are responsible for ensuring updateParameters() has run for this block
     // first so the currentXxx caches reflect the freshly-loaded APVTS values.
 
-    // Snap each HPSSProcessor's INTERNAL gain smoothers — those are the ones
+    // Snap the HPSSProcessor's INTERNAL gain smoothers — those are the ones
     // actually advanced per-frame in HPSSProcessor::processBlock. (The
     // PluginProcessor previously also carried three SmoothedValue members
     // with the same names; those were dead state from an earlier refactor
     // and have been removed.)
-    for (auto& processor : channelProcessors)
-        if (processor)
-            processor->snapGainSmoothers(currentTonalGain,
-                                          currentNoisyGain,
-                                          currentTransientGain);
+    if (hpssProcessor)
+        hpssProcessor->snapGainSmoothers(currentTonalGain,
+                                         currentNoisyGain,
+                                         currentTransientGain);
 
     if (brightnessParam_ != nullptr)
-        brightnessGainSmoother_.setCurrentAndTargetValue(brightnessParam_->load());
+    {
+        brightnessShelf_.snapGainDb(brightnessParam_->load());
+       #if UNRAVEL_SPECTRAL_BRIGHTNESS
+        if (hpssProcessor)
+            hpssProcessor->snapSpectralBrightness(brightnessParam_->load());
+       #endif
+    }
 
-    // brightnessFilters_[].reset() can reach a conditional malloc if the
-    // filter's coefficient ORDER changed since prepare(). Enforced by the
-    // jassert in prepareToPlay: every entry of brightnessCoeffTable_ is an
-    // order-2 high shelf built by makeHighShelf, so the order is invariant
-    // and reset() is allocation-free here.
-    for (auto& filter : brightnessFilters_)
-        filter.reset();
+    // Plain float state: clearing it is allocation-free.
+    brightnessShelf_.reset();
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -665,103 +905,28 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 // Visualization Accessors
 // =============================================================================
 
-void UnravelAudioProcessor::publishSpectrumSnapshot(bool bypassed) noexcept
-{
-    // Audio thread: copy the latest analysis frame from channel 0 into the
-    // published snapshot, guarded by a seqlock. Wait-free: two atomic stores
-    // around a fixed-size copy, no allocation, no locks. `bypassed` is the same
-    // value processBlock already loaded — passed in so the snapshot's state can't
-    // disagree with what was actually processed this block.
-    if (channelProcessors.empty() || !channelProcessors[0])
-        return;
-
-    const juce::Span<const float> mag       = bypassed ? juce::Span<const float>{} : channelProcessors[0]->getCurrentMagnitudes();
-    const juce::Span<const float> tonal     = bypassed ? juce::Span<const float>{} : channelProcessors[0]->getCurrentTonalMask();
-    const juce::Span<const float> transient = bypassed ? juce::Span<const float>{} : channelProcessors[0]->getCurrentTransientMask();
-    const juce::Span<const float> noise     = bypassed ? juce::Span<const float>{} : channelProcessors[0]->getCurrentNoiseMask();
-
-    const auto copyOrZero = [](std::vector<float>& dst, juce::Span<const float> src)
-    {
-        const size_t n = dst.size();
-        if (src.size() == n)
-            std::copy(src.begin(), src.end(), dst.begin());
-        else
-            std::fill(dst.begin(), dst.end(), 0.0f);
-    };
-
-    snapSeq_.fetch_add(1, std::memory_order_release);           // -> odd: write in progress
-    std::atomic_thread_fence(std::memory_order_release);
-    copyOrZero(snapMagnitudes_, mag);
-    copyOrZero(snapTonalMask_, tonal);
-    copyOrZero(snapTransientMask_, transient);
-    copyOrZero(snapNoiseMask_, noise);
-    std::atomic_thread_fence(std::memory_order_release);
-    snapSeq_.fetch_add(1, std::memory_order_release);           // -> even: stable
-}
-
-bool UnravelAudioProcessor::readSpectrumSnapshot(std::vector<float>& magnitudes,
-                                                 std::vector<float>& tonalMask,
-                                                 std::vector<float>& transientMask,
-                                                 std::vector<float>& noiseMask) const
-{
-    const size_t n = snapMagnitudes_.size();
-    if (n == 0)
-        return false;
-
-    magnitudes.resize(n);
-    tonalMask.resize(n);
-    transientMask.resize(n);
-    noiseMask.resize(n);
-
-    // Seqlock read: retry on a torn read or while a write is in progress.
-    for (int attempt = 0; attempt < 8; ++attempt)
-    {
-        const uint32_t s1 = snapSeq_.load(std::memory_order_acquire);
-        if (s1 & 1u)
-            continue; // writer mid-update
-
-        std::copy(snapMagnitudes_.begin(),     snapMagnitudes_.end(),     magnitudes.begin());
-        std::copy(snapTonalMask_.begin(),      snapTonalMask_.end(),      tonalMask.begin());
-        std::copy(snapTransientMask_.begin(),  snapTransientMask_.end(),  transientMask.begin());
-        std::copy(snapNoiseMask_.begin(),      snapNoiseMask_.end(),      noiseMask.begin());
-
-        std::atomic_thread_fence(std::memory_order_acquire);
-        if (snapSeq_.load(std::memory_order_acquire) == s1)
-            return true;
-    }
-    return false; // contended; caller keeps its previous frame
+void UnravelAudioProcessor::publishProfileRecord(uint64_t startTicks, int numChannels, int numSamples) noexcept
+{
+    // Audio thread, end of processBlock: the whole callback's ticks plus the
+    // engine's per-stage split. The end stamps let the reader calibrate the
+    // tick rate; nothing here allocates or blocks.
+    DspProfiler::BlockRecord record;
+    if (hpssProcessor)
+        hpssProcessor->collectStageTicks(record);
+    record.endTicks = DspProfiler::readTicks();
+    record.endHighResTicks = juce::Time::getHighResolutionTicks();
+    record.blockTicks = record.endTicks - startTicks;
+    record.numSamples = numSamples;
+    record.numChannels = numChannels;
+    record.sampleRate = getSampleRate();
+    profileRing_.push(record);
 }
 
 int UnravelAudioProcessor::getNumBins() const noexcept
 {
-    if (!channelProcessors.empty() && channelProcessors[0])
+    if (hpssProcessor)
     {
-        return channelProcessors[0]->getNumBins();
+        return hpssProcessor->getNumBins();
     }
     return 0;
-}
-
-void UnravelAudioProcessor::rebuildBrightnessTable(double sampleRate)
-{
-    // Precompute one high-shelf coefficient set per 0.1 dB step across the full
-    // -12..+12 dB range. Called only from prepareToPlay (non-real-time).
-    brightnessCoeffTable_.clear();
-    brightnessCoeffTable_.reserve(kBrightnessTableSize);
-
-    for (int i = 0; i < kBrightnessTableSize; ++i)
-    {
-        const float gainDb = kBrightnessMinDb + static_cast<float>(i) * kBrightnessStepDb;
-        brightnessCoeffTable_.push_back(
-            juce::dsp::IIR::Coefficients<float>::makeHighShelf(
-                sampleRate,
-                kBrightnessFrequency,
-                kBrightnessQ,
-                juce::Decibels::decibelsToGain(gainDb)));
-    }
-}
-
-int UnravelAudioProcessor::brightnessTableIndex(float gainDb) const noexcept
-{
-    const int idx = static_cast<int>(std::round((gainDb - kBrightnessMinDb) / kBrightnessStepDb));
-    return juce::jlimit(0, kBrightnessTableSize - 1, idx);
 }
\ No newline at end of file
@@ -2,10 +2,16 @@
 
 #include <JuceHeader.h>
 #include <juce_dsp/juce_dsp.h>
+#include "DSP/BrightnessShelf.h"
 #include "DSP/HPSSProcessor.h"
+#include "DSP/ChannelWorkerPool.h"
+#include "DSP/SharedAnalysis.h"
+#include "DSP/DspProfiler.h"
+#include "DSP/QualityGovernor.h"
 #include "Parameters/ParameterDefinitions.h"
 
-class UnravelAudioProcessor : public juce::AudioProcessor
+class UnravelAudioProcessor : public juce::AudioProcessor,
+                              private HPSSProcessor::GainSource
 {
 public:
     UnravelAudioProcessor();
@@ -20,14 +26,20 @@ public:
 
     // Host bypass virtual. JUCE's default zeros output channels beyond the
     // input count and does NOT route through any compensating delay. With
-    // ~32 ms of reported PDC latency (fftSize - hopSize = 1536 samples), the
-    // default would put the bypassed track 1536 samples early relative to
+    // ~43 ms of reported PDC latency (2047 samples at 48 kHz), the
+    // default would put the bypassed track 2047 samples early relative to
     // parallel routes, breaking phase alignment. Route through the in-plugin
     // bypass path (HPSSProcessor::processBypass) so the delay buffer keeps
     // the bypassed signal aligned with what other plugins on parallel sends
     // produce. See REVIEW-AUDIO.md C3.
     void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+   #if UNRAVEL_HAS_AUDIO_WORKGROUP
+    // Worker threads join the host's audio workgroup so the OS schedules
+    // them against the same deadline as the audio callback.
+    void audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup) override;
+   #endif
+
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
@@ -75,21 +87,37 @@ private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     // New DSP pipeline using HPSS algorithm
-    static constexpr int numBins = 1025; // 2048/2 + 1 for real FFT
+    static constexpr int numBins = 1025; // 2048/2 + 1 for real FFT (history ring; 48 kHz band)
     
-    // Per-channel HPSS processor
-    std::vector<std::unique_ptr<HPSSProcessor>> channelProcessors;
-
-    // Per-stream gain smoothers live inside each HPSSProcessor and are
-    // advanced per-frame inside its processBlock().
-
-    // Current parameter values (updated once per block)
+    // Analysis group this instance joined (Analysis Group parameter), or
+    // nullptr. Declared before the engine, which only holds a raw pointer.
+    std::shared_ptr<SharedAnalysis> sharedAnalysis_;
+    int64_t expectedTimelineSample_ = -1;       // Timeline position the next block should start at
+
+    // Multichannel HPSS engine (one lane per input channel, frames processed
+    // in lock step; masks per channel or linked, see HPSSProcessor::ChannelLink)
+    std::unique_ptr<HPSSProcessor> hpssProcessor;
+
+    // Worker threads for wide buses. Channels fan out across the pool from
+    // kParallelChannelThreshold channels up; below that the threads aren't
+    // spawned and the engine runs serially on the audio thread.
+    static constexpr int kMaxChannels = 16;
+    static constexpr int kParallelChannelThreshold = 3;
+    ChannelWorkerPool workerPool_;
+
+    // Per-stream gain smoothers live inside the HPSSProcessor and are
+    // advanced per-frame inside its processBlock(). The engine asks for their
+    // targets at every frame boundary (getFrameGains), so a change lands on
+    // the next frame whatever the host block size.
+
+    // Current parameter values (updated once per block that completes a frame)
     float currentTonalGain = 1.0f;
     float currentNoisyGain = 1.0f;
     float currentTransientGain = 1.0f;
     float currentSeparation = 0.75f;
     float currentFocus = 0.0f;
     float currentSpectralFloor = 0.0f;  // Default OFF
+    bool currentStereoLink = false;     // Default OFF (independent L/R masks)
 
     // Solo/Mute state (per stream)
     bool soloTonal = false;
@@ -101,24 +129,55 @@ private:
 
     double currentSampleRate = 48000.0;
     int currentBlockSize = 512;
+    std::atomic<int> analysisFftSize_ { 0 };    // getAnalysisFftSize(), set in prepareToPlay
 
-    // Brightness filter (high shelf for post-processing)
-    static constexpr float kBrightnessFrequency = 4000.0f;
-    static constexpr float kBrightnessQ = 0.707f;
-    static constexpr float kBrightnessMinDb = -12.0f;
-    static constexpr float kBrightnessMaxDb = 12.0f;
-    static constexpr float kBrightnessStepDb = 0.1f;
-    static constexpr int kBrightnessTableSize = 241; // (24 dB / 0.1 dB) + 1, spans -12..+12 inclusive
-    std::array<juce::dsp::IIR::Filter<float>, 2> brightnessFilters_;
+    // Brightness: the post-HPSS high shelf on every channel (or, built with
+    // UNRAVEL_SPECTRAL_BRIGHTNESS, folded into the engine's bin gains).
+    BrightnessShelf brightnessShelf_;
     std::atomic<float>* brightnessParam_ = nullptr;
-    juce::SmoothedValue<float> brightnessGainSmoother_;
-    // Precomputed high-shelf coefficients (built off the audio thread in prepareToPlay).
-    // processBlock only selects from this table — no coefficient allocation on the audio thread.
-    std::vector<juce::dsp::IIR::Coefficients<float>::Ptr> brightnessCoeffTable_;
+
+    // Raw values the stream gains are computed from, looked up once: they
+    // are read at every frame boundary.
+    std::atomic<float>* tonalGainParam_ = nullptr;
+    std::atomic<float>* noisyGainParam_ = nullptr;
+    std::atomic<float>* transientGainParam_ = nullptr;
+    std::atomic<float>* soloParams_[3] {};      // Tonal, noise, transient
+    std::atomic<float>* muteParams_[3] {};
+
+    // Auto Quality: the governor (audio thread only) and the tier it chose,
+    // published for the editor.
+    QualityGovernor qualityGovernor_;
+    std::atomic<float>* autoQualityParam_ = nullptr;
+    std::atomic<int> qualityTier_ { 0 };
+
+    // Feed the governor one callback's time and hand its tier to the engine.
+    void updateQualityGovernor(int64_t startTicks, int numSamples) noexcept;
+
+    // Bypassed samples since the last zero row pushed for the display
+    int bypassDisplaySamples_ = 0;
 
     void updateParameters() noexcept;
-    void rebuildBrightnessTable(double sampleRate);
-    int brightnessTableIndex(float gainDb) const noexcept;
+
+    // The three stream gains from the current parameter values: dB to
+    // linear, the solo/mute matrix and the pad-corner transient scaling.
+    // Also refreshes the solo/mute flags.
+    HPSSProcessor::FrameGains computeStreamGains() noexcept;
+
+    // HPSSProcessor::GainSource: JUCE hands a plugin one value per parameter
+    // per block, so every frame reads the latest values.
+    HPSSProcessor::FrameGains getFrameGains(int sampleOffset) noexcept override;
+
+    // Restart the analysis when the host's timeline jumps, resyncing with
+    // the analysis group if any (see HPSSProcessor::resyncSharedAnalysis()).
+    void syncTimeline(int numSamples) noexcept;
+
+    // Both stem output buses enabled: the main output carries the tonal
+    // stream and the two aux buses the noise and transient streams.
+    bool hasStemBuses() const;
+
+    // One zero row per hop of bypassed audio, so the display decays at the
+    // frame rate rather than the host's callback rate.
+    void publishBypassedFrame(int numSamples) noexcept;
 
     // Audio-thread side of the message-thread snap request. Picks up
     // snapRequested_ in processBlock and applies the snap to smoothers and
@@ -138,27 +197,38 @@ private:
     std::atomic<int> editorWidth_  { 0 };
     std::atomic<int> editorHeight_ { 0 };
 
-    // Spectrum snapshot (seqlock: single audio-thread writer, single UI-thread reader).
-    // Even sequence = stable, odd = write in progress. Writer is wait-free (two atomic
-    // stores around a copy); reader retries on a torn read.
-    std::vector<float> snapMagnitudes_;
-    std::vector<float> snapTonalMask_;
-    std::vector<float> snapTransientMask_;
-    std::vector<float> snapNoiseMask_;
-    std::atomic<uint32_t> snapSeq_ { 0 };
-    void publishSpectrumSnapshot(bool bypassed) noexcept;
+    // Analysis frames for the editor: every frame of channel 0, pushed by the
+    // engine as it completes it (single writer), drained by SpectrumDisplay.
+    // Prepared once in the ctor (the bin count is fixed), so no prepareToPlay
+    // ever reallocates what the editor reads.
+    SpectrumHistoryRing spectrumHistory_;
+
+    // DSP load history (UNRAVEL_DSP_PROFILING builds): one record per
+    // processBlock, per-slot seqlocks, single audio-thread writer.
+    DspProfiler::Ring profileRing_;
+    void publishProfileRecord(uint64_t startTicks, int numChannels, int numSamples) noexcept;
 
 public:
-    // Spectrum visualization (thread-safe snapshot).
-    // The audio thread publishes the latest analysis frame via a seqlock; the UI
-    // copies a consistent snapshot into its own buffers. The UI never touches the
-    // live DSP buffers, so there is no data race or dangling-pointer risk.
-    // Returns false if no snapshot is available yet (e.g. before prepareToPlay).
-    bool readSpectrumSnapshot(std::vector<float>& magnitudes,
-                              std::vector<float>& tonalMask,
-                              std::vector<float>& transientMask,
-                              std::vector<float>& noiseMask) const;
+    // Spectrum visualization: recent analysis frames, written wait-free by the
+    // audio thread and read in bulk by the editor, which also sets the
+    // resolution they are written at. The UI never touches the live DSP
+    // buffers, so there is no data race or dangling-pointer risk.
+    SpectrumHistoryRing& getSpectrumHistory() noexcept { return spectrumHistory_; }
+
+    // Analysis FFT size the history's bins come from (the engine's scales
+    // with the sample rate; 0 before prepareToPlay).
+    int getAnalysisFftSize() const noexcept { return analysisFftSize_.load(std::memory_order_relaxed); }
     int getNumBins() const noexcept;
+
+    // Per-block DSP timing for the editor's load readout. Only populated in
+    // UNRAVEL_DSP_PROFILING builds; read it through a DspProfiler::LoadMeter.
+    const DspProfiler::Ring& getProfileRing() const noexcept { return profileRing_; }
+
+    // Quality tier the engine runs at (Full unless Auto Quality stepped it down).
+    QualityGovernor::Tier getQualityTier() const noexcept
+    {
+        return static_cast<QualityGovernor::Tier>(qualityTier_.load(std::memory_order_relaxed));
+    }
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UnravelAudioProcessor)
 };
\ No newline at end of file